@@ -19,11 +19,13 @@ class angularCam_t: public camera_t
 				   int _resx, int _resy, PFLOAT aspect, PFLOAT angle, bool circ);
 		virtual void setAxis(const vector3d_t &vx, const vector3d_t &vy, const vector3d_t &vz);
 		virtual ray_t shootRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOAT &wt) const;
+		virtual diffRay_t shootDiffRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOAT &wt) const;
 		virtual point3d_t screenproject(const point3d_t &p) const;
 		
 		static camera_t* factory(paraMap_t &params, renderEnvironment_t &render);
 	protected:
 		PFLOAT aspect,hor_phi, max_r;
+		PFLOAT du_dpx, dv_dpy; //!< change of the image plane coordinates per pixel
 		bool circular;
 };
 
@@ -18,6 +18,7 @@ class orthoCam_t: public camera_t
 				   int _resx, int _resy, PFLOAT aspect, PFLOAT scale);
 		virtual void setAxis(const vector3d_t &vx, const vector3d_t &vy, const vector3d_t &vz);
 		virtual ray_t shootRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOAT &wt) const;
+		virtual diffRay_t shootDiffRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOAT &wt) const;
 		virtual point3d_t screenproject(const point3d_t &p) const;
 		
 		static camera_t* factory(paraMap_t &params, renderEnvironment_t &render);
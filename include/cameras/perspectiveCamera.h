@@ -23,6 +23,7 @@ class perspectiveCam_t: public camera_t
 		virtual ~perspectiveCam_t();
 		virtual void setAxis(const vector3d_t &vx, const vector3d_t &vy, const vector3d_t &vz);
 		virtual ray_t shootRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOAT &wt) const;
+		virtual diffRay_t shootDiffRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOAT &wt) const;
 		virtual bool sampleLense() const;
 		virtual point3d_t screenproject(const point3d_t &p) const;
 		
@@ -10,6 +10,7 @@ __BEGIN_YAFRAY
 
 struct renderState_t;
 class light_t;
+class scene_t;
 
 class YAFRAYCORE_EXPORT background_t
 {
@@ -17,6 +18,11 @@ class YAFRAYCORE_EXPORT background_t
 		//! get the background color for a given ray
 		virtual color_t operator() (const ray_t &ray, renderState_t &state, bool filtered=false) const=0;
 		virtual color_t eval(const ray_t &ray, bool filtered=false) const=0;
+		//! called by the scene before the lights get initialized, i.e. before any bgLight_t evaluates the background
+		virtual void init(scene_t &scene) {}
+		/*! resolution of the underlying image in a latitude-longitude parametrization (u around the z axis),
+			0 if the background isn't image based */
+		virtual void resolution(int &u, int &v) const { u = v = 0; }
 		/*! get the light source representing background lighting.
 			\return the light source that reproduces background lighting, or NULL if background
 					shall only be sampled from BSDFs
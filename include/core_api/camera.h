@@ -53,6 +53,23 @@ class YAFRAYCORE_EXPORT camera_t
 		virtual void setAxis(const vector3d_t &vx, const vector3d_t &vy, const vector3d_t &vz) = 0; //!< Set camera axis
 		/*! Shoot a new ray from the camera gived image pixel coordinates px,py and lense dof effect */
 		virtual ray_t shootRay(PFLOAT px, PFLOAT py, float u, float v, PFLOAT &wt) const = 0; //!< Shoot a new ray from the camera.
+		/*! Shoot a ray together with its differentials, i.e. the rays through the pixels at px+1 and py+1
+			with the same lens sample. hasDifferentials is false when wt is 0. This default version shoots
+			three rays, cameras should override it with an analytic version. */
+		virtual diffRay_t shootDiffRay(PFLOAT px, PFLOAT py, float u, float v, PFLOAT &wt) const
+		{
+			diffRay_t ray(shootRay(px, py, u, v, wt));
+			if(wt == 0.f) return ray;
+			PFLOAT wt_dummy;
+			ray_t d_ray = shootRay(px + 1, py, u, v, wt_dummy);
+			ray.xfrom = d_ray.from;
+			ray.xdir = d_ray.dir;
+			d_ray = shootRay(px, py + 1, u, v, wt_dummy);
+			ray.yfrom = d_ray.from;
+			ray.ydir = d_ray.dir;
+			ray.hasDifferentials = true;
+			return ray;
+		}
 		virtual point3d_t screenproject(const point3d_t &p) const = 0; //!< Get projection of point p into camera plane
 		
 		virtual int resX() const { return resx; } //!< Get camera X resolution
@@ -25,7 +25,9 @@
 #include<yafray_config.h>
 
 #include <iostream>
+#include <vector>
 #include <utilities/mathOptimizations.h>
+#include <utilities/simd.h>
 
 #define COLOR_SIZE 3
 
@@ -48,11 +50,22 @@ class YAFRAYCORE_EXPORT color_t
 	friend YAFRAYCORE_EXPORT color_t mix(const color_t &a, const color_t &b, CFLOAT point);
 	friend YAFRAYCORE_EXPORT color_t convergenceAccell(const color_t &cn_1, const color_t &cn0, const color_t &cn1);
 	public:
+#ifdef Y_SSE
+		// components are always written with one 16 byte store, so the following vector loads can be forwarded
+		color_t() { _mm_storeu_ps(&R, _mm_setzero_ps()); }
+		color_t(CFLOAT r, CFLOAT g, CFLOAT b) { _mm_storeu_ps(&R, _mm_setr_ps(r, g, b, 0.f)); }
+		color_t(CFLOAT g) { _mm_storeu_ps(&R, _mm_setr_ps(g, g, g, 0.f)); }
+		color_t(CFLOAT af[3]) { _mm_storeu_ps(&R, _mm_setr_ps(af[0], af[1], af[2], 0.f)); }
+		explicit color_t(__m128 v) { _mm_storeu_ps(&R, v); }
+		__m128 vec() const { return _mm_loadu_ps(&R); }
+		bool isBlack() const { return sseIsZero3(vec()); }
+#else
 		color_t() { R=G=B=0; }
 		color_t(CFLOAT r, CFLOAT g, CFLOAT b) {R=r;G=g;B=b;};
 		color_t(CFLOAT g) { R=G=B=g; }
 		color_t(CFLOAT af[3]) { R=af[0];  G=af[1];  B=af[2]; }
 		bool isBlack() const { return ((R==0) && (G==0) && (B==0)); }
+#endif
 		~color_t() {}
 		void set(CFLOAT r, CFLOAT g, CFLOAT b) { R=r;  G=g;  B=b; }
 
@@ -78,6 +91,12 @@ class YAFRAYCORE_EXPORT color_t
 			if (G!=0.f) G=1.f/G;
 			if (B!=0.f) B=1.f/B;
 		}
+#ifdef Y_SSE
+		// the fourth lane is left alone, it holds the alpha of colorA_t
+		void absRGB() { _mm_storeu_ps(&R, sseSelect3(sseAbs(vec()), vec())); }
+		void darkenRGB(const color_t &col) { _mm_storeu_ps(&R, sseSelect3(_mm_min_ps(col.vec(), vec()), vec())); }
+		void lightenRGB(const color_t &col) { _mm_storeu_ps(&R, sseSelect3(_mm_max_ps(col.vec(), vec()), vec())); }
+#else
 		void absRGB() { R=std::fabs(R);  G=std::fabs(G);  B=std::fabs(B); }
 		void darkenRGB(const color_t &col)
 		{
@@ -91,11 +110,21 @@ class YAFRAYCORE_EXPORT color_t
 			if (G<col.G) G=col.G;
 			if (B<col.B) B=col.B;
 		}
+#endif
 
 		void black() { R=G=B=0; }
 		CFLOAT minimum() const { return std::min(R, std::min(G, B)); }
 		CFLOAT maximum() const { return std::max(R, std::max(G, B)); }
 		CFLOAT absmax() const { return std::max(std::fabs(R), std::max(std::fabs(G), std::fabs(B))); }
+#ifdef Y_SSE
+		// max(0, x) and min(1, x) keep NaNs just like the comparisons below
+		void clampRGB0() { _mm_storeu_ps(&R, sseSelect3(_mm_max_ps(_mm_setzero_ps(), vec()), vec())); }
+		void clampRGB01()
+		{
+			__m128 c = _mm_min_ps(_mm_set1_ps(1.f), _mm_max_ps(_mm_setzero_ps(), vec()));
+			_mm_storeu_ps(&R, sseSelect3(c, vec()));
+		}
+#else
 		void clampRGB0()
 		{
 			if (R<0.0) R=0.0;
@@ -109,8 +138,12 @@ class YAFRAYCORE_EXPORT color_t
 			if (G<0.0) G=0.0; else if (G>1.0) G=1.0;
 			if (B<0.0) B=0.0; else if (B>1.0) B=1.0;
 		}
+#endif
 //	protected:
 		CFLOAT R, G, B;
+#ifdef Y_SSE
+		CFLOAT A; //!< pads color_t to 4 floats, holds the alpha of colorA_t
+#endif
 };
 
 class YAFRAYCORE_EXPORT colorA_t : public color_t
@@ -129,11 +162,14 @@ class YAFRAYCORE_EXPORT colorA_t : public color_t
 	friend YAFRAYCORE_EXPORT colorA_t mix(const colorA_t &a, const colorA_t &b, CFLOAT point);
 	public:
 		colorA_t() { /* A=0; */ }
-		colorA_t(const color_t &c):color_t(c), A(1.f) { /* A=0; */ }
-		colorA_t(const color_t &c, CFLOAT a):color_t(c), A(a) {}
-		colorA_t(CFLOAT r, CFLOAT g, CFLOAT b, CFLOAT a=0):color_t(r,g,b), A(a) {}
+		colorA_t(const color_t &c):color_t(c) { A=1.f; }
+		colorA_t(const color_t &c, CFLOAT a):color_t(c) { A=a; }
+		colorA_t(CFLOAT r, CFLOAT g, CFLOAT b, CFLOAT a=0):color_t(r,g,b) { A=a; }
 		colorA_t(CFLOAT g):color_t(g) { A=g; }
 		colorA_t(CFLOAT af[4]):color_t(af) { A=af[3]; }
+#ifdef Y_SSE
+		explicit colorA_t(__m128 v):color_t(v) {}
+#endif
 		~colorA_t() {};
 		void set(CFLOAT r, CFLOAT g, CFLOAT b, CFLOAT a=0) { color_t::set(r,g,b);  A=a; }
 
@@ -158,8 +194,10 @@ class YAFRAYCORE_EXPORT colorA_t : public color_t
 			if (A<0.0) A=0.0; else if (A>1.0) A=1.0;
 		}
 
+#ifndef Y_SSE
 //	protected:
 		CFLOAT A;
+#endif
 };
 
 class YAFRAYCORE_EXPORT rgbe_t
@@ -221,6 +259,85 @@ YAFRAYCORE_EXPORT std::ostream & operator << (std::ostream & out,const colorA_t
 YAFRAYCORE_EXPORT colorA_t mix(const colorA_t &a,const colorA_t &b,CFLOAT point);
 
 
+#ifdef Y_SSE
+
+inline color_t operator * (const color_t &a,const color_t &b)
+{
+	return color_t(_mm_mul_ps(a.vec(), b.vec()));
+}
+
+inline color_t operator * (const CFLOAT f,const color_t &b)
+{
+	return color_t(_mm_mul_ps(_mm_set1_ps(f), b.vec()));
+}
+
+inline color_t operator * (const color_t &b,const CFLOAT f)
+{
+	return color_t(_mm_mul_ps(_mm_set1_ps(f), b.vec()));
+}
+
+inline color_t operator / (const color_t &b,CFLOAT f)
+{
+	return color_t(_mm_div_ps(b.vec(), _mm_set1_ps(f)));
+}
+
+inline color_t operator + (const color_t &a,const color_t &b)
+{
+	return color_t(_mm_add_ps(a.vec(), b.vec()));
+}
+
+inline color_t operator - (const color_t &a, const color_t &b)
+{
+	return color_t(_mm_sub_ps(a.vec(), b.vec()));
+}
+
+inline color_t & color_t::operator +=(const color_t &c)
+{ _mm_storeu_ps(&R, _mm_add_ps(vec(), c.vec()));  return *this; }
+inline color_t & color_t::operator *=(const color_t &c)
+{ _mm_storeu_ps(&R, _mm_mul_ps(vec(), c.vec()));  return *this; }
+inline color_t & color_t::operator *=(CFLOAT f)
+{ _mm_storeu_ps(&R, _mm_mul_ps(vec(), _mm_set1_ps(f)));  return *this; }
+inline color_t & color_t::operator -=(const color_t &c)
+{ _mm_storeu_ps(&R, _mm_sub_ps(vec(), c.vec()));  return *this; }
+
+inline colorA_t operator * (const colorA_t &a,const colorA_t &b)
+{
+	return colorA_t(_mm_mul_ps(a.vec(), b.vec()));
+}
+
+inline colorA_t operator * (const CFLOAT f,const colorA_t &b)
+{
+	return colorA_t(_mm_mul_ps(_mm_set1_ps(f), b.vec()));
+}
+
+inline colorA_t operator * (const colorA_t &b,const CFLOAT f)
+{
+	return colorA_t(_mm_mul_ps(_mm_set1_ps(f), b.vec()));
+}
+
+inline colorA_t operator / (const colorA_t &b,CFLOAT f)
+{
+	if (f!=0) f=1.0/f;
+	return colorA_t(_mm_mul_ps(b.vec(), _mm_set1_ps(f)));
+}
+
+inline colorA_t operator + (const colorA_t &a,const colorA_t &b)
+{
+	return colorA_t(_mm_add_ps(a.vec(), b.vec()));
+}
+
+inline colorA_t operator - (const colorA_t &a, const colorA_t &b)
+{
+	return colorA_t(_mm_sub_ps(a.vec(), b.vec()));
+}
+
+inline colorA_t & colorA_t::operator +=(const colorA_t &c) { _mm_storeu_ps(&R, _mm_add_ps(vec(), c.vec()));  return *this; }
+inline colorA_t & colorA_t::operator *=(const colorA_t &c) { _mm_storeu_ps(&R, _mm_mul_ps(vec(), c.vec()));  return *this; }
+inline colorA_t & colorA_t::operator *=(CFLOAT f) { _mm_storeu_ps(&R, _mm_mul_ps(vec(), _mm_set1_ps(f)));  return *this; }
+inline colorA_t & colorA_t::operator -=(const colorA_t &c) { _mm_storeu_ps(&R, _mm_sub_ps(vec(), c.vec()));  return *this; }
+
+#else // Y_SSE
+
 inline color_t operator * (const color_t &a,const color_t &b)
 {
 	return color_t(a.R*b.R,a.G*b.G,a.B*b.B);
@@ -312,6 +429,8 @@ inline colorA_t & colorA_t::operator *=(const colorA_t &c) { R *= c.R;  G *= c.G
 inline colorA_t & colorA_t::operator *=(CFLOAT f) { R *= f;  G*= f;  B *= f;  A *= f;  return *this; }
 inline colorA_t & colorA_t::operator -=(const colorA_t &c) { R -= c.R;  G -= c.G;  B -= c.B;  A -= c.A;  return *this; }
 
+#endif // Y_SSE
+
 inline CFLOAT maxAbsDiff(const color_t &a,const color_t &b)
 {
 	return (a - b).absmax();
@@ -319,6 +438,30 @@ inline CFLOAT maxAbsDiff(const color_t &a,const color_t &b)
 
 YAFRAYCORE_EXPORT color_t convergenceAccell(const color_t &cn_1,const color_t &cn0,const color_t &cn1);
 
+// batched kernels over arrays of colors, as used when resolving the image film; with SSE2 the
+// clamps, and gammaAdjustColors() in FAST_MATH builds, process one RGBA pixel per register
+YAFRAYCORE_EXPORT void scaleColors(colorA_t *c, const CFLOAT *f, int n); //!< c[i] *= f[i]
+YAFRAYCORE_EXPORT void clampColorsRGB0(colorA_t *c, int n);
+YAFRAYCORE_EXPORT void clampColorsRGB01(colorA_t *c, int n);
+YAFRAYCORE_EXPORT void gammaAdjustColors(colorA_t *c, int n, CFLOAT g); //!< RGB only, alpha is left alone
+
+/*! Lookup table for x^g, indexed by the bits of x: every octave from 2^-20 to 2^12 is split
+	into 256 segments that are interpolated linearly, which keeps the relative error below 1e-6
+	for the usual display gammas. Values outside that range fall back to fPow(). */
+class YAFRAYCORE_EXPORT gammaTable_t
+{
+	public:
+		gammaTable_t(): g(1.f) {}
+		void init(CFLOAT gamma);
+		CFLOAT getGamma() const { return g; }
+		CFLOAT operator()(CFLOAT v) const;
+		//! RGB only, alpha is left alone
+		void apply(colorA_t *c, int n) const;
+	protected:
+		CFLOAT g;
+		std::vector<float> table;
+};
+
 __END_YAFRAY
 
 #endif // Y_COLOR_H
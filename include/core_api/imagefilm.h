@@ -45,6 +45,7 @@ __BEGIN_YAFRAY
 */
 
 class progressBar_t;
+class checkpoint_t;
 
 // Image types define
 #define IF_IMAGE 1
@@ -61,6 +62,15 @@ class YAFRAYCORE_EXPORT imageFilm_t
 			GAUSS,
 			LANCZOS
 		};
+
+		//! what the cost map measures per pixel
+		enum costType
+		{
+			COST_NONE,
+			COST_TIME, //!< wall time in microseconds
+			COST_RAYS, //!< rays of all classes, needs the render statistics counters
+			COST_NODES //!< visited kd-tree nodes, needs the render statistics counters
+		};
 		
 		/*! imageFilm_t Constructor */
 		imageFilm_t(int width, int height, int xstart, int ystart, colorOutput_t &out, float filterSize=1.0, filterType filt=BOX,
@@ -72,6 +82,27 @@ class YAFRAYCORE_EXPORT imageFilm_t
 		void init(int numPasses = 0);
 		/*! Allocates memory for the z-buffer rendering */
 		void initDepthMap(); 
+		/*! Restricts the areas handed out by nextArea() to the window [x0,x1) x [y0,y1) in image
+			coordinates; samples still reach all film pixels within the filter width. A film that
+			covers the window plus filterRadius() thus holds finished pixel sums for the window,
+			which is how a frame is split among render processes. Takes effect with the next init(),
+			which then only clears the window plus filterRadius(); the other pixels keep their sums. */
+		void setSampleWindow(int x0, int y0, int x1, int y1);
+		//! pixels beyond a sample window that samples inside it can reach
+		int filterRadius() const;
+		/*! Weighted color sum of the samples at pixel (x,y) and the sum of their filter weights */
+		void getPixelSum(int x, int y, colorA_t &col, float &weight) const;
+		/*! Adds a weighted color sum, e.g. getPixelSum() of another film, to pixel (x,y) */
+		void addPixelSum(int x, int y, const colorA_t &col, float weight);
+		/*! Allocates the per pixel cost map; the rays and nodes measures enable the render statistics */
+		void initCostMap(costType type);
+		bool doCostMap() const { return costMap != 0; }
+		/*! Appends the accumulated samples (color, depth and density buffers), the sample count
+			and the pass number to a checkpoint */
+		void saveState(checkpoint_t &cp) const;
+		/*! Restores what saveState() wrote, into a film of the same size and channels set up with init();
+			\return false if the checkpoint does not match this film */
+		bool loadState(checkpoint_t &cp);
 		/*! Prepare for next pass, i.e. reset area_cnt, check if pixels need resample...
 			\param adaptive_AA if true, flag pixels to be resampled
 			\param threshold color threshold for adaptive antialiasing */
@@ -82,8 +113,14 @@ class YAFRAYCORE_EXPORT imageFilm_t
 		bool nextArea(renderArea_t &a);
 		/*! Indicate that all pixels inside the area have been sampled for this pass */
 		void finishArea(renderArea_t &a);
-		/*! Output all pixels to the color output */
+		/*! Output all pixels to the color output; the image is resolved in bands of rows which are
+			spread across the threads set with setNumThreads() */
 		void flush(int flags = IF_ALL, colorOutput_t *out = 0);
+		/*! Resolves the pixels [x0,x0+rw) x [y0,y0+rh) (film coordinates, starting at 0) into
+			rgba, rw colors per row: normalized, density added if flags has IF_DENSITYIMAGE,
+			clamped to positive values and gamma corrected. depth receives the normalized z-buffer
+			if it is not NULL and the film has one. The rows are split among nThreads threads. */
+		void resolveArea(int x0, int y0, int rw, int rh, colorA_t *rgba, float *depth, int flags = IF_IMAGE, int nThreads = 1) const;
 		/*! query if sample (x,y) was flagged to need more samples.
 			IMPORTANT! You may only call this after you have called nextPass(true, ...), otherwise
 			no such flags have been created !! */
@@ -101,6 +138,14 @@ class YAFRAYCORE_EXPORT imageFilm_t
 			use a=0 for contributions outside the area associated with current thread!
 		*/
 		void addDensitySample(const color_t &c, int x, int y, float dx, float dy, const renderArea_t *a = 0);
+		/*!	Current reading of the cost measure for the calling thread; the cost of a pixel is the
+			difference of two readings taken around its samples */
+		double costProbe() const;
+		/*!	Add cost to pixel (x,y); no locking, pixels of one area must come from the same thread */
+		void addCost(int x, int y, double cost) { (*costMap)(x - cx0, y - cy0) += (float)cost; }
+		/*!	Output the cost map, as false color image (black over blue, red and yellow to white,
+			scaled to the 99th percentile) or as raw cost values in all color channels */
+		void flushCostMap(colorOutput_t &out, bool falseColor = true);
 		//! Enables/Disables a light density estimation image
 		void setDensityEstimation(bool enable);
 		//! set number of samples for correct density estimation (if enabled)
@@ -109,6 +154,8 @@ class YAFRAYCORE_EXPORT imageFilm_t
 		void setClamp(bool c){ clamp = c; }
 		/*! Enables/disables gamma correction of output; when gammaVal is <= 0 the current value is kept */
 		void setGamma(float gammaVal, bool enable);
+		//! number of threads used by flush()
+		void setNumThreads(int n){ nThreads = (n > 1) ? n : 1; }
 		/*! Sets the adaptative AA sampling threshold */
 		void setAAThreshold(CFLOAT thresh){ AA_thesh=thresh; }
 		/*! Enables interactive color buffer output for preview during render */
@@ -132,14 +179,19 @@ class YAFRAYCORE_EXPORT imageFilm_t
 	protected:
 		rgba2DImage_t *image; //!< rgba color buffer
 		gray2DImage_t *depthMap; //!< storage for z-buffer channel
+		gray2DImage_nw_t *costMap; //!< accumulated per pixel cost
+		costType costMeasure;
 		rgb2DImage_nw_t *densityImage; //!< storage for z-buffer channel
 		rgba2DImage_nw_t *dpimage; //!< render parameters badge image
 		tiledBitArray2D_t<3> *flags; //!< flags for adaptive AA sampling;
 		int dpHeight; //!< height of the rendering parameters badge;
 		int w, h, cx0, cx1, cy0, cy1;
+		int sx0, sx1, sy0, sy1; //!< sample window
 		int area_cnt, completed_cnt;
 		volatile int next_area;
 		float gamma;
+		gammaTable_t gammaTable;
+		int nThreads;
 		CFLOAT AA_thesh;
 		double filterw, tableScale;
 		float *filterTable;
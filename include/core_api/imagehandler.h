@@ -35,16 +35,59 @@ typedef unsigned short yWord;
 class YAFRAYCORE_EXPORT imageHandler_t
 {
 public:
+	imageHandler_t(): m_width(0), m_height(0), m_hasAlpha(false), m_hasDepth(false), m_rgba(0), m_depth(0), m_threads(1) {}
 	virtual void initForOutput(int width, int height, bool withAlpha = false, bool withDepth = false) = 0;
 	virtual ~imageHandler_t() {};
 	virtual bool loadFromFile(const std::string &name) = 0;
 	virtual bool loadFromMemory(const yByte *data, size_t size) {return false; }
 	virtual bool saveToFile(const std::string &name) = 0;
 	virtual void putPixel(int x, int y, const colorA_t &rgba, float depth = 0.f) = 0;
+	/*! Stores a block of w x h pixels at (x0, y0), pixel (i, j) of the block is rgba[j * stride + i]
+		and, if the handler has a depth channel, depth[j * depthStride + i]. The default copies into
+		m_rgba and m_depth, handlers that keep their frame elsewhere override it. */
+	virtual void putArea(int x0, int y0, int w, int h, const colorA_t *rgba, int stride, const float *depth, int depthStride)
+	{
+		if(!m_rgba)
+		{
+			for(int j = 0; j < h; ++j)
+				for(int i = 0; i < w; ++i) putPixel(x0 + i, y0 + j, rgba[j * stride + i], (depth) ? depth[j * depthStride + i] : 0.f);
+			return;
+		}
+		for(int j = 0; j < h; ++j)
+		{
+			const colorA_t *row = rgba + j * stride;
+			for(int i = 0; i < w; ++i) (*m_rgba)(x0 + i, y0 + j) = row[i];
+		}
+		if(m_hasDepth && m_depth && depth)
+		{
+			for(int j = 0; j < h; ++j)
+			{
+				const float *row = depth + j * depthStride;
+				for(int i = 0; i < w; ++i) (*m_depth)(x0 + i, y0 + j) = row[i];
+			}
+		}
+	}
 	virtual colorA_t getPixel(int x, int y) = 0;
 	virtual int getWidth() { return m_width; }
 	virtual int getHeight() { return m_height; }
 	virtual bool isHDR() { return false; }
+	//! threads saveToFile() may use to encode and compress the image
+	void setNumThreads(int n) { m_threads = (n > 1) ? n : 1; }
+
+	/*! Streaming output, for images too large to keep a second full frame copy: instead of
+		putPixel() and saveToFile(), openStream() creates the file, writeStream() passes the image
+		in row segments and closeStream() completes it. Handlers that support it skip their frame
+		buffer when created with the "streaming" parameter and then report the order in which
+		they accept segments:
+		STREAM_ROWS: whole rows, top to bottom, each row once.
+		STREAM_AREAS: any segment in any order, segments may be written again; the file holds
+		the segments written so far while the stream is open. */
+	enum streamMode_t { STREAM_NONE, STREAM_ROWS, STREAM_AREAS };
+	virtual streamMode_t streamMode() const { return STREAM_NONE; }
+	virtual bool openStream(const std::string &name) { return false; }
+	//! writes n pixels of row y starting at column x, depth is only read when the handler has a depth channel
+	virtual bool writeStream(int x, int y, int n, const colorA_t *rgba, const float *depth) { return false; }
+	virtual bool closeStream() { return false; }
 	
 protected:
 	std::string handlerName;
@@ -54,6 +97,7 @@ protected:
 	bool m_hasDepth;
 	rgba2DImage_nw_t *m_rgba;
 	gray2DImage_nw_t *m_depth;
+	int m_threads;
 };
 
 __END_YAFRAY
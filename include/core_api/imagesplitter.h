@@ -50,7 +50,7 @@ struct renderArea_t
 	different threads.
 	CAUTION! Some methods need to be thread save!
 */
-class imageSpliter_t
+class YAFRAYCORE_EXPORT imageSpliter_t
 {
 	public:
 		enum tilesOrderType { LINEAR, RANDOM };
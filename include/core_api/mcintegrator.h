@@ -31,8 +31,8 @@ class YAFRAYCORE_EXPORT mcIntegrator_t: public tiledIntegrator_t
 	protected:
 		/*! Estimates direct light from all sources in a mc fashion and completing MIS (Multiple Importance Sampling) for a given surface point */
 		virtual color_t estimateAllDirectLight(renderState_t &state, const surfacePoint_t &sp, const vector3d_t &wo) const;
-		/*! Like previous but for only one random light source for a given surface point */
-		virtual color_t estimateOneDirectLight(renderState_t &state, const surfacePoint_t &sp, vector3d_t wo, int n) const;
+		/*! Like previous but for only one random light source for a given surface point, picked with the current path's sample */
+		virtual color_t estimateOneDirectLight(renderState_t &state, const surfacePoint_t &sp, vector3d_t wo) const;
 		/*! Does the actual light estimation on a specific light for the given surface point */
 		virtual color_t doLightEstimation(renderState_t &state, light_t *light, const surfacePoint_t &sp, const vector3d_t &wo, const unsigned int &loffs) const;
 		/*! Does recursive mc raytracing with MIS (Multiple Importance Sampling) for a given surface point */
@@ -54,7 +54,7 @@ class YAFRAYCORE_EXPORT mcIntegrator_t: public tiledIntegrator_t
 		float causRadius; //! Caustic search radius for estimation
 		int causDepth; //! Caustic photons max path depth
 		photonMap_t causticMap; //! Container for the caustic photon map
-		pdf1D_t *lightPowerD;
+		aliasPdf1D_t *lightPowerD;
 		
 		bool useAmbientOcclusion; //! Use ambient occlusion
 		int aoSamples; //! Ambient occlusion samples
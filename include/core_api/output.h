@@ -34,9 +34,26 @@ class colorOutput_t
 	public:
 		virtual ~colorOutput_t() {};
 		virtual bool putPixel(int x, int y, const float *c, bool alpha = true, bool depth = false, float z = 0.f)=0;
+		/*! Writes a block of w x h pixels starting at (x0, y0). The RGBA floats of block pixel (i, j) are
+			at c + j * stride + i * 4; with z given its depth is z[j * zStride + i]. Outputs implement it
+			to take whole rows at once, the default passes every pixel to putPixel(). */
+		virtual bool putArea(int x0, int y0, int w, int h, const float *c, int stride, bool alpha = true, const float *z = 0, int zStride = 0)
+		{
+			for(int j = 0; j < h; ++j)
+			{
+				for(int i = 0; i < w; ++i)
+				{
+					if(!putPixel(x0 + i, y0 + j, c + j * stride + i * 4, alpha, z != 0, (z) ? z[j * zStride + i] : 0.f)) return false;
+				}
+			}
+			return true;
+		}
 		virtual void flush()=0;
 		virtual void flushArea(int x0, int y0, int x1, int y1)=0;
 		virtual void highliteArea(int x0, int y0, int x1, int y1){};
+		/*! false if the output only takes the complete image of imageFilm_t::flush(),
+			the film then does not send it the pixels of areas finished during rendering */
+		virtual bool wantsAreas() const { return true; }
 };
 
 __END_YAFRAY
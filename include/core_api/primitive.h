@@ -13,11 +13,19 @@ __BEGIN_YAFRAY
 class triangleObject_t;
 class material_t;
 
+//! shapes kdTree_t can test inline, see primitive_t::getShape()
+enum primShape_t { PRIM_GENERIC=0, PRIM_TRIANGLE, PRIM_SPHERE };
+
 class YAFRAYCORE_EXPORT primitive_t
 {
 	public:
 	/*! return the object bound in global ("world") coordinates */
 	virtual bound_t getBound() const = 0;
+	/*! bound of the primitive while the frame time runs from t0 to t1 (both within [0;1]);
+		only primitives that move need to be tighter than getBound() */
+	virtual bound_t getMotionBound(PFLOAT t0, PFLOAT t1) const { return getBound(); }
+	//! true if the primitive's shape depends on ray_t::time
+	virtual bool hasMotion() const { return false; }
 	/*! a possibly more precise check to find out if the primitve really
 		intersects the bound of interest, given that the primitive's bound does.
 		used e.g. for optimized kd-tree construction */
@@ -33,6 +41,11 @@ class YAFRAYCORE_EXPORT primitive_t
 		\return false if ray misses primitive, true otherwise
 		\param t set this to raydepth where hit occurs */
 	virtual bool intersect(const ray_t &ray, PFLOAT *t, intersectData_t &data) const = 0;
+	/*! lets the kd-tree copy the primitive into its leaves and test it there without calling
+		intersect(): PRIM_TRIANGLE writes the vertices to p, PRIM_SPHERE the center to p[0]
+		and the radius to r. intersect() has to be the matching test of triangle.h or std_primitives.h.
+		Other primitives return PRIM_GENERIC and are tested with intersect(). */
+	virtual int getShape(point3d_t p[3], PFLOAT &r) const { return PRIM_GENERIC; }
 	/* fill in surfacePoint_t */
 	virtual void getSurface(surfacePoint_t &sp, const point3d_t &hit, intersectData_t &data) const = 0;
 	/* return the material */
@@ -10,6 +10,7 @@
 #include <yafraycore/ccthreads.h>
 #include <vector>
 #include <core_api/matrix4.h>
+#include <utilities/sobol.h>
 
 
 #define USER_DATA_SIZE 1024
@@ -32,11 +33,13 @@ class material_t;
 class object3d_t;
 class triangleObject_t;
 class meshObject_t;
+class curveObject_t;
 class surfacePoint_t;
 class ray_t;
 class primitive_t;
 class triKdTree_t;
 template<class T> class kdTree_t;
+template<class T> class motionTree_t;
 class triangle_t;
 class background_t;
 class light_t;
@@ -56,9 +59,9 @@ typedef unsigned int objID_t;
 struct YAFRAYCORE_EXPORT renderState_t
 {
 	renderState_t():raylevel(0), currentPass(0), pixelSample(0), rayDivision(1), rayOffset(0), dc1(0), dc2(0),
-		traveled(0.0), chromatic(true), includeLights(false), userdata(0), lightdata(0), prng(0) {};
+		traveled(0.0), samplingOffs(0), sampleIndex(0), sampleDim(SD_VERTEX), chromatic(true), includeLights(false), userdata(0), lightdata(0), prng(0) {};
 	renderState_t(random_t *rand):raylevel(0), currentPass(0), pixelSample(0), rayDivision(1), rayOffset(0), dc1(0), dc2(0),
-		traveled(0.0), chromatic(true), includeLights(false), userdata(0), lightdata(0), prng(rand) {};
+		traveled(0.0), samplingOffs(0), sampleIndex(0), sampleDim(SD_VERTEX), chromatic(true), includeLights(false), userdata(0), lightdata(0), prng(rand) {};
 	~renderState_t(){};
 
 	int raylevel;
@@ -73,7 +76,9 @@ struct YAFRAYCORE_EXPORT renderState_t
 	PFLOAT traveled;
 	int pixelNumber;
 	int threadID; //!< identify the current render thread; shall range from 0 to scene_t::getNumThreads() - 1
-	unsigned int samplingOffs; //!< a "noise-like" pixel offset you may use to decorelate sampling of adjacent pixel.
+	unsigned int samplingOffs; //!< a "noise-like" pixel offset you may use to decorelate sampling of adjacent pixel; also the seed for sample()
+	unsigned int sampleIndex; //!< index of the current path in the sample sequence, nested estimators use n * sampleIndex + i
+	unsigned int sampleDim; //!< first sample dimension of the current path vertex, see utilities/sobol.h
 	//point3d_t screenpos; //!< the image coordinates of the pixel being computed currently
 	const camera_t *cam;
 	bool chromatic; //!< indicates wether the full spectrum is calculated (true) or only a single wavelength (false).
@@ -93,7 +98,10 @@ struct YAFRAYCORE_EXPORT renderState_t
 		rayOffset = 0;
 		dc1 = dc2 = 0.f;
 		traveled = 0;
+		sampleDim = SD_VERTEX;
 	}
+	//! sample of the given dimension (relative to the current path vertex) for sample number index
+	float sample(unsigned int index, unsigned int dim) const { return sobolSample(index, sampleDim + dim, samplingOffs); }
 //	protected:
 	explicit renderState_t(const renderState_t &r):prng(r.prng) {}//forbiden
 };
@@ -128,6 +136,14 @@ struct objData_t
 	size_t lastVertId;
 };
 
+//! a mesh whose finish() and/or smoothing is deferred until update(), see scene_t::finishGeometry()
+struct pendingMesh_t
+{
+	objData_t *odat;
+	bool finish;
+	PFLOAT smoothAngle; //!< < 0: no smoothing requested
+};
+
 struct sceneGeometryState_t
 {
 	std::list<unsigned int> stack;
@@ -145,12 +161,15 @@ class YAFRAYCORE_EXPORT scene_t
 		scene_t();
 		~scene_t();
 		explicit scene_t(const scene_t &s){ Y_ERROR << "Scene: You may NOT use the copy constructor!" << yendl; }
-		bool render();
+		/*! \param flushFilm false leaves the samples in the film without resolving them into the
+			output, e.g. when the pixel sums are read directly (distributed rendering) */
+		bool render(bool flushFilm = true);
 		void abort();
 		bool startGeometry();
 		bool endGeometry();
 		bool startTriMesh(objID_t id, int vertices, int triangles, bool hasOrco, bool hasUV=false, int type=0);
 		bool endTriMesh();
+		//! starts a hair strand; all strands started with one ID form a curve mesh that can be instanced
 		bool startCurveMesh(objID_t id, int vertices);
 		bool endCurveMesh(const material_t *mat, float strandStart, float strandEnd, float strandShape);
 		int  addVertex(const point3d_t &p);
@@ -162,6 +181,7 @@ class YAFRAYCORE_EXPORT scene_t
 		bool startVmap(int id, int type, int dimensions);
 		bool endVmap();
 		bool addVmapValues(float *val);
+		//! smooths a triangle mesh; curve meshes always shade round, for them this does nothing
 		bool smoothMesh(objID_t id, PFLOAT angle);
 		bool update();
 		
@@ -170,6 +190,9 @@ class YAFRAYCORE_EXPORT scene_t
 		objID_t getNextFreeID();
 		bool addObject(object3d_t *obj, objID_t &id);
         bool addInstance(objID_t baseObjectId, matrix4x4_t objToWorld);
+		/*! instance that moves from objToWorld at frame time 0 to objToWorldEnd at time 1 (motion blur).
+			Curve meshes are instanced in both modes by copying their strands, which only use objToWorld */
+		bool addInstance(objID_t baseObjectId, matrix4x4_t objToWorld, matrix4x4_t objToWorldEnd);
 		void addVolumeRegion(VolumeRegion* vr) { volumes.push_back(vr); }
 		void setCamera(camera_t *cam);
 		void setImageFilm(imageFilm_t *film);
@@ -180,6 +203,13 @@ class YAFRAYCORE_EXPORT scene_t
 		void setNumThreads(int threads);
 		void setMode(int m){ mode = m; }
 		void depthChannel(bool enable){ do_depth=enable; }
+		/*! Progressive renders write a checkpoint to file after a pass once interval seconds passed
+			since the previous one (0: after every pass); with resume they first continue from the
+			checkpoint in file, if there is one. An empty file name disables checkpoints. */
+		void setCheckpoint(const std::string &file, float interval, bool resume)
+		{
+			checkpointFile = file; checkpointInterval = interval; checkpointResume = resume;
+		}
 		
 		background_t* getBackground() const;
 		triangleObject_t* getMesh(objID_t id) const;
@@ -193,12 +223,18 @@ class YAFRAYCORE_EXPORT scene_t
 		//! only for backward compatibility!
 		void getAAParameters(int &samples, int &passes, int &inc_samples, CFLOAT &threshold) const;
 		bool doDepth() const { return do_depth; }
+		const std::string &getCheckpointFile() const { return checkpointFile; }
+		float getCheckpointInterval() const { return checkpointInterval; }
+		bool doResume() const { return checkpointResume; }
+		/*! Queue for work that may run in the background while the scene is loaded, like decoding
+			texture images; update() waits for it before the lights are initialized. */
+		yafthreads::taskQueue_t &getLoadQueue() { return loadQueue; }
 		
 		bool intersect(const ray_t &ray, surfacePoint_t &sp) const;
 		bool isShadowed(renderState_t &state, const ray_t &ray) const;
 		bool isShadowed(renderState_t &state, const ray_t &ray, int maxDepth, color_t &filt) const;
 		
-		enum sceneState { READY, GEOMETRY, OBJECT, VMAP };
+		enum sceneState { READY, GEOMETRY, OBJECT, VMAP, CURVE };
 		enum changeFlags { C_NONE=0, C_GEOM=1, C_LIGHT= 1<<1, C_OTHER=1<<2,
 							C_ALL=C_GEOM|C_LIGHT|C_OTHER };
 		
@@ -206,8 +242,11 @@ class YAFRAYCORE_EXPORT scene_t
 		volumeIntegrator_t *volIntegrator;
 		
 	protected:
+		void finishGeometry();
+		bool smoothObject(objData_t *odat, PFLOAT angle);
 
 		sceneGeometryState_t state;
+		std::vector<pendingMesh_t> pendingMeshes;
 		std::map<objID_t, object3d_t *> objects;
 		std::map<objID_t, objData_t> meshes;
         std::map< std::string, material_t * > materials;
@@ -216,6 +255,10 @@ class YAFRAYCORE_EXPORT scene_t
 		imageFilm_t *imageFilm;
 		triKdTree_t *tree; //!< kdTree for triangle-only mode
 		kdTree_t<primitive_t> *vtree; //!< kdTree for universal mode
+		motionTree_t<triangle_t> *mtree; //!< moving triangles (of instances) in triangle-only mode
+		motionTree_t<primitive_t> *mvtree; //!< moving primitives in universal mode
+		curveObject_t *curves; //!< hair strands of all curve meshes
+		kdTree_t<primitive_t> *ctree; //!< hair strands in triangle-only mode, universal mode keeps them in vtree
 		background_t *background;
 		surfaceIntegrator_t *surfIntegrator;
 		bound_t sceneBound; //!< bounding box of all (finite) scene geometry
@@ -227,7 +270,11 @@ class YAFRAYCORE_EXPORT scene_t
 		int mode; //!< sets the scene mode (triangle-only, virtual primitives)
 		bool do_depth;
 		int signals;
+		std::string checkpointFile;
+		float checkpointInterval;
+		bool checkpointResume;
 		mutable yafthreads::mutex_t sig_mutex;
+		yafthreads::taskQueue_t loadQueue;
 };
 
 __END_YAFRAY
@@ -48,6 +48,45 @@ class YAFRAYCORE_EXPORT nodeFinder_t
 
 enum mix_modes{ MN_MIX=0, MN_ADD, MN_MULT, MN_SUB, MN_SCREEN, MN_DIV, MN_DIFF, MN_DARK, MN_LIGHT, MN_OVERLAY };
 
+//! operations the compiled node programs of the materials evaluate inline, see shaderNode_t::getOp()
+enum nodeOpCode_e { NOP_EVAL=0, NOP_CONST, NOP_MIX, NOP_LAYER };
+
+//! parts of a node result, to tell which ones an operation has to compute
+enum nodeValue_e { NV_COLOR=1, NV_SCALAR=2, NV_BOTH=3 };
+
+// layer flags
+#define TXF_RGBTOINT    1
+#define TXF_STENCIL     2
+#define TXF_NEGATIVE    4
+#define TXF_ALPHAMIX    8
+#define TXF_DOCOLOR     16
+#define TXF_DOSCALAR    32
+#define TXF_COLORINPUT  64
+
+/*! a shader node described as a core operation, so node programs don't need its virtual eval():
+	NOP_CONST: the result is konst[0]
+	NOP_MIX: inputs are input1, input2 and factor, mode selects the mix
+	NOP_LAYER: inputs are the texture input and the upper layer, blended by mode and the TXF_ flags
+	inputs that are not connected to a node (in[i] == 0) use konst[i] instead */
+struct nodeOp_t
+{
+	nodeOp_t(): code(NOP_EVAL), mode(MN_MIX), flags(0), colfac(1.f), valfac(1.f), defVal(1.f), defCol(1.f)
+	{
+		for(int i=0; i<3; ++i)
+		{
+			in[i] = 0;
+			konst[i] = nodeResult_t(colorA_t(0.f), 0.f);
+		}
+	}
+	nodeOpCode_e code;
+	mix_modes mode;
+	unsigned int flags;
+	const shaderNode_t *in[3];
+	nodeResult_t konst[3];
+	CFLOAT colfac, valfac, defVal;
+	colorA_t defCol;
+};
+
 /*!	shader nodes are as the name implies elements of a node based shading tree.
 	Note that a "shader" only associates a color or scalar with a surface point,
 	nothing more and nothing less. The material behaviour is implemented in the
@@ -70,6 +109,12 @@ class YAFRAYCORE_EXPORT shaderNode_t
 			{stack[this->ID] = nodeResult_t(colorA_t(0.f), 0.f);}
 		/*! indicate whether the shader value depends on wi and wo */
 		virtual bool isViewDependant() const { return false; }
+		/*! indicate whether the result only depends on the node's inputs (and not on the surface point or render state),
+			nodes for which this holds and whose inputs are all constant are evaluated only once when the material is compiled */
+		virtual bool isConstant() const { return false; }
+		/*! describe the node as one of the operations of nodeOp_t, which the materials evaluate
+			without calling eval(); nodes that return false are evaluated through eval() */
+		virtual bool getOp(nodeOp_t &op) const { return false; }
 		/*! configure the inputs. gets the same paramMap the factory functions get, but shader nodes
 			may be created in any order and linked afterwards, so inputs may not exist yet on instantiation */
 		virtual bool configInputs(const paraMap_t &params, const nodeFinder_t &find) = 0;
@@ -194,6 +239,166 @@ inline float texture_value_blend(float tex, float out, float fact, float facg, m
 			return fact*tex + facm*out;
 	}
 }
+
+//! the mix operations of the mix nodes; computes the parts of res given by need
+inline void mixNodeOp(mix_modes mode, CFLOAT f2, const nodeResult_t &in1, const nodeResult_t &in2, int need, nodeResult_t &res)
+{
+	float f1 = 1.f - f2;
+	const colorA_t &cin1 = in1.col, &cin2 = in2.col;
+	float fin1 = in1.f, fin2 = in2.f;
+	switch(mode)
+	{
+		case MN_ADD:
+			if(need & NV_COLOR) res.col = cin1 + f2 * cin2;
+			if(need & NV_SCALAR) res.f = fin1 + f2 * fin2;
+			break;
+
+		case MN_MULT:
+			if(need & NV_COLOR) res.col = cin1 * (colorA_t(f1) + f2 * cin2);
+			// the scalar of input1 has always been passed through unchanged
+			if(need & NV_SCALAR) res.f = fin1;
+			break;
+
+		case MN_SUB:
+			if(need & NV_COLOR) res.col = cin1 - f2 * cin2;
+			if(need & NV_SCALAR) res.f = fin1 - f2 * fin2;
+			break;
+
+		case MN_SCREEN:
+			if(need & NV_COLOR) res.col = colorA_t(1.f) - (colorA_t(f1) + f2 * (1.f - cin2)) * (1.f - cin1);
+			if(need & NV_SCALAR) res.f = 1.0 - (f1 + f2*(1.f - fin2)) * (1.f -  fin1);
+			break;
+
+		case MN_DIFF:
+			if(need & NV_COLOR)
+			{
+				res.col.R = f1*cin1.R + f2*std::fabs(cin1.R - cin2.R);
+				res.col.G = f1*cin1.G + f2*std::fabs(cin1.G - cin2.G);
+				res.col.B = f1*cin1.B + f2*std::fabs(cin1.B - cin2.B);
+				res.col.A = f1*cin1.A + f2*std::fabs(cin1.A - cin2.A);
+			}
+			if(need & NV_SCALAR) res.f = f1*fin1 + f2*std::fabs(fin1 - fin2);
+			break;
+
+		case MN_DARK:
+		case MN_LIGHT:
+		{
+			bool dark = (mode == MN_DARK);
+			if(need & NV_COLOR)
+			{
+				colorA_t c1 = cin1, c2 = cin2;
+				c2 *= f2;
+				if(dark ? c2.R < c1.R : c2.R > c1.R) c1.R = c2.R;
+				if(dark ? c2.G < c1.G : c2.G > c1.G) c1.G = c2.G;
+				if(dark ? c2.B < c1.B : c2.B > c1.B) c1.B = c2.B;
+				if(dark ? c2.A < c1.A : c2.A > c1.A) c1.A = c2.A;
+				res.col = c1;
+			}
+			if(need & NV_SCALAR)
+			{
+				fin2 *= f2;
+				res.f = (dark ? fin2 < fin1 : fin2 > fin1) ? fin2 : fin1;
+			}
+			break;
+		}
+
+		case MN_OVERLAY:
+			if(need & NV_COLOR)
+			{
+				res.col.R = (cin1.R < 0.5f) ? cin1.R * (f1 + 2.0f*f2*cin2.R) : 1.0 - (f1 + 2.0f*f2*(1.0 - cin2.R)) * (1.0 - cin1.R);
+				res.col.G = (cin1.G < 0.5f) ? cin1.G * (f1 + 2.0f*f2*cin2.G) : 1.0 - (f1 + 2.0f*f2*(1.0 - cin2.G)) * (1.0 - cin1.G);
+				res.col.B = (cin1.B < 0.5f) ? cin1.B * (f1 + 2.0f*f2*cin2.B) : 1.0 - (f1 + 2.0f*f2*(1.0 - cin2.B)) * (1.0 - cin1.B);
+				res.col.A = (cin1.A < 0.5f) ? cin1.A * (f1 + 2.0f*f2*cin2.A) : 1.0 - (f1 + 2.0f*f2*(1.0 - cin2.A)) * (1.0 - cin1.A);
+			}
+			if(need & NV_SCALAR) res.f = (fin1 < 0.5f) ? fin1 * (f1 + 2.0f*f2*fin2) : 1.0 - (f1 + 2.0f*f2*(1.0 - fin2)) * (1.0 - fin1);
+			break;
+
+		default:
+		case MN_MIX:
+			if(need & NV_COLOR) res.col = f1 * cin1 + f2 * cin2;
+			if(need & NV_SCALAR) res.f = f1 * fin1 + f2 * fin2;
+	}
+}
+
+//! the texture layer blend of the layer nodes; computes the parts of res given by need
+inline void layerNodeOp(const nodeOp_t &op, const nodeResult_t &input, const nodeResult_t &upper, int need, nodeResult_t &res)
+{
+	colorA_t rcol = upper.col, texcolor;
+	CFLOAT rval = upper.f, Tin=0.f, Ta=1.f, stencilTin = rcol.A;
+	unsigned int texflag = op.flags;
+
+	// == get texture input color ==
+	bool TEX_RGB = texflag & TXF_COLORINPUT;
+
+	if(TEX_RGB)
+	{
+		texcolor = input.col;
+		Ta = texcolor.A;
+	}
+	else Tin = input.f;
+
+	if(texflag & TXF_RGBTOINT)
+	{
+		Tin = texcolor.col2bri();
+		TEX_RGB = false;
+	}
+
+	if(texflag & TXF_NEGATIVE)
+	{
+		if (TEX_RGB) texcolor = colorA_t(1.f)-texcolor;
+		Tin = 1.f-Tin;
+	}
+
+	CFLOAT fact;
+
+	if(texflag & TXF_STENCIL)
+	{
+		if(TEX_RGB) // only scalar input affects stencil...?
+		{
+			fact = Ta;
+			Ta *= stencilTin;
+			stencilTin *= fact;
+		}
+		else
+		{
+			fact = Tin;
+			Tin *= stencilTin;
+			stencilTin *= fact;
+		}
+	}
+
+	// color type modulation
+	if((texflag & TXF_DOCOLOR) && (need & NV_COLOR))
+	{
+		if(!TEX_RGB)	texcolor = op.defCol;
+		else			Tin = Ta;
+
+		rcol = texture_rgb_blend(texcolor, rcol, Tin, stencilTin * op.colfac, op.mode);
+		rcol.clampRGB0();
+	}
+
+	// intensity type modulation
+	if((texflag & TXF_DOSCALAR) && (need & NV_SCALAR))
+	{
+		if(TEX_RGB)
+		{
+			if(texflag & TXF_ALPHAMIX)
+			{
+				Tin = Ta;
+				if(texflag & TXF_NEGATIVE) Tin = 1.f - Tin;
+			}
+			else
+			{
+				Tin = texcolor.col2bri();
+			}
+		}
+
+		rval = texture_value_blend(op.defVal, rval, Tin, stencilTin * op.valfac, op.mode, false);
+		if(rval<0.f) rval=0.f;
+	}
+	rcol.A = stencilTin;
+	res = nodeResult_t(rcol, rval);
+}
 	
 
 __END_YAFRAY
@@ -5,6 +5,7 @@
 #include <core_api/integrator.h>
 #include <core_api/imagesplitter.h>
 #include <core_api/material.h>
+#include <yafraycore/checkpoint.h>
 
 __BEGIN_YAFRAY
 
@@ -28,6 +29,18 @@ class YAFRAYCORE_EXPORT tiledIntegrator_t: public surfaceIntegrator_t
 		virtual void precalcDepths();
 	
 	protected:
+		/*! Continues from the scene's checkpoint file when resuming was asked for; call after imageFilm->init()
+			\return the number of passes the checkpoint had completed, 0 to render from the start */
+		int resumeCheckpoint(int passes);
+		/*! Writes a checkpoint after the given (1 based) pass if the scene asks for them and the interval passed */
+		void checkpointPass(int pass, int passes);
+		/*! Integrator state beyond the image film that later passes depend on;
+			loadCheckpointState() returns false if the checkpoint does not fit the current render */
+		virtual void saveCheckpointState(checkpoint_t &cp) const {}
+		virtual bool loadCheckpointState(checkpoint_t &cp) { return true; }
+
+		checkpoint_t checkpoint;
+		double lastCheckpoint; //!< timer_t::now() of the last checkpoint or the render start
 		int AA_samples, AA_passes, AA_inc_samples;
 		float iAA_passes; //!< Inverse of AA_passes used for depth map
 		float AA_threshold;
@@ -25,6 +25,7 @@
 #include <yafray_config.h>
 
 #include <utilities/mathOptimizations.h>
+#include <utilities/simd.h>
 #include <iostream>
 
 // ensure isnan is available. I *hope* it works with OSX w. gcc 4.x too
@@ -52,16 +53,57 @@ class point3d_t;
 class YAFRAYCORE_EXPORT vector3d_t
 {
 	public:
+#ifdef Y_SSE
+		vector3d_t() { _mm_storeu_ps(&x, _mm_setzero_ps()); }
+		vector3d_t(PFLOAT v) { _mm_storeu_ps(&x, _mm_setr_ps(v, v, v, 0.f)); }
+		vector3d_t(PFLOAT ix, PFLOAT iy, PFLOAT iz=0) { _mm_storeu_ps(&x, _mm_setr_ps(ix, iy, iz, 0.f)); }
+		vector3d_t(const vector3d_t &s) { _mm_storeu_ps(&x, s.vec()); }
+		explicit vector3d_t(__m128 v) { _mm_storeu_ps(&x, v); }
+		__m128 vec() const { return _mm_loadu_ps(&x); }
+#else
 		vector3d_t() { }
 		vector3d_t(PFLOAT v): x(v), y(v), z(v) {  }
 		vector3d_t(PFLOAT ix, PFLOAT iy, PFLOAT iz=0): x(ix), y(iy), z(iz) { }
 		vector3d_t(const vector3d_t &s): x(s.x), y(s.y), z(s.z) { }
+#endif
 		explicit vector3d_t(const normal_t &n);
 		explicit vector3d_t(const point3d_t &p);
 		
 		void set(PFLOAT ix, PFLOAT iy, PFLOAT iz=0) { x=ix;  y=iy;  z=iz; }
 		vector3d_t& normalize();
 		vector3d_t& reflect(const vector3d_t &n);
+#ifdef Y_SSE
+		// normalizes and returns length
+		PFLOAT normLen()
+		{
+			PFLOAT vl = sseDot3(vec(), vec());
+			if (vl!=0.0) {
+				vl = fSqrt(vl);
+				const PFLOAT d = 1.0/vl;
+				_mm_storeu_ps(&x, _mm_mul_ps(vec(), _mm_set1_ps(d)));
+			}
+			return vl;
+		}
+		// normalizes and returns length squared
+		PFLOAT normLenSqr()
+		{
+			PFLOAT vl = sseDot3(vec(), vec());
+			if (vl!=0.0) {
+				const PFLOAT d = 1.0/fSqrt(vl);
+				_mm_storeu_ps(&x, _mm_mul_ps(vec(), _mm_set1_ps(d)));
+			}
+			return vl;
+		}
+		PFLOAT length() const;
+		PFLOAT lengthSqr() const{ return sseDot3(vec(), vec()); }
+		bool null()const { return sseIsZero3(vec()); }
+		vector3d_t& operator = (const vector3d_t &s) { _mm_storeu_ps(&x, s.vec());  return *this;}
+		vector3d_t& operator +=(const vector3d_t &s) { _mm_storeu_ps(&x, _mm_add_ps(vec(), s.vec()));  return *this;}
+		vector3d_t& operator -=(const vector3d_t &s) { _mm_storeu_ps(&x, _mm_sub_ps(vec(), s.vec()));  return *this;}
+		vector3d_t& operator /=(PFLOAT s) { _mm_storeu_ps(&x, _mm_div_ps(vec(), _mm_set1_ps(s)));  return *this;}
+		vector3d_t& operator *=(PFLOAT s) { _mm_storeu_ps(&x, _mm_mul_ps(vec(), _mm_set1_ps(s)));  return *this;}
+		void abs() { _mm_storeu_ps(&x, sseAbs(vec())); }
+#else
 		// normalizes and returns length
 		PFLOAT normLen()
 		{
@@ -91,10 +133,14 @@ class YAFRAYCORE_EXPORT vector3d_t
 		vector3d_t& operator -=(const vector3d_t &s) { x-=s.x;  y-=s.y;  z-=s.z;  return *this;}
 		vector3d_t& operator /=(PFLOAT s) { x/=s;  y/=s;  z/=s;  return *this;}
 		vector3d_t& operator *=(PFLOAT s) { x*=s;  y*=s;  z*=s;  return *this;}
-		PFLOAT operator[] (int i) const{ return (&x)[i]; } //Lynx
 		void abs() { x=std::fabs(x);  y=std::fabs(y);  z=std::fabs(z); }
+#endif
+		PFLOAT operator[] (int i) const{ return (&x)[i]; } //Lynx
 		~vector3d_t() {};
 		PFLOAT x,y,z;
+#ifdef Y_SSE
+		PFLOAT w; //!< padding to 4 floats, 0 for vectors built from components
+#endif
 };
 
 class YAFRAYCORE_EXPORT normal_t
@@ -128,8 +174,13 @@ class YAFRAYCORE_EXPORT point3d_t
 };
 
 
+#ifdef Y_SSE
+inline vector3d_t::vector3d_t(const normal_t &n) { _mm_storeu_ps(&x, _mm_setr_ps(n.x, n.y, n.z, 0.f)); }
+inline vector3d_t::vector3d_t(const point3d_t &p) { _mm_storeu_ps(&x, _mm_setr_ps(p.x, p.y, p.z, 0.f)); }
+#else
 inline vector3d_t::vector3d_t(const normal_t &n): x(n.x), y(n.y), z(n.z) { }
 inline vector3d_t::vector3d_t(const point3d_t &p): x(p.x), y(p.y), z(p.z) { }
+#endif
 
 #define FAST_ANGLE(a,b)  ( (a).x*(b).y - (a).y*(b).x )
 #define FAST_SANGLE(a,b) ( (((a).x*(b).y - (a).y*(b).x) >= 0) ? 0 : 1 )
@@ -138,39 +189,73 @@ inline vector3d_t::vector3d_t(const point3d_t &p): x(p.x), y(p.y), z(p.z) { }
 YAFRAYCORE_EXPORT std::ostream & operator << (std::ostream &out,const vector3d_t &v);
 YAFRAYCORE_EXPORT std::ostream & operator << (std::ostream &out,const point3d_t &p);
 
+#ifdef Y_SSE
+
 inline PFLOAT operator * ( const vector3d_t &a,const vector3d_t &b)
 {
-	return (a.x*b.x+a.y*b.y+a.z*b.z);
+	return sseDot3(a.vec(), b.vec());
 }
 
 inline vector3d_t operator * ( PFLOAT f,const vector3d_t &b)
 {
-	return vector3d_t(f*b.x,f*b.y,f*b.z);
+	return vector3d_t(_mm_mul_ps(_mm_set1_ps(f), b.vec()));
 }
 
 inline vector3d_t operator * (const vector3d_t &b,PFLOAT f)
 {
-	return vector3d_t(f*b.x,f*b.y,f*b.z);
+	return vector3d_t(_mm_mul_ps(_mm_set1_ps(f), b.vec()));
 }
 
-inline point3d_t operator * (PFLOAT f,const point3d_t &b)
+inline vector3d_t operator / (const vector3d_t &b,PFLOAT f)
 {
-	return point3d_t(f*b.x,f*b.y,f*b.z);
+	return vector3d_t(_mm_div_ps(b.vec(), _mm_set1_ps(f)));
 }
 
-inline vector3d_t operator / (const vector3d_t &b,PFLOAT f)
+inline vector3d_t operator / (PFLOAT f,const vector3d_t &b)
 {
-	return vector3d_t(b.x/f,b.y/f,b.z/f);
+	return vector3d_t(_mm_div_ps(b.vec(), _mm_set1_ps(f)));
 }
 
-inline point3d_t operator / (const point3d_t &b,PFLOAT f)
+inline vector3d_t operator ^ ( const vector3d_t &a,const vector3d_t &b)
 {
-	return point3d_t(b.x/f,b.y/f,b.z/f);
+	return vector3d_t(sseCross(a.vec(), b.vec()));
 }
 
-inline point3d_t operator * (const point3d_t &b,PFLOAT f)
+inline vector3d_t  operator - ( const vector3d_t &a,const vector3d_t &b)
 {
-	return point3d_t(b.x*f,b.y*f,b.z*f);
+	return vector3d_t(_mm_sub_ps(a.vec(), b.vec()));
+}
+
+inline vector3d_t  operator - ( const vector3d_t &b)
+{
+	return vector3d_t(sseNeg(b.vec()));
+}
+
+inline vector3d_t  operator + ( const vector3d_t &a,const vector3d_t &b)
+{
+	return vector3d_t(_mm_add_ps(a.vec(), b.vec()));
+}
+
+#else // Y_SSE
+
+inline PFLOAT operator * ( const vector3d_t &a,const vector3d_t &b)
+{
+	return (a.x*b.x+a.y*b.y+a.z*b.z);
+}
+
+inline vector3d_t operator * ( PFLOAT f,const vector3d_t &b)
+{
+	return vector3d_t(f*b.x,f*b.y,f*b.z);
+}
+
+inline vector3d_t operator * (const vector3d_t &b,PFLOAT f)
+{
+	return vector3d_t(f*b.x,f*b.y,f*b.z);
+}
+
+inline vector3d_t operator / (const vector3d_t &b,PFLOAT f)
+{
+	return vector3d_t(b.x/f,b.y/f,b.z/f);
 }
 
 inline vector3d_t operator / (PFLOAT f,const vector3d_t &b)
@@ -188,24 +273,41 @@ inline vector3d_t  operator - ( const vector3d_t &a,const vector3d_t &b)
 	return vector3d_t(a.x-b.x,a.y-b.y,a.z-b.z);
 }
 
-inline vector3d_t  operator - ( const point3d_t &a,const point3d_t &b)
+inline vector3d_t  operator - ( const vector3d_t &b)
 {
-	return vector3d_t(a.x-b.x,a.y-b.y,a.z-b.z);
+	return vector3d_t(-b.x,-b.y,-b.z);
 }
 
-inline point3d_t  operator - ( const point3d_t &a,const vector3d_t &b)
+inline vector3d_t  operator + ( const vector3d_t &a,const vector3d_t &b)
 {
-	return point3d_t(a.x-b.x,a.y-b.y,a.z-b.z);
+	return vector3d_t(a.x+b.x,a.y+b.y,a.z+b.z);
 }
 
-inline vector3d_t  operator - ( const vector3d_t &b)
+#endif // Y_SSE
+
+inline point3d_t operator * (PFLOAT f,const point3d_t &b)
 {
-	return vector3d_t(-b.x,-b.y,-b.z);
+	return point3d_t(f*b.x,f*b.y,f*b.z);
 }
 
-inline vector3d_t  operator + ( const vector3d_t &a,const vector3d_t &b)
+inline point3d_t operator / (const point3d_t &b,PFLOAT f)
 {
-	return vector3d_t(a.x+b.x,a.y+b.y,a.z+b.z);
+	return point3d_t(b.x/f,b.y/f,b.z/f);
+}
+
+inline point3d_t operator * (const point3d_t &b,PFLOAT f)
+{
+	return point3d_t(b.x*f,b.y*f,b.z*f);
+}
+
+inline vector3d_t  operator - ( const point3d_t &a,const point3d_t &b)
+{
+	return vector3d_t(a.x-b.x,a.y-b.y,a.z-b.z);
+}
+
+inline point3d_t  operator - ( const point3d_t &a,const vector3d_t &b)
+{
+	return point3d_t(a.x-b.x,a.y-b.y,a.z-b.z);
 }
 
 inline point3d_t  operator + ( const point3d_t &a,const point3d_t &b)
@@ -233,18 +335,16 @@ inline point3d_t mult(const point3d_t &a, const vector3d_t &b)
 
 inline PFLOAT vector3d_t::length()const
 {
-	return fSqrt(x*x+y*y+z*z);
+	return fSqrt(lengthSqr());
 }
 
 inline vector3d_t& vector3d_t::normalize()
 {
-	PFLOAT len = x*x + y*y + z*z;
+	PFLOAT len = lengthSqr();
 	if (len!=0)
 	{
 		len = 1.0/fSqrt(len);
-		x *= len;
-		y *= len;
-		z *= len;
+		(*this) *= len;
 	}
 	return *this;
 }
@@ -257,10 +357,8 @@ inline vector3d_t& vector3d_t::normalize()
  */
 inline vector3d_t& vector3d_t::reflect(const vector3d_t &n)
 {
-	const float vn = 2.0f*(x*n.x+y*n.y+z*n.z);
-	x = vn*n.x -x;
-	y = vn*n.y -y;
-	z = vn*n.z -z;
+	const float vn = 2.0f*((*this)*n);
+	*this = vn*n - *this;
 	return *this;
 }
 
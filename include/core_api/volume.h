@@ -1,11 +1,12 @@
 #ifndef Y_VOLUMETRIC_H
 #define Y_VOLUMETRIC_H
 
-#include <map>
+#include <vector>
 
 #include "ray.h"
 #include "color.h"
 #include <core_api/bound.h>
+#include <yafraycore/ccthreads.h>
 
 __BEGIN_YAFRAY
 
@@ -21,9 +22,18 @@ class volumeHandler_t
 		virtual bool scatter(const renderState_t &state, const ray_t &ray, ray_t &sRay, pSample_t &s) const=0;
 };
 
+/*! Computes the transmittance from a point towards a light, used to fill (or lazily refine)
+	the attenuation grids of volume regions. Must be safe to call from several threads at once. */
+class attenuationSampler_t
+{
+	public:
+		virtual ~attenuationSampler_t() {}
+		virtual float lightTransmittance(const point3d_t &p, int light) const = 0;
+};
+
 class YAFRAYCORE_EXPORT VolumeRegion {
 	public:
-	VolumeRegion() {}
+	VolumeRegion(): attGridX(8), attGridY(8), attGridZ(8), haveEmptySpaceInfo(false), attHalf(false), nAttLights(0), attSampler(0) {}
 	VolumeRegion(color_t sa, color_t ss, color_t le, float gg, point3d_t pmin, point3d_t pmax, int attgridScale) {
 		bBox = bound_t(pmin, pmax);
 		s_a = sa;
@@ -36,6 +46,10 @@ class YAFRAYCORE_EXPORT VolumeRegion {
 		attGridX = 8 * attgridScale;
 		attGridY = 8 * attgridScale;
 		attGridZ = 8 * attgridScale;
+		attHalf = false;
+		attSampler = 0;
+		nAttLights = 0;
+		haveEmptySpaceInfo = false;
 	}
 	
 	virtual ~VolumeRegion(){}
@@ -47,7 +61,19 @@ class YAFRAYCORE_EXPORT VolumeRegion {
 		return sigma_a(p, v) + sigma_s(p, v);
 	}
 
-	float attenuation(const point3d_t p, light_t *l);
+	/*! Trilinear lookup of the precomputed transmittance from p towards light number \a light
+		(the index in the light list passed to the attenuation sampler). */
+	float attenuation(const point3d_t p, int light);
+
+	/*! Allocates the attenuation grids of \a nLights lights in one contiguous block.
+		\param halfPrecision store grid values as 16 bit floats
+		\param lazySampler if not NULL, only the coarse brick corner grid has to be filled upfront,
+		fine bricks get built on their first lookup (interpolated from the corners where these agree) */
+	void initAttenuationGrids(int nLights, bool halfPrecision, const attenuationSampler_t *lazySampler = 0);
+	//! number of z-slices that have to be filled by fillAttenuationSlice() for each light
+	int attenuationSlices() const;
+	//! fill z-slice \a z of the grid of \a light (the coarse grid in lazy mode)
+	void fillAttenuationSlice(const attenuationSampler_t &sampler, int light, int z);
 	
 	// w_l: dir *from* the light, w_s: direction, into which should be scattered
 	virtual float p(const vector3d_t &w_l, const vector3d_t &w_s) {
@@ -58,20 +84,46 @@ class YAFRAYCORE_EXPORT VolumeRegion {
 	
 	virtual color_t tau(const ray_t &ray, float step, float offset) = 0;
 	
+	/*! Empty space skipping: returns the ray distance up to which the region is known to have
+		no density when starting at distance t, i.e. t itself if nothing is known about the space there.
+		The default skips everything in front of and behind the bounding box. */
+	virtual float skipEmpty(const ray_t &ray, float t, float tMax);
+
 	bool intersect(const ray_t &ray, float& t0, float& t1) {
 		return bBox.cross(ray, t0, t1, 10000.f);
 	}
 
 	bound_t getBB() { return bBox; }
 
-	std::map<light_t *, float*> attenuationGridMap;
 	int attGridX, attGridY, attGridZ; // FIXME: un-hardcode
 
 	protected:
+	//! world position of the center of attenuation grid voxel (x, y, z)
+	point3d_t attGridPoint(int x, int y, int z) const;
+	float attValue(int idx) const;
+	void setAttValue(int idx, float val);
+	void buildAttBrick(int light, int bx, int by, int bz);
+	void checkAttBrick(int light, int x, int y, int z);
+
 	bound_t bBox;
 	color_t s_a, s_s, l_e;
 	bool haveS_a, haveS_s, haveL_e;
+	bool haveEmptySpaceInfo; //!< skipEmpty() knows about empty space inside the bounding box
 	float g;
+
+	// attenuation grids of all lights, light i starts at i * attGridX * attGridY * attGridZ
+	std::vector<float> attGrid;
+	std::vector<unsigned short> attGridHalf;
+	bool attHalf;
+	int nAttLights;
+	// lazy coarse-to-fine mode
+	const attenuationSampler_t *attSampler;
+	std::vector<float> attCoarse; //!< brick corner values, (attBricksX+1) * (attBricksY+1) * (attBricksZ+1) per light
+	std::vector<int> attBrickReady; //!< only accessed with yafthreads::atomicLoadAcquire/atomicStoreRelease
+	int attBricksX, attBricksY, attBricksZ;
+	//! bricks are built under attMutex[brick % attLocks], so threads only wait for builds of the same brick stripe
+	static const int attLocks = 64;
+	yafthreads::mutex_t attMutex[attLocks];
 	// TODO: add transform for BB
 };
 
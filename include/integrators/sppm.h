@@ -69,9 +69,12 @@ class YAFRAYPLUGIN_EXPORT SPPM: public mcIntegrator_t
 		/*! based on integrate method to do the gatering trace, need double-check deadly. */
 		GatherInfo traceGatherRay(renderState_t &state, diffRay_t &ray, HitPoint &hp);
 	protected:
+		//! per-pixel statistics, photon count and photon sequence state that the next passes build on
+		virtual void saveCheckpointState(checkpoint_t &cp) const;
+		virtual bool loadCheckpointState(checkpoint_t &cp);
 		hashGrid_t  photonGrid; // the hashgrid for holding photons
 		photonMap_t diffuseMap,causticMap; // photonmap
-		pdf1D_t *lightPowerD;
+		aliasPdf1D_t *lightPowerD;
 		unsigned int nPhotons; //photon number to scatter
 		float dsRadius; // used to do initial radius estimate
 		int nSearch;// now used to do initial radius estimate
@@ -23,6 +23,7 @@ class YAFRAYPLUGIN_EXPORT xmlInterface_t: public yafrayInterface_t
 		virtual bool startCurveMesh(unsigned int id, int vertices);
 		virtual bool endTriMesh();
 		virtual bool addInstance(unsigned int baseObjectId, matrix4x4_t objToWorld);
+		virtual bool addInstance(unsigned int baseObjectId, matrix4x4_t objToWorld, matrix4x4_t objToWorldEnd);
 		virtual bool endCurveMesh(const material_t *mat, float strandStart, float strandEnd, float strandShape);
 		virtual int  addVertex(double x, double y, double z); //!< add vertex to mesh; returns index to be used for addTriangle
 		virtual int  addVertex(double x, double y, double z, double ox, double oy, double oz); //!< add vertex with Orco to mesh; returns index to be used for addTriangle
@@ -42,7 +42,7 @@ class YAFRAYPLUGIN_EXPORT yafrayInterface_t
 		*/
 		virtual unsigned int getNextFreeID();
 		virtual bool startTriMesh(unsigned int id, int vertices, int triangles, bool hasOrco, bool hasUV=false, int type=0);
-		virtual bool startCurveMesh(unsigned int id, int vertices);
+		virtual bool startCurveMesh(unsigned int id, int vertices); //!< start a strand of curve mesh id; use one ID for all strands of a mesh to instance it
 		virtual bool startTriMeshPtr(unsigned int *id, int vertices, int triangles, bool hasOrco, bool hasUV=false, int type=0);
 		virtual bool endTriMesh(); //!< end current mesh and return to geometry state
 		virtual bool endCurveMesh(const material_t *mat, float strandStart, float strandEnd, float strandShape); //!< end current mesh and return to geometry state
@@ -52,8 +52,9 @@ class YAFRAYPLUGIN_EXPORT yafrayInterface_t
 		virtual bool addTriangle(int a, int b, int c, const material_t *mat); //!< add a triangle given vertex indices and material pointer
 		virtual bool addTriangle(int a, int b, int c, int uv_a, int uv_b, int uv_c, const material_t *mat); //!< add a triangle given vertex and uv indices and material pointer
 		virtual int  addUV(float u, float v); //!< add a UV coordinate pair; returns index to be used for addTriangle
-		virtual bool smoothMesh(unsigned int id, double angle); //!< smooth vertex normals of mesh with given ID and angle (in degrees)
+		virtual bool smoothMesh(unsigned int id, double angle); //!< smooth vertex normals of mesh with given ID and angle (in degrees); no-op for curve meshes
 		virtual bool addInstance(unsigned int baseObjectId, matrix4x4_t objToWorld);
+		virtual bool addInstance(unsigned int baseObjectId, matrix4x4_t objToWorld, matrix4x4_t objToWorldEnd); //!< instance moving from objToWorld to objToWorldEnd during the frame
 		// functions to build paramMaps instead of passing them from Blender
 		// (decouling implementation details of STL containers, paraMap_t etc. as much as possible)
 		virtual void paramsSetPoint(const char* name, double x, double y, double z);
@@ -88,6 +89,7 @@ class YAFRAYPLUGIN_EXPORT yafrayInterface_t
 		virtual void abort();
 		virtual paraMap_t* getRenderParameters() { return params; }
 		virtual bool getRenderedImage(colorOutput_t &output); //!< put the rendered image to output
+		virtual bool getCostMap(colorOutput_t &output, bool falseColor = true); //!< put the per pixel cost map to output, needs the "cost_map" render parameter
 		virtual std::vector<std::string> listImageHandlers();
 		virtual std::vector<std::string> listImageHandlersFullName();
 		virtual std::string getImageFormatFromFullName(const std::string &fullname);
@@ -102,6 +104,11 @@ class YAFRAYPLUGIN_EXPORT yafrayInterface_t
 		virtual void setDrawParams(bool on = true);
 		virtual bool getDrawParams();
 
+		virtual void setRenderStats(bool on = true); //!< count rays, kd-tree work and material evaluations of the following renders
+		virtual std::string getRenderStats(); //!< statistics of the last render as JSON object
+		virtual void setRenderTrace(bool on = true); //!< record a timeline of tiles, passes and preprocess phases of the following renders
+		virtual bool saveRenderTrace(const char *fileName); //!< write the timeline of the last render in Chrome trace format
+
 		virtual char* getVersion() const; //!< Get version to check aginst the exporters
 		
 		/*! Console Printing wrappers to report in color with yafaray's own console coloring */
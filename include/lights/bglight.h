@@ -27,12 +27,12 @@
 __BEGIN_YAFRAY
 
 class background_t;
-class pdf1D_t;
+class aliasPdf1D_t;
 
 class bgLight_t : public light_t
 {
 	public:
-		bgLight_t(int sampl, bool shootC = true, bool shootD = true, bool invertIntersect = false);
+		bgLight_t(int sampl, bool shootC = true, bool shootD = true, bool invertIntersect = false, bool resFromBg = false);
 		virtual ~bgLight_t();
 		virtual void init(scene_t &scene);
 		virtual color_t totalEnergy() const;
@@ -55,7 +55,7 @@ class bgLight_t : public light_t
 		float dir_pdf(const vector3d_t dir) const;
 		float CalcFromSample(float s1, float s2, float &u, float &v, bool inv = false) const;
 		float CalcFromDir(const vector3d_t &dir, float &u, float &v, bool inv = false) const;
-		pdf1D_t **uDist, *vDist;
+		aliasPdf1D_t **uDist, *vDist;
 		int samples;
 		point3d_t worldCenter;
 		float worldRadius;
@@ -64,6 +64,7 @@ class bgLight_t : public light_t
 		bool shootCaustic;
 		bool shootDiffuse;
 		bool absInter;
+		bool resFromBackground; //!< size the sampling tables after background_t::resolution()
 };
 
 __END_YAFRAY
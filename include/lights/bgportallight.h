@@ -27,7 +27,7 @@ __BEGIN_YAFRAY
 
 class triangleObject_t;
 class triangle_t;
-class pdf1D_t;
+class aliasPdf1D_t;
 class paraMap_t;
 class renderEnvironment_t;
 class triKdTree_t;
@@ -59,7 +59,7 @@ class bgPortalLight_t : public light_t
 		void initIS();
 		void sampleSurface(point3d_t &p, vector3d_t &n, float u, float v) const;
 		unsigned int objID;
-		pdf1D_t *areaDist;
+		aliasPdf1D_t *areaDist;
 		const triangle_t **tris;
 		int samples;
 		int nTris; //!< gives the array size of uDist
@@ -27,7 +27,7 @@ __BEGIN_YAFRAY
 
 class triangleObject_t;
 class triangle_t;
-class pdf1D_t;
+class aliasPdf1D_t;
 class paraMap_t;
 class renderEnvironment_t;
 class triKdTree_t;
@@ -57,7 +57,7 @@ class meshLight_t : public light_t
 		unsigned int objID;
 		bool doubleSided;
 		color_t color;
-		pdf1D_t *areaDist;
+		aliasPdf1D_t *areaDist;
 		const triangle_t **tris;
 		int samples;
 		int nTris; //!< gives the array size of uDist
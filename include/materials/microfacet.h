@@ -25,7 +25,8 @@ inline void sample_quadrant_aniso(vector3d_t &H, float s1, float s2, float e_u,
 	float cosPhi2 = cosPhi*cosPhi;
 	float sinPhi2 = 1.f - cosPhi2;
 	
-	cosTheta = fPow(1.f - s2, 1.f / (e_u*cosPhi2 + e_v*sinPhi2 + 1.f));
+	// the exponent is below 1 here, where the approximation is good to ~1e-4 (see yafaray-mathbench)
+	cosTheta = std::min(1.f, fastPow(1.f - s2, 1.f / (e_u*cosPhi2 + e_v*sinPhi2 + 1.f)));
 	sinTheta = fSqrt(1.f - cosTheta*cosTheta);
 	sinPhi = fSqrt(sinPhi2);
 	
@@ -68,6 +69,7 @@ inline void AS_Aniso_Sample(vector3d_t &H, float s1, float s2, float e_u, float
 	}
 }
 
+// the pow() error grows with the exponent, so the distributions themselves stay with fPow
 inline float Blinn_D(float cos_h, float e)
 {
 	return (e + 1.f) * fPow(std::max(0.f, cos_h), e);
@@ -81,7 +83,7 @@ inline float Blinn_Pdf(float costheta, float cos_w_H, float e)
 inline void Blinn_Sample(vector3d_t &H, float s1, float s2, float exponent)
 {
 	// Compute sampled half-angle vector H for Blinn distribution
-	float cosTheta = fPow(s2, 1.f / (exponent + 1.f));
+	float cosTheta = std::min(1.f, fastPow(s2, 1.f / (exponent + 1.f)));
 	float sinTheta = fSqrt(1.f - cosTheta*cosTheta);
 	float phi = s1 * M_2PI;
 	H = vector3d_t(sinTheta*fCos(phi), sinTheta*fSin(phi), cosTheta);
@@ -67,6 +67,7 @@ class shinyDiffuseMat_t: public nodeMaterial_t
         shaderNode_t *mTranslucencyShader;  //!< Shader node for translucency strength (float)
         shaderNode_t *mMirrorShader;        //!< Shader node for specular reflection strength (float)
         shaderNode_t *mMirrorColorShader;   //!< Shader node for specular reflection color
+        nodeProgram_t progTransparency;     //!< evaluates the nodes getTransparency() reads
 
         color_t mDiffuseColor;              //!< BSDF Diffuse component color
         color_t mEmitColor;                 //!< Emit color
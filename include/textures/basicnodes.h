@@ -45,6 +45,7 @@ class valueNode_t: public shaderNode_t
 		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const;
 		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp, const vector3d_t &wo, const vector3d_t &wi)const;
 		virtual bool configInputs(const paraMap_t &params, const nodeFinder_t &find) { return true; };
+		virtual bool isConstant() const { return true; }
 		static shaderNode_t* factory(const paraMap_t &params,renderEnvironment_t &render);
 	protected:
 		colorA_t color;
@@ -54,47 +55,18 @@ class valueNode_t: public shaderNode_t
 class mixNode_t: public shaderNode_t
 {
 	public:
-		mixNode_t();
-		mixNode_t(float val);
+		mixNode_t(mix_modes mode, float val);
 		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const;
 		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp, const vector3d_t &wo, const vector3d_t &wi)const;
 		virtual bool configInputs(const paraMap_t &params, const nodeFinder_t &find);
 		virtual bool getDependencies(std::vector<const shaderNode_t*> &dep) const;
+		virtual bool isConstant() const { return true; }
+		virtual bool getOp(nodeOp_t &o) const { o = op; return true; }
 		static shaderNode_t* factory(const paraMap_t &params,renderEnvironment_t &render);
 	protected:
-		void getInputs(nodeStack_t &stack, colorA_t &cin1, colorA_t &cin2, CFLOAT &fin1, CFLOAT &fin2, CFLOAT &f2) const;
-		colorA_t col1, col2;
-		float val1, val2, cfactor;
-		const shaderNode_t *input1;
-		const shaderNode_t *input2;
-		const shaderNode_t *factor;
+		nodeOp_t op; //!< inputs input1, input2 and factor, with color1, color2 and value for unconnected ones
 };
 
-inline void mixNode_t::getInputs(nodeStack_t &stack, colorA_t &cin1, colorA_t &cin2, CFLOAT &fin1, CFLOAT &fin2, CFLOAT &f2) const
-{
-	f2 = (factor) ? factor->getScalar(stack) : cfactor;
-	if(input1)
-	{
-		cin1 = input1->getColor(stack);
-		fin1 = input1->getScalar(stack);
-	}
-	else
-	{
-		cin1 = col1;
-		fin1 = val1;
-	}
-	if(input2)
-	{
-		cin2 = input2->getColor(stack);
-		fin2 = input2->getScalar(stack);
-	}
-	else
-	{
-		cin2 = col2;
-		fin2 = val2;
-	}
-}
-
 
 __END_YAFRAY
 
@@ -27,6 +27,7 @@
 #include <core_api/environment.h>
 #include <core_api/imagehandler.h>
 #include <utilities/interpolation.h>
+#include <yafraycore/ccthreads.h>
 
 __BEGIN_YAFRAY
 
@@ -60,6 +61,11 @@ class textureImage_t : public texture_t
 		virtual colorA_t getNoGammaColor(int x, int y, int z) const;
 		virtual void resolution(int &x, int &y, int &z) const;
 		static texture_t *factory(paraMap_t &params,renderEnvironment_t &render);
+		//! reads the image file into the image handler, the texture is black until this succeeded
+		bool loadImage(const std::string &fileName);
+		/*! true when the image was decoded successfully; while the decode is still running on the
+			scene's load queue this blocks until it is done, so it is safe to call during parsing */
+		bool isLoaded() const;
 
 	protected:
 		void setCrop(float minx, float miny, float maxx, float maxy);
@@ -75,6 +81,9 @@ class textureImage_t : public texture_t
 		imageHandler_t *image;
 		interpolationType intp_type;
 		float gamma;
+		enum { LOAD_PENDING = 0, LOAD_OK, LOAD_FAILED };
+		volatile int loadState; //!< written once by loadImage() with release semantics, see isLoaded()
+		mutable yafthreads::conditionVar_t loadCond;
 };
 
 /*static inline colorA_t cubicInterpolate(const colorA_t &c1, const colorA_t &c2,
@@ -0,0 +1,93 @@
+/****************************************************************************
+ *
+ *      halfFloat.h: 16 bit IEEE 754 floating point storage helpers
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef Y_HALFFLOAT_H
+#define Y_HALFFLOAT_H
+
+#include <yafray_config.h>
+
+__BEGIN_YAFRAY
+
+/*! Half precision values are only meant for compact storage of large float
+	tables (attenuation and density grids...), all arithmetic is done on floats.
+	Conversion rounds to nearest, overflows clamp to infinity and denormals are kept. */
+
+typedef unsigned short half_t;
+
+union halfBits_t
+{
+	unsigned int i;
+	float f;
+};
+
+inline half_t floatToHalf(float val)
+{
+	halfBits_t v;
+	v.f = val;
+	unsigned int sign = (v.i >> 16) & 0x8000;
+	unsigned int absBits = v.i & 0x7FFFFFFF;
+
+	if(absBits >= 0x47800000) // overflow, inf or NaN
+	{
+		if(absBits > 0x7F800000) return (half_t)(sign | 0x7E00);
+		return (half_t)(sign | 0x7C00);
+	}
+	if(absBits < 0x38800000) // denormal half or zero
+	{
+		if(absBits < 0x33000000) return (half_t)sign;
+		unsigned int exp = absBits >> 23;
+		unsigned int mant = (absBits & 0x7FFFFF) | 0x800000;
+		unsigned int shift = 126 - exp;
+		unsigned int res = mant >> shift;
+		unsigned int rem = mant & ((1 << shift) - 1);
+		unsigned int halfway = 1 << (shift - 1);
+		if(rem > halfway || (rem == halfway && (res & 1))) ++res;
+		return (half_t)(sign | res);
+	}
+	// normalized, rebias exponent and round mantissa to nearest even
+	unsigned int res = (absBits - 0x38000000) >> 13;
+	unsigned int rem = absBits & 0x1FFF;
+	if(rem > 0x1000 || (rem == 0x1000 && (res & 1))) ++res;
+	return (half_t)(sign | res);
+}
+
+inline float halfToFloat(half_t h)
+{
+	halfBits_t v;
+	unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+	unsigned int exp = (h >> 10) & 0x1F;
+	unsigned int mant = h & 0x3FF;
+
+	if(exp == 0)
+	{
+		// zero or denormal: value is mant * 2^-24
+		v.f = (float)mant * 5.9604644775390625e-8f;
+		v.i |= sign;
+		return v.f;
+	}
+	if(exp == 31) v.i = sign | 0x7F800000 | (mant << 13);
+	else v.i = sign | ((exp + 112) << 23) | (mant << 13);
+	return v.f;
+}
+
+__END_YAFRAY
+
+#endif // Y_HALFFLOAT_H
@@ -87,6 +87,15 @@ public:
 		for(int i = 0; i < width; i++) data[i].resize(height);
 	}
 
+	//! resets the elements in [x0,x1) x [y0,y1) and leaves the rest as it is
+	inline void clearArea(int x0, int y0, int x1, int y1)
+	{
+		for(int i = x0; i < x1; i++)
+		{
+			for(int j = y0; j < y1; j++) data[i][j] = T();
+		}
+	}
+
 	inline T &operator()(int x, int y)
 	{
 		return data[x][y];
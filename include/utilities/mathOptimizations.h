@@ -132,6 +132,31 @@ inline float iSqrt(float x)
     return a.f*(1.5f - xhalf*a.f*a.f);
 }
 
+/*! Approximations that are used regardless of FAST_MATH/FAST_TRIG, for call sites that know the
+	error is acceptable; the f* functions below follow the global options. Accuracy and speed of
+	all approximations can be checked with the yafaray-mathbench program. */
+inline float fastPow(float a, float b) { return fExp2(fLog2(a) * b); }
+inline float fastLog(float a) { return fLog2(a) * (float)M_LN2; }
+inline float fastExp(float a) { return fExp2((float)M_LOG2E * a); }
+
+inline float fastSin(float x)
+{
+	if(x > M_2PI || x < -M_2PI) x -= ((int)(x * (float)M_1_2PI)) * (float)M_2PI; //float modulo x % M_2PI
+	if(x < -M_PI)
+	{
+		x += (float)M_2PI;
+	}
+	else if(x > M_PI)
+	{
+		x -= (float)M_2PI;
+	}
+
+	x = ((float)M_4_PI * x) - ((float)M_4_PI2 * x * std::fabs(x));
+	return CONST_P * (x * std::fabs(x) - x) + x;
+}
+
+inline float fastCos(float x) { return fastSin(x + (float)M_PI_2); }
+
 inline float fPow(float a, float b)
 {
 #ifdef FAST_MATH
@@ -192,19 +217,7 @@ inline float fLdexp(float x, int a)
 inline float fSin(float x)
 {
 #ifdef FAST_TRIG
-	if(x > M_2PI || x < -M_2PI) x -= ((int)(x * (float)M_1_2PI)) * (float)M_2PI; //float modulo x % M_2PI
-	if(x < -M_PI)
-	{
-		x += (float)M_2PI;
-	}
-	else if(x > M_PI)
-	{
-		x -= (float)M_2PI;
-	}
-
-	x = ((float)M_4_PI * x) - ((float)M_4_PI2 * x * std::fabs(x));
-	return CONST_P * (x * std::fabs(x) - x) + x;
-
+	return fastSin(x);
 #else
 	return sin(x);
 #endif
@@ -213,7 +226,7 @@ inline float fSin(float x)
 inline float fCos(float x)
 {
 #ifdef FAST_TRIG
-	return fSin(x + (float)M_PI_2);
+	return fastCos(x);
 #else
 	return cos(x);
 #endif
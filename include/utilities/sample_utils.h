@@ -4,6 +4,7 @@
 
 #include <core_api/ray.h>
 #include <algorithm>
+#include <vector>
 #include <string.h>
 
 __BEGIN_YAFRAY
@@ -123,6 +124,79 @@ class pdf1D_t
 	int count;
 };
 
+/*! pdf1D_t variant that samples in constant time using Walker's alias method (table built
+	with Vose's algorithm). func, integral etc. are the same as in pdf1D_t, but the mapping from
+	u to the sample differs: it is not monotonic, so 1D stratification of u is only kept within bins.
+*/
+
+class aliasPdf1D_t: public pdf1D_t
+{
+	public:
+	aliasPdf1D_t(float *f, int n): pdf1D_t(f, n)
+	{
+		prob = new float[n];
+		alias = new int[n];
+
+		// scaled probabilities, average is 1
+		std::vector<double> p(n);
+		std::vector<int> small, large;
+		for(int i=0; i<n; ++i)
+		{
+			p[i] = (integral > 0.f) ? (double)func[i] / (double)integral : 1.0;
+			if(p[i] < 1.0) small.push_back(i);
+			else large.push_back(i);
+		}
+		while(!small.empty() && !large.empty())
+		{
+			int s = small.back(); small.pop_back();
+			int l = large.back();
+			prob[s] = (float)p[s];
+			alias[s] = l;
+			p[l] = (p[l] + p[s]) - 1.0;
+			if(p[l] < 1.0)
+			{
+				large.pop_back();
+				small.push_back(l);
+			}
+		}
+		// leftovers are 1 up to rounding errors
+		for(unsigned int i=0; i<large.size(); ++i) { prob[large[i]] = 1.f; alias[large[i]] = large[i]; }
+		for(unsigned int i=0; i<small.size(); ++i) { prob[small[i]] = 1.f; alias[small[i]] = small[i]; }
+	}
+	~aliasPdf1D_t(){ delete[] prob; delete[] alias; }
+	float Sample(float u, float *pdf)const
+	{
+		float offs;
+		int index = DSample(u, pdf, &offs);
+		return index + offs;
+	}
+	/*! take a discrete sample in O(1).
+		\param remapped if not NULL, receives a new uniform sample in [0,1) derived from u */
+	int DSample(float u, float *pdf, float *remapped = 0)const
+	{
+		float x = u * count;
+		int i = std::max(0, std::min((int)x, count - 1));
+		float frac = x - i;
+		int index;
+		float rem;
+		if(frac < prob[i])
+		{
+			index = i;
+			rem = frac / prob[i];
+		}
+		else
+		{
+			index = alias[i];
+			rem = (frac - prob[i]) / (1.f - prob[i]);
+		}
+		if(pdf) *pdf = func[index] * invIntegral;
+		if(remapped) *remapped = std::max(0.f, std::min(rem, 0.99999994f));
+		return index;
+	}
+	float *prob; //!< probability to keep bin i instead of taking alias[i]
+	int *alias;
+};
+
 // rotate the coord-system D, U, V with minimum rotation so that D gets
 // mapped to D2, i.e. rotate around D^D2.
 // V is assumed to be D^U, accordingly V2 is D2^U2; all input vectors must be normalized!
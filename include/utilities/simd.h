@@ -0,0 +1,102 @@
+/****************************************************************************
+ *
+ *      simd.h: SSE helpers for the color and vector types
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef Y_SIMD_H
+#define Y_SIMD_H
+
+#include <yafray_config.h>
+
+//! defined when the compiler targets SSE2, which is always the case on x86-64
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define Y_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+//! defined when the compiler targets AVX2 (e.g. -mavx2 or -march=native), enables the 8 wide math
+#if defined(__AVX2__)
+#define Y_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+/*! The SIMD_MATH build option switches color_t and vector3d_t to a padded 4 float layout
+	processed with SSE; Y_SSE is defined when these code paths are active.
+	The padded types are loaded and stored unaligned: material user data and node stacks place
+	them at arbitrary offsets, and unaligned access to aligned data costs nothing on current CPUs. */
+#if defined(SIMD_MATH) && defined(Y_HAVE_SSE2)
+#define Y_SSE
+#endif
+
+#ifdef Y_HAVE_SSE2
+
+__BEGIN_YAFRAY
+
+//! all bits set in the first three lanes
+inline __m128 sseMask3()
+{
+	return _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+}
+
+//! first three lanes from a, fourth lane from b
+inline __m128 sseSelect3(__m128 a, __m128 b)
+{
+	const __m128 m = sseMask3();
+	return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+
+//! a.x*b.x + a.y*b.y + a.z*b.z, summed in the same order as the scalar code
+inline float sseDot3(__m128 a, __m128 b)
+{
+	__m128 p = _mm_mul_ps(a, b);
+	__m128 s = _mm_add_ss(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)));
+	s = _mm_add_ss(s, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2)));
+	return _mm_cvtss_f32(s);
+}
+
+inline __m128 sseCross(__m128 a, __m128 b)
+{
+	__m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 a_zxy = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+	__m128 b_zxy = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+	return _mm_sub_ps(_mm_mul_ps(a_yzx, b_zxy), _mm_mul_ps(a_zxy, b_yzx));
+}
+
+inline __m128 sseAbs(__m128 a)
+{
+	return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+}
+
+inline __m128 sseNeg(__m128 a)
+{
+	return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x80000000)));
+}
+
+//! true if the first three lanes compare equal to zero
+inline bool sseIsZero3(__m128 a)
+{
+	return (_mm_movemask_ps(_mm_cmpeq_ps(a, _mm_setzero_ps())) & 7) == 7;
+}
+
+__END_YAFRAY
+
+#endif // Y_HAVE_SSE2
+
+#endif // Y_SIMD_H
@@ -0,0 +1,276 @@
+/****************************************************************************
+ *
+ *      simdMath.h: 4 and 8 wide versions of the math approximations
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef Y_SIMDMATH_H
+#define Y_SIMDMATH_H
+
+#include <yafray_config.h>
+#include <utilities/mathOptimizations.h>
+#include <utilities/simd.h>
+#include <core_api/color.h>
+
+__BEGIN_YAFRAY
+
+/*! Precision requested by a call site: MATH_DEFAULT follows the FAST_MATH/FAST_TRIG build options,
+	MATH_FAST always uses the approximations of mathOptimizations.h and MATH_EXACT always uses libm. */
+enum mathPrecision_t { MATH_DEFAULT, MATH_FAST, MATH_EXACT };
+
+inline bool useFastMath(mathPrecision_t p)
+{
+#ifdef FAST_MATH
+	return p != MATH_EXACT;
+#else
+	return p == MATH_FAST;
+#endif
+}
+
+inline bool useFastTrig(mathPrecision_t p)
+{
+#ifdef FAST_TRIG
+	return p != MATH_EXACT;
+#else
+	return p == MATH_FAST;
+#endif
+}
+
+/* The vector versions use the same polynomials as the scalar approximations in
+	mathOptimizations.h, they differ from them only by rounding. */
+
+#ifdef Y_HAVE_SSE2
+
+inline __m128 fExp2_ps(__m128 x)
+{
+	x = _mm_min_ps(x, _mm_set1_ps(f_HI));
+	x = _mm_max_ps(x, _mm_set1_ps(f_LOW));
+
+	__m128i ipart = _mm_cvttps_epi32(_mm_sub_ps(x, _mm_set1_ps(0.5f)));
+	__m128 fpart = _mm_sub_ps(x, _mm_cvtepi32_ps(ipart));
+	__m128 expipart = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(ipart, _mm_set1_epi32(127)), 23));
+
+	__m128 p = _mm_add_ps(_mm_mul_ps(fpart, _mm_set1_ps(1.8775767e-3f)), _mm_set1_ps(8.9893397e-3f));
+	p = _mm_add_ps(_mm_mul_ps(fpart, p), _mm_set1_ps(5.5826318e-2f));
+	p = _mm_add_ps(_mm_mul_ps(fpart, p), _mm_set1_ps(2.4015361e-1f));
+	p = _mm_add_ps(_mm_mul_ps(fpart, p), _mm_set1_ps(6.9315308e-1f));
+	p = _mm_add_ps(_mm_mul_ps(fpart, p), _mm_set1_ps(9.9999994e-1f));
+
+	return _mm_mul_ps(expipart, p);
+}
+
+inline __m128 fLog2_ps(__m128 x)
+{
+	__m128i i = _mm_castps_si128(x);
+	__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(_mm_and_si128(i, _mm_set1_epi32(LOG_EXP)), 23), _mm_set1_epi32(127)));
+	__m128 one = _mm_set1_ps(1.f);
+	__m128 m = _mm_or_ps(_mm_castsi128_ps(_mm_and_si128(i, _mm_set1_epi32(LOG_MANT))), one);
+
+	__m128 p = _mm_add_ps(_mm_mul_ps(m, _mm_set1_ps(-3.4436006e-2f)), _mm_set1_ps(3.1821337e-1f));
+	p = _mm_add_ps(_mm_mul_ps(m, p), _mm_set1_ps(-1.2315303f));
+	p = _mm_add_ps(_mm_mul_ps(m, p), _mm_set1_ps(2.5988452f));
+	p = _mm_add_ps(_mm_mul_ps(m, p), _mm_set1_ps(-3.3241990f));
+	p = _mm_add_ps(_mm_mul_ps(m, p), _mm_set1_ps(3.1157899f));
+
+	return _mm_add_ps(_mm_mul_ps(p, _mm_sub_ps(m, one)), e);
+}
+
+inline __m128 fExp_ps(__m128 x) { return fExp2_ps(_mm_mul_ps(x, _mm_set1_ps((float)M_LOG2E))); }
+inline __m128 fLog_ps(__m128 x) { return _mm_mul_ps(fLog2_ps(x), _mm_set1_ps((float)M_LN2)); }
+inline __m128 fPow_ps(__m128 a, __m128 b) { return fExp2_ps(_mm_mul_ps(fLog2_ps(a), b)); }
+
+inline __m128 fSin_ps(__m128 x)
+{
+	const __m128 pi = _mm_set1_ps((float)M_PI);
+	const __m128 twoPi = _mm_set1_ps((float)M_2PI);
+	// x % 2pi, then shift into [-pi, pi]
+	x = _mm_sub_ps(x, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps((float)M_1_2PI)))), twoPi));
+	x = _mm_add_ps(x, _mm_and_ps(_mm_cmplt_ps(x, sseNeg(pi)), twoPi));
+	x = _mm_sub_ps(x, _mm_and_ps(_mm_cmpgt_ps(x, pi), twoPi));
+
+	x = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps((float)M_4_PI), x), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps((float)M_4_PI2), x), sseAbs(x)));
+	return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(CONST_P), _mm_sub_ps(_mm_mul_ps(x, sseAbs(x)), x)), x);
+}
+
+inline __m128 fCos_ps(__m128 x) { return fSin_ps(_mm_add_ps(x, _mm_set1_ps((float)M_PI_2))); }
+
+inline __m128 fAsin_ps(__m128 x)
+{
+	__m128 x2 = _mm_mul_ps(x, x);
+	__m128 p = _mm_add_ps(_mm_set1_ps(0.0303819444f), _mm_mul_ps(_mm_set1_ps(0.022372159f), x2));
+	p = _mm_add_ps(_mm_set1_ps(0.0446428571f), _mm_mul_ps(p, x2));
+	p = _mm_add_ps(_mm_set1_ps(0.075f), _mm_mul_ps(p, x2));
+	p = _mm_add_ps(_mm_set1_ps(0.166666667f), _mm_mul_ps(p, x2));
+	return _mm_add_ps(x, _mm_mul_ps(p, x2));
+}
+
+inline __m128 fAcos_ps(__m128 x) { return _mm_sub_ps(_mm_set1_ps((float)M_PI_2), fAsin_ps(x)); }
+
+#endif // Y_HAVE_SSE2
+
+#ifdef Y_HAVE_AVX2
+
+inline __m256 fExp2_ps256(__m256 x)
+{
+	x = _mm256_min_ps(x, _mm256_set1_ps(f_HI));
+	x = _mm256_max_ps(x, _mm256_set1_ps(f_LOW));
+
+	__m256i ipart = _mm256_cvttps_epi32(_mm256_sub_ps(x, _mm256_set1_ps(0.5f)));
+	__m256 fpart = _mm256_sub_ps(x, _mm256_cvtepi32_ps(ipart));
+	__m256 expipart = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(ipart, _mm256_set1_epi32(127)), 23));
+
+	__m256 p = _mm256_add_ps(_mm256_mul_ps(fpart, _mm256_set1_ps(1.8775767e-3f)), _mm256_set1_ps(8.9893397e-3f));
+	p = _mm256_add_ps(_mm256_mul_ps(fpart, p), _mm256_set1_ps(5.5826318e-2f));
+	p = _mm256_add_ps(_mm256_mul_ps(fpart, p), _mm256_set1_ps(2.4015361e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(fpart, p), _mm256_set1_ps(6.9315308e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(fpart, p), _mm256_set1_ps(9.9999994e-1f));
+
+	return _mm256_mul_ps(expipart, p);
+}
+
+inline __m256 fLog2_ps256(__m256 x)
+{
+	__m256i i = _mm256_castps_si256(x);
+	__m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(_mm256_and_si256(i, _mm256_set1_epi32(LOG_EXP)), 23), _mm256_set1_epi32(127)));
+	__m256 one = _mm256_set1_ps(1.f);
+	__m256 m = _mm256_or_ps(_mm256_castsi256_ps(_mm256_and_si256(i, _mm256_set1_epi32(LOG_MANT))), one);
+
+	__m256 p = _mm256_add_ps(_mm256_mul_ps(m, _mm256_set1_ps(-3.4436006e-2f)), _mm256_set1_ps(3.1821337e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(m, p), _mm256_set1_ps(-1.2315303f));
+	p = _mm256_add_ps(_mm256_mul_ps(m, p), _mm256_set1_ps(2.5988452f));
+	p = _mm256_add_ps(_mm256_mul_ps(m, p), _mm256_set1_ps(-3.3241990f));
+	p = _mm256_add_ps(_mm256_mul_ps(m, p), _mm256_set1_ps(3.1157899f));
+
+	return _mm256_add_ps(_mm256_mul_ps(p, _mm256_sub_ps(m, one)), e);
+}
+
+inline __m256 fExp_ps256(__m256 x) { return fExp2_ps256(_mm256_mul_ps(x, _mm256_set1_ps((float)M_LOG2E))); }
+inline __m256 fLog_ps256(__m256 x) { return _mm256_mul_ps(fLog2_ps256(x), _mm256_set1_ps((float)M_LN2)); }
+inline __m256 fPow_ps256(__m256 a, __m256 b) { return fExp2_ps256(_mm256_mul_ps(fLog2_ps256(a), b)); }
+
+inline __m256 fSin_ps256(__m256 x)
+{
+	const __m256 pi = _mm256_set1_ps((float)M_PI);
+	const __m256 twoPi = _mm256_set1_ps((float)M_2PI);
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+	x = _mm256_sub_ps(x, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps((float)M_1_2PI)))), twoPi));
+	x = _mm256_add_ps(x, _mm256_and_ps(_mm256_cmp_ps(x, _mm256_set1_ps(-(float)M_PI), _CMP_LT_OQ), twoPi));
+	x = _mm256_sub_ps(x, _mm256_and_ps(_mm256_cmp_ps(x, pi, _CMP_GT_OQ), twoPi));
+
+	x = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps((float)M_4_PI), x), _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps((float)M_4_PI2), x), _mm256_and_ps(x, absMask)));
+	return _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(CONST_P), _mm256_sub_ps(_mm256_mul_ps(x, _mm256_and_ps(x, absMask)), x)), x);
+}
+
+inline __m256 fCos_ps256(__m256 x) { return fSin_ps256(_mm256_add_ps(x, _mm256_set1_ps((float)M_PI_2))); }
+
+inline __m256 fAsin_ps256(__m256 x)
+{
+	__m256 x2 = _mm256_mul_ps(x, x);
+	__m256 p = _mm256_add_ps(_mm256_set1_ps(0.0303819444f), _mm256_mul_ps(_mm256_set1_ps(0.022372159f), x2));
+	p = _mm256_add_ps(_mm256_set1_ps(0.0446428571f), _mm256_mul_ps(p, x2));
+	p = _mm256_add_ps(_mm256_set1_ps(0.075f), _mm256_mul_ps(p, x2));
+	p = _mm256_add_ps(_mm256_set1_ps(0.166666667f), _mm256_mul_ps(p, x2));
+	return _mm256_add_ps(x, _mm256_mul_ps(p, x2));
+}
+
+inline __m256 fAcos_ps256(__m256 x) { return _mm256_sub_ps(_mm256_set1_ps((float)M_PI_2), fAsin_ps256(x)); }
+
+#endif // Y_HAVE_AVX2
+
+/*! Batched evaluation over arrays, using the widest vector code the build targets.
+	out may alias in. Lengths don't need to be multiples of the vector width. */
+
+#if defined(Y_HAVE_AVX2)
+#define Y_MATH_ARRAY_LOOP(FN, SCALAR) \
+	int i = 0; \
+	for(; i + 8 <= n; i += 8) _mm256_storeu_ps(out + i, FN##_ps256(_mm256_loadu_ps(in + i))); \
+	for(; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, FN##_ps(_mm_loadu_ps(in + i))); \
+	for(; i < n; ++i) out[i] = SCALAR(in[i]);
+#elif defined(Y_HAVE_SSE2)
+#define Y_MATH_ARRAY_LOOP(FN, SCALAR) \
+	int i = 0; \
+	for(; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, FN##_ps(_mm_loadu_ps(in + i))); \
+	for(; i < n; ++i) out[i] = SCALAR(in[i]);
+#else
+#define Y_MATH_ARRAY_LOOP(FN, SCALAR) \
+	for(int i = 0; i < n; ++i) out[i] = SCALAR(in[i]);
+#endif
+
+inline void expArray(float *out, const float *in, int n, mathPrecision_t prec = MATH_DEFAULT)
+{
+	if(!useFastMath(prec)) { for(int i = 0; i < n; ++i) out[i] = std::exp(in[i]); return; }
+	Y_MATH_ARRAY_LOOP(fExp, fastExp)
+}
+
+inline void logArray(float *out, const float *in, int n, mathPrecision_t prec = MATH_DEFAULT)
+{
+	if(!useFastMath(prec)) { for(int i = 0; i < n; ++i) out[i] = std::log(in[i]); return; }
+	Y_MATH_ARRAY_LOOP(fLog, fastLog)
+}
+
+inline void sinArray(float *out, const float *in, int n, mathPrecision_t prec = MATH_DEFAULT)
+{
+	if(!useFastTrig(prec)) { for(int i = 0; i < n; ++i) out[i] = std::sin(in[i]); return; }
+	Y_MATH_ARRAY_LOOP(fSin, fastSin)
+}
+
+inline void cosArray(float *out, const float *in, int n, mathPrecision_t prec = MATH_DEFAULT)
+{
+	if(!useFastTrig(prec)) { for(int i = 0; i < n; ++i) out[i] = std::cos(in[i]); return; }
+	Y_MATH_ARRAY_LOOP(fCos, fastCos)
+}
+
+//! fAcos has no global switch, MATH_DEFAULT means the approximation here as well
+inline void acosArray(float *out, const float *in, int n, mathPrecision_t prec = MATH_DEFAULT)
+{
+	if(prec == MATH_EXACT) { for(int i = 0; i < n; ++i) out[i] = std::acos(in[i]); return; }
+	Y_MATH_ARRAY_LOOP(fAcos, fAcos)
+}
+
+#undef Y_MATH_ARRAY_LOOP
+
+//! out[i] = pow(in[i], e)
+inline void powArray(float *out, const float *in, float e, int n, mathPrecision_t prec = MATH_DEFAULT)
+{
+	if(!useFastMath(prec)) { for(int i = 0; i < n; ++i) out[i] = std::pow(in[i], e); return; }
+	int i = 0;
+#ifdef Y_HAVE_AVX2
+	for(; i + 8 <= n; i += 8) _mm256_storeu_ps(out + i, fPow_ps256(_mm256_loadu_ps(in + i), _mm256_set1_ps(e)));
+#endif
+#ifdef Y_HAVE_SSE2
+	for(; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, fPow_ps(_mm_loadu_ps(in + i), _mm_set1_ps(e)));
+#endif
+	for(; i < n; ++i) out[i] = fastPow(in[i], e);
+}
+
+//! per channel exp() of a color, e.g. transmittance from optical thickness
+inline color_t colorExp(const color_t &c, mathPrecision_t prec = MATH_DEFAULT)
+{
+	if(!useFastMath(prec)) return color_t(std::exp(c.R), std::exp(c.G), std::exp(c.B));
+#ifdef Y_HAVE_SSE2
+	float r[4];
+	_mm_storeu_ps(r, fExp_ps(_mm_setr_ps(c.R, c.G, c.B, 0.f)));
+	return color_t(r[0], r[1], r[2]);
+#else
+	return color_t(fastExp(c.R), fastExp(c.G), fastExp(c.B));
+#endif
+}
+
+__END_YAFRAY
+
+#endif // Y_SIMDMATH_H
@@ -0,0 +1,130 @@
+/****************************************************************************
+ *
+ *      skyTable.h: precomputed radiance tables for analytic sky models
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef Y_SKYTABLE_H
+#define Y_SKYTABLE_H
+
+#include <yafray_config.h>
+
+#include <core_api/color.h>
+#include <core_api/vector3d.h>
+#include <yafraycore/ccthreads.h>
+#include <vector>
+#include <cmath>
+
+__BEGIN_YAFRAY
+
+//! analytic sky model that can be baked into a skyTable_t
+class skyFunction_t
+{
+	public:
+		virtual ~skyFunction_t() {}
+		//! has to be thread safe, it gets called from several threads while baking
+		virtual color_t skyRadiance(const vector3d_t &dir) const = 0;
+};
+
+/*! Sky radiance baked into a latitude-longitude map of res x res/2 texels,
+	looked up bilinearly. Row 0 starts at the zenith (+z), column 0 at phi = -pi.
+*/
+class skyTable_t
+{
+	public:
+		skyTable_t(): width(0), height(0) {}
+
+		bool ready() const { return width > 0; }
+
+		//! evaluates func at all texel centers, the rows are spread across nThreads threads
+		void bake(const skyFunction_t &func, int res, int nThreads)
+		{
+			width = 0;
+			int w = std::max(4, res);
+			int h = std::max(2, w / 2);
+			data.resize(w * h);
+
+			bakeJob_t job(func, &data[0], w, h);
+			yafthreads::runParallel(job, h, nThreads);
+
+			height = h;
+			width = w;
+		}
+
+		color_t lookup(const vector3d_t &dir) const
+		{
+			float len2 = dir.x * dir.x + dir.y * dir.y + dir.z * dir.z;
+			float cosTheta = (len2 > 0.f) ? dir.z * fISqrt(len2) : 1.f;
+			float phi = (dir.x == 0.f && dir.y == 0.f) ? 0.f : std::atan2(dir.y, dir.x);
+
+			float theta = std::acos(std::max(-1.f, std::min(1.f, cosTheta)));
+
+			float u = (phi * (float)M_1_2PI + 0.5f) * width - 0.5f;
+			float v = theta * (float)M_1_PI * height - 0.5f;
+
+			int u0 = (int)std::floor(u);
+			int v0 = (int)std::floor(v);
+			float du = u - u0;
+			float dv = v - v0;
+
+			// wrap around in longitude, clamp at the poles
+			int u1 = u0 + 1;
+			if(u0 < 0) u0 += width;
+			if(u1 >= width) u1 -= width;
+			int v1 = std::min(v0 + 1, height - 1);
+			if(v0 < 0) { v0 = 0; dv = 0.f; }
+
+			const color_t *r0 = &data[v0 * width];
+			const color_t *r1 = &data[v1 * width];
+
+			return (r0[u0] * (1.f - du) + r0[u1] * du) * (1.f - dv) + (r1[u0] * (1.f - du) + r1[u1] * du) * dv;
+		}
+
+		static vector3d_t texelDir(int x, int y, int w, int h)
+		{
+			float phi = (((float)x + 0.5f) / (float)w - 0.5f) * (float)M_2PI;
+			float theta = ((float)y + 0.5f) / (float)h * (float)M_PI;
+			float sinTheta = std::sin(theta);
+			return vector3d_t(sinTheta * std::cos(phi), sinTheta * std::sin(phi), std::cos(theta));
+		}
+
+	protected:
+		class bakeJob_t: public yafthreads::parallelJob_t
+		{
+			public:
+				bakeJob_t(const skyFunction_t &f, color_t *d, int w, int h): func(f), dst(d), width(w), height(h) {}
+				virtual void run(int start, int end)
+				{
+					for(int y = start; y < end; ++y)
+					{
+						for(int x = 0; x < width; ++x) dst[y * width + x] = func.skyRadiance(texelDir(x, y, width, height));
+					}
+				}
+			protected:
+				const skyFunction_t &func;
+				color_t *dst;
+				int width, height;
+		};
+
+		int width, height;
+		std::vector<color_t> data;
+};
+
+__END_YAFRAY
+
+#endif // Y_SKYTABLE_H
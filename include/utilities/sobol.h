@@ -0,0 +1,121 @@
+/****************************************************************************
+ *
+ *      sobol.h: scrambled Sobol sampling with random access
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef Y_SOBOL_H
+#define Y_SOBOL_H
+
+#include <yafray_config.h>
+
+extern YAFRAYCORE_EXPORT const unsigned int sobolTable[2][4][256];
+
+__BEGIN_YAFRAY
+
+/*! Sample dimensions, grouped in pairs (2k, 2k+1) which are stratified against each other.
+	Dimensions are only used as keys for the scrambling, so they don't need to be dense;
+	everything a path vertex needs lives within SD_VERTEX_STRIDE dimensions. */
+#define SD_PIXEL		0	//!< 2 dims, image plane
+#define SD_LENS			2	//!< 2 dims, depth of field
+#define SD_TIME			4
+#define SD_WAVELENGTH	5
+#define SD_VERTEX		8	//!< first dimension of the first path vertex
+#define SD_VERTEX_STRIDE 4096
+
+// offsets within a path vertex
+#define SD_BSDF			0	//!< 2 dims, next direction
+#define SD_BSDF_COMP	2	//!< BSDF component selection (photon scattering)
+#define SD_SPECTRAL		3	//!< wavelength of dispersive splitting
+#define SD_LIGHT_SELECT	4
+#define SD_LIGHT		6	//!< 2 dims per light
+
+// photon maps use the photon number as index and a fixed seed per map
+#define SD_PHOTON_LIGHT			0	//!< light selection
+#define SD_PHOTON_WAVELENGTH	1
+#define SD_PHOTON_EMIT			2	//!< 4 dims, emitPhoton()
+#define DIFFUSE_PHOTON_SEED		0x2b7e1516
+#define CAUSTIC_PHOTON_SEED		0x28aed2a6
+
+inline unsigned int reverseBits(unsigned int bits)
+{
+	bits = ( bits << 16) | ( bits >> 16);
+	bits = ((bits & 0x00ff00ff) << 8) | ((bits & 0xff00ff00) >> 8);
+	bits = ((bits & 0x0f0f0f0f) << 4) | ((bits & 0xf0f0f0f0) >> 4);
+	bits = ((bits & 0x33333333) << 2) | ((bits & 0xcccccccc) >> 2);
+	bits = ((bits & 0x55555555) << 1) | ((bits & 0xaaaaaaaa) >> 1);
+	return bits;
+}
+
+//! integer hash (murmur3 finalizer)
+inline unsigned int sobolHash(unsigned int x)
+{
+	x ^= x >> 16;
+	x *= 0x85ebca6b;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35;
+	x ^= x >> 16;
+	return x;
+}
+
+inline unsigned int hashCombine(unsigned int seed, unsigned int v)
+{
+	return seed ^ (sobolHash(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+/*! hash based Owen scrambling, after "Practical Hash-based Owen Scrambling" by Brent Burley;
+	each bit is flipped depending only on the bits above it, so stratification is preserved */
+inline unsigned int owenScramble(unsigned int x, unsigned int seed)
+{
+	x = reverseBits(x);
+	x += seed;
+	x ^= x * 0x6c50b47c;
+	x ^= x * 0xb82f1e52;
+	x ^= x * 0xc7afe638;
+	x ^= x * 0x8d22f6e6;
+	return reverseBits(x);
+}
+
+//! unscrambled Sobol point of the first (d=0) or second (d=1) dimension, 4 table lookups
+inline unsigned int sobolPoint(unsigned int index, int d)
+{
+	const unsigned int (*t)[256] = sobolTable[d];
+	return t[0][index & 0xff] ^ t[1][(index >> 8) & 0xff] ^ t[2][(index >> 16) & 0xff] ^ t[3][index >> 24];
+}
+
+/*! Random access to an Owen scrambled, padded Sobol sequence: every dimension pair is a
+	(0,2)-sequence in the first two Sobol dimensions, pairs get decorrelated by shuffling the
+	index and scrambling independently. No setup is required, any (index, dim) can be drawn
+	in constant time.
+	\param index sample number within the sequence
+	\param dim sample dimension, see SD_* above
+	\param seed selects the sequence, e.g. renderState_t::samplingOffs for a pixel
+	\return sample in [0, 1)
+*/
+inline float sobolSample(unsigned int index, unsigned int dim, unsigned int seed)
+{
+	unsigned int pairSeed = hashCombine(seed, dim >> 1);
+	unsigned int i = owenScramble(index, pairSeed);
+	unsigned int x = owenScramble(sobolPoint(i, dim & 1), hashCombine(pairSeed, dim & 1));
+	// 24 bits give exactly representable floats strictly below 1
+	return (float)(x >> 8) * (1.f / 16777216.f);
+}
+
+__END_YAFRAY
+
+#endif // Y_SOBOL_H
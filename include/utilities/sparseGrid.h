@@ -0,0 +1,242 @@
+/****************************************************************************
+ *
+ *      sparseGrid.h: sparse, quantized voxel grid storage
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef Y_SPARSEGRID_H
+#define Y_SPARSEGRID_H
+
+#include <yafray_config.h>
+
+#include <vector>
+#include <algorithm>
+#include <utilities/halfFloat.h>
+
+__BEGIN_YAFRAY
+
+#define VOXEL_TILE_LOG 3
+#define VOXEL_TILE (1 << VOXEL_TILE_LOG)
+#define VOXEL_TILE_MASK (VOXEL_TILE - 1)
+#define VOXEL_TILE_SIZE (VOXEL_TILE * VOXEL_TILE * VOXEL_TILE)
+
+/*! Two level voxel grid: the top level has one entry per tile of VOXEL_TILE^3 voxels,
+	tiles in which all voxels are zero are not stored at all. Stored tiles are contiguous
+	blocks, quantized either to 8 bit relative to the tile's min/max range or to half floats.
+	The per tile min/max values are kept for empty space skipping.
+	The grid is built slab by slab (VOXEL_TILE z-slices at once), so a dense copy never has to exist. */
+class sparseVoxelGrid_t
+{
+	public:
+		enum quantization_t { QUANT_8BIT, QUANT_HALF };
+
+		sparseVoxelGrid_t(): nx(0), ny(0), nz(0), tx(0), ty(0), tz(0), quant(QUANT_8BIT), storedTiles(0) {}
+
+		void init(int x, int y, int z, quantization_t q)
+		{
+			nx = x; ny = y; nz = z;
+			tx = (nx + VOXEL_TILE_MASK) >> VOXEL_TILE_LOG;
+			ty = (ny + VOXEL_TILE_MASK) >> VOXEL_TILE_LOG;
+			tz = (nz + VOXEL_TILE_MASK) >> VOXEL_TILE_LOG;
+			quant = q;
+			storedTiles = 0;
+			tiles.assign(tx * ty * tz, tile_t());
+			data8.clear();
+			dataHalf.clear();
+			regionMax.clear();
+		}
+
+		/*! add all tiles of tile row \a tileZ; slab holds the dense voxel values of the z-slices
+			tileZ*VOXEL_TILE to tileZ*VOXEL_TILE + VOXEL_TILE - 1 (clipped to the grid size), x running fastest. */
+		void addSlab(int tileZ, const float *slab)
+		{
+			int z0 = tileZ << VOXEL_TILE_LOG;
+			int zn = std::min(VOXEL_TILE, nz - z0);
+			float vals[VOXEL_TILE_SIZE];
+
+			for(int tileY = 0; tileY < ty; ++tileY)
+			{
+				int y0 = tileY << VOXEL_TILE_LOG;
+				int yn = std::min(VOXEL_TILE, ny - y0);
+				for(int tileX = 0; tileX < tx; ++tileX)
+				{
+					int x0 = tileX << VOXEL_TILE_LOG;
+					int xn = std::min(VOXEL_TILE, nx - x0);
+					float vMin = 1e30f, vMax = -1e30f;
+
+					// gather tile, voxels beyond the grid border repeat the last one
+					for(int z = 0; z < VOXEL_TILE; ++z)
+					for(int y = 0; y < VOXEL_TILE; ++y)
+					for(int x = 0; x < VOXEL_TILE; ++x)
+					{
+						int sx = x0 + std::min(x, xn - 1), sy = y0 + std::min(y, yn - 1), sz = std::min(z, zn - 1);
+						float v = slab[sx + sy * nx + sz * nx * ny];
+						vals[x + (y << VOXEL_TILE_LOG) + (z << (2 * VOXEL_TILE_LOG))] = v;
+						vMin = std::min(vMin, v);
+						vMax = std::max(vMax, v);
+					}
+
+					tile_t &t = tiles[tileIndex(tileX, tileY, tileZ)];
+					t.minVal = vMin;
+					t.maxVal = vMax;
+					if(vMin == 0.f && vMax == 0.f) continue; // empty tile, elided
+
+					t.offset = storedTiles * VOXEL_TILE_SIZE;
+					++storedTiles;
+					if(quant == QUANT_HALF)
+					{
+						dataHalf.resize(storedTiles * VOXEL_TILE_SIZE);
+						for(int i = 0; i < VOXEL_TILE_SIZE; ++i) dataHalf[t.offset + i] = floatToHalf(vals[i]);
+					}
+					else
+					{
+						t.scale = (vMax - vMin) / 255.f;
+						float iScale = (vMax > vMin) ? 255.f / (vMax - vMin) : 0.f;
+						data8.resize(storedTiles * VOXEL_TILE_SIZE);
+						for(int i = 0; i < VOXEL_TILE_SIZE; ++i) data8[t.offset + i] = (unsigned char)((vals[i] - vMin) * iScale + 0.5f);
+					}
+				}
+			}
+		}
+
+		/*! has to be called once all slabs are added; computes the maximum value that can
+			influence trilinear lookups within each tile (the tile and its +x/+y/+z neighbours) */
+		void finish()
+		{
+			regionMax.resize(tiles.size());
+			for(int z = 0; z < tz; ++z)
+			for(int y = 0; y < ty; ++y)
+			for(int x = 0; x < tx; ++x)
+			{
+				float m = 0.f;
+				for(int i = 0; i < 8; ++i)
+				{
+					int ix = std::min(x + (i & 1), tx - 1), iy = std::min(y + ((i >> 1) & 1), ty - 1), iz = std::min(z + (i >> 2), tz - 1);
+					m = std::max(m, tiles[tileIndex(ix, iy, iz)].maxVal);
+				}
+				regionMax[tileIndex(x, y, z)] = m;
+			}
+		}
+
+		float voxel(int x, int y, int z) const
+		{
+			const tile_t &t = tiles[tileIndex(x >> VOXEL_TILE_LOG, y >> VOXEL_TILE_LOG, z >> VOXEL_TILE_LOG)];
+			if(t.offset < 0) return 0.f;
+			return tileValue(t, (x & VOXEL_TILE_MASK) + ((y & VOXEL_TILE_MASK) << VOXEL_TILE_LOG) + ((z & VOXEL_TILE_MASK) << (2 * VOXEL_TILE_LOG)));
+		}
+
+		/*! trilinear lookup in voxel coordinates (voxel centers at integer positions),
+			lookups outside the grid are clamped to the border voxels */
+		float lookup(float x, float y, float z) const
+		{
+			x = std::max(0.f, std::min(x, (float)(nx - 1)));
+			y = std::max(0.f, std::min(y, (float)(ny - 1)));
+			z = std::max(0.f, std::min(z, (float)(nz - 1)));
+
+			int x0 = (int)x, y0 = (int)y, z0 = (int)z;
+			int x1 = std::min(x0 + 1, nx - 1), y1 = std::min(y0 + 1, ny - 1), z1 = std::min(z0 + 1, nz - 1);
+			float xd = x - x0, yd = y - y0, zd = z - z0;
+
+			float v000, v001, v010, v011, v100, v101, v110, v111;
+
+			int tileX = x0 >> VOXEL_TILE_LOG, tileY = y0 >> VOXEL_TILE_LOG, tileZ = z0 >> VOXEL_TILE_LOG;
+			if((x1 >> VOXEL_TILE_LOG) == tileX && (y1 >> VOXEL_TILE_LOG) == tileY && (z1 >> VOXEL_TILE_LOG) == tileZ)
+			{
+				// all 8 voxels in the same block, fetch with constant strides
+				const tile_t &t = tiles[tileIndex(tileX, tileY, tileZ)];
+				if(t.offset < 0) return 0.f;
+				int i = (x0 & VOXEL_TILE_MASK) + ((y0 & VOXEL_TILE_MASK) << VOXEL_TILE_LOG) + ((z0 & VOXEL_TILE_MASK) << (2 * VOXEL_TILE_LOG));
+				int dx = x1 - x0, dy = (y1 - y0) << VOXEL_TILE_LOG, dz = (z1 - z0) << (2 * VOXEL_TILE_LOG);
+				v000 = tileValue(t, i);				v001 = tileValue(t, i + dz);
+				v010 = tileValue(t, i + dy);		v011 = tileValue(t, i + dy + dz);
+				v100 = tileValue(t, i + dx);		v101 = tileValue(t, i + dx + dz);
+				v110 = tileValue(t, i + dx + dy);	v111 = tileValue(t, i + dx + dy + dz);
+			}
+			else
+			{
+				v000 = voxel(x0, y0, z0);	v001 = voxel(x0, y0, z1);
+				v010 = voxel(x0, y1, z0);	v011 = voxel(x0, y1, z1);
+				v100 = voxel(x1, y0, z0);	v101 = voxel(x1, y0, z1);
+				v110 = voxel(x1, y1, z0);	v111 = voxel(x1, y1, z1);
+			}
+
+			float i1 = v000 * (1 - zd) + v001 * zd;
+			float i2 = v010 * (1 - zd) + v011 * zd;
+			float j1 = v100 * (1 - zd) + v101 * zd;
+			float j2 = v110 * (1 - zd) + v111 * zd;
+
+			float w1 = i1 * (1 - yd) + i2 * yd;
+			float w2 = j1 * (1 - yd) + j2 * yd;
+
+			return w1 * (1 - xd) + w2 * xd;
+		}
+
+		//! min/max voxel value of a tile, both are 0 for elided tiles
+		void tileBound(int x, int y, int z, float &vMin, float &vMax) const
+		{
+			const tile_t &t = tiles[tileIndex(x, y, z)];
+			vMin = t.minVal;
+			vMax = t.maxVal;
+		}
+
+		/*! maximum value returned by lookup() for voxel coordinates in [tileX * VOXEL_TILE, (tileX + 1) * VOXEL_TILE)
+			(same for y and z), only valid after finish() */
+		float lookupMax(int tileX, int tileY, int tileZ) const { return regionMax[tileIndex(tileX, tileY, tileZ)]; }
+
+		int tilesX() const { return tx; }
+		int tilesY() const { return ty; }
+		int tilesZ() const { return tz; }
+		int sizeX() const { return nx; }
+		int sizeY() const { return ny; }
+		int sizeZ() const { return nz; }
+		int nStoredTiles() const { return storedTiles; }
+		size_t memUsage() const
+		{
+			return tiles.size() * sizeof(tile_t) + regionMax.size() * sizeof(float) + data8.size() + dataHalf.size() * sizeof(half_t);
+		}
+
+	protected:
+		struct tile_t
+		{
+			tile_t(): offset(-1), minVal(0.f), maxVal(0.f), scale(0.f) {}
+			int offset; //!< first voxel of the tile in the data arrays, -1 for empty tiles
+			float minVal, maxVal;
+			float scale; //!< 8 bit quantization step
+		};
+
+		int tileIndex(int x, int y, int z) const { return x + tx * (y + ty * z); }
+
+		float tileValue(const tile_t &t, int i) const
+		{
+			if(quant == QUANT_HALF) return halfToFloat(dataHalf[t.offset + i]);
+			return t.minVal + t.scale * (float)data8[t.offset + i];
+		}
+
+		int nx, ny, nz;
+		int tx, ty, tz;
+		quantization_t quant;
+		int storedTiles;
+		std::vector<tile_t> tiles;
+		std::vector<float> regionMax;
+		std::vector<unsigned char> data8;
+		std::vector<half_t> dataHalf;
+};
+
+__END_YAFRAY
+
+#endif // Y_SPARSEGRID_H
@@ -4,6 +4,8 @@
 #include <yafray_config.h>
 
 #include <errno.h>
+#include <deque>
+#include <vector>
 
 #if HAVE_PTHREAD
 	#include <pthread.h>
@@ -114,6 +116,97 @@ class YAFRAYCORE_EXPORT thread_t
 #endif
 };
 
+/*! Load with acquire semantics: reads after it cannot see data older than what was written
+	before the atomicStoreRelease() that stored the loaded value. Together they publish data
+	that was built once (e.g. set a ready flag after filling a cache) without taking a lock
+	on the reader side.
+*/
+inline int atomicLoadAcquire(const volatile int *p)
+{
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#elif defined(__GNUC__)
+	int v = *p;
+	__sync_synchronize();
+	return v;
+#elif defined(WIN32)
+	return InterlockedCompareExchange((volatile LONG *)p, 0, 0);
+#else
+	return *p;
+#endif
+}
+
+//! Store with release semantics: everything written before is visible to an atomicLoadAcquire() that reads v
+inline void atomicStoreRelease(volatile int *p, int v)
+{
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+#elif defined(__GNUC__)
+	__sync_synchronize();
+	*p = v;
+#elif defined(WIN32)
+	InterlockedExchange((volatile LONG *)p, v);
+#else
+	*p = v;
+#endif
+}
+
+/*! Interface for work that splits into independent items [0, count), see runParallel() */
+class parallelJob_t
+{
+	public:
+		virtual ~parallelJob_t() {}
+		//! process items [start, end); called concurrently from several threads with disjoint ranges
+		virtual void run(int start, int end) = 0;
+};
+
+/*! Processes the items [0, count) of a job with up to nThreads threads, each one fetching
+	chunks of chunkSize items until all are done. Returns when the whole job is finished.
+	Without thread support (or nThreads <= 1) the job runs on the calling thread.
+*/
+YAFRAYCORE_EXPORT void runParallel(parallelJob_t &job, int count, int nThreads, int chunkSize = 1);
+
+//! Number of processors available on this system, at least 1
+YAFRAYCORE_EXPORT int numCPUs();
+
+/*! Interface for a piece of work queued on a taskQueue_t */
+class task_t
+{
+	public:
+		virtual ~task_t() {}
+		virtual void run() = 0;
+};
+
+class taskWorker_t;
+
+/*! Runs tasks in the background on up to nThreads worker threads, in the order they were added.
+	The workers are started by the first add() after construction or wait(), so a queue that never
+	gets any tasks costs nothing. Without thread support add() runs the task right away.
+*/
+class YAFRAYCORE_EXPORT taskQueue_t
+{
+	friend class taskWorker_t;
+	public:
+		//! nThreads <= 0 uses one thread per processor
+		taskQueue_t(int nThreads = 0);
+		//! waits for the remaining tasks
+		~taskQueue_t();
+		//! queues t and takes ownership of it, it gets deleted after it ran
+		void add(task_t *t);
+		//! blocks until all queued tasks have run, then stops the workers
+		void wait();
+	protected:
+		taskQueue_t(const taskQueue_t &q);
+		taskQueue_t & operator = (const taskQueue_t &q);
+		//! for the workers: the next task, NULL when the queue is empty and stopping
+		task_t *next();
+		conditionVar_t cond;
+		std::deque<task_t *> tasks;
+		std::vector<taskWorker_t *> workers;
+		int nThreads;
+		bool stopping;
+};
+
 } // yafthreads
 
 #endif
@@ -0,0 +1,69 @@
+#ifndef Y_CHECKPOINT_H
+#define Y_CHECKPOINT_H
+
+#include <yafray_config.h>
+
+#include <string>
+#include <vector>
+
+__BEGIN_YAFRAY
+
+class checkpointWriter_t;
+
+/*! Binary snapshot of a progressive render, taken between passes so the render can be
+	continued later from the last completed pass. The contents are a plain sequence of values
+	written with put() and read back in the same order with get(); they are stored in host
+	byte order behind a short header, so a checkpoint can only be resumed by a build for the
+	same architecture.
+	saveAsync() hands the snapshot to a background thread which writes it to a temporary
+	file and renames that over the target, so an interrupted write never replaces the
+	previous checkpoint. */
+class YAFRAYCORE_EXPORT checkpoint_t
+{
+	public:
+		checkpoint_t();
+		~checkpoint_t();
+
+		//! start a new snapshot
+		void clear();
+		void put(const void *src, size_t bytes);
+		template<class T> void put(const T &v) { put(&v, sizeof(T)); }
+		void putString(const std::string &s);
+		template<class T> void putVector(const std::vector<T> &v)
+		{
+			put((unsigned long long)v.size());
+			if(!v.empty()) put(&v[0], v.size() * sizeof(T));
+		}
+
+		//! read the next value; once a read runs past the end all further reads fail
+		bool get(void *dst, size_t bytes);
+		template<class T> bool get(T &v) { return get(&v, sizeof(T)); }
+		bool getString(std::string &s);
+		template<class T> bool getVector(std::vector<T> &v)
+		{
+			unsigned long long n = 0;
+			if(!get(n) || n * sizeof(T) > data.size() - readPos) return (valid = false);
+			v.resize(n);
+			return v.empty() || get(&v[0], v.size() * sizeof(T));
+		}
+		//! false if a get() failed or the loaded file was no checkpoint
+		bool good() const { return valid; }
+
+		//! reads a checkpoint file, the values can be fetched with get() afterwards
+		bool load(const std::string &fileName);
+		/*! writes the snapshot to fileName in the background and empties it; waits for the
+			write of the previous snapshot first */
+		void saveAsync(const std::string &fileName);
+		//! blocks until the background write finished, returns false if it failed
+		bool wait();
+
+	protected:
+		std::vector<char> data;
+		size_t readPos;
+		bool valid;
+		checkpointWriter_t *writer;
+};
+
+__END_YAFRAY
+
+#endif // Y_CHECKPOINT_H
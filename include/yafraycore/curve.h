@@ -0,0 +1,94 @@
+#ifndef Y_CURVE_H
+#define Y_CURVE_H
+
+#include <yafray_config.h>
+
+#include <core_api/primitive.h>
+#include <core_api/object3d.h>
+#include <core_api/matrix4.h>
+
+#include <vector>
+#include <map>
+
+__BEGIN_YAFRAY
+
+class curveObject_t;
+
+struct curveVertex_t
+{
+	point3d_t p;
+	float radius; //!< half width of the ribbon at this vertex
+	float u; //!< position along the strand, 0 at the root and 1 at the tip
+};
+
+/*! straight piece of a hair strand between two vertices of a curveObject_t.
+	It is rendered as a flat ribbon that always faces the ray, with the width interpolated
+	between the vertex radii and round ends, so strands show no gaps at their bends.
+	The shading normal is bent across the ribbon so it shades like a round fiber.
+	The intersection data holds the ribbon orientation (b0, b1), the position along the
+	segment (b2) and across the ribbon in [-1;1] (t). */
+class YAFRAYCORE_EXPORT curveSegment_t: public primitive_t
+{
+	friend class curveObject_t;
+	public:
+		curveSegment_t(const curveObject_t *c, unsigned int v, unsigned short m): curve(c), vert(v), matId(m) {}
+		virtual bound_t getBound() const;
+		virtual bool clippingSupport() const { return true; }
+		//! clips the segment to the box, thin diagonal segments get much smaller bounds in the kd-tree this way
+		virtual bool clipToBound(double bound[2][3], int axis, bound_t &clipped, void *d_old, void *d_new) const;
+		virtual bool intersect(const ray_t &ray, PFLOAT *t, intersectData_t &data) const;
+		virtual void getSurface(surfacePoint_t &sp, const point3d_t &hit, intersectData_t &data) const;
+		virtual const material_t* getMaterial() const;
+	protected:
+		const curveObject_t *curve;
+		unsigned int vert; //!< index of the first vertex, the segment ends at the next one
+		unsigned short matId; //!< index in the materials of the curve object
+};
+
+//! the strands of one curve mesh: vertices [firstVertex, endVertex), segments [firstSegment, endSegment)
+struct curveRange_t
+{
+	size_t firstVertex, endVertex, firstSegment, endSegment;
+	int strands;
+};
+
+/*! holds the hair strands of a scene; the strands only share storage, each segment
+	is a primitive of its own. The strands added under one object ID form a curve mesh,
+	which can be instanced like triangle meshes. */
+class YAFRAYCORE_EXPORT curveObject_t: public object3d_t
+{
+	friend class curveSegment_t;
+	public:
+		curveObject_t(): strandBegin(0), strands(0), curMesh(0) {}
+		virtual int numPrimitives() const { return segments.size(); }
+		virtual int getPrimitives(const primitive_t **prims) const;
+
+		//! starts a new strand of curve mesh id, its points follow with addVertex()
+		void startStrand(unsigned int id, int vertices);
+		int addVertex(const point3d_t &p);
+		/*! finishes the strand: the radius runs from strandStart at the root to strandEnd
+			at the tip, strandShape in [-1;1] bends that transition towards the root (< 0) or the tip (> 0) */
+		bool endStrand(const material_t *mat, float strandStart, float strandEnd, float strandShape);
+
+		//! true if strands were added with that ID
+		bool hasMesh(unsigned int id) const { return meshes.find(id) != meshes.end(); }
+		//! appends a copy of the strands of mesh baseId transformed by m as mesh id
+		bool addInstance(unsigned int baseId, unsigned int id, const matrix4x4_t &m);
+
+		int numStrands() const { return strands; }
+		//! bytes used by vertices and segments
+		size_t memory() const;
+	protected:
+		std::vector<curveVertex_t> vertices;
+		std::vector<curveSegment_t> segments;
+		std::vector<const material_t *> materials;
+		std::map<unsigned int, curveRange_t> meshes;
+		size_t strandBegin; //!< first vertex of the strand that is being added
+		int strands;
+		curveRange_t *curMesh; //!< mesh the strand that is being added belongs to
+		curveRange_t endRange() const;
+};
+
+__END_YAFRAY
+
+#endif // Y_CURVE_H
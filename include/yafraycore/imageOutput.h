@@ -26,8 +26,20 @@
 #include <core_api/imagehandler.h>
 #include <core_api/output.h>
 
+#include <vector>
+
 __BEGIN_YAFRAY
 
+class imageSaver_t;
+
+/*! Writes the image through an image handler. Handlers created for streaming (see
+	imageHandler_t::streamMode()) get the pixels as row segments while the image is produced:
+	area streaming handlers receive every finished area, row streaming handlers the final image
+	of the film's flush(), which comes top to bottom. Other handlers collect the whole frame and
+	save it on flush().
+	With setAsyncSave() the saving runs on a background thread and flush() returns at once, so
+	e.g. the next frame of a sequence can be loaded while the file is encoded. Writing pixels
+	waits for a pending save, as does the destructor; the handler must stay alive until then. */
 class YAFRAYCORE_EXPORT imageOutput_t : public colorOutput_t
 {
 	public:
@@ -35,13 +47,29 @@ class YAFRAYCORE_EXPORT imageOutput_t : public colorOutput_t
 		imageOutput_t(); //!< Dummy initializer
 		virtual ~imageOutput_t();
 		virtual bool putPixel(int x, int y, const float *c, bool alpha = true, bool depth = false, float z = 0.f);
+		virtual bool putArea(int x0, int y0, int w, int h, const float *c, int stride, bool alpha = true, const float *z = 0, int zStride = 0);
 		virtual void flush();
-		virtual void flushArea(int x0, int y0, int x1, int y1) {}; // not used by images... yet
+		virtual void flushArea(int x0, int y0, int x1, int y1);
+		virtual bool wantsAreas() const;
+		void setAsyncSave(bool on) { asyncSave = on; }
+		//! blocks until a background save has finished, returns false if it failed
+		bool waitSave();
 	private:
+		//! adds n pixels of row y from column x to the stream segment, writes the segment when it can't be extended
+		bool appendRun(int x, int y, const colorA_t *c, const float *z, int n);
+		//! hands the pending row segment to the stream
+		bool writeRun();
+
 		imageHandler_t *image;
 		std::string fname;
 		float bX;
 		float bY;
+		bool streamOpen;
+		std::vector<colorA_t> run; //!< pixels of the row segment gathered for the stream
+		std::vector<float> runDepth;
+		int runX, runY;
+		bool asyncSave;
+		imageSaver_t *saver;
 };
 
 __END_YAFRAY
@@ -132,7 +132,9 @@ public:
 	bool Intersect(const ray_t &ray, PFLOAT dist, triangle_t **tr, PFLOAT &Z, intersectData_t &data) const;
 //	bool IntersectDBG(const ray_t &ray, PFLOAT dist, triangle_t **tr, PFLOAT &Z) const;
 	bool IntersectS(const ray_t &ray, PFLOAT dist, triangle_t **tr) const;
-	bool IntersectTS(renderState_t &state, const ray_t &ray, int maxDepth, PFLOAT dist, triangle_t **tr, color_t &filt) const;
+	/*! \param layers if given, the transparent surfaces already filtered by an earlier query on another tree;
+		they count against maxDepth and the ones found here are added */
+	bool IntersectTS(renderState_t &state, const ray_t &ray, int maxDepth, PFLOAT dist, triangle_t **tr, color_t &filt, int *layers=0) const;
 //	bool IntersectO(const point3d_t &from, const vector3d_t &ray, PFLOAT dist, triangle_t **tr, PFLOAT &Z) const;
 	bound_t getBound(){ return treeBound; }
 	~triKdTree_t();
@@ -12,6 +12,7 @@ class YAFRAYCORE_EXPORT memoryIO_t : public colorOutput_t
 	public:
 		memoryIO_t(int resx, int resy, float* iMem);
 		virtual bool putPixel(int x, int y, const float *c, bool alpha = true, bool depth = false, float z = 0.f);
+		virtual bool putArea(int x0, int y0, int w, int h, const float *c, int stride, bool alpha = true, const float *z = 0, int zStride = 0);
 		void flush();
 		virtual void flushArea(int x0, int y0, int x1, int y1) {}; // no tiled file format used...yet
 		virtual ~memoryIO_t();
@@ -67,16 +67,18 @@ class YAFRAYCORE_EXPORT triangleObject_t: public object3d_t
 	friend class scene_t;
 	friend class triangleObjectInstance_t;
 	public:
-		triangleObject_t() : has_orco(false), has_uv(false), is_smooth(false), normals_exported(false) { /* Empty */ }
+		triangleObject_t() : normals_shift(0), has_orco(false), has_uv(false), is_smooth(false), normals_exported(false) { /* Empty */ }
 		triangleObject_t(int ntris, bool hasUV=false, bool hasOrco=false);
 		/*! the number of primitives the object holds. Primitive is an element
 			that by definition can perform ray-triangle intersection */
 		virtual int numPrimitives() const { return triangles.size(); }
 		virtual int getPrimitives(const triangle_t **prims);
 		
-		triangle_t* addTriangle(const triangle_t &t);
+		triangle_t* addTriangle(const triangle_t &t, const material_t *mat);
 		
 		virtual void finish();
+		//! bytes used by the triangles and their per triangle data, without vertices, normals and uv values
+		size_t triangleMemory() const;
 
         inline virtual vector3d_t getVertexNormal(int index) const
         {
@@ -94,6 +96,10 @@ class YAFRAYCORE_EXPORT triangleObject_t: public object3d_t
 		std::vector<normal_t> normals;
 		std::vector<int> uv_offsets;
 		std::vector<uv_t> uv_values;
+		std::vector<int> normal_offsets; //!< 3 normal indices per triangle, empty if they follow from the vertex indices
+		int normals_shift; //!< without normal_offsets the normal index is the vertex index >> normals_shift
+		std::vector<const material_t *> materials; //!< the distinct materials of the triangles
+		std::vector<unsigned short> material_ids; //!< index in materials per triangle
 	protected:
 		bool has_orco;
 		bool has_uv;
@@ -107,6 +113,9 @@ class YAFRAYCORE_EXPORT triangleObjectInstance_t: public triangleObject_t
 	friend class scene_t;
 	public:
 		triangleObjectInstance_t(triangleObject_t *base, matrix4x4_t obj2World);
+		/*! instance moving from obj2World at frame time 0 to obj2WorldEnd at time 1;
+			vertices move on straight lines in between */
+		triangleObjectInstance_t(triangleObject_t *base, matrix4x4_t obj2World, matrix4x4_t obj2WorldEnd);
 		/*! the number of primitives the object holds. Primitive is an element
 			that by definition can perform ray-triangle intersection */
 		virtual int numPrimitives() const { return triangles.size(); }
@@ -124,10 +133,29 @@ class YAFRAYCORE_EXPORT triangleObjectInstance_t: public triangleObject_t
             return objToWorld * mBase->points[index];
         }
 
+		vector3d_t getVertexNormal(int index, PFLOAT time) const
+		{
+			if(!moving) return getVertexNormal(index);
+			const normal_t &n = mBase->normals[index];
+			return (1.f - time) * vector3d_t(objToWorld * n) + time * vector3d_t(objToWorldEnd * n);
+		}
+
+		point3d_t getVertex(int index, PFLOAT time) const
+		{
+			if(!moving) return getVertex(index);
+			const point3d_t &p = mBase->points[index];
+			return (1.f - time) * (objToWorld * p) + time * (objToWorldEnd * p);
+		}
+
+		bool hasMotion() const { return moving; }
+
 	private:
         std::vector<triangleInstance_t> triangles;
         matrix4x4_t objToWorld;
+        matrix4x4_t objToWorldEnd; //!< transform at frame time 1, only used if moving
+        bool moving;
         triangleObject_t* mBase;
+		void init();
 };
 
 #include <yafraycore/triangle_inline.h>
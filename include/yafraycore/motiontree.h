@@ -0,0 +1,54 @@
+#ifndef Y_MOTIONTREE_H
+#define Y_MOTIONTREE_H
+
+#include <yafray_config.h>
+
+#include <vector>
+
+#include <yafraycore/ray_kdtree.h>
+
+__BEGIN_YAFRAY
+
+/*! Acceleration structure for primitives that move during the frame (hasMotion() is true).
+	A single kd-tree would have to bound every primitive over the whole shutter interval,
+	so fast moving geometry turns into huge boxes that nearly every ray has to test.
+	Instead the frame time [0;1] is split into equal segments with a kd-tree each, built
+	from the bounds of the primitives within that segment only; a ray is traced in the
+	tree of the segment its ray_t::time falls into.
+	The number of segments is picked at construction: it is doubled as long as that
+	shrinks the summed bound surface of the primitives noticeably. */
+template<class T> class YAFRAYCORE_EXPORT motionTree_t
+{
+	public:
+		motionTree_t(const T **v, int np, int maxSegments=16);
+		~motionTree_t();
+		bool Intersect(const ray_t &ray, PFLOAT dist, T **tr, PFLOAT &Z, intersectData_t &data) const
+		{
+			return segment(ray.time)->Intersect(ray, dist, tr, Z, data);
+		}
+		bool IntersectS(const ray_t &ray, PFLOAT dist, T **tr) const
+		{
+			return segment(ray.time)->IntersectS(ray, dist, tr);
+		}
+		bool IntersectTS(renderState_t &state, const ray_t &ray, int maxDepth, PFLOAT dist, T **tr, color_t &filt, int *layers=0) const
+		{
+			return segment(ray.time)->IntersectTS(state, ray, maxDepth, dist, tr, filt, layers);
+		}
+		//! bound over the whole frame
+		bound_t getBound() const { return treeBound; }
+		int numSegments() const { return (int)segments.size(); }
+	private:
+		const kdTree_t<T> *segment(PFLOAT time) const
+		{
+			int s = (int)(time * segments.size());
+			if(s < 0) s = 0;
+			else if(s >= (int)segments.size()) s = segments.size() - 1;
+			return segments[s];
+		}
+		std::vector<kdTree_t<T> *> segments;
+		bound_t treeBound;
+};
+
+__END_YAFRAY
+
+#endif // Y_MOTIONTREE_H
@@ -12,6 +12,28 @@ class renderEnvironment_t;
 
 enum nodeType_e { VIEW_DEP=1, VIEW_INDEP=1<<1 };
 
+/*! one instruction of a node program: an operation of nodeOp_t evaluated inline, or a node
+	that only has its virtual eval(). The result goes to the stack slot dst, the inputs come from
+	the slots in reg, or from op.konst where reg is -1 (unconnected or constant inputs) */
+struct nodeInstr_t
+{
+	nodeInstr_t(): dst(0), need(NV_BOTH), node(0) { reg[0] = reg[1] = reg[2] = -1; }
+	const nodeResult_t &input(int i, const nodeStack_t &stack) const { return (reg[i] < 0) ? op.konst[i] : stack(reg[i]); }
+	nodeOp_t op;
+	int reg[3];
+	unsigned int dst;
+	int need; //!< parts of the result that are read (NV_COLOR, NV_SCALAR)
+	const shaderNode_t *node; //!< the node the instruction was made from
+};
+
+/*! a flat list of instructions evaluating the nodes a material reads, built by
+	nodeMaterial_t::compileProgram(): nodes whose results are not read are dropped, constant
+	nodes are only stored when something reads them from the stack */
+struct nodeProgram_t
+{
+	std::vector<nodeInstr_t> code;
+};
+
 class YAFRAYCORE_EXPORT nodeMaterial_t: public material_t
 {
 	public:
@@ -30,13 +52,42 @@ class YAFRAYCORE_EXPORT nodeMaterial_t: public material_t
 			std::vector<shaderNode_t *>::const_iterator iter, end=nodes.end();
 			for(iter = nodes.begin(); iter!=end; ++iter) (*iter)->eval(stack, state, sp);
 		}
+		void evalNodes(const renderState_t &state, const surfacePoint_t &sp, const nodeProgram_t &prog, nodeStack_t &stack)const
+		{
+			std::vector<nodeInstr_t>::const_iterator iter, end=prog.code.end();
+			for(iter = prog.code.begin(); iter!=end; ++iter)
+			{
+				const nodeInstr_t &ins = *iter;
+				switch(ins.op.code)
+				{
+					case NOP_CONST: stack[ins.dst] = ins.op.konst[0]; break;
+					case NOP_MIX: mixNodeOp(ins.op.mode, ins.input(2, stack).f, ins.input(0, stack), ins.input(1, stack), ins.need, stack[ins.dst]); break;
+					case NOP_LAYER: layerNodeOp(ins.op, ins.input(0, stack), ins.input(1, stack), ins.need, stack[ins.dst]); break;
+					default: ins.node->eval(stack, state, sp);
+				}
+			}
+		}
+		/*! fold constant nodes and build the programs for allSorted and allViewindep, which compute
+			everything the roots given to solveNodesOrder() depend on;
+			call after solveNodesOrder() and after the node lists have been filled */
+		void compileNodes();
+		/*! build the program evaluating those of the nodes that the given outputs depend on, the
+			outputs are read as colors or as scalars (null pointers are skipped); requires compileNodes() */
+		void compileProgram(const std::vector<const shaderNode_t *> &colorOutputs, const std::vector<const shaderNode_t *> &scalarOutputs,
+							const std::vector<shaderNode_t *> &nodes, nodeProgram_t &prog) const;
+		//! true if the node's result is the same at all surface points, only valid after compileNodes()
+		bool isConstantNode(const shaderNode_t *node) const { return node->ID < constNode.size() && constNode[node->ID]; }
 		void evalBump(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp, const shaderNode_t *bumpS)const;
 		/*! filter out nodes with specific properties */
 		void filterNodes(const std::vector<shaderNode_t *> &input, std::vector<shaderNode_t *> &output, int flags);
 		virtual ~nodeMaterial_t();
 		
 		std::vector<shaderNode_t *> allNodes, allSorted, allViewdep, allViewindep, bumpNodes;
+		std::vector<const shaderNode_t *> rootNodes; //!< the roots given to solveNodesOrder()
 		std::map<std::string,shaderNode_t *> mShadersTable;
+		nodeProgram_t progSorted, progViewindep;
+		std::vector<bool> constNode; //!< indexed by node ID
+		std::vector<nodeResult_t> constResult; //!< indexed by node ID, only set for constant nodes
 		size_t reqNodeMem;
 };
 
@@ -19,6 +19,34 @@ class renderState_t;
 
 #define PRIM_DAT_SIZE 32
 
+//! triangle copied into a leaf of a kdTree_t<primitive_t>, with the edges of the intersection test
+struct kdTriangle_t
+{
+	point3d_t a;
+	vector3d_t edge1, edge2;
+	primitive_t *prim;
+};
+
+//! sphere copied into a leaf of a kdTree_t<primitive_t>
+struct kdSphere_t
+{
+	point3d_t center;
+	PFLOAT radius;
+	primitive_t *prim;
+};
+
+/*! leaf of a kdTree_t<primitive_t> (universal mode): the header is followed by the triangles,
+	the spheres and pointers to all other primitives, each in one contiguous block.
+	The first two are tested inline, so most leaves need no virtual call and no access to
+	the scattered mesh data; see primitive_t::getShape(). */
+struct primLeaf_t
+{
+	u_int32 nTris, nSpheres, nOther, pad;
+	const kdTriangle_t *tris() const { return (const kdTriangle_t *)(this + 1); }
+	const kdSphere_t *spheres() const { return (const kdSphere_t *)(tris() + nTris); }
+	primitive_t * const *others() const { return (primitive_t * const *)(spheres() + nSpheres); }
+};
+
 // ============================================================
 /*! kd-tree nodes, kept as small as possible
     double precision float and/or 64 bit system: 12bytes
@@ -60,10 +88,13 @@ public:
 		PFLOAT 			division;		//!< interior: division plane position
 		T** 	primitives;		//!< leaf: list of primitives
 		T*		onePrimitive;	//!< leaf: direct inxex of one primitive
+		primLeaf_t* leaf;		//!< leaf of kdTree_t<primitive_t>, replaces the two above
 	};
 	u_int32	flags;		//!< 2bits: isLeaf, axis; 30bits: nprims (leaf) or index of right child
 };
 
+template<> void rkdTreeNode<primitive_t>::createLeaf(u_int32 *primIdx, int np, const primitive_t **prims, MemoryArena &arena);
+
 /*! Stack elements for the custom stack of the recursive traversal */
 template<class T> struct rKdStack
 {
@@ -80,12 +111,16 @@ template<class T> struct rKdStack
 template<class T> class YAFRAYCORE_EXPORT kdTree_t
 {
 public:
+	/*! \param t0,t1 frame time interval the tree is valid for; primitives are bounded
+		with getMotionBound(t0, t1), which makes no difference for static ones */
 	kdTree_t(const T **v, int np, int depth=-1, int leafSize=2,
-			float cost_ratio=0.35, float emptyBonus=0.33);
+			float cost_ratio=0.35, float emptyBonus=0.33, PFLOAT t0=0.f, PFLOAT t1=1.f);
 	bool Intersect(const ray_t &ray, PFLOAT dist, T **tr, PFLOAT &Z, intersectData_t &data) const;
 //	bool IntersectDBG(const ray_t &ray, PFLOAT dist, triangle_t **tr, PFLOAT &Z) const;
 	bool IntersectS(const ray_t &ray, PFLOAT dist, T **tr) const;
-	bool IntersectTS(renderState_t &state, const ray_t &ray, int maxDepth, PFLOAT dist, T **tr, color_t &filt) const;
+	/*! \param layers if given, the transparent surfaces already filtered by an earlier query on another tree;
+		they count against maxDepth and the ones found here are added */
+	bool IntersectTS(renderState_t &state, const ray_t &ray, int maxDepth, PFLOAT dist, T **tr, color_t &filt, int *layers=0) const;
 //	bool IntersectO(const point3d_t &from, const vector3d_t &ray, PFLOAT dist, T **tr, PFLOAT &Z) const;
 	bound_t getBound(){ return treeBound; }
 	~kdTree_t();
@@ -0,0 +1,108 @@
+#ifndef Y_RENDERSTATS_H
+#define Y_RENDERSTATS_H
+
+#include <yafray_config.h>
+#include <yafraycore/threadslots.h>
+
+#include <string>
+#include <vector>
+#include <utility>
+
+__BEGIN_YAFRAY
+
+/*! Ray classes. The first closest hit query after a camera sample is the primary ray,
+	all other closest hit queries are secondary, occlusion queries are shadow rays. */
+enum rayClass_t { RAY_PRIMARY = 0, RAY_SECONDARY, RAY_SHADOW, RAY_CLASSES };
+
+//! counters, the ray related ones are indexed by base + rayClass_t
+enum statCounter_t
+{
+	STAT_RAYS = 0,
+	STAT_KD_NODES = STAT_RAYS + RAY_CLASSES, //!< visited kd-tree nodes, interior and leaf
+	STAT_KD_TESTS = STAT_KD_NODES + RAY_CLASSES, //!< ray-primitive tests
+	STAT_MATERIAL_EVALS = STAT_KD_TESTS + RAY_CLASSES,
+	STAT_LIGHT_SAMPLES,
+	STAT_PHOTON_GATHERS,
+	STAT_COUNTERS
+};
+
+//! counters of one thread, written by that thread only
+struct threadStats_t
+{
+	threadStats_t() { clear(); }
+	void clear();
+	unsigned long long counters[STAT_COUNTERS];
+	bool pendingPrimary; //!< a camera sample was taken, the next closest hit query is primary
+	char pad[64]; //!< keeps blocks of different threads off the same cache line
+};
+
+/*! Render statistics: per thread counters and the time spent in each render phase.
+	Counting is off by default and toggled with setEnabled(); when off every counting
+	call costs a test of a global flag. When on, each thread counts into its own block
+	(no atomics or locks after a thread's first count), the blocks are summed when the
+	statistics are read. Render workers use the block of their worker index in every pass.
+	reset() must not run concurrently with counting threads, renderEnvironment_t::setupScene()
+	calls it before every render. */
+class YAFRAYCORE_EXPORT renderStats_t
+{
+	public:
+		renderStats_t();
+		~renderStats_t();
+
+		static void setEnabled(bool on) { enabled = on; }
+		static bool isEnabled() { return enabled; }
+
+		static void count(statCounter_t c, unsigned long long n = 1);
+		//! marks the next closest hit query of the calling thread as primary ray
+		static void primaryRay();
+		//! accounts a finished kd-tree query
+		static void traversal(bool shadow, unsigned int nodes, unsigned int tests);
+		//! sum of the counters [first, first + n) of the calling thread
+		static unsigned long long threadSum(int first, int n = 1);
+
+		//! zero all counters and forget the phase times
+		void reset();
+		//! adds time to a named phase; phases are reported in order of their first appearance
+		void addPhase(const std::string &name, double seconds);
+		//! adds a phase named "pass <n>", n counting the passes since reset()
+		void addPass(double seconds);
+		//! sets a named value, e.g. a kd-tree build statistic
+		void setValue(const std::string &name, double value);
+
+		unsigned long long total(statCounter_t c) const;
+		int threads() const;
+		//! the statistics as JSON object
+		std::string toJSON() const;
+		bool saveJSON(const std::string &fileName) const;
+
+		static bool enabled;
+
+	protected:
+		static threadStats_t *local();
+
+		mutable yafthreads::mutex_t mutex;
+		threadSlots_t<threadStats_t> blocks;
+		std::vector< std::pair<std::string, double> > phases, values;
+		int passes;
+};
+
+extern YAFRAYCORE_EXPORT renderStats_t gStats;
+
+inline void statCount(statCounter_t c, unsigned long long n = 1)
+{
+	if(renderStats_t::enabled) renderStats_t::count(c, n);
+}
+
+/*! counts the nodes and primitive tests of one kd-tree query on the stack and
+	accounts them when it goes out of scope, on whichever return path */
+struct kdQueryStats_t
+{
+	kdQueryStats_t(bool s): nodes(0), tests(0), shadow(s) {}
+	~kdQueryStats_t() { if(renderStats_t::enabled) renderStats_t::traversal(shadow, nodes, tests); }
+	unsigned int nodes, tests;
+	bool shadow;
+};
+
+__END_YAFRAY
+
+#endif // Y_RENDERSTATS_H
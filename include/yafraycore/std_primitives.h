@@ -10,6 +10,29 @@ class renderEnvironment_t;
 class paraMap_t;
 class object3d_t;
 
+//! ray-sphere test of sphere_t, also used inline by the kd-tree leaves of universal mode
+inline bool intersectSphere(const point3d_t &center, PFLOAT radius, const ray_t &ray, PFLOAT *t)
+{
+	vector3d_t vf = ray.from - center;
+	PFLOAT ea = ray.dir*ray.dir;
+	PFLOAT eb = 2.0*(vf*ray.dir);
+	PFLOAT ec = vf*vf - radius*radius;
+	PFLOAT osc = eb*eb-4.0*ea*ec;
+	if(osc<0) return false;
+	osc=fSqrt(osc);
+	PFLOAT sol1=(-eb-osc)/(2.0*ea);
+	PFLOAT sol2=(-eb+osc)/(2.0*ea);
+	PFLOAT sol=sol1;
+	if(sol < ray.tmin)
+	{
+		sol = sol2;
+		if(sol < ray.tmin) return false;
+	}
+	//if(sol > ray.tmax) return false; //tmax = -1 is not substituted yet...
+	*t = sol;
+	return true;
+}
+
 class YAFRAYCORE_EXPORT sphere_t: public primitive_t
 {
 	public:
@@ -18,7 +41,11 @@ class YAFRAYCORE_EXPORT sphere_t: public primitive_t
 		virtual bool intersectsBound(exBound_t &b) const { return true; };
 		//virtual bool clippingSupport() const { return false; }
 		//virtual bool clipToBound(double bound[2][3], int axis, bound_t &clipped, void *d_old, void *d_new) const {return false;}
-		virtual bool intersect(const ray_t &ray, PFLOAT *t, intersectData_t &data) const;
+		virtual bool intersect(const ray_t &ray, PFLOAT *t, intersectData_t &data) const
+		{
+			return intersectSphere(center, radius, ray, t);
+		}
+		virtual int getShape(point3d_t p[3], PFLOAT &r) const { p[0] = center; r = radius; return PRIM_SPHERE; }
 		virtual void getSurface(surfacePoint_t &sp, const point3d_t &hit, intersectData_t &data) const;
 		virtual const material_t* getMaterial() const { return material; }
 	protected:
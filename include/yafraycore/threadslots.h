@@ -0,0 +1,106 @@
+#ifndef Y_THREADSLOTS_H
+#define Y_THREADSLOTS_H
+
+#include <yafray_config.h>
+#include <yafraycore/ccthreads.h>
+
+#include <vector>
+
+#if defined(_MSC_VER)
+	#define Y_THREAD_LOCAL __declspec(thread)
+#else
+	#define Y_THREAD_LOCAL __thread
+#endif
+
+__BEGIN_YAFRAY
+
+/*! Stable index of the calling thread among the render workers, set by the worker at its start.
+	The integrators start new worker threads for every pass, the index lets per thread data
+	of worker i be reused by the next pass's worker i. -1 for threads that are no render worker. */
+YAFRAYCORE_EXPORT void setWorkerIndex(int index);
+YAFRAYCORE_EXPORT int workerIndex();
+
+/*! Per thread blocks of T for the global recorders (render statistics, trace timeline), written
+	by their thread only. Render workers get the block of their worker index, other threads one
+	of their own; blocks are recycled by reset(), so the memory stays bounded by the number of
+	workers plus the other threads that recorded since the last reset().
+	Each recorder keeps the block of the calling thread in two thread locals that local() checks
+	against the generation bumped by reset(); they are passed in so they can stay static in the
+	recorder's source file. All methods except local() must be called with the mutex given to the
+	constructor locked, local() locks it when a thread needs a new block. */
+template<class T> class threadSlots_t
+{
+	public:
+		threadSlots_t(yafthreads::mutex_t &m): mutex(m), otherUsed(0), generation(1) {}
+		~threadSlots_t()
+		{
+			for(size_t i = 0; i < workerBlocks.size(); ++i) delete workerBlocks[i];
+			for(size_t i = 0; i < otherBlocks.size(); ++i) delete otherBlocks[i];
+		}
+
+		/*! block of the calling thread; init(block) is called under the lock when a block
+			is handed out for the first time since reset() */
+		template<class F> T *local(T *&cache, unsigned int &cacheGeneration, const F &init)
+		{
+			if(cacheGeneration != generation)
+			{
+				mutex.lock();
+				cache = acquire(init);
+				cacheGeneration = generation;
+				mutex.unlock();
+			}
+			return cache;
+		}
+
+		//! hands all blocks out again, threads notice the new generation on their next local()
+		void reset()
+		{
+			active.clear();
+			workers.clear();
+			otherUsed = 0;
+			++generation;
+		}
+
+		//! blocks handed out since reset(), in order of their first use
+		size_t size() const { return active.size(); }
+		const T *operator [] (size_t i) const { return active[i]; }
+		//! worker index of the threads that used block i, -1 if they were no render workers
+		int worker(size_t i) const { return workers[i]; }
+		//! number of worker indices blocks exist for, the worker indices are below it
+		int workerSlots() const { return (int)workerBlocks.size(); }
+
+	protected:
+		template<class F> T *acquire(const F &init)
+		{
+			int w = workerIndex();
+			T *b;
+			if(w >= 0)
+			{
+				if(w >= (int)workerBlocks.size()) workerBlocks.resize(w + 1, (T *)0);
+				if(!workerBlocks[w]) workerBlocks[w] = new T;
+				b = workerBlocks[w];
+				// the worker of an earlier pass already started it
+				for(size_t i = 0; i < active.size(); ++i) if(active[i] == b) return b;
+			}
+			else
+			{
+				if(otherUsed == otherBlocks.size()) otherBlocks.push_back(new T);
+				b = otherBlocks[otherUsed++];
+			}
+			init(b);
+			active.push_back(b);
+			workers.push_back(w);
+			return b;
+		}
+
+		yafthreads::mutex_t &mutex;
+		std::vector<T *> workerBlocks, otherBlocks;
+		std::vector<T *> active;
+		std::vector<int> workers;
+		size_t otherUsed;
+		unsigned int generation;
+};
+
+__END_YAFRAY
+
+#endif // Y_THREADSLOTS_H
@@ -24,6 +24,8 @@ class YAFRAYCORE_EXPORT timer_t
 		double getTime(const std::string &name);
 		
 		static void splitTime(double t, double *secs, int *mins=0, int *hours=0, int *days=0);
+		//! wall clock reading in seconds with microsecond resolution, for measuring short intervals
+		static double now();
 	
 	protected:
 		bool includes(const std::string &label)const;
@@ -0,0 +1,95 @@
+#ifndef Y_TRACE_H
+#define Y_TRACE_H
+
+#include <yafray_config.h>
+#include <yafraycore/threadslots.h>
+
+#include <string>
+#include <vector>
+
+__BEGIN_YAFRAY
+
+/*! one finished scope on the timeline; name, category and argument names must be string
+	literals, the argument names are comma separated, e.g. "x,y,w,h" */
+struct traceEvent_t
+{
+	const char *name, *category, *argNames;
+	double start, duration; //!< microseconds since the recorder's reset()
+	int arg[4];
+};
+
+//! event ring of one thread, written by that thread only
+struct traceBuffer_t
+{
+	traceBuffer_t(): events(0), capacity(0), next(0) {}
+	~traceBuffer_t() { delete [] events; }
+	traceEvent_t *events;
+	unsigned int capacity;
+	unsigned long long next; //!< events written since reset(), the ring keeps the last capacity ones
+};
+
+/*! Timeline recorder for render scheduling (tiles, passes, preprocess phases, film output).
+	Recording is off by default and toggled with setEnabled(); when off a trace scope costs
+	a test of a global flag. Each thread records into its own fixed size ring buffer, so
+	recording takes no locks after a thread's first event; once full, a thread's oldest
+	events are overwritten. Render workers use the ring and timeline row of their worker index.
+	The timeline is written in the Chrome trace event format (chrome://tracing, Perfetto)
+	by saveJSON(), which like reset() must not run concurrently with recording threads. */
+class YAFRAYCORE_EXPORT traceRecorder_t
+{
+	public:
+		traceRecorder_t();
+		~traceRecorder_t();
+
+		static void setEnabled(bool on) { enabled = on; }
+		static bool isEnabled() { return enabled; }
+
+		//! current time on the trace clock
+		double now() const;
+		//! records a finished scope of the calling thread
+		static void record(const char *name, const char *category, const char *argNames, double start, const int *arg);
+
+		//! forget all events and restart the trace clock
+		void reset();
+		//! events per thread that are kept, only takes effect for threads that record after the next reset()
+		void setCapacity(int events) { capacity = events; }
+		std::string toJSON() const;
+		bool saveJSON(const std::string &fileName) const;
+
+		static bool enabled;
+
+	protected:
+		static traceBuffer_t *local();
+
+		mutable yafthreads::mutex_t mutex;
+		threadSlots_t<traceBuffer_t> buffers;
+		int capacity;
+		double epoch;
+};
+
+extern YAFRAYCORE_EXPORT traceRecorder_t gTrace;
+
+/*! records the lifetime of the scope as one timeline event:
+	\code
+	traceScope_t ts("tile", "render", "x,y,w,h", a.X, a.Y, a.W, a.H);
+	\endcode */
+class traceScope_t
+{
+	public:
+		traceScope_t(const char *n, const char *c, const char *argN = 0, int a0 = 0, int a1 = 0, int a2 = 0, int a3 = 0):
+			name(n), category(c), argNames(argN), start(0.0)
+		{
+			if(!traceRecorder_t::enabled) return;
+			arg[0] = a0; arg[1] = a1; arg[2] = a2; arg[3] = a3;
+			start = gTrace.now();
+		}
+		~traceScope_t() { if(traceRecorder_t::enabled) traceRecorder_t::record(name, category, argNames, start, arg); }
+	protected:
+		const char *name, *category, *argNames;
+		double start;
+		int arg[4];
+};
+
+__END_YAFRAY
+
+#endif // Y_TRACE_H
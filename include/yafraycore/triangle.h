@@ -15,48 +15,72 @@ __BEGIN_YAFRAY
 // triBoxOverlap() is in src/yafraycore/tribox3_d.cc!
 int triBoxOverlap(double boxcenter[3],double boxhalfsize[3],double triverts[3][3]);
 
+//! Moller-Trumbore test of vTriangle_t, also used inline by the kd-tree leaves of universal mode
+inline bool intersectTriangle(const point3d_t &a, const vector3d_t &edge1, const vector3d_t &edge2,
+							const ray_t &ray, PFLOAT *t, intersectData_t &data)
+{
+	vector3d_t tvec, pvec, qvec;
+	float det, inv_det, u, v;
+	pvec = ray.dir ^ edge2;
+	det = edge1 * pvec;
+	if (/*(det>-0.000001) && (det<0.000001)*/ det == 0.0) return false;
+	inv_det = 1.0 / det;
+	tvec = ray.from - a;
+	u = (tvec*pvec) * inv_det;
+	if (u < 0.0 || u > 1.0) return false;
+	qvec = tvec^edge1;
+	v = (ray.dir*qvec) * inv_det;
+	if ((v<0.0) || ((u+v)>1.0) ) return false;
+	*t = edge2 * qvec * inv_det;
+	data.b1 = u;
+	data.b2 = v;
+	return true;
+}
+
 class triangleObject_t;
 class triangleObjectInstance_t;
 class meshObject_t;
 class triangleInstance_t;
 
-/*! non-inherited triangle, so no virtual functions to allow inlining
-	othwise totally identically to vTriangle_t (when it actually ever
-	makes it into release)
+/*! triangle of a triangleObject_t; kept small since huge scenes hold hundreds of millions of them:
+	only the vertex indices and the mesh are stored, the position in the mesh's triangle array
+	indexes everything else (material, normal indices and uv offsets), and the geometric
+	normal is computed when needed.
 */
 class YAFRAYCORE_EXPORT triangle_t
 {
 	friend class scene_t;
 	friend class triangleObject_t;
 	friend class triangleInstance_t;
+	friend struct vertexFaces_t;
+	friend class smoothAngleJob_t;
 	
 	public:
-		triangle_t(): pa(-1), pb(-1), pc(-1), na(-1), nb(-1), nc(-1), mesh(NULL) { /* Empty */ }
-        triangle_t(int ia, int ib, int ic, triangleObject_t* m): pa(ia), pb(ib), pc(ic), na(-1), nb(-1), nc(-1), mesh(m) { /* Empty */ }
+		triangle_t(): pa(-1), pb(-1), pc(-1), mesh(NULL) { /* Empty */ }
+        triangle_t(int ia, int ib, int ic, triangleObject_t* m): pa(ia), pb(ib), pc(ic), mesh(m) { /* Empty */ }
 		virtual bool intersect(const ray_t &ray, float *t, intersectData_t &data) const;
 		virtual bound_t getBound() const;
+		virtual bound_t getMotionBound(PFLOAT t0, PFLOAT t1) const { return getBound(); }
+		virtual bool hasMotion() const { return false; }
 		virtual bool intersectsBound(exBound_t &eb) const;
 		virtual bool clippingSupport() const{ return true; }
 		// return: false:=doesn't overlap bound; true:=valid clip exists
 		virtual bool clipToBound(double bound[2][3], int axis, bound_t &clipped, void *d_old, void *d_new) const;
-		virtual const material_t* getMaterial() const { return material; }	
+		virtual const material_t* getMaterial() const;
 		virtual void getSurface(surfacePoint_t &sp, const point3d_t &hit, intersectData_t &data) const;
 		virtual float surfaceArea() const;
 		virtual void sample(float s1, float s2, point3d_t &p, vector3d_t &n) const;
 		
-		virtual vector3d_t getNormal() const{ return vector3d_t(normal); }
+		virtual vector3d_t getNormal() const;
 		void setVertexIndices(int a, int b, int c){ pa=a, pb=b, pc=c; }
-		void setMaterial(const material_t *m) { material = m; }
-		void setNormals(int a, int b, int c){ na=a, nb=b, nc=c; }
-		virtual void recNormal();
+		//! index of the triangle within its mesh
+		size_t getIndex() const;
+		//! indices in the normal array of the mesh, only meaningful if the mesh is smoothed or has exported normals
+		void getNormalIndices(int &na, int &nb, int &nc) const;
 
 	private:
 		int pa, pb, pc; //!< indices in point array, referenced in mesh.
-		int na, nb, nc; //!< indices in normal array, if mesh is smoothed.
-		const material_t* material;
-		normal_t normal; //!< the geometric normal
         const triangleObject_t* mesh;
-		size_t selfIndex;
 };
 
 class YAFRAYCORE_EXPORT triangleInstance_t: public triangle_t
@@ -69,8 +93,11 @@ class YAFRAYCORE_EXPORT triangleInstance_t: public triangle_t
         triangleInstance_t(triangle_t* base, triangleObjectInstance_t* m): mBase(base), mesh(m) { }
 		virtual bool intersect(const ray_t &ray, float *t, intersectData_t &data) const;
 		virtual bound_t getBound() const;
+		virtual bound_t getMotionBound(PFLOAT t0, PFLOAT t1) const;
+		virtual bool hasMotion() const;
 		virtual bool intersectsBound(exBound_t &eb) const;
-		virtual bool clippingSupport() const { return true; }
+		//! the clipping works on the vertices at one time, so it is off for moving instances
+		virtual bool clippingSupport() const { return !hasMotion(); }
 		// return: false:=doesn't overlap bound; true:=valid clip exists
 		virtual bool clipToBound(double bound[2][3], int axis, bound_t &clipped, void *d_old, void *d_new) const;
 		virtual const material_t* getMaterial() const { return mBase->getMaterial(); }	
@@ -79,7 +106,8 @@ class YAFRAYCORE_EXPORT triangleInstance_t: public triangle_t
 		virtual void sample(float s1, float s2, point3d_t &p, vector3d_t &n) const;
 		
 		virtual vector3d_t getNormal() const;
-		virtual void recNormal() { /* Empty */ };
+		//! geometric normal at the given frame time
+		vector3d_t getNormal(PFLOAT time) const;
 
 	private:
         const triangle_t* mBase;
@@ -105,6 +133,7 @@ class YAFRAYCORE_EXPORT vTriangle_t: public primitive_t
 		virtual bool clipToBound(double bound[2][3], int axis, bound_t &clipped, void *d_old, void *d_new) const;
 		virtual const material_t* getMaterial() const { return material; }	
 		virtual void getSurface(surfacePoint_t &sp, const point3d_t &hit, intersectData_t &data) const;
+		virtual int getShape(point3d_t p[3], PFLOAT &r) const;
 		
 		// following are methods which are not part of primitive interface:
 		void setMaterial(const material_t *m) { material = m; }
@@ -132,6 +161,8 @@ class YAFRAYCORE_EXPORT bsTriangle_t: public primitive_t
 					na(-1), nb(-1), nc(-1), mesh(m){ };
 		virtual bool intersect(const ray_t &ray, PFLOAT *t, intersectData_t &data) const;
 		virtual bound_t getBound() const;
+		virtual bound_t getMotionBound(PFLOAT t0, PFLOAT t1) const;
+		virtual bool hasMotion() const { return true; }
 		//virtual bool intersectsBound(exBound_t &eb) const;
 		// return: false:=doesn't overlap bound; true:=valid clip exists
 		//virtual bool clipToBound(double bound[2][3], int axis, bound_t &clipped, void *d_old, void *d_new) const;
@@ -78,13 +78,37 @@ inline bool triangle_t::intersectsBound(exBound_t &eb) const
 	return triBoxOverlap(eb.center, eb.halfSize, tPoints);
 }
 
-inline void triangle_t::recNormal()
+inline vector3d_t triangle_t::getNormal() const
 {
     point3d_t const& a = mesh->getVertex(pa);
     point3d_t const& b = mesh->getVertex(pb);
     point3d_t const& c = mesh->getVertex(pc);
 
-	normal = ((b-a)^(c-a)).normalize();
+	return ((b-a)^(c-a)).normalize();
+}
+
+inline size_t triangle_t::getIndex() const
+{
+	return this - &mesh->triangles[0];
+}
+
+inline const material_t* triangle_t::getMaterial() const
+{
+	return mesh->materials[mesh->material_ids[getIndex()]];
+}
+
+inline void triangle_t::getNormalIndices(int &na, int &nb, int &nc) const
+{
+	if(mesh->normal_offsets.empty())
+	{
+		int s = mesh->normals_shift;
+		na = pa >> s, nb = pb >> s, nc = pc >> s;
+	}
+	else
+	{
+		const int *n = &mesh->normal_offsets[3 * getIndex()];
+		na = n[0], nb = n[1], nc = n[2];
+	}
 }
 
 // triangleInstance_t inlined functions
@@ -93,9 +117,9 @@ inline bool triangleInstance_t::intersect(const ray_t &ray, float *t, intersectD
 {
 	// Tomas Möller and Ben Trumbore ray intersection scheme
 	// Getting the barycentric coordinates of the hit point
-    point3d_t const& a = mesh->getVertex(mBase->pa);
-    point3d_t const& b = mesh->getVertex(mBase->pb);
-    point3d_t const& c = mesh->getVertex(mBase->pc);
+    point3d_t const& a = mesh->getVertex(mBase->pa, ray.time);
+    point3d_t const& b = mesh->getVertex(mBase->pb, ray.time);
+    point3d_t const& c = mesh->getVertex(mBase->pc, ray.time);
     
 	vector3d_t edge1, edge2, tvec, pvec, qvec;
 	float det, inv_det, u, v;
@@ -121,11 +145,35 @@ inline bool triangleInstance_t::intersect(const ray_t &ray, float *t, intersectD
 
 	data.b1 = u;
 	data.b2 = v;
+	data.t = ray.time;
 	return true;
 }
 
+inline bool triangleInstance_t::hasMotion() const
+{
+	return mesh->hasMotion();
+}
+
+inline bound_t triangleInstance_t::getMotionBound(PFLOAT t0, PFLOAT t1) const
+{
+	// the vertices move on straight lines, so their positions at t0 and t1 enclose the whole interval
+	if(!mesh->hasMotion()) return getBound();
+	bound_t b1;
+	const int idx[3] = { mBase->pa, mBase->pb, mBase->pc };
+	for(int i=0; i<3; ++i)
+	{
+		point3d_t p0 = mesh->getVertex(idx[i], t0), p1 = mesh->getVertex(idx[i], t1);
+		bound_t pb(point3d_t(std::min(p0.x, p1.x), std::min(p0.y, p1.y), std::min(p0.z, p1.z)),
+					point3d_t(std::max(p0.x, p1.x), std::max(p0.y, p1.y), std::max(p0.z, p1.z)));
+		b1 = i ? bound_t(b1, pb) : pb;
+	}
+	return b1;
+}
+
 inline bound_t triangleInstance_t::getBound() const
 {
+	if(mesh->hasMotion()) return getMotionBound(0.f, 1.f);
+
     point3d_t const& a = mesh->getVertex(mBase->pa);
     point3d_t const& b = mesh->getVertex(mBase->pb);
     point3d_t const& c = mesh->getVertex(mBase->pc);
@@ -142,6 +190,7 @@ inline bound_t triangleInstance_t::getBound() const
 
 inline bool triangleInstance_t::intersectsBound(exBound_t &eb) const
 {
+	if(mesh->hasMotion()) return true;
 	double tPoints[3][3];
 
     point3d_t const& a = mesh->getVertex(mBase->pa);
@@ -160,5 +209,15 @@ inline bool triangleInstance_t::intersectsBound(exBound_t &eb) const
 
 inline vector3d_t triangleInstance_t::getNormal() const
 {
-	return vector3d_t(mesh->objToWorld * mBase->normal).normalize();
+	return vector3d_t(mesh->objToWorld * normal_t(mBase->triangle_t::getNormal())).normalize();
+}
+
+inline vector3d_t triangleInstance_t::getNormal(PFLOAT time) const
+{
+	if(!mesh->hasMotion()) return getNormal();
+	// the vertices move on straight lines, so only their positions at time give the plane that was hit
+	point3d_t a = mesh->getVertex(mBase->pa, time);
+	point3d_t b = mesh->getVertex(mBase->pb, time);
+	point3d_t c = mesh->getVertex(mBase->pc, time);
+	return ((b - a) ^ (c - a)).normalize();
 }
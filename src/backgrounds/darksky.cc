@@ -24,23 +24,27 @@
 #include <utilities/ColorConv.h>
 #include <utilities/spectralData.h>
 #include <utilities/curveUtils.h>
+#include <utilities/skyTable.h>
+#include <utilities/simdMath.h>
 
 __BEGIN_YAFRAY
 
-class darkSkyBackground_t: public background_t
+class darkSkyBackground_t: public background_t, public skyFunction_t
 {
 	public:
 		darkSkyBackground_t(const point3d_t dir, float turb, float pwr, float skyBright, bool clamp, float av, float bv, float cv, float dv, float ev,
-							float altitude, bool night, float exp, bool genc, ColorSpaces cs);
+							float altitude, bool night, float exp, bool genc, ColorSpaces cs, int tableRes);
 		virtual color_t operator() (const ray_t &ray, renderState_t &state, bool filtered=false) const;
 		virtual color_t eval(const ray_t &ray, bool filtered=false) const;
+		virtual void init(scene_t &scene);
+		virtual color_t skyRadiance(const vector3d_t &dir) const;
 		virtual ~darkSkyBackground_t();
 		static background_t *factory(paraMap_t &,renderEnvironment_t &);
 		color_t getAttenuatedSunColor();
 
 	protected:
 		color_t getSkyCol(const ray_t &ray) const;
-		double PerezFunction(const double *lam, double cosTheta, double gamma, double cosGamma, double lvz) const;
+		double PerezFunction(const double *lam, float expTheta, float expGamma, double cosGamma2, double lvz) const;
 		double prePerez(const double *perez);
 
 		color_t getSunColorFromSunRad();
@@ -57,11 +61,14 @@ class darkSkyBackground_t: public background_t
 		ColorConv convert;
 		float alt;
 		bool nightSky;
+		int skyTableRes;
+		skyTable_t skyTable;
 };
 
 darkSkyBackground_t::darkSkyBackground_t(const point3d_t dir, float turb, float pwr, float skyBright, bool clamp,float av, float bv, float cv, float dv, float ev,
-										float altitude, bool night, float exp, bool genc, ColorSpaces cs):
-									   power(pwr * skyBright), skyBrightness(skyBright), convert(clamp, genc, cs, exp), alt(altitude), nightSky(night)
+										float altitude, bool night, float exp, bool genc, ColorSpaces cs, int tableRes):
+									   power(pwr * skyBright), skyBrightness(skyBright), convert(clamp, genc, cs, exp), alt(altitude), nightSky(night),
+									   skyTableRes(tableRes)
 {
 	
 	
@@ -200,15 +207,31 @@ double darkSkyBackground_t::prePerez(const double *perez)
 	return 1.0 / pNum;
 }
 
-double darkSkyBackground_t::PerezFunction(const double *lam, double cosTheta, double gamma, double cosGamma2, double lvz) const
+//! expTheta = exp(lam[1] / cosTheta), expGamma = exp(lam[3] * gamma)
+double darkSkyBackground_t::PerezFunction(const double *lam, float expTheta, float expGamma, double cosGamma2, double lvz) const
 {
-	double num = ( (1 + lam[0] * fExp(lam[1]/cosTheta) ) * (1 + lam[2] * fExp(lam[3]*gamma)  + lam[4] * cosGamma2));
+	double num = ( (1 + lam[0] * expTheta ) * (1 + lam[2] * expGamma  + lam[4] * cosGamma2));
 	return lvz * num * lam[5];
 }
 
+void darkSkyBackground_t::init(scene_t &scene)
+{
+	if(skyTableRes > 0 && !skyTable.ready())
+	{
+		Y_INFO << "DarkSky: Baking sky radiance table (" << skyTableRes << "x" << skyTableRes / 2 << ")" << yendl;
+		skyTable.bake(*this, skyTableRes, scene.getNumThreads());
+	}
+}
+
 inline color_t darkSkyBackground_t::getSkyCol(const ray_t &ray) const
 {
-	vector3d_t Iw = ray.dir;
+	if(skyTable.ready()) return skyTable.lookup(ray.dir);
+	return skyRadiance(ray.dir);
+}
+
+color_t darkSkyBackground_t::skyRadiance(const vector3d_t &dir) const
+{
+	vector3d_t Iw = dir;
 	Iw.z += alt;
 	Iw.normalize();
 
@@ -224,9 +247,16 @@ inline color_t darkSkyBackground_t::getSkyCol(const ray_t &ray) const
     cosGamma2 = cosGamma * cosGamma;
 	gamma = acos(cosGamma);
 
-	x = PerezFunction(perez_x, cosTheta, gamma, cosGamma2, zenith_x);
-	y = PerezFunction(perez_y, cosTheta, gamma, cosGamma2, zenith_y);
-	Y = PerezFunction(perez_Y, cosTheta, gamma, cosGamma2, zenith_Y) * 6.66666666666666666667e-5;
+	// the six exponentials of the three Perez functions in one batch
+	double iCosTheta = 1.0 / cosTheta;
+	float e[6] = { (float)(perez_x[1] * iCosTheta), (float)(perez_x[3] * gamma),
+					(float)(perez_y[1] * iCosTheta), (float)(perez_y[3] * gamma),
+					(float)(perez_Y[1] * iCosTheta), (float)(perez_Y[3] * gamma) };
+	expArray(e, e, 6, MATH_FAST);
+
+	x = PerezFunction(perez_x, e[0], e[1], cosGamma2, zenith_x);
+	y = PerezFunction(perez_y, e[2], e[3], cosGamma2, zenith_y);
+	Y = PerezFunction(perez_Y, e[4], e[5], cosGamma2, zenith_Y) * 6.66666666666666666667e-5;
 	
 	skyCol = convert.fromxyY(x,y,Y);
 	
@@ -269,6 +299,7 @@ background_t *darkSkyBackground_t::factory(paraMap_t &params,renderEnvironment_t
 	bool gammaEnc = false;
 	std::string cs = "CIE (E)";
 	float exp = 1.f;
+	int tableRes = 0;
 
 	Y_INFO << "DarkSky: Begin" << yendl;
 
@@ -298,6 +329,7 @@ background_t *darkSkyBackground_t::factory(paraMap_t &params,renderEnvironment_t
 	params.getParam("light_samples", bgl_samples);
 
 	params.getParam("night", night);
+	params.getParam("sky_table_res", tableRes); // bake the sky into a table of res x res/2 texels, 0 = evaluate per ray
 	
 	ColorSpaces colorS = cieRGB_E_CS;
 	if(cs == "CIE (E)") colorS = cieRGB_E_CS;
@@ -312,7 +344,7 @@ background_t *darkSkyBackground_t::factory(paraMap_t &params,renderEnvironment_t
 	}
 
 	darkSkyBackground_t *darkSky = new darkSkyBackground_t(dir, turb, power, bright, clamp, av, bv, cv, dv, ev,
-																altitude, night, exp, gammaEnc, colorS);
+																altitude, night, exp, gammaEnc, colorS, tableRes);
 
 	if (add_sun && radToDeg(acos(dir.z)) < 100.0)
 	{
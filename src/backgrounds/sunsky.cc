@@ -25,6 +25,8 @@
 #include <core_api/params.h>
 #include <core_api/scene.h>
 #include <core_api/light.h>
+#include <utilities/skyTable.h>
+#include <utilities/simdMath.h>
 
 __BEGIN_YAFRAY
 
@@ -35,12 +37,14 @@ __BEGIN_YAFRAY
 
 color_t ComputeAttenuatedSunlight(float theta, int turbidity);
 
-class sunskyBackground_t: public background_t
+class sunskyBackground_t: public background_t, public skyFunction_t
 {
 	public:
-		sunskyBackground_t(const point3d_t dir, float turb, float a_var, float b_var, float c_var, float d_var, float e_var, float pwr);
+		sunskyBackground_t(const point3d_t dir, float turb, float a_var, float b_var, float c_var, float d_var, float e_var, float pwr, int tableRes);
 		virtual color_t operator() (const ray_t &ray, renderState_t &state, bool filtered=false) const;
 		virtual color_t eval(const ray_t &ray, bool filtered=false) const;
+		virtual void init(scene_t &scene);
+		virtual color_t skyRadiance(const vector3d_t &dir) const;
 		virtual ~sunskyBackground_t();
 		static background_t *factory(paraMap_t &,renderEnvironment_t &);
 	protected:
@@ -52,11 +56,14 @@ class sunskyBackground_t: public background_t
 		double zenith_Y, zenith_x, zenith_y;
 		double perez_Y[5], perez_x[5], perez_y[5];
 		double AngleBetween(double thetav, double phiv) const;
-		double PerezFunction(const double *lam, double theta, double gamma, double lvz) const;
+		double PerezFunction(const double *lam, double e3, double e4, double gamma, double lvz) const;
 		float power;
+		int skyTableRes;
+		skyTable_t skyTable;
 };
 
-sunskyBackground_t::sunskyBackground_t(const point3d_t dir, float turb, float a_var, float b_var, float c_var, float d_var, float e_var, float pwr): power(pwr)
+sunskyBackground_t::sunskyBackground_t(const point3d_t dir, float turb, float a_var, float b_var, float c_var, float d_var, float e_var, float pwr, int tableRes):
+	power(pwr), skyTableRes(tableRes)
 {
 	sunDir.set(dir.x, dir.y, dir.z);
 	sunDir.normalize();
@@ -102,9 +109,10 @@ sunskyBackground_t::~sunskyBackground_t()
 	// Empty
 }
 
-double sunskyBackground_t::PerezFunction(const double *lam, double theta, double gamma, double lvz) const
+//! e3 = exp(lam[1]/cos(theta)), e4 = exp(lam[3]*gamma)
+double sunskyBackground_t::PerezFunction(const double *lam, double e3, double e4, double gamma, double lvz) const
 {
-  double e1=0, e2=0, e3=0, e4=0;
+  double e1=0, e2=0;
   if (lam[1]<=230.)
     e1 = fExp(lam[1]);
   else
@@ -113,14 +121,6 @@ double sunskyBackground_t::PerezFunction(const double *lam, double theta, double
     e2 = fExp(e2);
   else
     e2 = 7.7220185e99;
-  if ((e3 = lam[1]/cos(theta))<=230.)
-    e3 = fExp(e3);
-  else
-    e3 = 7.7220185e99;
-  if ((e4 = lam[3]*gamma)<=230.)
-    e4 = fExp(e4);
-  else
-    e4 = 7.7220185e99;
   double den = (1 + lam[0]*e1) * (1 + lam[2]*e2 + lam[4]*fCos(thetaS)*fCos(thetaS));
   double num = (1 + lam[0]*e3) * (1 + lam[2]*e4 + lam[4]*fCos(gamma)*fCos(gamma));
   return (lvz * num / den);
@@ -135,9 +135,24 @@ double sunskyBackground_t::AngleBetween(double thetav, double phiv) const
   return acos(cospsi);
 }
 
+void sunskyBackground_t::init(scene_t &scene)
+{
+	if(skyTableRes > 0 && !skyTable.ready())
+	{
+		Y_INFO << "Sunsky: Baking sky radiance table (" << skyTableRes << "x" << skyTableRes / 2 << ")" << yendl;
+		skyTable.bake(*this, skyTableRes, scene.getNumThreads());
+	}
+}
+
 inline color_t sunskyBackground_t::getSkyCol(const ray_t &ray) const
 {
-	vector3d_t Iw = ray.dir;
+	if(skyTable.ready()) return skyTable.lookup(ray.dir);
+	return skyRadiance(ray.dir);
+}
+
+color_t sunskyBackground_t::skyRadiance(const vector3d_t &dir) const
+{
+	vector3d_t Iw = dir;
 	Iw.normalize();
 
 	double theta, phi, hfade=1, nfade=1;
@@ -168,11 +183,20 @@ inline color_t sunskyBackground_t::getSkyCol(const ray_t &ray) const
 		phi = atan2(Iw.y, Iw.x);
 
 	double gamma = AngleBetween(theta, phi);
+	// exponentials of the three Perez functions, evaluated in one batch
+	double iCosTheta = 1.0 / cos(theta);
+	float arg[6] = { (float)(perez_x[1] * iCosTheta), (float)(perez_x[3] * gamma),
+					(float)(perez_y[1] * iCosTheta), (float)(perez_y[3] * gamma),
+					(float)(perez_Y[1] * iCosTheta), (float)(perez_Y[3] * gamma) };
+	float ex[6];
+	expArray(ex, arg, 6, MATH_FAST);
+	double e[6];
+	for(int i = 0; i < 6; ++i) e[i] = (arg[i] <= 230.f) ? (double)ex[i] : 7.7220185e99;
 	// Compute xyY values
-	double x = PerezFunction(perez_x, theta, gamma, zenith_x);
-	double y = PerezFunction(perez_y, theta, gamma, zenith_y);
+	double x = PerezFunction(perez_x, e[0], e[1], gamma, zenith_x);
+	double y = PerezFunction(perez_y, e[2], e[3], gamma, zenith_y);
 	// Luminance scale 1.0/15000.0
-	double Y = 6.666666667e-5 * nfade * hfade * PerezFunction(perez_Y, theta, gamma, zenith_Y);
+	double Y = 6.666666667e-5 * nfade * hfade * PerezFunction(perez_Y, e[4], e[5], gamma, zenith_Y);
 	
 	if(y == 0.f) return skycolor;
 	
@@ -208,6 +232,7 @@ background_t *sunskyBackground_t::factory(paraMap_t &params,renderEnvironment_t
 	float pw = 1.0;	// sunlight power
 	float av, bv, cv, dv, ev;
 	av = bv = cv = dv = ev = 1.0;	// color variation parameters, default is normal
+	int tableRes = 0;	// sky radiance table resolution, 0 = evaluate per ray
 
 	params.getParam("from", dir);
 	params.getParam("turbidity", turb);
@@ -226,8 +251,9 @@ background_t *sunskyBackground_t::factory(paraMap_t &params,renderEnvironment_t
 	
 	params.getParam("background_light", bgl);
 	params.getParam("light_samples", bgl_samples);
+	params.getParam("sky_table_res", tableRes);
 	
-	background_t *new_sunsky = new sunskyBackground_t(dir, turb, av, bv, cv, dv, ev, power);
+	background_t *new_sunsky = new sunskyBackground_t(dir, turb, av, bv, cv, dv, ev, power, tableRes);
 
 	if(bgl)
 	{
@@ -43,6 +43,7 @@ class textureBackground_t: public background_t
 		textureBackground_t(const texture_t *texture, PROJECTION proj, float bpower, float rot);
 		virtual color_t operator() (const ray_t &ray, renderState_t &state, bool filtered=false) const;
 		virtual color_t eval(const ray_t &ray, bool filtered=false) const;
+		virtual void resolution(int &u, int &v) const;
 		virtual ~textureBackground_t();
 		static background_t *factory(paraMap_t &,renderEnvironment_t &);
 
@@ -115,6 +116,23 @@ color_t textureBackground_t::eval(const ray_t &ray, bool filtered) const
 	return power * ret;
 }
 
+void textureBackground_t::resolution(int &u, int &v) const
+{
+	int x, y, z;
+	tex->resolution(x, y, z);
+	if(project == angular)
+	{
+		// a light probe covers the whole sphere within its diameter
+		u = x;
+		v = x / 2;
+	}
+	else
+	{
+		u = x;
+		v = y;
+	}
+}
+
 background_t* textureBackground_t::factory(paraMap_t &params,renderEnvironment_t &render)
 {
 	const texture_t *tex=0;
@@ -126,6 +144,7 @@ background_t* textureBackground_t::factory(paraMap_t &params,renderEnvironment_t
 	int IBL_sam = 16;
 	bool caust = true;
 	bool diffuse = true;
+	bool IBL_res = false;
 	
 	if( !params.getParam("texture", texname) )
 	{
@@ -148,6 +167,7 @@ background_t* textureBackground_t::factory(paraMap_t &params,renderEnvironment_t
 	params.getParam("rotation", rot);
 	params.getParam("with_caustic", caust);
 	params.getParam("with_diffuse", diffuse);
+	params.getParam("ibl_res_from_image", IBL_res);
 	
 	background_t *texBG = new textureBackground_t(tex, pr, power, rot);
 	
@@ -159,6 +179,7 @@ background_t* textureBackground_t::factory(paraMap_t &params,renderEnvironment_t
 		bgp["shoot_caustics"] = caust;
 		bgp["shoot_diffuse"] = diffuse;
 		bgp["abs_intersect"] = (pr == angular);
+		bgp["res_from_background"] = IBL_res;
 		
 		light_t *bglight = render.createLight("textureBackground_bgLight", bgp);
 		
@@ -0,0 +1,363 @@
+/****************************************************************************
+ *
+ *      bench.cc: yafaray-bench driver, harness and reporting
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+/*	Micro benchmarks of the core data structures and macro benchmarks rendering the
+	built-in reference scenes through yafrayInterface_t. Results go to the console, or as
+	JSON (in the layout of Google Benchmark, plus a "scenes" array) for regression tracking:
+		yafaray-bench -pp <plugin path> -json -o results.json
+*/
+
+#include "bench.h"
+#include <core_api/scene.h>
+#include <core_api/color_console.h>
+#include <utilities/console_utils.h>
+#include <utilities/simd.h>
+#include <yaf_revision.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cmath>
+#include <sstream>
+
+__BEGIN_YAFRAY
+
+benchConfig_t benchConfig;
+
+benchState_t::benchState_t(double mt, int a): arg(a), iterations(0), seconds(0.0), items(0.0), skipped(false),
+	minTime(mt), start(0.0), paused(0.0), pauseStart(0.0), running(false)
+{
+	clock.addEvent("bench");
+	clock.start("bench");
+}
+
+double benchState_t::now()
+{
+	clock.stop("bench");
+	return clock.getTime("bench");
+}
+
+bool benchState_t::keepRunning()
+{
+	if(!running)
+	{
+		running = true;
+		start = now();
+		return true;
+	}
+	++iterations;
+	seconds = now() - start - paused;
+	return seconds < minTime;
+}
+
+void benchState_t::pauseTiming()
+{
+	pauseStart = now();
+}
+
+void benchState_t::resumeTiming()
+{
+	paused += now() - pauseStart;
+}
+
+double sceneResult_t::stage(const std::string &s) const
+{
+	for(size_t i = 0; i < stages.size(); ++i) if(stages[i].first == s) return stages[i].second;
+	return 0.0;
+}
+
+void bumpySphere(meshSink_t &sink, const point3d_t &center, float radius, float bump, int nu, int nv)
+{
+	// poles are single vertices, rings 1..nv-1 have nu vertices each
+	sink.begin(2 + nu * (nv - 1), 2 * nu * (nv - 1));
+	sink.vertex(center + vector3d_t(0, 0, radius));
+	for(int j = 1; j < nv; ++j)
+	{
+		float theta = M_PI * j / nv;
+		for(int i = 0; i < nu; ++i)
+		{
+			float phi = M_2PI * i / nu;
+			float r = radius * (1.f + bump * std::sin(7.f * theta) * std::sin(5.f * phi));
+			sink.vertex(center + r * vector3d_t(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)));
+		}
+	}
+	sink.vertex(center - vector3d_t(0, 0, radius));
+
+	const int south = 1 + nu * (nv - 1);
+	for(int i = 0; i < nu; ++i)
+	{
+		int i1 = (i + 1) % nu;
+		sink.triangle(0, 1 + i, 1 + i1);
+		for(int j = 1; j < nv - 1; ++j)
+		{
+			int a = 1 + (j - 1) * nu, b = 1 + j * nu;
+			sink.triangle(a + i, b + i, b + i1);
+			sink.triangle(a + i, b + i1, a + i1);
+		}
+		sink.triangle(south, 1 + (nv - 2) * nu + i1, 1 + (nv - 2) * nu + i);
+	}
+	sink.end();
+}
+
+void quad(meshSink_t &sink, const point3d_t &a, const point3d_t &b, const point3d_t &c, const point3d_t &d)
+{
+	sink.begin(4, 2);
+	sink.vertex(a); sink.vertex(b); sink.vertex(c); sink.vertex(d);
+	sink.triangle(0, 1, 2);
+	sink.triangle(0, 2, 3);
+	sink.end();
+}
+
+void box(meshSink_t &sink, const point3d_t &a, const point3d_t &b)
+{
+	static const int faces[12][3] = { {0,2,1}, {0,3,2}, {4,5,6}, {4,6,7}, {0,1,5}, {0,5,4},
+		{1,2,6}, {1,6,5}, {2,3,7}, {2,7,6}, {3,0,4}, {3,4,7} };
+	sink.begin(8, 12);
+	for(int k = 0; k < 2; ++k)
+	{
+		float z = k ? b.z : a.z;
+		sink.vertex(point3d_t(a.x, a.y, z));
+		sink.vertex(point3d_t(b.x, a.y, z));
+		sink.vertex(point3d_t(b.x, b.y, z));
+		sink.vertex(point3d_t(a.x, b.y, z));
+	}
+	for(int i = 0; i < 12; ++i) sink.triangle(faces[i][0], faces[i][1], faces[i][2]);
+	sink.end();
+}
+
+static std::string jsonString(const std::string &s)
+{
+	std::string r = "\"";
+	for(size_t i = 0; i < s.size(); ++i)
+	{
+		if(s[i] == '"' || s[i] == '\\') r += '\\';
+		r += s[i];
+	}
+	return r + "\"";
+}
+
+static std::string simdName()
+{
+#if defined(Y_HAVE_AVX2)
+	return "avx2";
+#elif defined(Y_HAVE_SSE2)
+	return "sse2";
+#else
+	return "none";
+#endif
+}
+
+static void writeJson(FILE *f, const std::vector<benchResult_t> &micro, const std::vector<sceneResult_t> &scenes)
+{
+	char date[64];
+	time_t t = time(0);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&t));
+
+	fprintf(f, "{\n  \"context\": {\n");
+	fprintf(f, "    \"date\": %s,\n", jsonString(date).c_str());
+	fprintf(f, "    \"revision\": %s,\n", jsonString(YAF_SVN_REV).c_str());
+	fprintf(f, "    \"simd\": %s,\n", jsonString(simdName()).c_str());
+#ifdef Y_SSE
+	fprintf(f, "    \"simd_math\": true,\n");
+#else
+	fprintf(f, "    \"simd_math\": false,\n");
+#endif
+	fprintf(f, "    \"min_time\": %g\n  },\n", benchConfig.minTime);
+
+	fprintf(f, "  \"benchmarks\": [");
+	bool first = true;
+	for(size_t i = 0; i < micro.size(); ++i)
+	{
+		const benchResult_t &r = micro[i];
+		if(!r.skipped.empty()) continue;
+		fprintf(f, "%s\n    {\"name\": %s, \"iterations\": %lld, \"real_time\": %.6g, \"time_unit\": \"ns\", \"items_per_second\": %.6g",
+			first ? "" : ",", jsonString(r.name).c_str(), r.iterations, r.seconds / r.iterations * 1e9, r.items / r.seconds);
+		if(!r.label.empty()) fprintf(f, ", \"label\": %s", jsonString(r.label).c_str());
+		fprintf(f, "}");
+		first = false;
+	}
+	fprintf(f, "\n  ],\n");
+
+	fprintf(f, "  \"scenes\": [");
+	for(size_t i = 0; i < scenes.size(); ++i)
+	{
+		const sceneResult_t &s = scenes[i];
+		double render = s.stage("render");
+		fprintf(f, "%s\n    {\"name\": %s, \"integrator\": %s, \"threads\": %d, \"width\": %d, \"height\": %d, \"samples\": %d,",
+			i ? "," : "", jsonString(s.name).c_str(), jsonString(s.integrator).c_str(), s.threads, s.width, s.height, s.samples);
+		fprintf(f, " \"primary_rays\": %.0f, \"mrays_per_second\": %.6g, \"speedup\": %.4g, \"efficiency\": %.4g,\n      \"stages\": {",
+			s.primaryRays, render > 0.0 ? s.primaryRays / render * 1e-6 : 0.0, s.speedup, s.speedup / s.threads);
+		for(size_t k = 0; k < s.stages.size(); ++k)
+			fprintf(f, "%s\"%s\": %.6g", k ? ", " : "", s.stages[k].first.c_str(), s.stages[k].second);
+		fprintf(f, "}}");
+	}
+	fprintf(f, "\n  ]\n}\n");
+}
+
+static void writeText(FILE *f, const std::vector<benchResult_t> &micro, const std::vector<sceneResult_t> &scenes)
+{
+	if(!micro.empty())
+	{
+		fprintf(f, "%-36s %14s %12s %16s\n", "Benchmark", "Time/iter", "Iterations", "Items/s");
+		for(size_t i = 0; i < micro.size(); ++i)
+		{
+			const benchResult_t &r = micro[i];
+			if(!r.skipped.empty())
+			{
+				fprintf(f, "%-36s skipped: %s\n", r.name.c_str(), r.skipped.c_str());
+				continue;
+			}
+			double t = r.seconds / r.iterations * 1e9;
+			const char *unit = "ns";
+			if(t >= 1e6) t *= 1e-6, unit = "ms";
+			else if(t >= 1e3) t *= 1e-3, unit = "us";
+			fprintf(f, "%-36s %11.3f %s %12lld %14.4gM/s %s\n", r.name.c_str(), t, unit,
+				r.iterations, r.items / r.seconds * 1e-6, r.label.c_str());
+		}
+	}
+	if(!scenes.empty())
+	{
+		if(!micro.empty()) fprintf(f, "\n");
+		fprintf(f, "%-16s %7s %10s %8s %8s  %s\n", "Scene", "Threads", "Mrays/s", "Speedup", "Eff.", "Stages [s]");
+		for(size_t i = 0; i < scenes.size(); ++i)
+		{
+			const sceneResult_t &s = scenes[i];
+			double render = s.stage("render");
+			fprintf(f, "%-16s %7d %10.4g %8.3g %7.0f%% ", s.name.c_str(), s.threads,
+				render > 0.0 ? s.primaryRays / render * 1e-6 : 0.0, s.speedup, 100.0 * s.speedup / s.threads);
+			for(size_t k = 0; k < s.stages.size(); ++k) fprintf(f, " %s %.3f", s.stages[k].first.c_str(), s.stages[k].second);
+			fprintf(f, "\n");
+		}
+		fprintf(f, "Mrays/s counts primary camera rays over the render stage.\n");
+	}
+}
+
+static bool parseThreadList(const std::string &s, std::vector<int> &threads)
+{
+	std::stringstream in(s);
+	std::string item;
+	threads.clear();
+	while(std::getline(in, item, ','))
+	{
+		int n = atoi(item.c_str());
+		if(n < 1) return false;
+		threads.push_back(n);
+	}
+	return !threads.empty();
+}
+
+__END_YAFRAY
+
+using namespace yafaray;
+
+int main(int argc, char *argv[])
+{
+	cliParser_t parse(argc, argv, 0, 0, "");
+	parse.setAppName("YafaRay benchmark suite",
+	"[OPTIONS]...\nRuns the micro benchmarks and renders the built-in reference scenes with increasing thread counts.");
+	parse.setOption("pp", "plugin-path", false, "Path to load plugins, needed for the texture and scene benchmarks.");
+	parse.setOption("f", "filter", false, "Only run benchmarks and scenes whose name contains this string.");
+	parse.setOption("t", "threads", false, "Comma separated thread counts, default 1,2,4,... up to the number of cores.");
+	parse.setOption("mt", "min-time", false, "Minimum measuring time per micro benchmark in milliseconds, default 500.");
+	parse.setOption("r", "repetitions", false, "Renders per scene and thread count, the fastest one is reported, default 1.");
+	parse.setOption("o", "output", false, "Write the results to this file instead of the console.");
+	parse.setOption("m", "micro", true, "Only run the micro benchmarks.");
+	parse.setOption("s", "scenes", true, "Only render the reference scenes.");
+	parse.setOption("j", "json", true, "Output machine readable JSON.");
+	parse.setOption("h", "help", true, "Displays this help text.");
+	if(!parse.parseCommandLine())
+	{
+		parse.printError();
+		parse.printUsage();
+		return 1;
+	}
+	if(parse.getFlag("h", "help"))
+	{
+		parse.printUsage();
+		return 0;
+	}
+
+	benchConfig.pluginPath = parse.getOptionString("pp", "plugin-path");
+	benchConfig.filter = parse.getOptionString("f", "filter");
+	int ms = parse.getOptionInteger("mt", "min-time");
+	benchConfig.minTime = ms > 0 ? ms * 1e-3 : 0.5;
+	int reps = parse.getOptionInteger("r", "repetitions");
+	benchConfig.repetitions = reps > 0 ? reps : 1;
+
+	// the kd-tree and render loops log a lot, only errors are interesting here
+	yafout.setMasterVerbosity(VL_ERROR);
+
+	std::string threadList = parse.getOptionString("t", "threads");
+	if(threadList.empty())
+	{
+		scene_t probe;
+		probe.setNumThreads(-1);
+		int maxThreads = std::max(1, probe.getNumThreads());
+		for(int n = 1; n < maxThreads; n *= 2) benchConfig.threads.push_back(n);
+		benchConfig.threads.push_back(maxThreads);
+	}
+	else if(!parseThreadList(threadList, benchConfig.threads))
+	{
+		Y_ERROR << "Bench: invalid thread list \"" << threadList << "\"" << yendl;
+		return 1;
+	}
+
+	bool micro = !parse.getFlag("s", "scenes");
+	bool scenes = !parse.getFlag("m", "micro");
+
+	std::vector<benchResult_t> microResults;
+	if(micro)
+	{
+		std::vector<benchCase_t> cases;
+		registerMicroBenchmarks(cases);
+		for(size_t i = 0; i < cases.size(); ++i)
+		{
+			if(cases[i].name.find(benchConfig.filter) == std::string::npos) continue;
+			fprintf(stderr, "%s\n", cases[i].name.c_str());
+			benchState_t state(benchConfig.minTime, cases[i].arg);
+			cases[i].func(state);
+			benchResult_t r;
+			r.name = cases[i].name;
+			r.label = state.label;
+			r.iterations = std::max(1LL, state.iterations);
+			r.seconds = state.seconds;
+			r.items = state.items;
+			if(state.skipped) r.skipped = state.message.empty() ? "skipped" : state.message;
+			microResults.push_back(r);
+		}
+	}
+
+	std::vector<sceneResult_t> sceneResults;
+	if(scenes) runSceneBenchmarks(sceneResults);
+
+	FILE *out = stdout;
+	std::string outName = parse.getOptionString("o", "output");
+	if(!outName.empty() && !(out = fopen(outName.c_str(), "w")))
+	{
+		Y_ERROR << "Bench: could not open " << outName << " for writing" << yendl;
+		return 1;
+	}
+	if(parse.getFlag("j", "json")) writeJson(out, microResults, sceneResults);
+	else writeText(out, microResults, sceneResults);
+	if(out != stdout) fclose(out);
+
+	return 0;
+}
@@ -0,0 +1,152 @@
+/****************************************************************************
+ *
+ *      bench.h: benchmark harness shared by the micro and macro benchmarks
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef Y_BENCH_H
+#define Y_BENCH_H
+
+#include <yafray_config.h>
+#include <yafraycore/timer.h>
+#include <core_api/vector3d.h>
+#include <core_api/output.h>
+#include <yafraycore/monitor.h>
+
+#include <string>
+#include <vector>
+#include <utility>
+
+__BEGIN_YAFRAY
+
+/*! State of a running micro benchmark, used like Google Benchmark's State:
+	\code
+	while(state.keepRunning()) { ...timed work... }
+	state.setItemsProcessed(n);
+	\endcode
+	The body runs until minTime seconds of (unpaused) time have passed. */
+class benchState_t
+{
+	public:
+		benchState_t(double minTime, int arg);
+		//! true while another iteration shall run
+		bool keepRunning();
+		//! exclude setup work inside the loop from the measurement
+		void pauseTiming();
+		void resumeTiming();
+		void setItemsProcessed(double n) { items = n; }
+		//! mark the benchmark as not runnable (e.g. missing plugins), the loop must not be entered
+		void skip(const std::string &reason) { skipped = true; message = reason; }
+		void setLabel(const std::string &l) { label = l; }
+
+		int arg; //!< benchmark argument, e.g. the thread count
+		long long iterations;
+		double seconds;
+		double items;
+		bool skipped;
+		std::string message, label;
+
+	private:
+		double now();
+		timer_t clock;
+		double minTime, start, paused, pauseStart;
+		bool running;
+};
+
+typedef void benchFunc_t(benchState_t &state);
+
+struct benchCase_t
+{
+	benchCase_t(const std::string &n, benchFunc_t *f, int a = 0): name(n), func(f), arg(a) {}
+	std::string name;
+	benchFunc_t *func;
+	int arg;
+};
+
+struct benchResult_t
+{
+	std::string name, label, skipped;
+	long long iterations;
+	double seconds, items;
+};
+
+//! one render of a reference scene
+struct sceneResult_t
+{
+	std::string name, integrator;
+	int threads, width, height, samples;
+	double primaryRays;
+	double speedup; //!< render time with the lowest measured thread count over this one
+	std::vector< std::pair<std::string, double> > stages; //!< seconds, in execution order
+	double stage(const std::string &s) const;
+};
+
+struct benchConfig_t
+{
+	std::string pluginPath;
+	std::string filter; //!< substring a benchmark name must contain
+	double minTime;
+	std::vector<int> threads; //!< thread counts for the contention and scaling runs
+	int repetitions; //!< renders per scene and thread count, the fastest one is reported
+};
+
+extern benchConfig_t benchConfig;
+
+//! discards the rendered pixels
+class nullOutput_t: public colorOutput_t
+{
+	public:
+		virtual bool putPixel(int x, int y, const float *c, bool alpha = true, bool depth = false, float z = 0.f) { return true; }
+		virtual bool putArea(int x0, int y0, int w, int h, const float *c, int stride, bool alpha = true, const float *z = 0, int zStride = 0) { return true; }
+		virtual void flush() {}
+		virtual void flushArea(int x0, int y0, int x1, int y1) {}
+};
+
+//! keeps the console progress bar off stdout; the image film takes ownership
+class quietProgressBar_t: public progressBar_t
+{
+	public:
+		virtual void init(int totalSteps) {}
+		virtual void update(int steps = 1) {}
+		virtual void done() {}
+		virtual void setTag(const char* text) {}
+};
+
+//! receives the geometry of the procedural test meshes
+class meshSink_t
+{
+	public:
+		virtual ~meshSink_t() {}
+		virtual void begin(int vertices, int triangles) = 0;
+		virtual void vertex(const point3d_t &p) = 0;
+		virtual void triangle(int a, int b, int c) = 0;
+		virtual void end() = 0;
+};
+
+/*! latitude/longitude sphere with a wavy displacement, so the kd-tree sees
+	triangles of varying size and orientation; emits 2*nu*(nv-1) triangles */
+void bumpySphere(meshSink_t &sink, const point3d_t &center, float radius, float bump, int nu, int nv);
+void quad(meshSink_t &sink, const point3d_t &a, const point3d_t &b, const point3d_t &c, const point3d_t &d);
+void box(meshSink_t &sink, const point3d_t &a, const point3d_t &b);
+
+void registerMicroBenchmarks(std::vector<benchCase_t> &list);
+void runSceneBenchmarks(std::vector<sceneResult_t> &results);
+
+__END_YAFRAY
+
+#endif // Y_BENCH_H
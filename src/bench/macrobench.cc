@@ -0,0 +1,335 @@
+/****************************************************************************
+ *
+ *      macrobench.cc: reference scene renders through yafrayInterface_t
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+/*	The reference scenes are built procedurally, so they can't drift from the code that
+	renders them. Every scene is rebuilt and rendered once per thread count; the stages are
+	taken from the gTimer events of the core (kdtree, rendert, flush).
+*/
+
+#include "bench.h"
+#include <interface/yafrayinterface.h>
+#include <core_api/scene.h>
+#include <core_api/environment.h>
+#include <core_api/imagefilm.h>
+
+#include <cstdio>
+
+__BEGIN_YAFRAY
+
+//! gives access to the render stages, yafrayInterface_t::render() runs them in one go
+class benchInterface_t: public yafrayInterface_t
+{
+	public:
+		bool renderStages(colorOutput_t &output, sceneResult_t &res);
+};
+
+bool benchInterface_t::renderStages(colorOutput_t &output, sceneResult_t &res)
+{
+	timer_t t;
+	t.addEvent("setup");
+	t.addEvent("update");
+	t.addEvent("total");
+
+	t.start("total");
+	t.start("setup");
+	if(!env->setupScene(*scene, *params, output, new quietProgressBar_t)) return false;
+	t.stop("setup");
+
+	// builds the kd-tree and runs the integrator preprocess (e.g. photon shooting),
+	// the update within scene_t::render() has nothing left to do then
+	t.start("update");
+	if(!scene->update()) return false;
+	t.stop("update");
+
+	if(!scene->render()) return false;
+	film = scene->getImageFilm();
+	t.stop("total");
+
+	double kdtree = std::max(0.0, gTimer.getTime("kdtree"));
+	res.stages.clear();
+	res.stages.push_back(std::make_pair(std::string("setup"), t.getTime("setup")));
+	res.stages.push_back(std::make_pair(std::string("kdtree"), kdtree));
+	res.stages.push_back(std::make_pair(std::string("preprocess"), std::max(0.0, t.getTime("update") - kdtree)));
+	res.stages.push_back(std::make_pair(std::string("render"), gTimer.getTime("rendert")));
+	res.stages.push_back(std::make_pair(std::string("flush"), gTimer.getTime("flush")));
+	res.stages.push_back(std::make_pair(std::string("total"), t.getTime("total")));
+	return true;
+}
+
+class interfaceMeshSink_t: public meshSink_t
+{
+	public:
+		interfaceMeshSink_t(yafrayInterface_t &y): yi(y), mat(0) {}
+		virtual void begin(int vertices, int triangles)
+		{
+			yi.startGeometry();
+			yi.startTriMesh(yi.getNextFreeID(), vertices, triangles, false);
+		}
+		virtual void vertex(const point3d_t &p) { yi.addVertex(p.x, p.y, p.z); }
+		virtual void triangle(int a, int b, int c) { yi.addTriangle(a, b, c, mat); }
+		virtual void end()
+		{
+			yi.endTriMesh();
+			yi.endGeometry();
+		}
+		yafrayInterface_t &yi;
+		const material_t *mat;
+};
+
+struct sceneDesc_t
+{
+	const char *name;
+	const char *integrator;
+	int width, height, samples;
+	void (*build)(yafrayInterface_t &yi, const sceneDesc_t &d);
+};
+
+static material_t *diffuse(yafrayInterface_t &yi, const char *name, float r, float g, float b)
+{
+	yi.paramsClearAll();
+	yi.paramsSetString("type", "shinydiffusemat");
+	yi.paramsSetColor("color", r, g, b);
+	return yi.createMaterial(name);
+}
+
+static void camera(yafrayInterface_t &yi, const sceneDesc_t &d, const point3d_t &from, const point3d_t &to, const point3d_t &up)
+{
+	yi.paramsClearAll();
+	yi.paramsSetString("type", "perspective");
+	yi.paramsSetPoint("from", from.x, from.y, from.z);
+	yi.paramsSetPoint("to", to.x, to.y, to.z);
+	yi.paramsSetPoint("up", up.x, up.y, up.z);
+	yi.paramsSetInt("resx", d.width);
+	yi.paramsSetInt("resy", d.height);
+	yi.paramsSetFloat("focal", 1.4);
+	yi.createCamera("cam");
+}
+
+static void areaLight(yafrayInterface_t &yi, const point3d_t &corner, float size, float power)
+{
+	yi.paramsClearAll();
+	yi.paramsSetString("type", "arealight");
+	yi.paramsSetPoint("corner", corner.x, corner.y, corner.z);
+	yi.paramsSetPoint("point1", corner.x + size, corner.y, corner.z);
+	yi.paramsSetPoint("point2", corner.x, corner.y + size, corner.z);
+	yi.paramsSetColor("color", 1.f, 1.f, 1.f);
+	yi.paramsSetFloat("power", power);
+	yi.paramsSetInt("samples", 4);
+	yi.createLight("area");
+}
+
+//! closed room [-1,1]x[-1,1]x[0,2] with colored side walls, open towards -y
+static void room(yafrayInterface_t &yi)
+{
+	interfaceMeshSink_t sink(yi);
+	sink.mat = diffuse(yi, "white", 0.8f, 0.8f, 0.8f);
+	quad(sink, point3d_t(-1, -1, 0), point3d_t(1, -1, 0), point3d_t(1, 1, 0), point3d_t(-1, 1, 0));
+	quad(sink, point3d_t(-1, -1, 2), point3d_t(-1, 1, 2), point3d_t(1, 1, 2), point3d_t(1, -1, 2));
+	quad(sink, point3d_t(-1, 1, 0), point3d_t(1, 1, 0), point3d_t(1, 1, 2), point3d_t(-1, 1, 2));
+	sink.mat = diffuse(yi, "red", 0.75f, 0.15f, 0.15f);
+	quad(sink, point3d_t(-1, -1, 0), point3d_t(-1, 1, 0), point3d_t(-1, 1, 2), point3d_t(-1, -1, 2));
+	sink.mat = diffuse(yi, "green", 0.15f, 0.75f, 0.15f);
+	quad(sink, point3d_t(1, -1, 0), point3d_t(1, -1, 2), point3d_t(1, 1, 2), point3d_t(1, 1, 0));
+}
+
+static void roomCamera(yafrayInterface_t &yi, const sceneDesc_t &d)
+{
+	camera(yi, d, point3d_t(0, -3.6, 1), point3d_t(0, 0, 1), point3d_t(0, -3.6, 2));
+}
+
+//! high polygon count and direct lighting only, dominated by primary and shadow rays
+static void buildDirect(yafrayInterface_t &yi, const sceneDesc_t &d)
+{
+	interfaceMeshSink_t sink(yi);
+	sink.mat = diffuse(yi, "ground", 0.7f, 0.7f, 0.7f);
+	quad(sink, point3d_t(-6, -6, 0), point3d_t(6, -6, 0), point3d_t(6, 6, 0), point3d_t(-6, 6, 0));
+
+	yi.paramsClearAll();
+	yi.paramsSetString("type", "glossy");
+	yi.paramsSetColor("diffuse_color", 0.2f, 0.5f, 0.8f);
+	yi.paramsSetColor("color", 1.f, 1.f, 1.f);
+	yi.paramsSetFloat("glossy_reflect", 0.5);
+	yi.paramsSetFloat("exponent", 50);
+	sink.mat = yi.createMaterial("gloss");
+	bumpySphere(sink, point3d_t(0, 0, 1.2), 1.f, 0.05f, 500, 200);
+	sink.mat = diffuse(yi, "orange", 0.8f, 0.5f, 0.2f);
+	bumpySphere(sink, point3d_t(-2, 1, 0.6), 0.6f, 0.1f, 200, 100);
+	bumpySphere(sink, point3d_t(2, 1.5, 0.6), 0.6f, 0.1f, 200, 100);
+
+	yi.paramsClearAll();
+	yi.paramsSetString("type", "pointlight");
+	yi.paramsSetPoint("from", 4, -4, 5);
+	yi.paramsSetColor("color", 1.f, 0.9f, 0.8f);
+	yi.paramsSetFloat("power", 40);
+	yi.createLight("point");
+	areaLight(yi, point3d_t(-1, -1, 5), 2.f, 4.f);
+
+	camera(yi, d, point3d_t(0, -6, 3), point3d_t(0, 0, 0.8), point3d_t(0, -6, 4));
+
+	yi.paramsClearAll();
+	yi.paramsSetString("type", "directlighting");
+	yi.paramsSetInt("raydepth", 3);
+	yi.createIntegrator("integ");
+}
+
+//! Cornell box style room with two boxes, global illumination by path tracing
+static void buildPath(yafrayInterface_t &yi, const sceneDesc_t &d)
+{
+	room(yi);
+	interfaceMeshSink_t sink(yi);
+	sink.mat = diffuse(yi, "box", 0.7f, 0.7f, 0.6f);
+	box(sink, point3d_t(-0.7, 0, 0), point3d_t(-0.1, 0.6, 1.2));
+	box(sink, point3d_t(0.1, -0.6, 0), point3d_t(0.7, 0, 0.6));
+	areaLight(yi, point3d_t(-0.3, -0.3, 1.98), 0.6f, 6.f);
+	roomCamera(yi, d);
+
+	yi.paramsClearAll();
+	yi.paramsSetString("type", "pathtracing");
+	yi.paramsSetInt("raydepth", 5);
+	yi.paramsSetInt("bounces", 4);
+	yi.paramsSetInt("path_samples", 1);
+	yi.createIntegrator("integ");
+}
+
+//! glass sphere in the room, photon mapping with caustics and final gathering
+static void buildPhoton(yafrayInterface_t &yi, const sceneDesc_t &d)
+{
+	room(yi);
+	interfaceMeshSink_t sink(yi);
+	yi.paramsClearAll();
+	yi.paramsSetString("type", "glass");
+	yi.paramsSetFloat("IOR", 1.5);
+	yi.paramsSetColor("filter_color", 1.f, 1.f, 1.f);
+	yi.paramsSetColor("mirror_color", 1.f, 1.f, 1.f);
+	sink.mat = yi.createMaterial("glass");
+	bumpySphere(sink, point3d_t(0.3, -0.2, 0.45), 0.45f, 0.f, 96, 48);
+	sink.mat = diffuse(yi, "box", 0.7f, 0.7f, 0.6f);
+	box(sink, point3d_t(-0.7, 0.1, 0), point3d_t(-0.1, 0.7, 1.2));
+	areaLight(yi, point3d_t(-0.3, -0.3, 1.98), 0.6f, 6.f);
+	roomCamera(yi, d);
+
+	yi.paramsClearAll();
+	yi.paramsSetString("type", "photonmapping");
+	yi.paramsSetInt("raydepth", 5);
+	yi.paramsSetInt("photons", 200000);
+	yi.paramsSetInt("cPhotons", 200000);
+	yi.paramsSetFloat("diffuseRadius", 0.2);
+	yi.paramsSetFloat("causticRadius", 0.05);
+	yi.paramsSetInt("search", 50);
+	yi.paramsSetBool("finalGather", true);
+	yi.paramsSetInt("fg_samples", 8);
+	yi.paramsSetInt("fg_bounces", 2);
+	yi.createIntegrator("integ");
+}
+
+static const sceneDesc_t sceneList[] =
+{
+	{ "direct_highpoly", "directlighting", 400, 300, 4, buildDirect },
+	{ "cornell_path", "pathtracing", 200, 200, 8, buildPath },
+	{ "glass_photon", "photonmapping", 240, 240, 2, buildPhoton }
+};
+
+//! builds the scene from scratch and renders it once
+static bool renderScene(benchInterface_t &yi, const sceneDesc_t &d, int threads, sceneResult_t &res)
+{
+	yi.clearAll();
+	yi.startScene(0);
+	d.build(yi, d);
+
+	yi.paramsClearAll();
+	yi.paramsSetString("type", "none");
+	yi.createIntegrator("vol");
+	yi.paramsSetString("type", "constant");
+	yi.paramsSetColor("color", 0.1f, 0.12f, 0.15f);
+	yi.createBackground("world");
+
+	yi.paramsClearAll();
+	yi.paramsSetString("camera_name", "cam");
+	yi.paramsSetString("integrator_name", "integ");
+	yi.paramsSetString("volintegrator_name", "vol");
+	yi.paramsSetString("background_name", "world");
+	yi.paramsSetInt("AA_passes", 1);
+	yi.paramsSetInt("AA_minsamples", d.samples);
+	yi.paramsSetFloat("AA_pixelwidth", 1.5);
+	yi.paramsSetString("filter_type", "gauss");
+	yi.paramsSetInt("width", d.width);
+	yi.paramsSetInt("height", d.height);
+	yi.paramsSetInt("threads", threads);
+
+	nullOutput_t output;
+	return yi.renderStages(output, res);
+}
+
+void runSceneBenchmarks(std::vector<sceneResult_t> &results)
+{
+	if(benchConfig.pluginPath.empty())
+	{
+		Y_ERROR << "Bench: the reference scenes need the plugins, use -pp" << yendl;
+		return;
+	}
+	benchInterface_t yi;
+	yi.loadPlugins(benchConfig.pluginPath.c_str());
+
+	for(size_t s = 0; s < sizeof(sceneList) / sizeof(sceneList[0]); ++s)
+	{
+		const sceneDesc_t &d = sceneList[s];
+		if(std::string(d.name).find(benchConfig.filter) == std::string::npos) continue;
+		double baseTime = 0.0;
+		int baseThreads = 1;
+		for(size_t t = 0; t < benchConfig.threads.size(); ++t)
+		{
+			int threads = benchConfig.threads[t];
+			fprintf(stderr, "%s, %d threads\n", d.name, threads);
+			sceneResult_t best;
+			bool ok = false;
+			for(int r = 0; r < benchConfig.repetitions; ++r)
+			{
+				sceneResult_t res;
+				if(!renderScene(yi, d, threads, res)) break;
+				if(!ok || res.stage("render") < best.stage("render")) best = res;
+				ok = true;
+			}
+			if(!ok)
+			{
+				Y_ERROR << "Bench: rendering " << d.name << " failed" << yendl;
+				break;
+			}
+			best.name = d.name;
+			best.integrator = d.integrator;
+			best.threads = threads;
+			best.width = d.width;
+			best.height = d.height;
+			best.samples = d.samples;
+			best.primaryRays = (double)d.width * d.height * d.samples;
+			if(t == 0)
+			{
+				baseTime = best.stage("render");
+				baseThreads = threads;
+			}
+			// relative to the first thread count, assuming it scaled perfectly
+			best.speedup = baseThreads * baseTime / best.stage("render");
+			results.push_back(best);
+		}
+	}
+	yi.clearAll();
+}
+
+__END_YAFRAY
@@ -0,0 +1,255 @@
+/****************************************************************************
+ *
+ *      mathbench.cc: accuracy and throughput of the math approximations
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+/*	Compares the approximations of mathOptimizations.h and simdMath.h with libm:
+	for every function the maximum absolute and relative error over its domain, and the
+	throughput of libm, the scalar approximation and the batched (4/8 wide) version.
+	Also times the batched color kernels used by the image film.
+	Usage: yafaray-mathbench [-n samples]
+*/
+
+#include <yafray_config.h>
+#include <utilities/simdMath.h>
+#include <yafraycore/timer.h>
+#include <core_api/color.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <string>
+
+__BEGIN_YAFRAY
+
+typedef float (*scalarFunc_t)(float);
+typedef double (*refFunc_t)(double);
+typedef void (*arrayFunc_t)(float *, const float *, int, mathPrecision_t);
+
+static float libmExp(float x) { return std::exp(x); }
+static float libmLog(float x) { return std::log(x); }
+static float libmSin(float x) { return std::sin(x); }
+static float libmCos(float x) { return std::cos(x); }
+static float libmAcos(float x) { return std::acos(x); }
+static double refExp(double x) { return std::exp(x); }
+static double refLog(double x) { return std::log(x); }
+static double refSin(double x) { return std::sin(x); }
+static double refCos(double x) { return std::cos(x); }
+static double refAcos(double x) { return std::acos(x); }
+
+// pow is measured with a fixed exponent, like the glossy lobes use it
+static float powExponent = 1.f;
+static float libmPow(float x) { return std::pow(x, powExponent); }
+static float fastPowE(float x) { return fastPow(x, powExponent); }
+static double refPow(double x) { return std::pow(x, (double)powExponent); }
+static void powArrayE(float *out, const float *in, int n, mathPrecision_t p) { powArray(out, in, powExponent, n, p); }
+
+struct mathFunc_t
+{
+	const char *name;
+	scalarFunc_t libm, fast;
+	arrayFunc_t batch;
+	refFunc_t ref;
+	float lo, hi;
+	bool logSpaced; //!< samples spaced evenly in log(x), for functions on (0, inf)
+};
+
+// keeps the optimizer from dropping the timed loops
+static volatile float sink;
+
+static double now(timer_t &t)
+{
+	t.stop("bench");
+	return t.getTime("bench");
+}
+
+static void fillDomain(std::vector<float> &x, const mathFunc_t &f)
+{
+	int n = (int)x.size();
+	for(int i = 0; i < n; ++i)
+	{
+		float t = (float)i / (float)(n - 1);
+		x[i] = f.logSpaced ? f.lo * std::pow(f.hi / f.lo, t) : f.lo + (f.hi - f.lo) * t;
+	}
+}
+
+//! evaluations per second of body over in, repeated until at least 0.2 seconds passed
+template<class F> static double throughput(F body, std::vector<float> &out, const std::vector<float> &in)
+{
+	timer_t t;
+	t.addEvent("bench");
+	t.start("bench");
+	long long evals = 0;
+	double elapsed = 0.0;
+	do
+	{
+		body(&out[0], &in[0], (int)in.size());
+		evals += in.size();
+		sink = out[evals % in.size()];
+		elapsed = now(t);
+	} while(elapsed < 0.2);
+	return evals / elapsed;
+}
+
+struct scalarLoop_t
+{
+	scalarLoop_t(scalarFunc_t f): func(f) {}
+	void operator()(float *out, const float *in, int n) const { for(int i = 0; i < n; ++i) out[i] = func(in[i]); }
+	scalarFunc_t func;
+};
+
+struct batchLoop_t
+{
+	batchLoop_t(arrayFunc_t f): func(f) {}
+	void operator()(float *out, const float *in, int n) const { func(out, in, n, MATH_FAST); }
+	arrayFunc_t func;
+};
+
+static void errors(const mathFunc_t &f, const std::vector<float> &x, const std::vector<float> &y, double &maxAbs, double &maxRel)
+{
+	maxAbs = maxRel = 0.0;
+	for(size_t i = 0; i < x.size(); ++i)
+	{
+		double r = f.ref(x[i]);
+		double e = std::fabs((double)y[i] - r);
+		if(e > maxAbs) maxAbs = e;
+		// relative error is meaningless around roots
+		if(std::fabs(r) > 1e-3 && e / std::fabs(r) > maxRel) maxRel = e / std::fabs(r);
+	}
+}
+
+static void benchFunction(const mathFunc_t &f, int samples)
+{
+	std::vector<float> in(samples), out(samples);
+	fillDomain(in, f);
+
+	double absFast, relFast, absBatch, relBatch;
+	scalarLoop_t(f.fast)(&out[0], &in[0], samples);
+	errors(f, in, out, absFast, relFast);
+	batchLoop_t(f.batch)(&out[0], &in[0], samples);
+	errors(f, in, out, absBatch, relBatch);
+
+	// throughput is measured on a cache resident block
+	std::vector<float> blockIn(in.begin(), in.begin() + std::min(samples, 4096)), blockOut(blockIn.size());
+	for(size_t i = 0; i < blockIn.size(); ++i) blockIn[i] = in[(i * 7919) % samples];
+
+	double tLibm = throughput(scalarLoop_t(f.libm), blockOut, blockIn);
+	double tFast = throughput(scalarLoop_t(f.fast), blockOut, blockIn);
+	double tBatch = throughput(batchLoop_t(f.batch), blockOut, blockIn);
+
+	printf("%-10s [%9g, %9g]  %10.3e %10.3e  %10.3e %10.3e  %8.1f %8.1f %8.1f\n", f.name, f.lo, f.hi,
+		absFast, relFast, absBatch, relBatch, tLibm * 1e-6, tFast * 1e-6, tBatch * 1e-6);
+}
+
+static void benchColorKernels()
+{
+	const int n = 4096;
+	std::vector<colorA_t> c(n);
+	std::vector<CFLOAT> w(n);
+	for(int i = 0; i < n; ++i)
+	{
+		c[i] = colorA_t((i % 97) * 0.02f, (i % 89) * 0.02f, (i % 83) * 0.02f, 1.f);
+		w[i] = 1.f / (1.f + (i % 13));
+	}
+
+	const char *names[] = { "scale", "clampRGB0", "clampRGB01", "gamma" };
+	for(int k = 0; k < 4; ++k)
+	{
+		timer_t t;
+		t.addEvent("bench");
+		t.start("bench");
+		long long pixels = 0;
+		double elapsed = 0.0;
+		do
+		{
+			std::vector<colorA_t> tmp(c);
+			switch(k)
+			{
+				case 0: scaleColors(&tmp[0], &w[0], n); break;
+				case 1: clampColorsRGB0(&tmp[0], n); break;
+				case 2: clampColorsRGB01(&tmp[0], n); break;
+				default: gammaAdjustColors(&tmp[0], n, 1.f / 2.2f); break;
+			}
+			sink = tmp[pixels % n].R;
+			pixels += n;
+			elapsed = now(t);
+		} while(elapsed < 0.2);
+		printf("%-12s %8.1f Mpixels/s\n", names[k], pixels / elapsed * 1e-6);
+	}
+}
+
+__END_YAFRAY
+
+using namespace yafaray;
+
+int main(int argc, char *argv[])
+{
+	int samples = 1 << 20;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(!strcmp(argv[i], "-n") && i + 1 < argc) samples = std::max(16, atoi(argv[++i]));
+		else
+		{
+			printf("Usage: %s [-n samples]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const char *width = "scalar";
+#if defined(Y_HAVE_AVX2)
+	width = "AVX2 (8 wide)";
+#elif defined(Y_HAVE_SSE2)
+	width = "SSE2 (4 wide)";
+#endif
+	printf("Batched math: %s, %d samples per function\n", width, samples);
+	printf("Errors against double precision libm, throughput in Mevals/s\n\n");
+	printf("%-10s %-23s  %-21s  %-21s  %-26s\n", "function", "domain", "fast abs/rel err", "batch abs/rel err", "libm / fast / batch");
+
+	mathFunc_t funcs[] =
+	{
+		{ "exp",  libmExp,  fastExp,  expArray,  refExp,  -30.f, 30.f, false },
+		{ "log",  libmLog,  fastLog,  logArray,  refLog,  1e-6f, 1e6f, true },
+		{ "sin",  libmSin,  fastSin,  sinArray,  refSin,  (float)-M_2PI, (float)M_2PI, false },
+		{ "cos",  libmCos,  fastCos,  cosArray,  refCos,  (float)-M_2PI, (float)M_2PI, false },
+		{ "acos", libmAcos, fAcos,    acosArray, refAcos, -1.f, 1.f, false },
+	};
+	for(size_t i = 0; i < sizeof(funcs) / sizeof(funcs[0]); ++i) benchFunction(funcs[i], samples);
+
+	const float exponents[] = { 2.2f, 10.f, 100.f, 1000.f };
+	for(int i = 0; i < 4; ++i)
+	{
+		powExponent = exponents[i];
+		char name[32];
+		sprintf(name, "pow^%g", exponents[i]);
+		mathFunc_t f = { name, libmPow, fastPowE, powArrayE, refPow, 1e-3f, 1.f, false };
+		benchFunction(f, samples);
+	}
+
+	printf("\nColor kernels (%s):\n",
+#ifdef Y_SSE
+		"SSE"
+#else
+		"scalar"
+#endif
+		);
+	benchColorKernels();
+	return 0;
+}
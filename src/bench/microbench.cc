@@ -0,0 +1,663 @@
+/****************************************************************************
+ *
+ *      microbench.cc: micro benchmarks of the core data structures
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "bench.h"
+#include <core_api/scene.h>
+#include <core_api/environment.h>
+#include <core_api/imagefilm.h>
+#include <core_api/imagehandler.h>
+#include <core_api/params.h>
+#include <core_api/texture.h>
+#include <core_api/material.h>
+#include <yafraycore/kdtree.h>
+#include <yafraycore/meshtypes.h>
+#include <yafraycore/photon.h>
+#include <yafraycore/hashgrid.h>
+#include <yafraycore/ccthreads.h>
+#include <utilities/mcqmc.h>
+#include <utilities/sample_utils.h>
+
+#include <cstdio>
+#include <sstream>
+#include <limits>
+
+__BEGIN_YAFRAY
+
+// keeps the optimizer from dropping the timed loops
+static volatile float sink;
+
+//! feeds the procedural meshes into a scene_t, without materials
+class sceneMeshSink_t: public meshSink_t
+{
+	public:
+		sceneMeshSink_t(scene_t &s): scene(s) {}
+		virtual void begin(int vertices, int triangles)
+		{
+			scene.startGeometry();
+			id = scene.getNextFreeID();
+			scene.startTriMesh(id, vertices, triangles, false);
+		}
+		virtual void vertex(const point3d_t &p) { scene.addVertex(p); }
+		virtual void triangle(int a, int b, int c) { scene.addTriangle(a, b, c, 0); }
+		virtual void end()
+		{
+			scene.endTriMesh();
+			scene.endGeometry();
+		}
+		scene_t &scene;
+		objID_t id;
+};
+
+//! a bumpy sphere of radius 1 at the origin, built once per size
+struct testMesh_t
+{
+	testMesh_t(int nu, int nv)
+	{
+		sceneMeshSink_t sink(scene);
+		bumpySphere(sink, point3d_t(0, 0, 0), 1.f, 0.05f, nu, nv);
+		triangleObject_t *mesh = scene.getMesh(sink.id);
+		tris.resize(mesh->numPrimitives());
+		mesh->getPrimitives(&tris[0]);
+	}
+	scene_t scene;
+	std::vector<const triangle_t *> tris;
+};
+
+static testMesh_t &smallMesh()
+{
+	static testMesh_t mesh(160, 64); // 20160 triangles
+	return mesh;
+}
+
+static testMesh_t &largeMesh()
+{
+	static testMesh_t mesh(500, 200); // 199000 triangles
+	return mesh;
+}
+
+static triKdTree_t &largeTree()
+{
+	static triKdTree_t tree(&largeMesh().tris[0], largeMesh().tris.size(), -1, 1, 0.8, 0.33);
+	return tree;
+}
+
+static vector3d_t randomDir(random_t &rnd)
+{
+	return SampleSphere(rnd(), rnd());
+}
+
+static void kdBuild(benchState_t &state, testMesh_t &mesh)
+{
+	while(state.keepRunning())
+	{
+		triKdTree_t tree(&mesh.tris[0], mesh.tris.size(), -1, 1, 0.8, 0.33);
+		sink = tree.getBound().a.x;
+	}
+	state.setItemsProcessed((double)state.iterations * mesh.tris.size());
+}
+
+static void benchKdBuildSmall(benchState_t &state) { kdBuild(state, smallMesh()); }
+static void benchKdBuildLarge(benchState_t &state) { kdBuild(state, largeMesh()); }
+
+static void kdIntersect(benchState_t &state, const std::vector<ray_t> &rays)
+{
+	const triKdTree_t &tree = largeTree();
+	const PFLOAT inf = std::numeric_limits<PFLOAT>::infinity();
+	int hits = 0;
+	while(state.keepRunning())
+	{
+		for(size_t i = 0; i < rays.size(); ++i)
+		{
+			triangle_t *hit = 0;
+			PFLOAT Z;
+			intersectData_t data;
+			hits += tree.Intersect(rays[i], inf, &hit, Z, data);
+		}
+	}
+	sink = hits;
+	state.setItemsProcessed((double)state.iterations * rays.size());
+}
+
+//! primary rays of a 256x256 pinhole camera looking at the sphere, in scanline order
+static void benchKdCoherent(benchState_t &state)
+{
+	std::vector<ray_t> rays;
+	point3d_t eye(0, -4, 1);
+	vector3d_t dir = point3d_t(0, 0, 0) - eye;
+	dir.normalize();
+	vector3d_t right, up;
+	createCS(dir, right, up);
+	for(int y = 0; y < 256; ++y)
+		for(int x = 0; x < 256; ++x)
+		{
+			vector3d_t d = dir + ((x - 128) / 256.f) * 0.7f * right + ((y - 128) / 256.f) * 0.7f * up;
+			rays.push_back(ray_t(eye, d.normalize()));
+		}
+	kdIntersect(state, rays);
+}
+
+//! rays between random points around and inside the sphere, like diffuse bounces
+static void benchKdIncoherent(benchState_t &state)
+{
+	std::vector<ray_t> rays;
+	random_t rnd(1234);
+	for(int i = 0; i < 65536; ++i)
+	{
+		point3d_t from = point3d_t(0, 0, 0) + 3.f * randomDir(rnd);
+		vector3d_t d = (point3d_t(0, 0, 0) + 0.8f * randomDir(rnd)) - from;
+		rays.push_back(ray_t(from, d.normalize()));
+	}
+	kdIntersect(state, rays);
+}
+
+//! shadow rays from points just outside the surface to a point light
+static void benchKdShadow(benchState_t &state)
+{
+	const triKdTree_t &tree = largeTree();
+	point3d_t light(3, -3, 3);
+	std::vector<ray_t> rays;
+	std::vector<PFLOAT> dist;
+	random_t rnd(4321);
+	for(int i = 0; i < 65536; ++i)
+	{
+		point3d_t from = point3d_t(0, 0, 0) + 1.1f * randomDir(rnd);
+		vector3d_t d = light - from;
+		dist.push_back(d.length());
+		rays.push_back(ray_t(from, d.normalize()));
+	}
+	int hits = 0;
+	while(state.keepRunning())
+	{
+		for(size_t i = 0; i < rays.size(); ++i)
+		{
+			triangle_t *hit = 0;
+			hits += tree.IntersectS(rays[i], dist[i], &hit);
+		}
+	}
+	sink = hits;
+	state.setItemsProcessed((double)state.iterations * rays.size());
+}
+
+//! ray-triangle tests, about half of the rays hit their triangle
+static void benchTriangleIntersect(benchState_t &state)
+{
+	const std::vector<const triangle_t *> &tris = smallMesh().tris;
+	const int n = 4096;
+	std::vector<ray_t> rays;
+	std::vector<const triangle_t *> targets;
+	random_t rnd(99);
+	for(int i = 0; i < n; ++i)
+	{
+		const triangle_t *t = tris[(i * 7919) % tris.size()];
+		bound_t b = t->getBound();
+		point3d_t c = 0.5f * (b.a + b.g);
+		point3d_t from = c + 2.f * randomDir(rnd);
+		// aim slightly off the triangle's bound center to get misses too
+		vector3d_t d = (c + (b.g - b.a) * (float)(rnd() - 0.5)) - from;
+		rays.push_back(ray_t(from, d.normalize()));
+		targets.push_back(t);
+	}
+	int hits = 0;
+	while(state.keepRunning())
+	{
+		for(int i = 0; i < n; ++i)
+		{
+			float t;
+			intersectData_t data;
+			hits += targets[i]->intersect(rays[i], &t, data);
+		}
+	}
+	sink = hits;
+	state.setItemsProcessed((double)state.iterations * n);
+}
+
+class addSampleJob_t: public yafthreads::parallelJob_t
+{
+	public:
+		addSampleJob_t(imageFilm_t &f, int w, int h, int spc): film(f), width(w), height(h), samplesPerChunk(spc) {}
+		virtual void run(int start, int end)
+		{
+			for(int c = start; c < end; ++c)
+			{
+				random_t rnd(c + 1);
+				for(int i = 0; i < samplesPerChunk; ++i)
+				{
+					float x = rnd() * width, y = rnd() * height;
+					int ix = (int)x, iy = (int)y;
+					film.addSample(colorA_t(0.5f, 0.6f, 0.7f, 1.f), ix, iy, x - ix, y - iy);
+				}
+			}
+		}
+		imageFilm_t &film;
+		int width, height, samplesPerChunk;
+};
+
+//! all threads splat into the same film, as the tiled integrators do at tile borders
+static void benchAddSample(benchState_t &state)
+{
+	const int w = 512, h = 512, chunks = 64, perChunk = 2048;
+	nullOutput_t out;
+	imageFilm_t film(w, h, 0, 0, out, 1.5, imageFilm_t::GAUSS);
+	film.setProgressBar(new quietProgressBar_t);
+	film.init();
+	addSampleJob_t job(film, w, h, perChunk);
+	while(state.keepRunning()) yafthreads::runParallel(job, chunks, state.arg);
+	state.setItemsProcessed((double)state.iterations * chunks * perChunk);
+}
+
+static const int nPhotons = 200000;
+static const int nGather = 50;
+// about nGather photons are expected in this radius
+static const float gatherRadius = std::sqrt(4.f * nGather / (M_PI * nPhotons));
+
+//! photons on the square [-1,1]^2 in the z=0 plane, queries on the same plane
+static void makePhotons(std::vector<photon_t> &photons, std::vector<point3d_t> &queries)
+{
+	random_t rnd(777);
+	for(int i = 0; i < nPhotons; ++i)
+	{
+		point3d_t p(2.f * rnd() - 1.f, 2.f * rnd() - 1.f, 0.f);
+		photons.push_back(photon_t(vector3d_t(0, 0, 1), p, color_t(1.f)));
+	}
+	for(int i = 0; i < 4096; ++i) queries.push_back(point3d_t(1.8f * rnd() - 0.9f, 1.8f * rnd() - 0.9f, 0.f));
+}
+
+static void benchPhotonGather(benchState_t &state)
+{
+	std::vector<photon_t> photons;
+	std::vector<point3d_t> queries;
+	makePhotons(photons, queries);
+	photonMap_t map;
+	for(size_t i = 0; i < photons.size(); ++i) map.pushPhoton(photons[i]);
+	map.updateTree();
+
+	std::vector<foundPhoton_t> found(nGather);
+	int total = 0;
+	while(state.keepRunning())
+	{
+		for(size_t i = 0; i < queries.size(); ++i)
+		{
+			PFLOAT sqRadius = gatherRadius * gatherRadius;
+			total += map.gather(queries[i], &found[0], nGather, sqRadius);
+		}
+	}
+	sink = total;
+	state.setItemsProcessed((double)state.iterations * queries.size());
+}
+
+static void benchHashGridGather(benchState_t &state)
+{
+	std::vector<photon_t> photons;
+	std::vector<point3d_t> queries;
+	makePhotons(photons, queries);
+	// the same cell size and grid size the SPPM integrator uses
+	hashGrid_t grid(2.f * gatherRadius, nPhotons, bound_t(point3d_t(-1, -1, -1), point3d_t(1, 1, 1)));
+	for(size_t i = 0; i < photons.size(); ++i) grid.pushPhoton(photons[i]);
+	grid.updateGrid();
+
+	// the hash grid returns every photon within the radius, not only the closest K
+	std::vector<foundPhoton_t> found(nPhotons);
+	int total = 0;
+	while(state.keepRunning())
+	{
+		for(size_t i = 0; i < queries.size(); ++i)
+			total += grid.gather(queries[i], &found[0], nGather, gatherRadius * gatherRadius);
+	}
+	sink = total;
+	state.setItemsProcessed((double)state.iterations * queries.size());
+}
+
+//! render environment with the plugins loaded, 0 if no plugin path was given
+static renderEnvironment_t *pluginEnv()
+{
+	static renderEnvironment_t *env = 0;
+	if(!env && !benchConfig.pluginPath.empty())
+	{
+		env = new renderEnvironment_t();
+		env->loadPlugins(benchConfig.pluginPath);
+	}
+	return env;
+}
+
+static const char *noiseTypes[] = { "newperlin", "stdperlin", "blender", "voronoi_f1", "cellnoise" };
+
+//! a single octave of the noise generator, through the clouds texture
+static void benchNoise(benchState_t &state)
+{
+	renderEnvironment_t *env = pluginEnv();
+	if(!env) return state.skip("needs -pp");
+	paraMap_t params;
+	params["type"] = std::string("clouds");
+	params["noise_type"] = std::string(noiseTypes[state.arg]);
+	params["depth"] = 0;
+	texture_t *tex = env->createTexture(noiseTypes[state.arg], params);
+	if(!tex) return state.skip("no clouds texture plugin");
+
+	const int n = 4096;
+	std::vector<point3d_t> points;
+	random_t rnd(5);
+	for(int i = 0; i < n; ++i) points.push_back(point3d_t(10.f * rnd(), 10.f * rnd(), 10.f * rnd()));
+	float sum = 0.f;
+	while(state.keepRunning())
+	{
+		for(int i = 0; i < n; ++i) sum += tex->getFloat(points[i]);
+	}
+	sink = sum;
+	state.setItemsProcessed((double)state.iterations * n);
+}
+
+static const char *interpolations[] = { "none", "bilinear", "bicubic" };
+
+//! random lookups into a 1024x1024 image, written to a temporary tga file and loaded back
+static void benchImageTexture(benchState_t &state)
+{
+	renderEnvironment_t *env = pluginEnv();
+	if(!env) return state.skip("needs -pp");
+
+	const int size = 1024;
+	const char *file = "yafaray-bench-texture.tga";
+	paraMap_t ihParams;
+	ihParams["type"] = std::string("tga");
+	ihParams["width"] = size;
+	ihParams["height"] = size;
+	imageHandler_t *ih = env->createImageHandler("benchImage", ihParams, false);
+	if(!ih) return state.skip("no tga image handler plugin");
+	for(int y = 0; y < size; ++y)
+		for(int x = 0; x < size; ++x)
+			ih->putPixel(x, y, colorA_t((x ^ y) / 1024.f, (x % 64) / 64.f, (y % 64) / 64.f, 1.f));
+	bool written = ih->saveToFile(file);
+	delete ih;
+	if(!written) return state.skip("could not write the test image");
+
+	paraMap_t params;
+	params["type"] = std::string("image");
+	params["filename"] = std::string(file);
+	params["interpolate"] = std::string(interpolations[state.arg]);
+	texture_t *tex = env->createTexture(std::string("image_") + interpolations[state.arg], params);
+	remove(file);
+	if(!tex) return state.skip("could not load the test image");
+
+	const int n = 4096;
+	std::vector<point3d_t> points;
+	random_t rnd(6);
+	for(int i = 0; i < n; ++i) points.push_back(point3d_t(2.f * rnd() - 1.f, 2.f * rnd() - 1.f, 0.f));
+	float sum = 0.f;
+	while(state.keepRunning())
+	{
+		for(int i = 0; i < n; ++i) sum += tex->getColor(points[i]).G;
+	}
+	sink = sum;
+	state.setItemsProcessed((double)state.iterations * n);
+}
+
+//! a*b + c*f over color arrays, the shape of most shading code
+static void benchColorArith(benchState_t &state)
+{
+	const int n = 4096;
+	std::vector<color_t> a(n), b(n), c(n), out(n);
+	random_t rnd(7);
+	for(int i = 0; i < n; ++i)
+	{
+		a[i] = color_t(rnd(), rnd(), rnd());
+		b[i] = color_t(rnd(), rnd(), rnd());
+		c[i] = color_t(rnd(), rnd(), rnd());
+	}
+	while(state.keepRunning())
+	{
+		for(int i = 0; i < n; ++i) out[i] = a[i] * b[i] + c[i] * 0.5f;
+		sink = out[state.iterations % n].G;
+	}
+	state.setItemsProcessed((double)state.iterations * n);
+}
+
+//! normalize, dot and cross product, as in building a shading frame
+static void benchVectorFrame(benchState_t &state)
+{
+	const int n = 4096;
+	std::vector<vector3d_t> v(n), w(n), out(n);
+	random_t rnd(8);
+	for(int i = 0; i < n; ++i)
+	{
+		v[i] = vector3d_t(rnd() - 0.5, rnd() - 0.5, rnd() - 0.5);
+		w[i] = vector3d_t(rnd() - 0.5, rnd() - 0.5, rnd() - 0.5);
+	}
+	float sum = 0.f;
+	while(state.keepRunning())
+	{
+		for(int i = 0; i < n; ++i)
+		{
+			vector3d_t u = v[i];
+			u.normalize();
+			sum += u * w[i];
+			out[i] = u ^ w[i];
+		}
+		sink = sum + out[state.iterations % n].y;
+	}
+	state.setItemsProcessed((double)state.iterations * n);
+}
+
+static const char *colorKernels[] = { "scale", "clampRGB01", "gamma" };
+
+//! the batched kernels the image film resolves its rows with
+static void benchColorKernel(benchState_t &state)
+{
+	const int n = 4096;
+	std::vector<colorA_t> c(n), tmp(n);
+	std::vector<CFLOAT> w(n);
+	random_t rnd(9);
+	for(int i = 0; i < n; ++i)
+	{
+		c[i] = colorA_t(1.2f * rnd(), 1.2f * rnd(), 1.2f * rnd(), 1.f);
+		w[i] = 1.f / (1.f + (i % 13));
+	}
+	while(state.keepRunning())
+	{
+		state.pauseTiming();
+		tmp = c;
+		state.resumeTiming();
+		switch(state.arg)
+		{
+			case 0: scaleColors(&tmp[0], &w[0], n); break;
+			case 1: clampColorsRGB01(&tmp[0], n); break;
+			default: gammaAdjustColors(&tmp[0], n, 1.f / 2.2f); break;
+		}
+		sink = tmp[state.iterations % n].R;
+	}
+	state.setItemsProcessed((double)state.iterations * n);
+}
+
+static const char *materialCalls[] = { "init", "transparency" };
+
+static paraMap_t shaderNode(const std::string &name, const std::string &type)
+{
+	paraMap_t p;
+	p["element"] = std::string("shader_node");
+	p["name"] = name;
+	p["type"] = type;
+	return p;
+}
+
+/*! a shinydiffuse material the way the exporter writes layered blender materials: a constant tint
+	mixed from two values, four texture layers on top of it for the color, one scalar layer each
+	for mirror and transparency and a bump layer on a texture of its own. The textures are cheap
+	gradients, so the time goes to evaluating the nodes rather than to the texture lookups */
+static material_t *layeredMaterial(renderEnvironment_t *env, const std::string &name, int seed)
+{
+	static const char *blendTypes[] = { "lin", "quad", "ease", "diag", "sphere" };
+	std::list<paraMap_t> nodes;
+	for(int i = 0; i < 5; ++i)
+	{
+		std::ostringstream tex;
+		tex << name << "_tex" << i;
+		paraMap_t tp;
+		tp["type"] = std::string("blend");
+		tp["stype"] = std::string(blendTypes[i]);
+		if(!env->getTexture(tex.str()) && !env->createTexture(tex.str(), tp)) return 0;
+
+		std::ostringstream map;
+		map << "map" << i;
+		paraMap_t mp = shaderNode(map.str(), "texture_mapper");
+		mp["texture"] = tex.str();
+		mp["scale"] = point3d_t(1.f + seed, 2.f, 1.f + i);
+		nodes.push_back(mp);
+	}
+	paraMap_t v1 = shaderNode("tint1", "value"), v2 = shaderNode("tint2", "value"), tint = shaderNode("tint", "mix");
+	v1["color"] = color_t(0.8f, 0.6f, 0.4f);
+	v2["color"] = color_t(0.2f, 0.3f, 0.9f);
+	tint["input1"] = std::string("tint1");
+	tint["input2"] = std::string("tint2");
+	tint["value"] = 0.3f;
+	nodes.push_back(v1);
+	nodes.push_back(v2);
+	nodes.push_back(tint);
+	for(int i = 0; i < 4; ++i)
+	{
+		std::ostringstream layer, upper, map;
+		layer << "layer" << i;
+		upper << "layer" << i - 1;
+		map << "map" << i;
+		paraMap_t lp = shaderNode(layer.str(), "layer");
+		lp["input"] = map.str();
+		lp["upper_layer"] = (i == 0) ? std::string("tint") : upper.str();
+		lp["mode"] = i;
+		lp["colfac"] = 0.6f;
+		lp["color_input"] = (i % 2 == 0);
+		lp["stencil"] = (i == 2);
+		lp["def_col"] = color_t(0.1f * i, 0.5f, 0.2f);
+		nodes.push_back(lp);
+	}
+	const char *scalarLayers[] = { "mirror", "transp", "bump" };
+	const char *scalarInputs[] = { "map1", "map3", "map4" };
+	for(int i = 0; i < 3; ++i)
+	{
+		paraMap_t lp = shaderNode(scalarLayers[i], "layer");
+		lp["input"] = std::string(scalarInputs[i]);
+		lp["color_input"] = false;
+		lp["do_color"] = false;
+		lp["do_scalar"] = true;
+		lp["valfac"] = 0.3f;
+		nodes.push_back(lp);
+	}
+
+	paraMap_t params;
+	params["type"] = std::string("shinydiffusemat");
+	params["diffuse_shader"] = std::string("layer3");
+	params["mirror_shader"] = std::string("mirror");
+	params["transparency_shader"] = std::string("transp");
+	params["bump_shader"] = std::string("bump");
+	return env->createMaterial(name, params, nodes);
+}
+
+//! a blend of two layered materials masked by a further layer, arg selects the material call
+static void benchLayeredMaterial(benchState_t &state)
+{
+	renderEnvironment_t *env = pluginEnv();
+	if(!env) return state.skip("needs -pp");
+	material_t *mat = env->getMaterial("layeredBlend");
+	if(!mat)
+	{
+		if(!layeredMaterial(env, "layered1", 0) || !layeredMaterial(env, "layered2", 1))
+			return state.skip("no shinydiffusemat or texture plugins");
+		paraMap_t tp;
+		tp["type"] = std::string("blend");
+		if(!env->createTexture("layeredMaskTex", tp)) return state.skip("no blend texture plugin");
+		std::list<paraMap_t> nodes;
+		paraMap_t mp = shaderNode("maskMap", "texture_mapper"), lp = shaderNode("mask", "layer");
+		mp["texture"] = std::string("layeredMaskTex");
+		lp["input"] = std::string("maskMap");
+		lp["color_input"] = false;
+		lp["do_color"] = false;
+		lp["do_scalar"] = true;
+		nodes.push_back(mp);
+		nodes.push_back(lp);
+		paraMap_t params;
+		params["type"] = std::string("blend_mat");
+		params["material1"] = std::string("layered1");
+		params["material2"] = std::string("layered2");
+		params["mask"] = std::string("mask");
+		mat = env->createMaterial("layeredBlend", params, nodes);
+		if(!mat) return state.skip("no blend_mat plugin");
+	}
+
+	const int n = 1024;
+	std::vector<surfacePoint_t> points(n);
+	random_t rnd(10);
+	for(int i = 0; i < n; ++i)
+	{
+		surfacePoint_t &sp = points[i];
+		sp.P = point3d_t(4.f * rnd() - 2.f, 4.f * rnd() - 2.f, 4.f * rnd() - 2.f);
+		sp.N = sp.Ng = sp.orcoNg = randomDir(rnd);
+		createCS(sp.N, sp.NU, sp.NV);
+		sp.dPdU = sp.NU;
+		sp.dPdV = sp.NV;
+		sp.dSdU = vector3d_t(1.f, 0.f, 0.f);
+		sp.dSdV = vector3d_t(0.f, 1.f, 0.f);
+		sp.orcoP = sp.P;
+		sp.U = rnd();
+		sp.V = rnd();
+	}
+	// getReqMem() of a blend leaves out its materials, integrators always hand out USER_DATA_SIZE
+	unsigned char userdata[USER_DATA_SIZE+7];
+	renderState_t rs;
+	rs.userdata = (void *)( ((size_t)&userdata[7])&(~7 ) ); // pad userdata to 8 bytes
+	float sum = 0.f;
+	while(state.keepRunning())
+	{
+		for(int i = 0; i < n; ++i)
+		{
+			if(state.arg == 0)
+			{
+				BSDF_t bsdfs;
+				mat->initBSDF(rs, points[i], bsdfs);
+				sum += bsdfs;
+			}
+			else sum += mat->getTransparency(rs, points[i], points[i].N).G;
+		}
+	}
+	sink = sum;
+	state.setItemsProcessed((double)state.iterations * n);
+}
+
+void registerMicroBenchmarks(std::vector<benchCase_t> &list)
+{
+	list.push_back(benchCase_t("kdtree/build/20k", benchKdBuildSmall));
+	list.push_back(benchCase_t("kdtree/build/200k", benchKdBuildLarge));
+	list.push_back(benchCase_t("kdtree/intersect/coherent", benchKdCoherent));
+	list.push_back(benchCase_t("kdtree/intersect/incoherent", benchKdIncoherent));
+	list.push_back(benchCase_t("kdtree/shadow", benchKdShadow));
+	list.push_back(benchCase_t("triangle/intersect", benchTriangleIntersect));
+	for(size_t i = 0; i < benchConfig.threads.size(); ++i)
+	{
+		std::stringstream name;
+		name << "imagefilm/addsample/threads:" << benchConfig.threads[i];
+		list.push_back(benchCase_t(name.str(), benchAddSample, benchConfig.threads[i]));
+	}
+	list.push_back(benchCase_t("photonmap/gather", benchPhotonGather));
+	list.push_back(benchCase_t("hashgrid/gather", benchHashGridGather));
+	for(int i = 0; i < 5; ++i) list.push_back(benchCase_t(std::string("noise/") + noiseTypes[i], benchNoise, i));
+	for(int i = 0; i < 3; ++i) list.push_back(benchCase_t(std::string("imagetex/") + interpolations[i], benchImageTexture, i));
+	list.push_back(benchCase_t("color/arith", benchColorArith));
+	list.push_back(benchCase_t("vector/frame", benchVectorFrame));
+	for(int i = 0; i < 3; ++i) list.push_back(benchCase_t(std::string("color/kernel/") + colorKernels[i], benchColorKernel, i));
+	for(int i = 0; i < 2; ++i) list.push_back(benchCase_t(std::string("material/layered/") + materialCalls[i], benchLayeredMaterial, i));
+}
+
+__END_YAFRAY
@@ -0,0 +1,352 @@
+/****************************************************************************
+ *
+ *      simdcheck.cc: checks the color and vector arithmetic against scalar code
+ *      This is part of the yafray package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+/*	Regression check for the SSE code of color_t, colorA_t and vector3d_t (SIMD_MATH) and the
+	batched color kernels: every operation is compared with a plain float version written out
+	in the order of the scalar code, over random inputs including zeros and negative zeros.
+	The release build uses -ffast-math, which leaves NaNs undefined (so there are none among
+	the inputs) and ignores the sign of zero (so -0 equals +0 here). Single operations must give
+	the same value; compound ones (dot products, normalization), divisions, which -ffast-math
+	turns into multiplications with the reciprocal in the scalar code, and the pow approximation
+	may differ by a few units in the last place. Exits with 1 if any result is off.
+	Usage: yafaray-simdcheck [-n samples]
+*/
+
+#include <yafray_config.h>
+#include <core_api/color.h>
+#include <core_api/vector3d.h>
+#include <utilities/simd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <string>
+
+__BEGIN_YAFRAY
+
+//! distance of a and b in units in the last place
+static unsigned int ulps(float a, float b)
+{
+	int ia, ib;
+	std::memcpy(&ia, &a, sizeof(ia));
+	std::memcpy(&ib, &b, sizeof(ib));
+	// map the sign-magnitude bits to a monotonic integer scale, -0 and +0 both become 0
+	if(ia < 0) ia = (int)0x80000000 - ia;
+	if(ib < 0) ib = (int)0x80000000 - ib;
+	long long d = (long long)ia - (long long)ib;
+	return (unsigned int)(d < 0 ? -d : d);
+}
+
+struct checkResult_t
+{
+	checkResult_t(const char *n, unsigned int tol): name(n), tolerance(tol), tests(0), failures(0), worst(0) {}
+	void compare(const float *got, const float *ref, int n)
+	{
+		++tests;
+		bool fail = false;
+		for(int i = 0; i < n; ++i)
+		{
+			unsigned int u = ulps(got[i], ref[i]);
+			if(u > worst) worst = u;
+			if(u > tolerance) fail = true;
+		}
+		if(fail && ++failures <= 3)
+		{
+			printf("  %s mismatch:", name);
+			for(int i = 0; i < n; ++i) printf(" %.9g/%.9g", got[i], ref[i]);
+			printf("\n");
+		}
+	}
+	void compare(float got, float ref) { compare(&got, &ref, 1); }
+	void compare(const vector3d_t &got, const float ref[3]) { float g[3] = { got.x, got.y, got.z }; compare(g, ref, 3); }
+	void compare(const color_t &got, const float ref[3]) { float g[3] = { got.R, got.G, got.B }; compare(g, ref, 3); }
+	void compare(const colorA_t &got, const float ref[4]) { float g[4] = { got.R, got.G, got.B, got.A }; compare(g, ref, 4); }
+	const char *name;
+	unsigned int tolerance; //!< ulps
+	long long tests, failures;
+	unsigned int worst;
+};
+
+class checker_t
+{
+	public:
+		checker_t(): seed(12345) {}
+		checkResult_t &operator()(const char *name, unsigned int tolerance = 0)
+		{
+			// the names are literals, compare the pointers first
+			for(size_t i = 0; i < results.size(); ++i) if(results[i].name == name) return results[i];
+			for(size_t i = 0; i < results.size(); ++i) if(!strcmp(results[i].name, name)) return results[i];
+			results.push_back(checkResult_t(name, tolerance));
+			return results.back();
+		}
+		//! mostly values in [-2, 2], with some exact zeros, negative zeros and large values
+		float value()
+		{
+			seed = seed * 1664525u + 1013904223u;
+			unsigned int r = seed >> 8;
+			switch(r & 63)
+			{
+				case 0: return 0.f;
+				case 1: return -0.f;
+				case 2: return (float)(r >> 6) * 1e3f;
+				default: return (float)(r >> 6) * (4.f / (float)(1 << 18)) - 2.f;
+			}
+		}
+		std::vector<checkResult_t> results;
+		unsigned int seed;
+};
+
+static void checkVectors(checker_t &chk, int samples)
+{
+	for(int s = 0; s < samples; ++s)
+	{
+		float a[3], b[3], f = chk.value();
+		for(int i = 0; i < 3; ++i) { a[i] = chk.value(); b[i] = chk.value(); }
+		// a zero vector now and then, for null() and normalize()
+		if(s % 97 == 0) a[0] = a[1] = a[2] = 0.f;
+		if(f == 0.f) f = 0.5f;
+		vector3d_t va(a[0], a[1], a[2]), vb(b[0], b[1], b[2]);
+		float r[3];
+
+		for(int i = 0; i < 3; ++i) r[i] = a[i] + b[i];
+		chk("vector a+b").compare(va + vb, r);
+		for(int i = 0; i < 3; ++i) r[i] = a[i] - b[i];
+		chk("vector a-b").compare(va - vb, r);
+		for(int i = 0; i < 3; ++i) r[i] = -a[i];
+		chk("vector -a").compare(-va, r);
+		for(int i = 0; i < 3; ++i) r[i] = a[i] * f;
+		chk("vector a*f").compare(va * f, r);
+		chk("vector f*a").compare(f * va, r);
+		for(int i = 0; i < 3; ++i) r[i] = a[i] / f;
+		chk("vector a/f", 4).compare(va / f, r);
+		vector3d_t t = va;
+		t.abs();
+		for(int i = 0; i < 3; ++i) r[i] = std::fabs(a[i]);
+		chk("vector abs").compare(t, r);
+		chk("vector null").compare((float)va.null(), (float)(a[0] == 0 && a[1] == 0 && a[2] == 0));
+
+		chk("vector dot", 4).compare(va * vb, a[0] * b[0] + a[1] * b[1] + a[2] * b[2]);
+		r[0] = a[1] * b[2] - a[2] * b[1];
+		r[1] = a[2] * b[0] - a[0] * b[2];
+		r[2] = a[0] * b[1] - a[1] * b[0];
+		chk("vector cross", 4).compare(va ^ vb, r);
+
+		float len2 = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+		float inv = len2 != 0 ? (float)(1.0 / fSqrt(len2)) : 1.f;
+		for(int i = 0; i < 3; ++i) r[i] = len2 != 0 ? a[i] * inv : a[i];
+		t = va;
+		chk("vector normalize", 4).compare(t.normalize(), r);
+		t = va;
+		chk("vector normLenSqr", 4).compare(t.normLenSqr(), len2);
+		chk("vector normLenSqr dir", 4).compare(t, r);
+		t = va;
+		float len = len2 != 0 ? fSqrt(len2) : 0.f;
+		chk("vector normLen", 4).compare(t.normLen(), len);
+
+		// reflect about a unit normal, 2*(v.n)*n - v
+		vector3d_t n = vb;
+		n.normalize();
+		float nn[3] = { n.x, n.y, n.z };
+		float vn = 2.0f * (a[0] * nn[0] + a[1] * nn[1] + a[2] * nn[2]);
+		for(int i = 0; i < 3; ++i) r[i] = vn * nn[i] - a[i];
+		t = va;
+		chk("vector reflect", 8).compare(t.reflect(n), r);
+	}
+}
+
+static void checkColors(checker_t &chk, int samples)
+{
+	for(int s = 0; s < samples; ++s)
+	{
+		float a[4], b[4], f = chk.value();
+		for(int i = 0; i < 4; ++i) { a[i] = chk.value(); b[i] = chk.value(); }
+		if(s % 97 == 0) a[0] = a[1] = a[2] = 0.f;
+		if(f == 0.f) f = 0.5f;
+		color_t ca(a[0], a[1], a[2]), cb(b[0], b[1], b[2]);
+		colorA_t aa(a[0], a[1], a[2], a[3]), ab(b[0], b[1], b[2], b[3]);
+		float r[4];
+
+		for(int i = 0; i < 3; ++i) r[i] = a[i] + b[i];
+		chk("color a+b").compare(ca + cb, r);
+		color_t t = ca;
+		t += cb;
+		chk("color a+=b").compare(t, r);
+		for(int i = 0; i < 3; ++i) r[i] = a[i] - b[i];
+		chk("color a-b").compare(ca - cb, r);
+		t = ca;
+		t -= cb;
+		chk("color a-=b").compare(t, r);
+		for(int i = 0; i < 3; ++i) r[i] = a[i] * b[i];
+		chk("color a*b").compare(ca * cb, r);
+		t = ca;
+		t *= cb;
+		chk("color a*=b").compare(t, r);
+		for(int i = 0; i < 3; ++i) r[i] = a[i] * f;
+		chk("color a*f").compare(ca * f, r);
+		chk("color f*a").compare(f * ca, r);
+		t = ca;
+		t *= f;
+		chk("color a*=f").compare(t, r);
+		for(int i = 0; i < 3; ++i) r[i] = a[i] / f;
+		chk("color a/f", 4).compare(ca / f, r);
+		chk("color isBlack").compare((float)ca.isBlack(), (float)(a[0] == 0 && a[1] == 0 && a[2] == 0));
+
+		for(int i = 0; i < 3; ++i) r[i] = a[i] < 0.f ? 0.f : a[i];
+		t = ca;
+		t.clampRGB0();
+		chk("color clampRGB0").compare(t, r);
+		for(int i = 0; i < 3; ++i) r[i] = a[i] < 0.f ? 0.f : (a[i] > 1.f ? 1.f : a[i]);
+		t = ca;
+		t.clampRGB01();
+		chk("color clampRGB01").compare(t, r);
+		for(int i = 0; i < 3; ++i) r[i] = std::fabs(a[i]);
+		t = ca;
+		t.absRGB();
+		chk("color absRGB").compare(t, r);
+		for(int i = 0; i < 3; ++i) r[i] = a[i] > b[i] ? b[i] : a[i];
+		t = ca;
+		t.darkenRGB(cb);
+		chk("color darkenRGB").compare(t, r);
+		for(int i = 0; i < 3; ++i) r[i] = a[i] < b[i] ? b[i] : a[i];
+		t = ca;
+		t.lightenRGB(cb);
+		chk("color lightenRGB").compare(t, r);
+
+		// colorA_t keeps alpha next to the color, the RGB only operations must leave it alone
+		for(int i = 0; i < 4; ++i) r[i] = a[i] + b[i];
+		chk("colorA a+b").compare(aa + ab, r);
+		for(int i = 0; i < 4; ++i) r[i] = a[i] - b[i];
+		chk("colorA a-b").compare(aa - ab, r);
+		for(int i = 0; i < 4; ++i) r[i] = a[i] * b[i];
+		chk("colorA a*b").compare(aa * ab, r);
+		for(int i = 0; i < 4; ++i) r[i] = a[i] * f;
+		chk("colorA a*f").compare(aa * f, r);
+		// colorA_t divides by multiplying with the reciprocal
+		float inv = (float)(1.0 / f);
+		for(int i = 0; i < 4; ++i) r[i] = a[i] * inv;
+		chk("colorA a/f").compare(aa / f, r);
+		for(int i = 0; i < 3; ++i) r[i] = a[i] < 0.f ? 0.f : (a[i] > 1.f ? 1.f : a[i]);
+		r[3] = a[3];
+		colorA_t ta = aa;
+		ta.clampRGB01();
+		chk("colorA clampRGB01").compare(ta, r);
+	}
+}
+
+static void checkKernels(checker_t &chk, int samples)
+{
+	// odd length, so a wider implementation has to handle a remainder
+	const int n = 1021;
+	std::vector<colorA_t> c(n), ref(n);
+	std::vector<CFLOAT> w(n);
+	for(int s = 0; s < samples; s += n)
+	{
+		for(int i = 0; i < n; ++i)
+		{
+			c[i] = colorA_t(chk.value(), chk.value(), chk.value(), chk.value());
+			w[i] = chk.value();
+		}
+
+		ref = c;
+		for(int i = 0; i < n; ++i) { ref[i].R *= w[i]; ref[i].G *= w[i]; ref[i].B *= w[i]; ref[i].A *= w[i]; }
+		std::vector<colorA_t> t(c);
+		scaleColors(&t[0], &w[0], n);
+		for(int i = 0; i < n; ++i) chk("kernel scaleColors").compare(t[i], &ref[i].R);
+
+		ref = c;
+		for(int i = 0; i < n; ++i)
+		{
+			if(ref[i].R < 0.f) ref[i].R = 0.f;
+			if(ref[i].G < 0.f) ref[i].G = 0.f;
+			if(ref[i].B < 0.f) ref[i].B = 0.f;
+		}
+		t = c;
+		clampColorsRGB0(&t[0], n);
+		for(int i = 0; i < n; ++i) chk("kernel clampColorsRGB0").compare(t[i], &ref[i].R);
+
+		ref = c;
+		for(int i = 0; i < n; ++i)
+		{
+			float *p = &ref[i].R;
+			for(int k = 0; k < 3; ++k) p[k] = p[k] < 0.f ? 0.f : (p[k] > 1.f ? 1.f : p[k]);
+		}
+		t = c;
+		clampColorsRGB01(&t[0], n);
+		for(int i = 0; i < n; ++i) chk("kernel clampColorsRGB01").compare(t[i], &ref[i].R);
+
+		// gamma of the film output, on the clamped colors it gets there
+		for(int i = 0; i < n; ++i) c[i].clampRGB0();
+		ref = c;
+		for(int i = 0; i < n; ++i) ref[i].gammaAdjust(1.f / 2.2f);
+		t = c;
+		gammaAdjustColors(&t[0], n, 1.f / 2.2f);
+		for(int i = 0; i < n; ++i) chk("kernel gammaAdjustColors", 64).compare(t[i], &ref[i].R);
+	}
+}
+
+__END_YAFRAY
+
+using namespace yafaray;
+
+int main(int argc, char *argv[])
+{
+	int samples = 200000;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(!strcmp(argv[i], "-n") && i + 1 < argc) samples = std::max(1, atoi(argv[++i]));
+		else
+		{
+			printf("Usage: %s [-n samples]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	printf("Color and vector arithmetic: %s, color kernels: %s, %d samples\n",
+#ifdef Y_SSE
+		"SSE",
+#else
+		"scalar",
+#endif
+#ifdef Y_HAVE_SSE2
+		"SSE2"
+#else
+		"scalar"
+#endif
+		, samples);
+
+	checker_t chk;
+	checkVectors(chk, samples);
+	checkColors(chk, samples);
+	checkKernels(chk, samples);
+
+	long long failures = 0;
+	printf("\n%-26s %10s %10s %10s\n", "operation", "tests", "failures", "max ulps");
+	for(size_t i = 0; i < chk.results.size(); ++i)
+	{
+		const checkResult_t &r = chk.results[i];
+		printf("%-26s %10lld %10lld %10u\n", r.name, r.tests, r.failures, r.worst);
+		failures += r.failures;
+	}
+	printf("\n%s\n", failures ? "FAILED" : "passed");
+	return failures ? 1 : 0;
+}
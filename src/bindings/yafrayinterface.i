@@ -143,6 +143,24 @@ public:
 		return true;
 	}
 
+	virtual bool putArea(int x0, int y0, int w, int h, const float *c, int stride, bool alpha = true, const float *z = 0, int zStride = 0)
+	{
+		for(int j = 0; j < h; ++j)
+		{
+			yafTilePixel_t *pix = tile->mem + resx * (y0 + j) + x0;
+			const float *col = c + j * stride;
+			for(int i = 0; i < w; ++i, col += 4)
+			{
+				pix[i].r = col[0];
+				pix[i].g = col[1];
+				pix[i].b = col[2];
+				pix[i].a = alpha ? col[3] : 1.0f;
+			}
+		}
+
+		return true;
+	}
+
 	virtual void flush()
 	{
 		tile->x0 = 0;
@@ -405,6 +423,7 @@ namespace yafaray
 			virtual bool saveToFile(const std::string &name) = 0;
 			virtual void putPixel(int x, int y, const colorA_t &rgba, float depth = 0.f) = 0;
 			virtual colorA_t getPixel(int x, int y) = 0;
+			void setNumThreads(int n);
 
 		protected:
 			std::string handlerName;
@@ -427,6 +446,8 @@ namespace yafaray
 			virtual bool putPixel(int x, int y, const float *c, bool alpha = true, bool depth = false, float z = 0.f);
 			virtual void flush();
 			virtual void flushArea(int x0, int y0, int x1, int y1) {}; // not used by images... yet
+			void setAsyncSave(bool on);
+			bool waitSave();
 		private:
 			imageHandler_t *image;
 			std::string fname;
@@ -515,6 +536,7 @@ namespace yafaray
 			virtual int  addUV(float u, float v); //!< add a UV coordinate pair; returns index to be used for addTriangle
 			virtual bool smoothMesh(unsigned int id, double angle); //!< smooth vertex normals of mesh with given ID and angle (in degrees)
 			virtual bool addInstance(unsigned int baseObjectId, matrix4x4_t objToWorld);
+			virtual bool addInstance(unsigned int baseObjectId, matrix4x4_t objToWorld, matrix4x4_t objToWorldEnd); //!< instance moving from objToWorld to objToWorldEnd during the frame
 			// functions to build paramMaps instead of passing them from Blender
 			// (decouling implementation details of STL containers, paraMap_t etc. as much as possible)
 			virtual void paramsSetPoint(const char* name, double x, double y, double z);
@@ -33,6 +33,8 @@ angularCam_t::angularCam_t(const point3d_t &pos, const point3d_t &look, const po
 	setAxis(camX,camY,camZ);
 
 	max_r = 1;
+	du_dpx = -2.f / (PFLOAT)resx;
+	dv_dpy = 2.f * aspect_ratio / (PFLOAT)resy;
 }
 
 void angularCam_t::setAxis(const vector3d_t &vx, const vector3d_t &vy, const vector3d_t &vz)
@@ -68,6 +70,52 @@ ray_t angularCam_t::shootRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOAT &w
 	return ray;
 }
 
+/*! Same mapping as shootRay(), written as dir = s(r) * (u*vright + v*vup) + cos(r*hor_phi) * vto
+	with s(r) = sin(r*hor_phi) / r, so the derivatives with respect to u and v come without atan2
+	and without a second and third evaluation of the trigonometric functions. */
+diffRay_t angularCam_t::shootDiffRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOAT &wt) const
+{
+	diffRay_t ray;
+	wt = 1;
+	ray.from = position;
+	PFLOAT u = 1.f - 2.f * (px/(PFLOAT)resx);
+	PFLOAT v = 2.f * (py/(PFLOAT)resy) - 1.f;
+	v *= aspect_ratio;
+	PFLOAT radius = fSqrt(u*u + v*v);
+	if (circular && radius>max_r) { wt=0; return ray; }
+	PFLOAT phi = radius * hor_phi;
+	PFLOAT sinPhi = fSin(phi), cosPhi = fCos(phi);
+
+	// s(r), s'(r)/r and (d cos(r*hor_phi)/dr)/r, with their limits for r -> 0
+	PFLOAT s, k, m;
+	if (radius > 1e-4f)
+	{
+		s = sinPhi / radius;
+		k = (hor_phi * cosPhi - s) / (radius * radius);
+		m = hor_phi * sinPhi / radius;
+	}
+	else
+	{
+		s = hor_phi;
+		k = -hor_phi * hor_phi * hor_phi / 3.f;
+		m = hor_phi * hor_phi;
+	}
+
+	vector3d_t side = u*vright + v*vup;
+	ray.dir = s*side + cosPhi*vto;
+
+	ray.tmin = nearClippingDistance;
+	ray.tmax = farClippingDistance;
+
+	vector3d_t dDdu = s*vright + (u*k)*side - (u*m)*vto;
+	vector3d_t dDdv = s*vup + (v*k)*side - (v*m)*vto;
+	ray.xfrom = ray.yfrom = ray.from;
+	ray.xdir = ray.dir + du_dpx * dDdu;
+	ray.ydir = ray.dir + dv_dpy * dDdv;
+	ray.hasDifferentials = true;
+	return ray;
+}
+
 camera_t* angularCam_t::factory(paraMap_t &params, renderEnvironment_t &render)
 {
 	point3d_t from(0,1,0), to(0,0,0), up(0,1,1);
@@ -61,6 +61,17 @@ ray_t orthoCam_t::shootRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOAT &wt)
 	return ray;
 }
 
+diffRay_t orthoCam_t::shootDiffRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOAT &wt) const
+{
+	diffRay_t ray(shootRay(px, py, lu, lv, wt));
+	// all rays are parallel, the differentials are just offset by one pixel
+	ray.xfrom = ray.from + vright;
+	ray.yfrom = ray.from + vup;
+	ray.xdir = ray.ydir = ray.dir;
+	ray.hasDifferentials = true;
+	return ray;
+}
+
 point3d_t orthoCam_t::screenproject(const point3d_t &p) const
 {
 	point3d_t s;
@@ -145,6 +145,44 @@ ray_t perspectiveCam_t::shootRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOA
 	return ray;
 }
 
+/*! The differentials are the first order change of the ray per pixel: vright and vup are the
+	pixel deltas on the image plane, their component orthogonal to the ray, divided by the distance
+	to the image plane point, gives the change of the normalized direction. With DOF the same
+	is done again for the focus point seen from the lens sample. */
+diffRay_t perspectiveCam_t::shootDiffRay(PFLOAT px, PFLOAT py, float lu, float lv, PFLOAT &wt) const
+{
+	diffRay_t ray;
+	wt = 1;
+
+	ray.from = position;
+	ray.dir = vright*px + vup*py + vto;
+	PFLOAT iLen = 1.f / ray.dir.normLen();
+
+	ray.tmin = nearClippingDistance;
+	ray.tmax = farClippingDistance;
+
+	vector3d_t dDdx = (vright - ray.dir * (ray.dir * vright)) * iLen;
+	vector3d_t dDdy = (vup - ray.dir * (ray.dir * vup)) * iLen;
+
+	if (aperture!=0) {
+		PFLOAT u, v;
+
+		getLensUV(lu, lv, u, v);
+		vector3d_t LI = dof_rt * u + dof_up * v;
+		ray.from += point3d_t(LI);
+		ray.dir = (ray.dir * dof_distance) - LI;
+		iLen = dof_distance / ray.dir.normLen();
+		dDdx = (dDdx - ray.dir * (ray.dir * dDdx)) * iLen;
+		dDdy = (dDdy - ray.dir * (ray.dir * dDdy)) * iLen;
+	}
+
+	ray.xfrom = ray.yfrom = ray.from;
+	ray.xdir = ray.dir + dDdx;
+	ray.ydir = ray.dir + dDdy;
+	ray.hasDifferentials = true;
+	return ray;
+}
+
 point3d_t perspectiveCam_t::screenproject(const point3d_t &p) const
 {
 	point3d_t s;
@@ -23,6 +23,7 @@
 #include "events.h"
 #include <QtCore/QCoreApplication>
 #include <iostream>
+#include <vector>
 #include <cstdlib>
 
 QtOutput::QtOutput(RenderWidget *render): renderBuffer(render)
@@ -64,6 +65,35 @@ bool QtOutput::putPixel(int x, int y, const float *c, bool alpha, bool depth, fl
 	return true;
 }
 
+bool QtOutput::putArea(int x0, int y0, int w, int h, const float *c, int stride, bool alpha, const float *z, int zStride)
+{
+	std::vector<QRgb> rgb(w), aval(alpha ? w : 0), zval(z ? w : 0);
+
+	for (int j = 0; j < h; ++j)
+	{
+		const float *col = c + j * stride;
+		for (int i = 0; i < w; ++i, col += 4)
+		{
+			rgb[i] = qRgb(std::max(0,std::min(255, (int)(col[0] * 255.f))),
+						  std::max(0,std::min(255, (int)(col[1] * 255.f))),
+						  std::max(0,std::min(255, (int)(col[2] * 255.f))));
+			if (alpha)
+			{
+				int a = std::max(0,std::min(255, (int)(col[3] * 255.f)));
+				aval[i] = qRgb(a, a, a);
+			}
+			if (z)
+			{
+				int d = std::max(0,std::min(255, (int)(z[j * zStride + i] * 255.f)));
+				zval[i] = qRgb(d, d, d);
+			}
+		}
+		renderBuffer->setRow(x0, y0 + j, w, &rgb[0], alpha ? &aval[0] : NULL, z ? &zval[0] : NULL);
+	}
+
+	return true;
+}
+
 void QtOutput::flush()
 {
 	QCoreApplication::postEvent(renderBuffer, new GuiUpdateEvent(QRect(), true));
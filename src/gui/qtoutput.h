@@ -38,6 +38,7 @@ public:
 
 	// inherited from yafaray::colorOutput_t
 	virtual bool putPixel(int x, int y, const float *c, bool alpha = true, bool depth = false, float z = 0.f);
+	virtual bool putArea(int x0, int y0, int w, int h, const float *c, int stride, bool alpha = true, const float *z = 0, int zStride = 0);
 	virtual void flush();
 	virtual void flushArea(int x0, int y0, int x1, int y1);
 	virtual void highliteArea(int x0, int y0, int x1, int y1);
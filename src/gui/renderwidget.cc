@@ -27,6 +27,7 @@
 #include "renderwidget.h"
 #include "events.h"
 #include <iostream>
+#include <cstring>
 
 /*=====================================
 /	RenderWidget implementation
@@ -110,6 +111,17 @@ void RenderWidget::setPixel(int x, int y, QRgb color, QRgb alpha, QRgb depth, bo
 	if (withDepth) depthChannel.setPixel(ix, iy, depth);
 }
 
+void RenderWidget::setRow(int x, int y, int n, const QRgb *color, const QRgb *alpha, const QRgb *depth)
+{
+	int ix = x + borderStart.x();
+	int iy = y + borderStart.y();
+
+	// all buffers are Format_RGB32, one QRgb per pixel
+	memcpy((QRgb *)colorBuffer.scanLine(iy) + ix, color, n * sizeof(QRgb));
+	if (alpha) memcpy((QRgb *)alphaChannel.scanLine(iy) + ix, alpha, n * sizeof(QRgb));
+	if (depth) memcpy((QRgb *)depthChannel.scanLine(iy) + ix, depth, n * sizeof(QRgb));
+}
+
 void RenderWidget::paintColorBuffer()
 {
 	bufferMutex.lock();
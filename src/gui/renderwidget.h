@@ -50,6 +50,8 @@ public:
 	void finishRendering();
 
 	void setPixel(int x, int y, QRgb color, QRgb alpha, QRgb depth, bool withAlpha, bool withDepth);
+	//! sets n pixels of row y starting at x; alpha and depth may be NULL
+	void setRow(int x, int y, int n, const QRgb *color, const QRgb *alpha, const QRgb *depth);
 
 	void paintColorBuffer();
 	void paintAlpha();
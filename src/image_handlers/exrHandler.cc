@@ -29,6 +29,7 @@
 #include <ImfRgbaFile.h>
 #include <ImfArray.h>
 #include <ImfVersion.h>
+#include <ImfThreading.h>
 
 #include <cstdio>
 
@@ -50,6 +51,7 @@ public:
 	bool loadFromFile(const std::string &name);
 	bool saveToFile(const std::string &name);
 	void putPixel(int x, int y, const colorA_t &rgba, float depth = 0.f);
+	void putArea(int x0, int y0, int w, int h, const colorA_t *rgba, int stride, const float *depth, int depthStride);
 	colorA_t getPixel(int x, int y);
 	static imageHandler_t *factory(paraMap_t &params, renderEnvironment_t &render);
 	bool isHDR() { return true; }
@@ -115,7 +117,10 @@ bool exrHandler_t::saveToFile(const std::string &name)
 	header.channels().insert("A", Channel(HALF));
 	if(m_hasDepth) header.channels().insert("Z", Channel(Imf::FLOAT));
 
-	OutputFile file(name.c_str(), header);
+	// ZIP compresses blocks of 16 lines, with several threads OpenEXR compresses them in parallel
+	if(m_threads > 1 && globalThreadCount() < m_threads) setGlobalThreadCount(m_threads);
+
+	OutputFile file(name.c_str(), header, (m_threads > 1) ? m_threads : globalThreadCount());
 
 	char* data_ptr = (char *)&(*m_halfrgba)(0, 0);
 
@@ -155,6 +160,30 @@ void exrHandler_t::putPixel(int x, int y, const colorA_t &rgba, float depth)
 	if(m_hasDepth) (*m_depthSL)(y, x) = depth;
 }
 
+void exrHandler_t::putArea(int x0, int y0, int w, int h, const colorA_t *rgba, int stride, const float *depth, int depthStride)
+{
+	// the half buffer is stored by rows, (y, x) addresses it
+	for(int j = 0; j < h; ++j)
+	{
+		Rgba *pixel = &(*m_halfrgba)(y0 + j, x0);
+		const colorA_t *row = rgba + j * stride;
+
+		for(int i = 0; i < w; ++i)
+		{
+			pixel[i].r = row[i].getR();
+			pixel[i].g = row[i].getG();
+			pixel[i].b = row[i].getB();
+			pixel[i].a = (m_hasAlpha) ? row[i].getA() : 1.f;
+		}
+
+		if(m_hasDepth && depth)
+		{
+			float *z = &(*m_depthSL)(y0 + j, x0);
+			for(int i = 0; i < w; ++i) z[i] = depth[j * depthStride + i];
+		}
+	}
+}
+
 colorA_t exrHandler_t::getPixel(int x, int y)
 {
 	Rgba &pixel = (*m_halfrgba)(x, y);
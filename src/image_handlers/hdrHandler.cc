@@ -24,7 +24,9 @@
 #include <core_api/environment.h>
 #include <core_api/imagehandler.h>
 #include <core_api/params.h>
+#include <yafraycore/ccthreads.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <vector>
@@ -39,21 +41,37 @@ public:
 	hdrHandler_t();
 	~hdrHandler_t();
 	void initForOutput(int width, int height, bool withAlpha = false, bool withDepth = false);
+	//! like initForOutput() but without frame buffers, the image can only be written by streaming
+	void initForStream(int width, int height, bool withAlpha = false, bool withDepth = false);
 	bool loadFromFile(const std::string &name);
 	bool saveToFile(const std::string &name);
 	void putPixel(int x, int y, const colorA_t &rgba, float depth = 0.f);
 	colorA_t getPixel(int x, int y);
 	static imageHandler_t *factory(paraMap_t &params, renderEnvironment_t &render);
 	bool isHDR() { return true; }
+	streamMode_t streamMode() const { return (m_streaming) ? STREAM_ROWS : STREAM_NONE; }
+	bool openStream(const std::string &name);
+	bool writeStream(int x, int y, int n, const colorA_t *rgba, const float *depth);
+	bool closeStream();
 
 private:
+	friend class hdrEncodeJob_t;
 	bool writeHeader(std::ofstream &file);
+	//! writes all scanlines of the color or depth buffer, they are encoded in bands across m_threads threads
+	bool writeImage(std::ofstream &file, bool depth);
 	bool writeScanline(std::ofstream &file, rgbePixel_t *scanline);
+	//! appends the scanline RLE compressed to out
+	bool encodeScanline(rgbePixel_t *scanline, std::vector<yByte> &out) const;
 	bool readHeader(std::ifstream &file); //!< Reads file header and detects if the file is valid
 	bool readORLE(std::ifstream &file, int y, int scanWidth); //!< Reads the scanline with the original Radiance RLE schema or without compression
 	bool readARLE(std::ifstream &file, int y, int scanWidth); //!< Reads a scanline with Adaptative RLE schema
 
 	rgbeHeader_t header;
+
+	bool m_streaming;
+	std::ofstream streamFile, depthStreamFile;
+	int streamRows; //!< rows written to the open stream
+	std::vector<rgbePixel_t> streamScanline;
 };
 
 hdrHandler_t::hdrHandler_t()
@@ -66,11 +84,15 @@ hdrHandler_t::hdrHandler_t()
 	m_rgba = NULL;
 	m_depth = NULL;
 
+	m_streaming = false;
+	streamRows = 0;
+
 	handlerName = "hdrHandler";
 }
 
 hdrHandler_t::~hdrHandler_t()
 {
+	closeStream();
 	if(m_rgba) delete m_rgba;
 	if(m_depth) delete m_depth;
 	m_rgba = NULL;
@@ -92,6 +114,15 @@ void hdrHandler_t::initForOutput(int width, int height, bool withAlpha, bool wit
 	}
 }
 
+void hdrHandler_t::initForStream(int width, int height, bool withAlpha, bool withDepth)
+{
+	m_width = width;
+	m_height = height;
+	m_hasAlpha = withAlpha;
+	m_hasDepth = withDepth;
+	m_streaming = true;
+}
+
 bool hdrHandler_t::loadFromFile(const std::string &name)
 {
 	Y_INFO << handlerName << ": Loading image \"" << name << "\"..." << yendl;
@@ -417,6 +448,65 @@ bool hdrHandler_t::readARLE(std::ifstream &file, int y, int scanWidth)
 	return true;
 }
 
+//! encodes the scanlines [y0+start, y0+end) into the buffers [start, end), an empty buffer marks a failed scanline
+class hdrEncodeJob_t: public yafthreads::parallelJob_t
+{
+	public:
+		hdrEncodeJob_t(const hdrHandler_t &h, int y0, bool depth, std::vector< std::vector<yByte> > &out):
+			handler(h), y0(y0), depth(depth), encoded(out) {}
+		virtual void run(int start, int end)
+		{
+			rgbePixel_t signature; //scanline start signature for adaptative RLE
+			signature.setScanlineStart(handler.m_width);
+			std::vector<rgbePixel_t> scanline(handler.m_width + 1);
+
+			for(int j = start; j < end; j++)
+			{
+				int y = y0 + j;
+				for (int x = 0; x < handler.m_width; x++)
+				{
+					if(depth) scanline[x] = color_t((*handler.m_depth)(x, y));
+					else scanline[x] = (*handler.m_rgba)(x, y);
+				}
+
+				std::vector<yByte> &out = encoded[j];
+				out.assign((const yByte *)&signature, (const yByte *)&signature + sizeof(rgbePixel_t));
+				if (!handler.encodeScanline(&scanline[0], out)) out.clear();
+			}
+		}
+	protected:
+		const hdrHandler_t &handler;
+		int y0;
+		bool depth;
+		std::vector< std::vector<yByte> > &encoded;
+};
+
+bool hdrHandler_t::writeImage(std::ofstream &file, bool depth)
+{
+	// bands bound the memory taken by the encoded scanlines, which are written in order
+	const int bandRows = 256;
+	std::vector< std::vector<yByte> > encoded(std::min(m_height, bandRows));
+
+	for (int y0 = 0; y0 < m_height; y0 += bandRows)
+	{
+		int n = std::min(bandRows, m_height - y0);
+		hdrEncodeJob_t job(*this, y0, depth, encoded);
+		yafthreads::runParallel(job, n, m_threads);
+
+		for (int j = 0; j < n; j++)
+		{
+			if (encoded[j].empty())
+			{
+				Y_ERROR << handlerName << ": An error has occurred during scanline saving..." << yendl;
+				return false;
+			}
+			file.write((const char *)&encoded[j][0], encoded[j].size());
+		}
+	}
+
+	return file.good();
+}
+
 bool hdrHandler_t::saveToFile(const std::string &name)
 {
 	std::ofstream file(name.c_str(), std::ios::out | std::ios::binary);
@@ -432,31 +522,9 @@ bool hdrHandler_t::saveToFile(const std::string &name)
 
 		writeHeader(file);
 
-		rgbePixel_t signature; //scanline start signature for adaptative RLE
-		signature.setScanlineStart(m_width); //setup the signature
-
-		rgbePixel_t *scanline = new rgbePixel_t[m_width];
-
 		// write using adaptive-rle encoding
-		for (int y = 0; y < m_height; y++)
-		{
-			// write scanline start signature
-			file.write((char *)&signature, sizeof(rgbePixel_t));
-
-			// fill the scanline buffer
-			for (int x = 0; x < m_width; x++)
-			{
-				scanline[x] = getPixel(x, y);
-			}
+		if (!writeImage(file, false)) return false;
 
-			// write the scanline RLE compressed by channel in 4 separated blocks not as contigous pixels pixel blocks
-			if (!writeScanline(file, scanline))
-			{
-				Y_ERROR << handlerName << ": An error has occurred during scanline saving..." << yendl;
-				return false;
-			}
-		}
-		delete [] scanline;
 		file.close();
 	}
 
@@ -473,42 +541,100 @@ bool hdrHandler_t::saveToFile(const std::string &name)
 		{
 			Y_INFO << handlerName << ": Saving Z-Buffer as \"" << depthName << "\"..." << yendl;
 			writeHeader(file);
-			rgbePixel_t signature; //scanline start signature for adaptative RLE
-			signature.setScanlineStart(m_width); //setup the signature
 
-			rgbePixel_t *scanline = new rgbePixel_t[m_width];
+			if (!writeImage(file, true)) return false;
 
-			// write using adaptive-rle encoding
-			for (int y = 0; y < m_height; y++)
-			{
-				// write scanline start signature
-				file.write((char *)&signature, sizeof(rgbePixel_t));
+			file.close();
+		}
+	}
 
-				// fill the scanline buffer with converted colors
-				for (int x = 0; x < m_width; x++)
-				{
-					scanline[x] = color_t((*m_depth)(x, y));
-				}
+	Y_INFO << handlerName << ": Done." << yendl;
 
-				// write the scanline RLE compressed
-				if (!writeScanline(file, scanline))
-				{
-					Y_ERROR << handlerName << ": An error has occurred during scanline saving..." << yendl;
-					return false;
-				}
-			}
+	return true;
+}
 
-			delete [] scanline;
+bool hdrHandler_t::openStream(const std::string &name)
+{
+	closeStream();
+	streamFile.open(name.c_str(), std::ios::out | std::ios::binary);
+	if (!streamFile.is_open()) return false;
 
-			file.close();
+	Y_INFO << handlerName << ": Streaming RGBE file to \"" << name << "\"..." << yendl;
+	if (m_hasAlpha) Y_INFO << handlerName << ": Ignoring alpha channel." << yendl;
+	writeHeader(streamFile);
+
+	if(m_hasDepth)
+	{
+		std::string depthName = name.substr(0, name.size() - 4) + "_zbuffer.hdr";
+		depthStreamFile.open(depthName.c_str(), std::ios::out | std::ios::binary);
+		if (!depthStreamFile.is_open())
+		{
+			Y_ERROR << handlerName << ": Couldn't open file \"" << depthName << "\"..." << yendl;
+			closeStream();
+			return false;
 		}
+		Y_INFO << handlerName << ": Streaming Z-Buffer to \"" << depthName << "\"..." << yendl;
+		writeHeader(depthStreamFile);
 	}
 
-	Y_INFO << handlerName << ": Done." << yendl;
-
+	streamRows = 0;
+	streamScanline.resize(m_width);
 	return true;
 }
 
+bool hdrHandler_t::writeStream(int x, int y, int n, const colorA_t *rgba, const float *depth)
+{
+	// scanlines are RLE compressed and follow each other, they can only be written in order
+	if (!streamFile.is_open() || x != 0 || n != m_width || y != streamRows) return false;
+
+	rgbePixel_t signature; //scanline start signature for adaptative RLE
+	signature.setScanlineStart(m_width);
+
+	streamFile.write((char *)&signature, sizeof(rgbePixel_t));
+	for (int i = 0; i < n; i++) streamScanline[i] = rgba[i];
+	if (!writeScanline(streamFile, &streamScanline[0])) return false;
+
+	if (depthStreamFile.is_open())
+	{
+		depthStreamFile.write((char *)&signature, sizeof(rgbePixel_t));
+		for (int i = 0; i < n; i++) streamScanline[i] = color_t(depth[i]);
+		if (!writeScanline(depthStreamFile, &streamScanline[0])) return false;
+	}
+
+	++streamRows;
+	return streamFile.good();
+}
+
+bool hdrHandler_t::closeStream()
+{
+	if (!streamFile.is_open()) return true;
+
+	// missing scanlines are written black so the file stays readable
+	rgbePixel_t signature;
+	signature.setScanlineStart(m_width);
+	for (int i = 0; i < m_width; i++) streamScanline[i] = color_t(0.f);
+	for (; streamRows < m_height; streamRows++)
+	{
+		streamFile.write((char *)&signature, sizeof(rgbePixel_t));
+		writeScanline(streamFile, &streamScanline[0]);
+		if (depthStreamFile.is_open())
+		{
+			depthStreamFile.write((char *)&signature, sizeof(rgbePixel_t));
+			writeScanline(depthStreamFile, &streamScanline[0]);
+		}
+	}
+
+	bool ok = streamFile.good();
+	streamFile.close();
+	if (depthStreamFile.is_open())
+	{
+		ok = depthStreamFile.good() && ok;
+		depthStreamFile.close();
+	}
+	Y_INFO << handlerName << ": Done." << yendl;
+	return ok;
+}
+
 bool hdrHandler_t::writeHeader(std::ofstream &file)
 {
 	if (m_height <= 0 || m_width <=0) return false;
@@ -523,6 +649,14 @@ bool hdrHandler_t::writeHeader(std::ofstream &file)
 }
 
 bool hdrHandler_t::writeScanline(std::ofstream &file, rgbePixel_t *scanline)
+{
+	std::vector<yByte> out;
+	if (!encodeScanline(scanline, out)) return false;
+	file.write((const char *)&out[0], out.size());
+	return true;
+}
+
+bool hdrHandler_t::encodeScanline(rgbePixel_t *scanline, std::vector<yByte> &out) const
 {
 	int cur, beg_run, run_count, old_run_count, nonrun_count;
 	yByte runDesc;
@@ -552,8 +686,8 @@ bool hdrHandler_t::writeScanline(std::ofstream &file, rgbePixel_t *scanline)
 			if ((old_run_count > 1) && (old_run_count == beg_run - cur))
 			{
 				runDesc = 128 + old_run_count;
-				file.write((const char*)&runDesc, 1);
-				file.write((const char*)&scanline[cur][chan], 1);
+				out.push_back(runDesc);
+				out.push_back(scanline[cur][chan]);
 				cur = beg_run;
 			}
 
@@ -566,11 +700,11 @@ bool hdrHandler_t::writeScanline(std::ofstream &file, rgbePixel_t *scanline)
 				if (nonrun_count > 128) nonrun_count = 128;
 
 				runDesc = nonrun_count;
-				file.write((const char*)&runDesc, 1);
+				out.push_back(runDesc);
 
 				for(int i = 0; i < nonrun_count; i++)
 				{
-					file.write((const char*)&scanline[cur + i][chan], 1);
+					out.push_back(scanline[cur + i][chan]);
 				}
 
 				cur += nonrun_count;
@@ -580,8 +714,8 @@ bool hdrHandler_t::writeScanline(std::ofstream &file, rgbePixel_t *scanline)
 			if (run_count >= 4)
 			{
 				runDesc = 128 + run_count;
-				file.write((const char*)&runDesc, 1);
-				file.write((const char*)&scanline[beg_run][chan], 1);
+				out.push_back(runDesc);
+				out.push_back(scanline[beg_run][chan]);
 				cur += run_count;
 			}
 
@@ -611,16 +745,22 @@ imageHandler_t *hdrHandler_t::factory(paraMap_t &params,renderEnvironment_t &ren
 	bool withAlpha = false;
 	bool withDepth = false;
 	bool forOutput = true;
+	bool streaming = false;
 
 	params.getParam("width", width);
 	params.getParam("height", height);
 	params.getParam("alpha_channel", withAlpha);
 	params.getParam("z_channel", withDepth);
 	params.getParam("for_output", forOutput);
+	params.getParam("streaming", streaming);
 
-	imageHandler_t *ih = new hdrHandler_t();
+	hdrHandler_t *ih = new hdrHandler_t();
 
-	if(forOutput) ih->initForOutput(width, height, withAlpha, withDepth);
+	if(forOutput)
+	{
+		if(streaming) ih->initForStream(width, height, withAlpha, withDepth);
+		else ih->initForOutput(width, height, withAlpha, withDepth);
+	}
 
 	return ih;
 }
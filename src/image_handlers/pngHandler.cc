@@ -23,15 +23,21 @@
 #include <core_api/environment.h>
 #include <core_api/imagehandler.h>
 #include <core_api/params.h>
+#include <yafraycore/ccthreads.h>
 
 #include <png.h>
+#include <zlib.h>
 
 extern "C"
 {
 	#include <setjmp.h>
 }
 
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 
 #include "pngUtils.h"
 
@@ -43,16 +49,33 @@ public:
 	pngHandler_t();
 	~pngHandler_t();
 	void initForOutput(int width, int height, bool withAlpha = false, bool withDepth = false);
+	//! like initForOutput() but without frame buffers, the image can only be written by streaming
+	void initForStream(int width, int height, bool withAlpha = false, bool withDepth = false);
 	bool loadFromFile(const std::string &name);
 	bool loadFromMemory(const yByte *data, size_t size);
 	bool saveToFile(const std::string &name);
 	void putPixel(int x, int y, const colorA_t &rgba, float depth = 0.f);
 	colorA_t getPixel(int x, int y);
 	static imageHandler_t *factory(paraMap_t &params, renderEnvironment_t &render);
+	streamMode_t streamMode() const { return (m_streaming) ? STREAM_ROWS : STREAM_NONE; }
+	bool openStream(const std::string &name);
+	bool writeStream(int x, int y, int n, const colorA_t *rgba, const float *depth);
+	bool closeStream();
 private:
 	void readFromStructs(png_structp pngPtr, png_infop infoPtr);
 	bool fillReadStructs(yByte *sig, png_structp &pngPtr, png_infop &infoPtr);
 	bool fillWriteStructs(FILE* fp, unsigned int colorType, png_structp &pngPtr, png_infop &infoPtr);
+	//! writes 8 bit rows to a new file, compressed in strips across m_threads threads when there are several
+	bool writeImage(const std::string &name, unsigned int colorType, int channels, std::vector<yByte> &data);
+	//! finishes and closes one stream file, missing rows are written black
+	bool finishStreamFile(FILE *&fp, png_structp &pngPtr, png_infop &infoPtr, int channels);
+
+	bool m_streaming;
+	FILE *streamFp, *depthStreamFp;
+	png_structp streamPng, depthStreamPng;
+	png_infop streamInfo, depthStreamInfo;
+	int streamRows; //!< rows written to the open stream
+	std::vector<yByte> streamRow;
 };
 
 pngHandler_t::pngHandler_t()
@@ -65,6 +88,12 @@ pngHandler_t::pngHandler_t()
 	m_rgba = NULL;
 	m_depth = NULL;
 
+	m_streaming = false;
+	streamFp = depthStreamFp = NULL;
+	streamPng = depthStreamPng = NULL;
+	streamInfo = depthStreamInfo = NULL;
+	streamRows = 0;
+
 	handlerName = "PNGHandler";
 }
 
@@ -83,8 +112,18 @@ void pngHandler_t::initForOutput(int width, int height, bool withAlpha, bool wit
 	}
 }
 
+void pngHandler_t::initForStream(int width, int height, bool withAlpha, bool withDepth)
+{
+	m_width = width;
+	m_height = height;
+	m_hasAlpha = withAlpha;
+	m_hasDepth = withDepth;
+	m_streaming = true;
+}
+
 pngHandler_t::~pngHandler_t()
 {
+	closeStream();
 	if(m_rgba) delete m_rgba;
 	if(m_depth) delete m_depth;
 	m_rgba = NULL;
@@ -103,15 +142,59 @@ colorA_t pngHandler_t::getPixel(int x, int y)
 	return (*m_rgba)(x, y);
 }
 
-bool pngHandler_t::saveToFile(const std::string &name)
+//! converts rows of the color or depth buffer to 8 bit
+class pngConvertJob_t: public yafthreads::parallelJob_t
 {
-	Y_INFO << handlerName << ": Saving RGB" << ( m_hasAlpha ? "A" : "" ) << " file as \"" << name << "\"..." << yendl;
+	public:
+		pngConvertJob_t(rgba2DImage_nw_t *rgba, gray2DImage_nw_t *depth, int width, int channels, yByte *data):
+			rgba(rgba), depth(depth), width(width), channels(channels), data(data) {}
+		virtual void run(int start, int end)
+		{
+			for(int y = start; y < end; y++)
+			{
+				yByte *row = data + (size_t)y * width * channels;
+				for(int x = 0; x < width; x++)
+				{
+					if(depth)
+					{
+						float color = std::max(0.f, std::min(1.f, (*depth)(x, y)));
+						row[x] = (yByte)(color * 255.f);
+						continue;
+					}
+
+					colorA_t color = (*rgba)(x, y);
+					color.clampRGBA01();
+
+					int i = x * channels;
+
+					row[i]   = (yByte)(color.getR() * 255.f);
+					row[i+1] = (yByte)(color.getG() * 255.f);
+					row[i+2] = (yByte)(color.getB() * 255.f);
+					if(channels == 4) row[i+3] = (yByte)(color.getA() * 255.f);
+				}
+			}
+		}
+	protected:
+		rgba2DImage_nw_t *rgba;
+		gray2DImage_nw_t *depth;
+		int width, channels;
+		yByte *data;
+};
 
+bool pngHandler_t::writeImage(const std::string &name, unsigned int colorType, int channels, std::vector<yByte> &data)
+{
 	FILE *fp;
 	png_structp pngPtr;
 	png_infop infoPtr;
-	int channels;
-	png_bytep *rowPointers = NULL;
+
+	// the strips are compressed before libpng gets involved, which only writes them out as IDAT chunks
+	bool strips = (m_threads > 1 && m_height > 1);
+	pngStripEncoder_t encoder(data.empty() ? NULL : &data[0], m_width * channels, channels, m_height);
+	if(strips && !encoder.encode(m_threads))
+	{
+		Y_ERROR << handlerName << ": Compression of the image data failed" << yendl;
+		return false;
+	}
 
 	fp = fopen(name.c_str(), "wb");
 
@@ -121,114 +204,189 @@ bool pngHandler_t::saveToFile(const std::string &name)
 		return false;
 	}
 
-	if(!fillWriteStructs(fp, (m_hasAlpha) ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB, pngPtr, infoPtr))
+	if(!fillWriteStructs(fp, colorType, pngPtr, infoPtr))
 	{
 		fclose(fp);
 		return false;
 	}
 
-	rowPointers = new png_bytep[m_height];
-
-	channels = 3;
-
-	if(m_hasAlpha) channels++;
-
-	for(int i = 0; i < m_height; i++)
+	if(setjmp(png_jmpbuf(pngPtr)))
 	{
-		rowPointers[i] = new yByte[ m_width * channels ];
+		Y_ERROR << handlerName << ": Long jump triggered error!" << yendl;
+		png_destroy_write_struct(&pngPtr, &infoPtr);
+		fclose(fp);
+		return false;
 	}
 
-	for(int y = 0; y < m_height; y++)
+	if(strips)
 	{
-		for(int x = 0; x < m_width; x++)
+		for(int s = 0; s < encoder.strips(); s++)
 		{
-			colorA_t &color = (*m_rgba)(x, y);
-			color.clampRGBA01();
-
-			int i = x * channels;
-
-			rowPointers[y][i]   = (yByte)(color.getR() * 255.f);
-			rowPointers[y][i+1] = (yByte)(color.getG() * 255.f);
-			rowPointers[y][i+2] = (yByte)(color.getB() * 255.f);
-			if(m_hasAlpha) rowPointers[y][i+3] = (yByte)(color.getA() * 255.f);
+			const std::vector<yByte> &strip = encoder.strip(s);
+			png_write_chunk(pngPtr, (png_bytep)"IDAT", (png_bytep)&strip[0], strip.size());
 		}
+		png_write_chunk(pngPtr, (png_bytep)"IEND", NULL, 0);
+	}
+	else
+	{
+		std::vector<png_bytep> rowPointers(m_height);
+		for(int y = 0; y < m_height; y++) rowPointers[y] = &data[(size_t)y * m_width * channels];
+		png_write_image(pngPtr, &rowPointers[0]);
+		png_write_end(pngPtr, NULL);
 	}
-
-	png_write_image(pngPtr, rowPointers);
-
-	png_write_end(pngPtr, NULL);
 
 	png_destroy_write_struct(&pngPtr, &infoPtr);
 
 	fclose(fp);
 
-	// cleanup:
-	for(int i = 0; i < m_height; i++)
-	{
-		delete [] rowPointers[i];
-	}
+	return true;
+}
 
-	delete[] rowPointers;
+bool pngHandler_t::saveToFile(const std::string &name)
+{
+	Y_INFO << handlerName << ": Saving RGB" << ( m_hasAlpha ? "A" : "" ) << " file as \"" << name << "\"..." << yendl;
+
+	int channels = 3;
+
+	if(m_hasAlpha) channels++;
+
+	std::vector<yByte> data((size_t)m_width * m_height * channels);
+	pngConvertJob_t convert(m_rgba, NULL, m_width, channels, &data[0]);
+	yafthreads::runParallel(convert, m_height, m_threads, 16);
+
+	if(!writeImage(name, (m_hasAlpha) ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB, channels, data)) return false;
 
 	if(m_hasDepth)
 	{
 		std::string zbufname = name.substr(0, name.size() - 4) + "_zbuffer.png";
 		Y_INFO << handlerName << ": Saving Z-Buffer as \"" << zbufname << "\"..." << yendl;
 
-		fp = fopen(zbufname.c_str(), "wb");
+		data.resize((size_t)m_width * m_height);
+		pngConvertJob_t convertDepth(NULL, m_depth, m_width, 1, &data[0]);
+		yafthreads::runParallel(convertDepth, m_height, m_threads, 16);
 
-		if(!fp)
-		{
-			Y_ERROR << handlerName << ": Cannot open file " << zbufname << yendl;
-			return false;
-		}
+		if(!writeImage(zbufname, PNG_COLOR_TYPE_GRAY, 1, data)) return false;
+	}
 
-		if(!fillWriteStructs(fp, PNG_COLOR_TYPE_GRAY, pngPtr, infoPtr))
-		{
-			fclose(fp);
-			return false;
-		}
+	Y_INFO << handlerName << ": Done." << yendl;
+
+	return true;
+}
+
+bool pngHandler_t::openStream(const std::string &name)
+{
+	closeStream();
+	Y_INFO << handlerName << ": Streaming RGB" << ( m_hasAlpha ? "A" : "" ) << " file to \"" << name << "\"..." << yendl;
 
-		rowPointers = new png_bytep[m_height];
+	streamFp = fopen(name.c_str(), "wb");
+	if(!streamFp)
+	{
+		Y_ERROR << handlerName << ": Cannot open file " << name << yendl;
+		return false;
+	}
+	if(!fillWriteStructs(streamFp, (m_hasAlpha) ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB, streamPng, streamInfo))
+	{
+		fclose(streamFp);
+		streamFp = NULL;
+		return false;
+	}
 
-		for(int i = 0; i < m_height; i++)
+	if(m_hasDepth)
+	{
+		std::string zbufname = name.substr(0, name.size() - 4) + "_zbuffer.png";
+		Y_INFO << handlerName << ": Streaming Z-Buffer to \"" << zbufname << "\"..." << yendl;
+		depthStreamFp = fopen(zbufname.c_str(), "wb");
+		if(!depthStreamFp || !fillWriteStructs(depthStreamFp, PNG_COLOR_TYPE_GRAY, depthStreamPng, depthStreamInfo))
 		{
-			rowPointers[i] = new yByte[ m_width ];
+			Y_ERROR << handlerName << ": Cannot open file " << zbufname << yendl;
+			if(depthStreamFp) fclose(depthStreamFp);
+			depthStreamFp = NULL;
+			closeStream();
+			return false;
 		}
+	}
 
+	streamRows = 0;
+	return true;
+}
 
-		for(int y = 0; y < m_height; y++)
-		{
-			for(int x = 0; x < m_width; x++)
-			{
-				float color = std::max(0.f, std::min(1.f, (*m_depth)(x, y)));
+bool pngHandler_t::writeStream(int x, int y, int n, const colorA_t *rgba, const float *depth)
+{
+	// rows go out compressed in order, there is no going back
+	if(!streamFp || x != 0 || n != m_width || y != streamRows) return false;
 
-				rowPointers[y][x] = (yByte)(color * 255.f);
-			}
-		}
+	int channels = (m_hasAlpha) ? 4 : 3;
+	streamRow.resize(m_width * channels);
 
-		png_write_image(pngPtr, rowPointers);
+	if(setjmp(png_jmpbuf(streamPng)))
+	{
+		Y_ERROR << handlerName << ": Long jump triggered error!" << yendl;
+		return false;
+	}
 
-		png_write_end(pngPtr, NULL);
+	for(int i = 0; i < n; i++)
+	{
+		colorA_t color = rgba[i];
+		color.clampRGBA01();
 
-		png_destroy_write_struct(&pngPtr, &infoPtr);
+		int c = i * channels;
 
-		fclose(fp);
+		streamRow[c]   = (yByte)(color.getR() * 255.f);
+		streamRow[c+1] = (yByte)(color.getG() * 255.f);
+		streamRow[c+2] = (yByte)(color.getB() * 255.f);
+		if(m_hasAlpha) streamRow[c+3] = (yByte)(color.getA() * 255.f);
+	}
+	png_write_row(streamPng, &streamRow[0]);
 
-		// cleanup:
-		for(int i = 0; i < m_height; i++)
+	if(depthStreamFp)
+	{
+		if(setjmp(png_jmpbuf(depthStreamPng)))
 		{
-			delete [] rowPointers[i];
+			Y_ERROR << handlerName << ": Long jump triggered error!" << yendl;
+			return false;
 		}
-
-		delete[] rowPointers;
+		for(int i = 0; i < n; i++) streamRow[i] = (yByte)(std::max(0.f, std::min(1.f, depth[i])) * 255.f);
+		png_write_row(depthStreamPng, &streamRow[0]);
 	}
 
-	Y_INFO << handlerName << ": Done." << yendl;
-
+	++streamRows;
 	return true;
 }
 
+bool pngHandler_t::finishStreamFile(FILE *&fp, png_structp &pngPtr, png_infop &infoPtr, int channels)
+{
+	bool ok = true;
+	if(setjmp(png_jmpbuf(pngPtr)))
+	{
+		Y_ERROR << handlerName << ": Long jump triggered error!" << yendl;
+		ok = false;
+	}
+	else
+	{
+		std::vector<yByte> black(m_width * channels, 0);
+		for(int y = streamRows; y < m_height; y++) png_write_row(pngPtr, &black[0]);
+		png_write_end(pngPtr, NULL);
+	}
+	png_destroy_write_struct(&pngPtr, &infoPtr);
+	ok = (fclose(fp) == 0) && ok;
+	fp = NULL;
+	pngPtr = NULL;
+	infoPtr = NULL;
+	return ok;
+}
+
+bool pngHandler_t::closeStream()
+{
+	bool ok = true;
+	if(streamFp)
+	{
+		ok = finishStreamFile(streamFp, streamPng, streamInfo, (m_hasAlpha) ? 4 : 3);
+		Y_INFO << handlerName << ": Done." << yendl;
+	}
+	if(depthStreamFp) ok = finishStreamFile(depthStreamFp, depthStreamPng, depthStreamInfo, 1) && ok;
+	return ok;
+}
+
 bool pngHandler_t::loadFromFile(const std::string &name)
 {
 	Y_INFO << handlerName << ": Loading image \"" << name << "\"..." << yendl;
@@ -521,16 +679,22 @@ imageHandler_t *pngHandler_t::factory(paraMap_t &params, renderEnvironment_t &re
 	bool withAlpha = false;
 	bool withDepth = false;
 	bool forOutput = true;
+	bool streaming = false;
 
 	params.getParam("width", width);
 	params.getParam("height", height);
 	params.getParam("alpha_channel", withAlpha);
 	params.getParam("z_channel", withDepth);
 	params.getParam("for_output", forOutput);
+	params.getParam("streaming", streaming);
 
-	imageHandler_t *ih = new pngHandler_t();
+	pngHandler_t *ih = new pngHandler_t();
 
-	if(forOutput) ih->initForOutput(width, height, withAlpha, withDepth);
+	if(forOutput)
+	{
+		if(streaming) ih->initForStream(width, height, withAlpha, withDepth);
+		else ih->initForOutput(width, height, withAlpha, withDepth);
+	}
 
 	return ih;
 }
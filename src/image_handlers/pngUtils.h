@@ -72,4 +72,158 @@ void readFromMem(png_structp pngPtr, png_bytep buffer, png_size_t bytesToRead)
    if(img->read((yByte*)buffer, (size_t)bytesToRead) < bytesToRead) png_warning(pngPtr, "EOF Found while reading image data");
 }
 
+/*! Compresses 8 bit image rows into the zlib stream of the PNG IDAT chunks with several threads.
+	The rows are split into strips which are filtered (adaptively per row, like libpng does) and
+	deflated independently; every strip gets the data preceding it as preset dictionary and ends
+	with a sync flush, so the concatenated strips form one valid stream. */
+class pngStripEncoder_t: public yafthreads::parallelJob_t
+{
+public:
+	pngStripEncoder_t(const yByte *rows, int rowBytes, int bytesPerPixel, int height):
+		rows(rows), rowBytes(rowBytes), bpp(bytesPerPixel), height(height), filterPass(true), ok(true)
+	{
+		stripRows = std::max(1, (256 * 1024) / (rowBytes + 1));
+		int n = (height + stripRows - 1) / stripRows;
+		filtered.resize(n);
+		compressed.resize(n);
+		adler.resize(n);
+	}
+
+	//! filters and compresses all strips, false if zlib failed
+	bool encode(int nThreads)
+	{
+		int n = (int)filtered.size();
+		if(n == 0) return false;
+
+		filterPass = true;
+		yafthreads::runParallel(*this, n, nThreads);
+		filterPass = false;
+		yafthreads::runParallel(*this, n, nThreads);
+		if(!ok) return false;
+
+		// zlib header (deflate, 32K window, default level) and the checksum of the whole data
+		compressed[0][0] = 0x78;
+		compressed[0][1] = 0x9C;
+		uLong sum = adler[0];
+		for(int s = 1; s < n; s++) sum = adler32_combine(sum, adler[s], (z_off_t)filtered[s].size());
+		std::vector<yByte> &last = compressed[n - 1];
+		for(int i = 3; i >= 0; i--) last.push_back((yByte)(sum >> (8 * i)));
+		return true;
+	}
+
+	int strips() const { return (int)compressed.size(); }
+	const std::vector<yByte> &strip(int s) const { return compressed[s]; }
+
+	virtual void run(int start, int end)
+	{
+		for(int s = start; s < end; s++)
+		{
+			if(filterPass) filterStrip(s);
+			else if(!deflateStrip(s)) ok = false;
+		}
+	}
+
+private:
+	static inline int paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+		if(pa <= pb && pa <= pc) return a;
+		return (pb <= pc) ? b : c;
+	}
+
+	void filterStrip(int s)
+	{
+		int y0 = s * stripRows;
+		int y1 = std::min(height, y0 + stripRows);
+		std::vector<yByte> &out = filtered[s];
+		out.resize((size_t)(y1 - y0) * (rowBytes + 1));
+		std::vector<yByte> zero(rowBytes, 0), trial(rowBytes);
+
+		for(int y = y0; y < y1; y++)
+		{
+			const yByte *cur = rows + (size_t)y * rowBytes;
+			const yByte *prev = (y > 0) ? cur - rowBytes : &zero[0];
+			yByte *dst = &out[(size_t)(y - y0) * (rowBytes + 1)];
+			unsigned long best = 0;
+
+			// the filter with the smallest sum of absolute (signed) differences usually compresses best
+			for(int f = 0; f < 5; f++)
+			{
+				unsigned long sum = 0;
+				for(int i = 0; i < rowBytes; i++)
+				{
+					int a = (i >= bpp) ? cur[i - bpp] : 0;
+					int b = prev[i];
+					int c = (i >= bpp) ? prev[i - bpp] : 0;
+					int pred = 0;
+					switch(f)
+					{
+						case 1: pred = a; break;
+						case 2: pred = b; break;
+						case 3: pred = (a + b) >> 1; break;
+						case 4: pred = paeth(a, b, c); break;
+					}
+					yByte v = (yByte)(cur[i] - pred);
+					trial[i] = v;
+					sum += (v < 128) ? v : 256 - v;
+				}
+				if(f == 0 || sum < best)
+				{
+					best = sum;
+					dst[0] = (yByte)f;
+					std::copy(trial.begin(), trial.end(), dst + 1);
+				}
+			}
+		}
+	}
+
+	bool deflateStrip(int s)
+	{
+		const std::vector<yByte> &in = filtered[s];
+		bool last = (s == (int)filtered.size() - 1);
+		size_t header = (s == 0) ? 2 : 0;
+
+		z_stream z;
+		memset(&z, 0, sizeof(z));
+		if(deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_FILTERED) != Z_OK) return false;
+		if(s > 0)
+		{
+			const std::vector<yByte> &dict = filtered[s - 1];
+			size_t n = std::min(dict.size(), (size_t)32768);
+			deflateSetDictionary(&z, &dict[dict.size() - n], (uInt)n);
+		}
+
+		std::vector<yByte> &out = compressed[s];
+		out.resize(header + deflateBound(&z, (uLong)in.size()) + 16);
+		z.next_in = (Bytef *)&in[0];
+		z.avail_in = (uInt)in.size();
+		size_t pos = header;
+		int ret;
+
+		for(;;)
+		{
+			z.next_out = &out[pos];
+			z.avail_out = (uInt)(out.size() - pos);
+			ret = deflate(&z, last ? Z_FINISH : Z_SYNC_FLUSH);
+			pos = out.size() - z.avail_out;
+			if(ret == Z_STREAM_ERROR) break;
+			if(last ? (ret == Z_STREAM_END) : (z.avail_in == 0 && z.avail_out > 0)) break;
+			out.resize(out.size() * 2);
+		}
+		deflateEnd(&z);
+		out.resize(pos);
+
+		adler[s] = adler32(adler32(0L, Z_NULL, 0), &in[0], (uInt)in.size());
+		return ret != Z_STREAM_ERROR;
+	}
+
+	const yByte *rows;
+	int rowBytes, bpp, height, stripRows;
+	bool filterPass;
+	volatile bool ok;
+	std::vector< std::vector<yByte> > filtered, compressed;
+	std::vector<uLong> adler;
+};
+
 __END_YAFRAY
@@ -27,6 +27,8 @@
 #include "tgaUtils.h"
 
 #include <cstdio>
+#include <cstring>
+#include <vector>
 
 __BEGIN_YAFRAY
 
@@ -39,6 +41,8 @@ class tgaHandler_t: public imageHandler_t
 public:
 	tgaHandler_t();
 	void initForOutput(int width, int height, bool withAlpha = false, bool withDepth = false);
+	//! like initForOutput() but without frame buffers, the image can only be written by streaming
+	void initForStream(int width, int height, bool withAlpha = false, bool withDepth = false);
 	void initForInput();
 	~tgaHandler_t();
 	bool loadFromFile(const std::string &name);
@@ -46,6 +50,10 @@ public:
 	void putPixel(int x, int y, const colorA_t &rgba, float depth = 0.f);
 	colorA_t getPixel(int x, int y);
 	static imageHandler_t *factory(paraMap_t &params, renderEnvironment_t &render);
+	streamMode_t streamMode() const { return (m_streaming) ? STREAM_AREAS : STREAM_NONE; }
+	bool openStream(const std::string &name);
+	bool writeStream(int x, int y, int n, const colorA_t *rgba, const float *depth);
+	bool closeStream();
 
 private:
 	/*! Image data reading template functions */
@@ -64,12 +72,21 @@ private:
 	colorA_t processColor32(void *data);
 	
 	bool precheckFile(tgaHeader_t &header, const std::string &name, bool &isGray, bool &isRLE, bool &hasColorMap, yByte &alphaBitDepth);
+	//! creates an uncompressed image file with all pixels zero, they are overwritten in place while streaming
+	FILE *createStreamFile(const std::string &name, yByte imageType, yByte bitDepth, yByte desc);
+	//! opens a file made by createStreamFile() for updating in place, NULL if it is missing or has another size
+	FILE *reopenStreamFile(const std::string &name, int pixelSize);
 	
 	rgba2DImage_nw_t *ColorMap;
 	size_t totPixels;
 	size_t minX, maxX, stepX;
 	size_t minY, maxY, stepY;
 
+	bool m_streaming;
+	FILE *streamFp, *depthStreamFp;
+	long streamDataStart; //!< file offset of the first pixel in both stream files
+	std::string streamName; //!< file created by the last openStream(), reopened in place by the next ones
+	std::vector<yByte> streamBuffer;
 };
 
 tgaHandler_t::tgaHandler_t()
@@ -82,6 +99,11 @@ tgaHandler_t::tgaHandler_t()
 	m_rgba = NULL;
 	m_depth = NULL;
 	
+	m_streaming = false;
+	streamFp = NULL;
+	depthStreamFp = NULL;
+	streamDataStart = 0;
+	
 	handlerName = "TGAHandler";
 }
 
@@ -100,8 +122,19 @@ void tgaHandler_t::initForOutput(int width, int height, bool withAlpha, bool wit
 	}
 }
 
+void tgaHandler_t::initForStream(int width, int height, bool withAlpha, bool withDepth)
+{
+	m_width = width;
+	m_height = height;
+	m_hasAlpha = withAlpha;
+	m_hasDepth = withDepth;
+	m_streaming = true;
+	streamName.clear();
+}
+
 tgaHandler_t::~tgaHandler_t()
 {
+	closeStream();
 	if(m_rgba) delete m_rgba;
 	if(m_depth) delete m_depth;
 	m_rgba = NULL;
@@ -430,6 +463,138 @@ bool tgaHandler_t::precheckFile(tgaHeader_t &header, const std::string &name, bo
 	return true;
 }
 
+FILE *tgaHandler_t::createStreamFile(const std::string &name, yByte imageType, yByte bitDepth, yByte desc)
+{
+	std::string imageId = "Image rendered with YafaRay";
+	tgaHeader_t header;
+	tgaFooter_t footer;
+
+	header.idLength = imageId.size();
+	header.imageType = imageType;
+	header.width = m_width;
+	header.height = m_height;
+	header.bitDepth = bitDepth;
+	header.desc = desc;
+
+	FILE *fp = fopen(name.c_str(), "w+b");
+	if(fp == NULL) return NULL;
+
+	fwrite(&header, sizeof(tgaHeader_t), 1, fp);
+	fwrite(imageId.c_str(), (size_t)header.idLength, 1, fp);
+	streamDataStart = ftell(fp);
+
+	std::vector<yByte> row(m_width * (bitDepth / 8), 0);
+	for(int y = 0; y < m_height; y++) fwrite(&row[0], row.size(), 1, fp);
+
+	fwrite(&footer, sizeof(tgaFooter_t), 1, fp);
+	if(fflush(fp) != 0)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	return fp;
+}
+
+FILE *tgaHandler_t::reopenStreamFile(const std::string &name, int pixelSize)
+{
+	FILE *fp = fopen(name.c_str(), "r+b");
+	if(fp == NULL) return NULL;
+
+	long size = streamDataStart + (long)m_width * m_height * pixelSize + (long)sizeof(tgaFooter_t);
+	if(fseek(fp, 0, SEEK_END) != 0 || ftell(fp) != size)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	return fp;
+}
+
+bool tgaHandler_t::openStream(const std::string &name)
+{
+	closeStream();
+	std::string depthName = name.substr(0, name.size() - 4) + "_zbuffer.tga";
+
+	// the film closes the stream on every intermediate flush, e.g. after each pass; the pixels
+	// of the earlier passes stay in the file until the new ones overwrite them
+	if(name == streamName)
+	{
+		streamFp = reopenStreamFile(name, (m_hasAlpha) ? sizeof(tgaPixelRGBA_t) : sizeof(tgaPixelRGB_t));
+		if(m_hasDepth && streamFp) depthStreamFp = reopenStreamFile(depthName, 1);
+		if(streamFp && (!m_hasDepth || depthStreamFp)) return true;
+		closeStream();
+	}
+
+	Y_INFO << handlerName << ": Streaming " << ((m_hasAlpha) ? "RGBA" : "RGB" ) << " file to \"" << name << "\"..." << yendl;
+
+	streamFp = createStreamFile(name, uncTrueColor, ((m_hasAlpha) ? 32 : 24 ), TL | ((m_hasAlpha) ? alpha8 : noAlpha ));
+	if(m_hasDepth && streamFp)
+	{
+		Y_INFO << handlerName << ": Streaming Z-Buffer to \"" << depthName << "\"..." << yendl;
+		depthStreamFp = createStreamFile(depthName, uncGray, 8, TL | noAlpha);
+	}
+
+	if(!streamFp || (m_hasDepth && !depthStreamFp))
+	{
+		closeStream();
+		streamName.clear();
+		return false;
+	}
+	streamName = name;
+	return true;
+}
+
+bool tgaHandler_t::writeStream(int x, int y, int n, const colorA_t *rgba, const float *depth)
+{
+	if(!streamFp || x < 0 || y < 0 || x + n > m_width || y >= m_height) return false;
+
+	size_t pixelSize = ((m_hasAlpha) ? sizeof(tgaPixelRGBA_t) : sizeof(tgaPixelRGB_t));
+	streamBuffer.resize(n * pixelSize);
+	for(int i = 0; i < n; i++)
+	{
+		colorA_t color = rgba[i];
+		color.clampRGBA01();
+		if(!m_hasAlpha)
+		{
+			tgaPixelRGB_t rgb;
+			rgb = (color_t)color;
+			memcpy(&streamBuffer[i * pixelSize], &rgb, pixelSize);
+		}
+		else
+		{
+			tgaPixelRGBA_t rgba;
+			rgba = color;
+			memcpy(&streamBuffer[i * pixelSize], &rgba, pixelSize);
+		}
+	}
+	long pixel = (long)y * m_width + x;
+	fseek(streamFp, streamDataStart + pixel * (long)pixelSize, SEEK_SET);
+	fwrite(&streamBuffer[0], streamBuffer.size(), 1, streamFp);
+
+	if(depthStreamFp)
+	{
+		for(int i = 0; i < n; i++) streamBuffer[i] = (yByte)(std::max(0.f, std::min(1.f, depth[i])) * 255.f);
+		fseek(depthStreamFp, streamDataStart + pixel, SEEK_SET);
+		fwrite(&streamBuffer[0], n, 1, depthStreamFp);
+		if(ferror(depthStreamFp)) return false;
+	}
+
+	return !ferror(streamFp);
+}
+
+bool tgaHandler_t::closeStream()
+{
+	bool ok = true;
+	if(streamFp)
+	{
+		ok = (fclose(streamFp) == 0);
+		Y_INFO << handlerName << ": Done." << yendl;
+	}
+	if(depthStreamFp) ok = (fclose(depthStreamFp) == 0) && ok;
+	streamFp = NULL;
+	depthStreamFp = NULL;
+	return ok;
+}
+
 bool tgaHandler_t::loadFromFile(const std::string &name)
 {
 	Y_INFO << handlerName << ": Loading image \"" << name << "\"..." << yendl;
@@ -600,16 +765,22 @@ imageHandler_t *tgaHandler_t::factory(paraMap_t &params,renderEnvironment_t &ren
 	bool withAlpha = false;
 	bool withDepth = false;
 	bool forOutput = true;
+	bool streaming = false;
 
 	params.getParam("width", width);
 	params.getParam("height", height);
 	params.getParam("alpha_channel", withAlpha);
 	params.getParam("z_channel", withDepth);
 	params.getParam("for_output", forOutput);
+	params.getParam("streaming", streaming);
 	
-	imageHandler_t *ih = new tgaHandler_t();
+	tgaHandler_t *ih = new tgaHandler_t();
 	
-	if(forOutput) ih->initForOutput(width, height, withAlpha, withDepth);
+	if(forOutput)
+	{
+		if(streaming) ih->initForStream(width, height, withAlpha, withDepth);
+		else ih->initForOutput(width, height, withAlpha, withDepth);
+	}
 	
 	return ih;
 }
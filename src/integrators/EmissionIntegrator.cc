@@ -8,6 +8,7 @@
 #include <yafraycore/photon.h>
 #include <utilities/mcqmc.h>
 #include <yafraycore/scr_halton.h>
+#include <utilities/simdMath.h>
 #include <vector>
 
 __BEGIN_YAFRAY
@@ -30,7 +31,7 @@ class YAFRAYPLUGIN_EXPORT EmissionIntegrator : public volumeIntegrator_t
 			result *= listVR.at(i)->tau(ray, 0, 0);
 		}
 		
-		result = colorA_t(fExp(-result.getR()), fExp(-result.getG()), fExp(-result.getB()));
+		result = colorA_t(colorExp(-1.f * result, MATH_FAST), 0.f);
 		
 		return result;
 	}
@@ -70,7 +71,7 @@ class YAFRAYPLUGIN_EXPORT EmissionIntegrator : public volumeIntegrator_t
 			{
 				ray_t stepRay(ray.from + (ray.dir * pos), ray.dir, 0, step, 0);
 				color_t stepTau = vr->tau(stepRay, 0, 0);
-				Tr *= colorA_t(fExp(-stepTau.getR()), fExp(-stepTau.getG()), fExp(-stepTau.getB()));
+				Tr *= colorExp(-1.f * stepTau, MATH_FAST);
 				result += Tr * vr->emission(stepRay.from, stepRay.dir);
 				pos += step;
 			}
@@ -13,11 +13,58 @@
 
 __BEGIN_YAFRAY
 
-class YAFRAYPLUGIN_EXPORT SingleScatterIntegrator : public volumeIntegrator_t
+struct attGridJob_t
+{
+	attGridJob_t(VolumeRegion *v, int l, int z): vr(v), light(l), slice(z) {}
+	VolumeRegion *vr;
+	int light;
+	int slice;
+};
+
+struct attGridData_t
+{
+	attGridData_t(const attenuationSampler_t &s): sampler(s), fetched(0) {}
+	const attenuationSampler_t &sampler;
+	std::vector<attGridJob_t> jobs;
+	volatile int fetched;
+	yafthreads::mutex_t mutex;
+};
+
+//! fills attenuation grid slices until all jobs are fetched
+class attGridWorker_t: public yafthreads::thread_t
+{
+	public:
+		attGridWorker_t(attGridData_t *dat): gdata(dat) {}
+		virtual void body();
+	protected:
+		attGridData_t *gdata;
+};
+
+void attGridWorker_t::body()
+{
+	int total = gdata->jobs.size();
+
+	while(true)
+	{
+		gdata->mutex.lock();
+		int job = gdata->fetched;
+		if(job < total) gdata->fetched = job + 1;
+		gdata->mutex.unlock();
+
+		if(job >= total) break;
+
+		const attGridJob_t &j = gdata->jobs[job];
+		j.vr->fillAttenuationSlice(gdata->sampler, j.light, j.slice);
+	}
+}
+
+class YAFRAYPLUGIN_EXPORT SingleScatterIntegrator : public volumeIntegrator_t, public attenuationSampler_t
 {
 private:
 	bool adaptive;
 	bool optimize;
+	bool attHalf;
+	bool attLazy;
 	float adaptiveStepSize;
 	std::vector<VolumeRegion*> listVR;
 	std::vector<light_t*> lights;
@@ -26,11 +73,13 @@ private:
 
 public:
 
-	SingleScatterIntegrator(float sSize, bool adapt, bool opt)
+	SingleScatterIntegrator(float sSize, bool adapt, bool opt, bool halfPrec, bool lazy)
 	{
 		adaptive = adapt;
 		stepSize = sSize;
 		optimize = opt;
+		attHalf = halfPrec;
+		attLazy = lazy;
 		adaptiveStepSize = sSize * 100.0f;
 
 		Y_INFO << "SingleScatter: stepSize: " << stepSize << " adaptive: " << adaptive << " optimize: " << optimize << yendl;
@@ -40,6 +89,7 @@ public:
 	{
 		Y_INFO << "SingleScatter: Preprocessing..." << yendl;
 
+		lights.clear();
 		for(unsigned int i=0;i<scene->lights.size();++i)
 		{
 			lights.push_back(scene->lights[i]);
@@ -51,102 +101,96 @@ public:
 		
 		if (optimize)
 		{
+			attGridData_t gdata(*this);
+
 			for (unsigned int i = 0; i < VRSize; i++)
 			{
 				VolumeRegion* vr = listVR.at(i);
-				bound_t bb = vr->getBB();
-
-				int xSize = vr->attGridX;
-				int ySize = vr->attGridY;
-				int zSize = vr->attGridZ;
+				vr->initAttenuationGrids(lights.size(), attHalf, attLazy ? this : 0);
 
-				float xSizeInv = 1.f/(float)xSize;
-				float ySizeInv = 1.f/(float)ySize;
-				float zSizeInv = 1.f/(float)zSize;
+				Y_INFO << "SingleScatter: volume, attGridMaps with size: " << vr->attGridX << " " << vr->attGridY << " " << vr->attGridZ
+					   << (attHalf ? " (half precision)" : "") << (attLazy ? " (lazy)" : "") << yendl;
 
-				Y_INFO << "SingleScatter: volume, attGridMaps with size: " << xSize << " " << ySize << " " << xSize << std::endl;
-			
-				for(std::vector<light_t *>::const_iterator l=lights.begin(); l!=lights.end(); ++l)
+				int slices = vr->attenuationSlices();
+				for (unsigned int l = 0; l < lights.size(); ++l)
 				{
-					color_t lcol(0.0);
+					for (int z = 0; z < slices; ++z) gdata.jobs.push_back(attGridJob_t(vr, l, z));
+				}
+			}
 
-					float* attenuationGrid = (float*)malloc(xSize * ySize * zSize * sizeof(float));
-					vr->attenuationGridMap[(*l)] = attenuationGrid;
+#ifdef USING_THREADS
+			int nThreads = scene->getNumThreads();
+			std::vector<attGridWorker_t *> workers;
+			for(int i=0; i<nThreads; ++i) workers.push_back(new attGridWorker_t(&gdata));
+			for(int i=0; i<nThreads; ++i) workers[i]->run();
+			for(int i=0; i<nThreads; ++i) workers[i]->wait();
+			for(int i=0; i<nThreads; ++i) delete workers[i];
+#else
+			for (unsigned int j = 0; j < gdata.jobs.size(); ++j)
+			{
+				gdata.jobs[j].vr->fillAttenuationSlice(*this, gdata.jobs[j].light, gdata.jobs[j].slice);
+			}
+#endif
+		}
 
-					for (int z = 0; z < zSize; ++z)
-					{
-						for (int y = 0; y < ySize; ++y)
-						{
-							for (int x = 0; x < xSize; ++x)
-							{
-								// generate the world position inside the grid
-								point3d_t p(bb.longX() * xSizeInv * x + bb.a.x,
-											bb.longY() * ySizeInv * y + bb.a.y,
-											bb.longZ() * zSizeInv * z + bb.a.z);
+		return true;
+	}
 
-								surfacePoint_t sp;
-								sp.P = p;
-								
-								ray_t lightRay;
+	// transmittance from the point p in the volume to light number "light" (i.e. how much light reaches p)
+	virtual float lightTransmittance(const point3d_t &p, int light) const
+	{
+		light_t *l = lights[light];
+		color_t lcol(0.0);
+		surfacePoint_t sp;
+		sp.P = p;
+
+		ray_t lightRay;
+		lightRay.from = sp.P;
 
-								lightRay.from = sp.P;
+		// handle lights with delta distribution, e.g. point and directional lights
+		if( l->diracLight() )
+		{
+			bool ill = l->illuminate(sp, lcol, lightRay);
+			lightRay.tmin = YAF_SHADOW_BIAS; // < better add some _smart_ self-bias value...this is bad.
+			if (lightRay.tmax < 0.f) lightRay.tmax = 1e10; // infinitely distant light
 
-								// handle lights with delta distribution, e.g. point and directional lights
-								if( (*l)->diracLight() )
-								{
-									bool ill = (*l)->illuminate(sp, lcol, lightRay);
-									lightRay.tmin = YAF_SHADOW_BIAS; // < better add some _smart_ self-bias value...this is bad.
-									if (lightRay.tmax < 0.f) lightRay.tmax = 1e10; // infinitely distant light
+			color_t lightstepTau(0.f);
+			if (ill)
+			{
+				for (unsigned int j = 0; j < VRSize; j++)
+				{
+					lightstepTau += listVR[j]->tau(lightRay, stepSize, 0.0f);
+				}
+			}
 
-									// transmittance from the point p in the volume to the light (i.e. how much light reaches p)
-									color_t lightstepTau(0.f);
-									if (ill)
-									{
-										for (unsigned int j = 0; j < VRSize; j++)
-										{
-											VolumeRegion* vr2 = listVR.at(j);
-											lightstepTau += vr2->tau(lightRay, stepSize, 0.0f);
-										}
-									}
+			return fastExp(-lightstepTau.energy());
+		}
+		else // area light and suchlike
+		{
+			float lightTr = 0;
+			int n = l->nSamples() >> 1; // samples / 2
+			if (n < 1) n = 1;
+			lSample_t ls;
+			for(int i=0; i<n; ++i)
+			{
+				// deterministic hammersley points, so the grid is independent of the filling thread
+				ls.s1 = ((float)i + 0.5f) / (float)n;
+				ls.s2 = RI_vdC(i);
 
-									float lightTr = fExp(-lightstepTau.energy());
-									attenuationGrid[x + y * xSize + ySize * xSize * z] = lightTr;
-								}
-								else // area light and suchlike
-								{
-									float lightTr = 0;
-									int n = (*l)->nSamples() >> 1; // samples / 2
-									if (n < 1) n = 1;
-									lSample_t ls;
-									for(int i=0; i<n; ++i)
-									{
-										ls.s1 = 0.5f; //(*state.prng)();
-										ls.s2 = 0.5f; //(*state.prng)();
-
-										(*l)->illumSample(sp, ls, lightRay);
-										lightRay.tmin = YAF_SHADOW_BIAS;
-										if (lightRay.tmax < 0.f) lightRay.tmax = 1e10; // infinitely distant light
-
-										// transmittance from the point p in the volume to the light (i.e. how much light reaches p)
-										color_t lightstepTau(0.f);
-										for (unsigned int j = 0; j < VRSize; j++)
-										{
-											VolumeRegion* vr2 = listVR.at(j);
-											lightstepTau += vr2->tau(lightRay, stepSize, 0.0f);
-										}
-										lightTr += fExp(-lightstepTau.energy());
-									}
+				l->illumSample(sp, ls, lightRay);
+				lightRay.tmin = YAF_SHADOW_BIAS;
+				if (lightRay.tmax < 0.f) lightRay.tmax = 1e10; // infinitely distant light
 
-									attenuationGrid[x + y * xSize + ySize * xSize * z] = lightTr / (float)n;
-								}
-							}
-						}
-					}
+				color_t lightstepTau(0.f);
+				for (unsigned int j = 0; j < VRSize; j++)
+				{
+					lightstepTau += listVR[j]->tau(lightRay, stepSize, 0.0f);
 				}
+				lightTr += fastExp(-lightstepTau.energy());
 			}
-		}
 
-		return true;
+			return lightTr / (float)n;
+		}
 	}
 	
 	color_t getInScatter(renderState_t& state, ray_t& stepRay, float currentStep) const
@@ -161,6 +205,7 @@ public:
 		for(std::vector<light_t *>::const_iterator l=lights.begin(); l!=lights.end(); ++l)
 		{
 			color_t lcol(0.0);
+			int lightIdx = l - lights.begin();
 
 			// handle lights with delta distribution, e.g. point and directional lights
 			if( (*l)->diracLight() )
@@ -182,7 +227,7 @@ public:
 							{
 								VolumeRegion* vr = listVR.at(i);
 								float t0Tmp = -1, t1Tmp = -1;
-								if (vr->intersect(lightRay, t0Tmp, t1Tmp)) lightTr += vr->attenuation(sp.P, (*l)) * iVRSize;
+								if (vr->intersect(lightRay, t0Tmp, t1Tmp)) lightTr += vr->attenuation(sp.P, lightIdx) * iVRSize;
 							}
 						}
 						else
@@ -199,7 +244,7 @@ public:
 								}
 							}
 							// transmittance from the point p in the volume to the light (i.e. how much light reaches p)
-							lightTr = fExp(-lightstepTau.energy());
+							lightTr = fastExp(-lightstepTau.energy());
 						}
 						lightTr *= iVRSize;
 
@@ -241,7 +286,7 @@ public:
 									float t0Tmp = -1, t1Tmp = -1;
 									if (vr->intersect(lightRay, t0Tmp, t1Tmp))
 									{
-										lightTr += vr->attenuation(sp.P, (*l)) * iVRSize;
+										lightTr += vr->attenuation(sp.P, lightIdx) * iVRSize;
 										break;
 									}
 								}
@@ -260,7 +305,7 @@ public:
 									}
 								}
 								// transmittance from the point p in the volume to the light (i.e. how much light reaches p)
-								lightTr += fExp(-lightstepTau.energy()) * iVRSize;
+								lightTr += fastExp(-lightstepTau.energy()) * iVRSize;
 							}
 
 						}
@@ -295,7 +340,7 @@ public:
 			{
 				float random = (*state.prng)();
 				color_t opticalThickness = vr->tau(ray, stepSize, random);
-				Tr *= colorA_t(fExp(-opticalThickness.energy()));
+				Tr *= colorA_t(fastExp(-opticalThickness.energy()));
 			}
 		}
 		
@@ -403,6 +448,23 @@ public:
 				}
 			}
 
+			if (!adaptive)
+			{
+				// empty space skipping, in whole steps so the remaining sample positions don't change
+				float skipTo = t1;
+				for (unsigned int j = 0; j < VRSize && skipTo > pos; j++)
+				{
+					skipTo = std::min(skipTo, listVR.at(j)->skipEmpty(ray, pos, t1));
+				}
+				if (skipTo > pos)
+				{
+					int skipSteps = (int)std::ceil((skipTo - pos) / currentStep);
+					stepSample += skipSteps - stepLength;
+					pos += skipSteps * currentStep;
+					continue;
+				}
+			}
+
 			ray_t stepRay(ray.from + (ray.dir * pos), ray.dir, 0, currentStep, 0);
 
 			if (adaptive)
@@ -422,7 +484,7 @@ public:
 				}
 			}
 
-			trTmp = fExp(-stepTau.energy());
+			trTmp = fastExp(-stepTau.energy());
 
 			if (optimize && trTmp.energy() < 1e-3f)
 			{
@@ -489,11 +551,15 @@ public:
 	{
 		bool adapt = false;
 		bool opt = false;
+		bool attHalf = false;
+		bool attLazy = false;
 		float sSize = 1.f;
 		params.getParam("stepSize", sSize);
 		params.getParam("adaptive", adapt);
 		params.getParam("optimize", opt);
-		SingleScatterIntegrator* inte = new SingleScatterIntegrator(sSize, adapt, opt);
+		params.getParam("attgridHalf", attHalf); // store attenuation grids as 16 bit floats
+		params.getParam("attgridLazy", attLazy); // coarse grid upfront, fine bricks on demand
+		SingleScatterIntegrator* inte = new SingleScatterIntegrator(sSize, adapt, opt, attHalf, attLazy);
 		return inte;
 	}
 
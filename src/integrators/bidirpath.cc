@@ -9,6 +9,8 @@
 #include <core_api/imagefilm.h>
 #include <integrators/integr_utils.h>
 #include <utilities/mcqmc.h>
+#include <utilities/sobol.h>
+#include <yafraycore/renderstats.h>
 
 __BEGIN_YAFRAY
 
@@ -122,7 +124,7 @@ class YAFRAYPLUGIN_EXPORT biDirIntegrator_t: public tiledIntegrator_t
 		virtual colorA_t integrate(renderState_t &state, diffRay_t &ray) const;
 		static integrator_t* factory(paraMap_t &params, renderEnvironment_t &render);
 	protected:
-		int createPath(renderState_t &state, ray_t &start, std::vector<pathVertex_t> &path, int maxLen) const;
+		int createPath(renderState_t &state, ray_t &start, std::vector<pathVertex_t> &path, int maxLen, unsigned int dimBase) const;
 		color_t evalPath(renderState_t &state, int s, int t, pathData_t &pd) const;
 		color_t evalLPath(renderState_t &state, int t, pathData_t &pd, ray_t &lRay, const color_t &lcol) const;
 		color_t evalPathE(renderState_t &state, int s, pathData_t &pd) const;
@@ -145,7 +147,7 @@ class YAFRAYPLUGIN_EXPORT biDirIntegrator_t: public tiledIntegrator_t
 		//mutable int nPaths;
 		//mutable pathData_t pathData;
 		mutable std::vector<pathData_t> threadData;
-		pdf1D_t *lightPowerD;
+		aliasPdf1D_t *lightPowerD;
 		float fNumLights;
 		std::map <const light_t*, CFLOAT> invLightPowerD;
 		imageFilm_t *lightImage;
@@ -188,7 +190,7 @@ bool biDirIntegrator_t::preprocess()
 	fNumLights = 1.f / (float) numLights;
 	float *energies = new float[numLights];
 	for(int i=0;i<numLights;++i) energies[i] = lights[i]->totalEnergy().energy();
-	lightPowerD = new pdf1D_t(energies, numLights);
+	lightPowerD = new aliasPdf1D_t(energies, numLights);
 	
 	for(int i=0;i<numLights;++i) invLightPowerD[lights[i]] = lightPowerD->func[i] * lightPowerD->invIntegral;
 	
@@ -268,7 +270,6 @@ colorA_t biDirIntegrator_t::integrate(renderState_t &state, diffRay_t &ray) cons
 		state.includeLights = true;
 		pathData_t &pathData = threadData[state.threadID];
 		++pathData.nPaths;
-		random_t &prng = *(state.prng);
 		pathVertex_t &ve = pathData.eyePath.front();
 		pathVertex_t &vl = pathData.lightPath.front();
 		int nEye=1, nLight=1;
@@ -290,17 +291,23 @@ colorA_t biDirIntegrator_t::integrate(renderState_t &state, diffRay_t &ray) cons
 		ve.flags = BSDF_DIFFUSE; //place holder! not applicable for e.g. orthogonal camera!
 		
 		// create eyePath
-		nEye = createPath(state, ray, pathData.eyePath, MAX_PATH_LENGTH);
+		nEye = createPath(state, ray, pathData.eyePath, MAX_PATH_LENGTH, state.sampleDim);
 		
 		// sample light (todo!)
 		ray_t lray;
 		lray.tmin = MIN_RAYDIST;
 		lray.tmax = -1.f;
 		float lightNumPdf;
-		int lightNum = lightPowerD->DSample(prng(), &lightNumPdf);
+		// the light path gets its own range of sample dimensions behind the eye path
+		unsigned int lightDim = state.sampleDim + MAX_PATH_LENGTH * SD_VERTEX_STRIDE;
+		unsigned int idx = state.sampleIndex;
+		int lightNum = lightPowerD->DSample(sobolSample(idx, lightDim + SD_LIGHT_SELECT, state.samplingOffs), &lightNumPdf);
 		lightNumPdf *= fNumLights;
 		lSample_t ls;
-		ls.s1=prng(), ls.s2=prng(), ls.s3=prng(), ls.s4=prng();
+		ls.s1 = sobolSample(idx, lightDim + SD_LIGHT, state.samplingOffs);
+		ls.s2 = sobolSample(idx, lightDim + SD_LIGHT + 1, state.samplingOffs);
+		ls.s3 = sobolSample(idx, lightDim + SD_LIGHT + 2, state.samplingOffs);
+		ls.s4 = sobolSample(idx, lightDim + SD_LIGHT + 3, state.samplingOffs);
 		ls.sp = &vl.sp;
 		color_t pcol = lights[lightNum]->emitSample(lray.dir, ls);
 		lray.from = vl.sp.P;
@@ -323,7 +330,7 @@ colorA_t biDirIntegrator_t::integrate(renderState_t &state, diffRay_t &ray) cons
 		pathData.singularL = (ls.flags & LIGHT_SINGULAR);
 		
 		// create lightPath
-		nLight = createPath(state, lray, pathData.lightPath, MAX_PATH_LENGTH);
+		nLight = createPath(state, lray, pathData.lightPath, MAX_PATH_LENGTH, lightDim);
 		if(nLight>1)
 		{
 			pathData.pdf_illum = lights[lightNum]->illumPdf(pathData.lightPath[1].sp, vl.sp) * lightNumPdf;
@@ -422,7 +429,7 @@ colorA_t biDirIntegrator_t::integrate(renderState_t &state, diffRay_t &ray) cons
 	important: resize path to maxLen *before* calling this function!
  ============================================================ */
 
-int biDirIntegrator_t::createPath(renderState_t &state, ray_t &start, std::vector<pathVertex_t> &path, int maxLen) const
+int biDirIntegrator_t::createPath(renderState_t &state, ray_t &start, std::vector<pathVertex_t> &path, int maxLen, unsigned int dimBase) const
 {
 	static int dbg=0;
 	random_t &prng = *state.prng;
@@ -447,7 +454,9 @@ int biDirIntegrator_t::createPath(renderState_t &state, ray_t &start, std::vecto
 //if(dbg<10) std::cout << nVert << "  mat: " << (void*) mat << " alpha:" << v.alpha << " p_f_s:" << v_prev.f_s << " qi:"<< v_prev.qi << std::endl;
 		mat->initBSDF(state, v.sp, mBSDF);
 		// create tentative sample for next path segment
-		sample_t s(prng(), prng(), BSDF_ALL, true);
+		// vertex i (i >= 1) draws its samples from dimBase + (i-1) * SD_VERTEX_STRIDE
+		unsigned int dim = dimBase + (nVert - 2) * SD_VERTEX_STRIDE + SD_BSDF;
+		sample_t s(sobolSample(state.sampleIndex, dim, state.samplingOffs), sobolSample(state.sampleIndex, dim + 1, state.samplingOffs), BSDF_ALL, true);
 		float W = 0.f;
 		v.f_s = mat->sample(state, v.sp, v.wi, ray.dir, s, W);
 		if(v.f_s.isBlack()) break;
@@ -537,6 +546,7 @@ inline bool biDirIntegrator_t::connectPaths(renderState_t &state, int s, int t,
 	x_l.pdf_f /= cos_y;
 	x_l.pdf_b /= y.cos_wi;
 	pd.f_y = y.sp.material->eval(state, y.sp, y.wi, vec, BSDF_ALL);
+	statCount(STAT_MATERIAL_EVALS);
 	pd.f_y += y.sp.material->emit(state, y.sp, vec);
 	
 	state.userdata = z.userdata;
@@ -546,6 +556,7 @@ inline bool biDirIntegrator_t::connectPaths(renderState_t &state, int s, int t,
 	x_e.pdf_b /= cos_z;
 	x_e.pdf_f /= z.cos_wi;
 	pd.f_z = z.sp.material->eval(state, z.sp, z.wi, -vec, BSDF_ALL);
+	statCount(STAT_MATERIAL_EVALS);
 	pd.f_z += z.sp.material->emit(state, z.sp, -vec);
 	
 	pd.w_l_e = vec;
@@ -591,7 +602,8 @@ inline bool biDirIntegrator_t::connectLPath(renderState_t &state, int t, pathDat
 	int nLightsI = lights.size();
 	if(nLightsI == 0) return false;
 	float lightNumPdf, cos_wo;
-	int lnum = lightPowerD->DSample((*state.prng)(), &lightNumPdf);
+	unsigned int dim = state.sampleDim + (t - 2) * SD_VERTEX_STRIDE;
+	int lnum = lightPowerD->DSample(sobolSample(state.sampleIndex, dim + SD_LIGHT_SELECT, state.samplingOffs), &lightNumPdf);
 	lightNumPdf *= fNumLights;
 	if(lnum > nLightsI-1) lnum = nLightsI-1;
 	const light_t *light = lights[lnum];
@@ -601,8 +613,8 @@ inline bool biDirIntegrator_t::connectLPath(renderState_t &state, int t, pathDat
 	lSample_t ls;
 	if(light->getFlags() == LIGHT_NONE) //only lights with non-specular components need sample values
 	{
-		ls.s1 = (*state.prng)();
-		ls.s2 = (*state.prng)();
+		ls.s1 = sobolSample(state.sampleIndex, dim + SD_LIGHT, state.samplingOffs);
+		ls.s2 = sobolSample(state.sampleIndex, dim + SD_LIGHT + 1, state.samplingOffs);
 	}
 	ls.sp = &spLight;
 	// generate light sample, abort when none could be created:
@@ -634,6 +646,7 @@ inline bool biDirIntegrator_t::connectLPath(renderState_t &state, int t, pathDat
 	x_e.pdf_f /= z.cos_wi;
 	x_e.specular = false;
 	pd.f_z = z.sp.material->eval(state, z.sp, z.wi, lRay.dir, BSDF_ALL);
+	statCount(STAT_MATERIAL_EVALS);
 	pd.f_z += z.sp.material->emit(state, z.sp, lRay.dir);
 	pd.light = light;
 	
@@ -682,6 +695,7 @@ inline bool biDirIntegrator_t::connectPathE(renderState_t &state, int s, pathDat
 	x_l.pdf_f /= cos_y;
 	x_l.pdf_b /= y.cos_wi;
 	pd.f_y = y.sp.material->eval(state, y.sp, y.wi, vec, BSDF_ALL);
+	statCount(STAT_MATERIAL_EVALS);
 	pd.f_y += y.sp.material->emit(state, y.sp, vec);
 	x_l.specular = false;
 	
@@ -886,6 +900,7 @@ color_t biDirIntegrator_t::evalPathE(renderState_t &state, int s, pathData_t &pd
 			{
 				if(trShad) lcol *= scol;
 				color_t surfCol = oneMat->eval(state, sp, wo, lightRay.dir, BSDF_ALL);
+				statCount(STAT_MATERIAL_EVALS);
 				col = surfCol * lcol * std::fabs(sp.N*lightRay.dir);
 			}
 		}
@@ -905,6 +920,7 @@ color_t biDirIntegrator_t::evalPathE(renderState_t &state, int s, pathData_t &pd
 			{
 				if(trShad) lcol *= scol;
 				color_t surfCol = oneMat->eval(state, sp, wo, lightRay.dir, BSDF_ALL);
+				statCount(STAT_MATERIAL_EVALS);
 				//test! limit lightPdf...
 				if(lightPdf > 2.f) lightPdf = 2.f;
 				col = surfCol * lcol * std::fabs(sp.N*lightRay.dir) * lightPdf;
@@ -26,7 +26,7 @@
 #include <core_api/background.h>
 #include <core_api/light.h>
 
-#include <yafraycore/scr_halton.h>
+#include <utilities/sobol.h>
 #include <yafraycore/photon.h>
 #include <yafraycore/spectrum.h>
 
@@ -158,12 +158,13 @@ colorA_t pathIntegrator_t::integrate(renderState_t &state, diffRay_t &ray/*, sam
 			color_t pathCol(0.0), wl_col;
 			path_flags |= (BSDF_DIFFUSE | BSDF_REFLECT | BSDF_TRANSMIT);
 			int nSamples = std::max(1, nPaths/state.rayDivision);
+			unsigned int oldIndex = state.sampleIndex, oldDim = state.sampleDim;
 			for(int i=0; i<nSamples; ++i)
 			{
 				void *first_udat = state.userdata;
 				unsigned char userdata[USER_DATA_SIZE+7];
 				void *n_udat = (void *)( &userdata[7] - ( ((size_t)&userdata[7])&7 ) ); // pad userdata to 8 bytes
-				unsigned int offs = nPaths * state.pixelSample + state.samplingOffs + i; // some redunancy here...
+				unsigned int offs = nPaths * oldIndex + i;
 				color_t throughput( 1.0 );
 				color_t lcol, scol;
 				surfacePoint_t sp1=sp, sp2;
@@ -172,10 +173,12 @@ colorA_t pathIntegrator_t::integrate(renderState_t &state, diffRay_t &ray/*, sam
 				ray_t pRay;
 
 				state.chromatic = was_chromatic;
-				if(was_chromatic) state.wavelength = RI_S(offs);
+				state.sampleIndex = offs;
+				state.sampleDim = oldDim;
+				if(was_chromatic) state.wavelength = state.sample(offs, SD_SPECTRAL);
 				//this mat already is initialized, just sample (diffuse...non-specular?)
-				float s1 = RI_vdC(offs);
-				float s2 = scrHalton(2, offs);
+				float s1 = state.sample(offs, SD_BSDF);
+				float s2 = state.sample(offs, SD_BSDF+1);
 				if(state.rayDivision > 1)
 				{
 					s1 = addMod1(s1, state.dc1);
@@ -200,7 +203,8 @@ colorA_t pathIntegrator_t::integrate(renderState_t &state, diffRay_t &ray/*, sam
 				BSDF_t matBSDFs;
 				p_mat->initBSDF(state, *hit, matBSDFs);
 				pwo = -pRay.dir;
-				lcol = estimateOneDirectLight(state, *hit, pwo, offs);
+				state.sampleDim = oldDim + SD_VERTEX_STRIDE;
+				lcol = estimateOneDirectLight(state, *hit, pwo);
 				if(matBSDFs & BSDF_EMIT) lcol += p_mat->emit(state, *hit, pwo);
 
 				pathCol += lcol*throughput;
@@ -209,9 +213,8 @@ colorA_t pathIntegrator_t::integrate(renderState_t &state, diffRay_t &ray/*, sam
 				
 				for(int depth = 1; depth < maxBounces; ++depth)
 				{
-					int d4 = 4*depth;
-					s.s1 = scrHalton(d4+3, offs); //ourRandom();//
-					s.s2 = scrHalton(d4+4, offs); //ourRandom();//
+					s.s1 = state.sample(offs, SD_BSDF);
+					s.s2 = state.sample(offs, SD_BSDF+1);
 
 					if(state.rayDivision > 1)
 					{
@@ -248,7 +251,8 @@ colorA_t pathIntegrator_t::integrate(renderState_t &state, diffRay_t &ray/*, sam
 					p_mat->initBSDF(state, *hit, matBSDFs);
 					pwo = -pRay.dir;
 
-					if(matBSDFs & BSDF_DIFFUSE) lcol = estimateOneDirectLight(state, *hit, pwo, offs);
+					state.sampleDim = oldDim + (depth + 1) * SD_VERTEX_STRIDE;
+					if(matBSDFs & BSDF_DIFFUSE) lcol = estimateOneDirectLight(state, *hit, pwo);
 					else lcol = color_t(0.f);
 
 					if((matBSDFs & BSDF_VOLUMETRIC) && (vol=p_mat->getVolumeHandler(hit->N * pwo < 0)))
@@ -263,6 +267,8 @@ colorA_t pathIntegrator_t::integrate(renderState_t &state, diffRay_t &ray/*, sam
 				state.userdata = first_udat;
 				
 			}
+			state.sampleIndex = oldIndex;
+			state.sampleDim = oldDim;
 			col += pathCol / nSamples;
 		}
 		//reset chromatic state:
@@ -21,7 +21,9 @@
 
 #include <integrators/photonintegr.h>
 #include <utilities/mcqmc.h>
-#include <yafraycore/scr_halton.h>
+#include <utilities/sobol.h>
+#include <yafraycore/renderstats.h>
+#include <yafraycore/trace.h>
 
 #include <sstream>
 
@@ -125,6 +127,7 @@ photonIntegrator_t::~photonIntegrator_t()
 
 bool photonIntegrator_t::preprocess()
 {
+	traceScope_t ts("photon maps", "photon");
 	std::stringstream set;
 	gTimer.addEvent("prepass");
 	gTimer.start("prepass");
@@ -179,7 +182,7 @@ bool photonIntegrator_t::preprocess()
 
 	for(int i=0;i<numDLights;++i) energies[i] = tmplights[i]->totalEnergy().energy();
 
-	lightPowerD = new pdf1D_t(energies, numDLights);
+	lightPowerD = new aliasPdf1D_t(energies, numDLights);
 	
 	Y_INFO << integratorName << ": Light(s) photon color testing for diffuse map:" << yendl;
 	for(int i=0;i<numDLights;++i)
@@ -221,10 +224,10 @@ bool photonIntegrator_t::preprocess()
 	{
 		if(scene->getSignals() & Y_SIG_ABORT) {  pb->done(); if(!intpb) delete pb; return false; }
 
-		s1 = RI_vdC(curr);
-		s2 = scrHalton(2, curr);
-		s3 = scrHalton(3, curr);
-		s4 = scrHalton(4, curr);
+		s1 = sobolSample(curr, SD_PHOTON_EMIT, DIFFUSE_PHOTON_SEED);
+		s2 = sobolSample(curr, SD_PHOTON_EMIT+1, DIFFUSE_PHOTON_SEED);
+		s3 = sobolSample(curr, SD_PHOTON_EMIT+2, DIFFUSE_PHOTON_SEED);
+		s4 = sobolSample(curr, SD_PHOTON_EMIT+3, DIFFUSE_PHOTON_SEED);
 
 		sL = float(curr) * invDiffPhotons;
 		int lightNum = lightPowerD->DSample(sL, &lightNumPdf);
@@ -300,11 +303,11 @@ bool photonIntegrator_t::preprocess()
 			// need to break in the middle otherwise we scatter the photon and then discard it => redundant
 			if(nBounces == maxBounces) break;
 			// scatter photon
-			int d5 = 3*nBounces + 5;
+			unsigned int d5 = SD_VERTEX + nBounces * SD_VERTEX_STRIDE;
 
-			s5 = scrHalton(d5, curr);
-			s6 = scrHalton(d5+1, curr);
-			s7 = scrHalton(d5+2, curr);
+			s5 = sobolSample(curr, d5 + SD_BSDF, DIFFUSE_PHOTON_SEED);
+			s6 = sobolSample(curr, d5 + SD_BSDF+1, DIFFUSE_PHOTON_SEED);
+			s7 = sobolSample(curr, d5 + SD_BSDF_COMP, DIFFUSE_PHOTON_SEED);
 			
 			pSample_t sample(s5, s6, s7, BSDF_ALL, pcol, transm);
 
@@ -356,7 +359,7 @@ bool photonIntegrator_t::preprocess()
 
 		for(int i=0;i<numCLights;++i) energies[i] = tmplights[i]->totalEnergy().energy();
 
-		lightPowerD = new pdf1D_t(energies, numCLights);
+		lightPowerD = new aliasPdf1D_t(energies, numCLights);
 		
 		Y_INFO << integratorName << ": Light(s) photon color testing for caustics map:" << yendl;
 		for(int i=0;i<numCLights;++i)
@@ -381,12 +384,12 @@ bool photonIntegrator_t::preprocess()
 		{
 			if(scene->getSignals() & Y_SIG_ABORT) { pb->done(); if(!intpb) delete pb; return false; }
 			state.chromatic = true;
-			state.wavelength = scrHalton(5,curr);
+			state.wavelength = sobolSample(curr, SD_PHOTON_WAVELENGTH, CAUSTIC_PHOTON_SEED);
 
-			s1 = RI_vdC(curr);
-			s2 = scrHalton(2, curr);
-			s3 = scrHalton(3, curr);
-			s4 = scrHalton(4, curr);
+			s1 = sobolSample(curr, SD_PHOTON_EMIT, CAUSTIC_PHOTON_SEED);
+			s2 = sobolSample(curr, SD_PHOTON_EMIT+1, CAUSTIC_PHOTON_SEED);
+			s3 = sobolSample(curr, SD_PHOTON_EMIT+2, CAUSTIC_PHOTON_SEED);
+			s4 = sobolSample(curr, SD_PHOTON_EMIT+3, CAUSTIC_PHOTON_SEED);
 
 			sL = float(curr) * invCaustPhotons;
 			int lightNum = lightPowerD->DSample(sL, &lightNumPdf);
@@ -451,11 +454,11 @@ bool photonIntegrator_t::preprocess()
 				// need to break in the middle otherwise we scatter the photon and then discard it => redundant
 				if(nBounces == maxBounces) break;
 				// scatter photon
-				int d5 = 3*nBounces + 5;
+				unsigned int d5 = SD_VERTEX + nBounces * SD_VERTEX_STRIDE;
 
-				s5 = scrHalton(d5, curr);
-				s6 = scrHalton(d5+1, curr);
-				s7 = scrHalton(d5+2, curr);
+				s5 = sobolSample(curr, d5 + SD_BSDF, CAUSTIC_PHOTON_SEED);
+				s6 = sobolSample(curr, d5 + SD_BSDF+1, CAUSTIC_PHOTON_SEED);
+				s7 = sobolSample(curr, d5 + SD_BSDF_COMP, CAUSTIC_PHOTON_SEED);
 
 				pSample_t sample(s5, s6, s7, BSDF_ALL, pcol, transm);
 
@@ -635,6 +638,7 @@ color_t photonIntegrator_t::finalGathering(renderState_t &state, const surfacePo
 	float W = 0.f;
 	
 	int nSampl = std::max(1, nPaths/state.rayDivision);
+	unsigned int oldIndex = state.sampleIndex, oldDim = state.sampleDim;
 	for(int i=0; i<nSampl; ++i)
 	{
 		color_t throughput( 1.0 );
@@ -645,11 +649,13 @@ color_t photonIntegrator_t::finalGathering(renderState_t &state, const surfacePo
 		BSDF_t matBSDFs;
 		bool did_hit;
 		const material_t *p_mat = sp.material;
-		unsigned int offs = nPaths * state.pixelSample + state.samplingOffs + i; // some redundancy here...
+		unsigned int offs = nPaths * oldIndex + i;
 		color_t lcol, scol;
+		state.sampleIndex = offs;
+		state.sampleDim = oldDim;
 		// "zero'th" FG bounce:
-		float s1 = RI_vdC(offs);
-		float s2 = scrHalton(2, offs);
+		float s1 = state.sample(offs, SD_BSDF);
+		float s2 = state.sample(offs, SD_BSDF+1);
 		if(state.rayDivision > 1)
 		{
 			s1 = addMod1(s1, state.dc1);
@@ -680,7 +686,7 @@ color_t photonIntegrator_t::finalGathering(renderState_t &state, const surfacePo
 		// further bounces construct a path just as with path tracing:
 		for(int depth=0; depth<gatherBounces && do_bounce; ++depth)
 		{
-			int d4 = 4*depth;
+			state.sampleDim = oldDim + (depth + 1) * SD_VERTEX_STRIDE;
 			pwo = -pRay.dir;
 			p_mat->initBSDF(state, hit, matBSDFs);
 			
@@ -693,7 +699,7 @@ color_t photonIntegrator_t::finalGathering(renderState_t &state, const surfacePo
 			{
 				if(close)
 				{
-					lcol = estimateOneDirectLight(state, hit, pwo, offs);
+					lcol = estimateOneDirectLight(state, hit, pwo);
 				}
 				else if(caustic)
 				{
@@ -709,8 +715,8 @@ color_t photonIntegrator_t::finalGathering(renderState_t &state, const surfacePo
 				}
 			}
 			
-			s1 = scrHalton(d4+3, offs);
-			s2 = scrHalton(d4+4, offs);
+			s1 = state.sample(offs, SD_BSDF);
+			s2 = state.sample(offs, SD_BSDF+1);
 
 			if(state.rayDivision > 1)
 			{
@@ -765,6 +771,8 @@ color_t photonIntegrator_t::finalGathering(renderState_t &state, const surfacePo
 		}
 		state.userdata = first_udat;
 	}
+	state.sampleIndex = oldIndex;
+	state.sampleDim = oldDim;
 	return pathCol / (float)nSampl;
 }
 
@@ -845,6 +853,7 @@ colorA_t photonIntegrator_t::integrate(renderState_t &state, diffRay_t &ray) con
 					if(nGathered > _nMax) _nMax = nGathered;
 
 					float scale = 1.f / ( (float)diffuseMap.nPaths() * radius * M_PI);
+					statCount(STAT_MATERIAL_EVALS, nGathered);
 					for(int i=0; i<nGathered; ++i)
 					{
 						vector3d_t pdir = gathered[i].photon->direction();
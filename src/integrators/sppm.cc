@@ -1,5 +1,7 @@
 #include <integrators/sppm.h>
 #include <yafraycore/scr_halton.h>
+#include <yafraycore/renderstats.h>
+#include <yafraycore/trace.h>
 #include <sstream>
 #include <cmath>
 #include <algorithm>
@@ -65,12 +67,17 @@ bool SPPM::render(yafaray::imageFilm_t *image)
 	if(scene->doDepth()) precalcDepths();
 
 	initializePPM(); // seems could integrate into the preRender
-	renderPass(1, 0, false);
+	int donePasses = resumeCheckpoint(passNum);
+	if(donePasses == 0)
+	{
+		renderPass(1, 0, false);
+		checkpointPass(1, passNum);
+	}
 	PM_IRE = false;
 
 	int hpNum = camera->resX() * camera->resY();
-	int passInfo = 1;
-	for(int i=1; i<passNum; ++i) //progress pass, the offset start from 1 as it is 0 based.
+	int passInfo = std::max(1, donePasses);
+	for(int i=passInfo; i<passNum; ++i) //progress pass, the offset start from 1 as it is 0 based.
 	{
 		if(scene->getSignals() & Y_SIG_ABORT) break;
 		passInfo = i+1;
@@ -78,7 +85,9 @@ bool SPPM::render(yafaray::imageFilm_t *image)
 		nRefined = 0;
 		renderPass(1, 1 + (i-1)*1, false); // offset are only related to the passNum, since we alway have only one sample.
 		Y_INFO <<  integratorName << ": This pass refined " << nRefined << " of " << hpNum << " pixels." << yendl;
+		checkpointPass(i+1, passNum);
 	}
+	checkpoint.wait();
 	maxDepth = 0.f;
 	gTimer.stop("rendert");
 	Y_INFO << integratorName << ": Overall rendertime: "<< gTimer.getTime("rendert") << "s." << yendl;
@@ -96,13 +105,13 @@ bool SPPM::renderTile(renderArea_t &a, int n_samples, int offset, bool adaptive,
 	int x, y;
 	const camera_t* camera = scene->getCamera();
 	bool do_depth = scene->doDepth();
+	bool do_cost = imageFilm->doCostMap();
 	x=camera->resX();
 	y=camera->resY();
 	diffRay_t c_ray;
-	ray_t d_ray;
 	PFLOAT dx=0.5, dy=0.5, d1=1.0/(PFLOAT)n_samples;
 	float lens_u=0.5f, lens_v=0.5f;
-	PFLOAT wt, wt_dummy;
+	PFLOAT wt;
 	random_t prng(offset*(x*a.Y+a.X)+123);
 	renderState_t rstate(&prng);
 	rstate.threadID = threadID;
@@ -118,12 +127,14 @@ bool SPPM::renderTile(renderArea_t &a, int n_samples, int offset, bool adaptive,
 
 			rstate.pixelNumber = x*i+j;
 			rstate.samplingOffs = fnv_32a_buf(i*fnv_32a_buf(j));//fnv_32a_buf(rstate.pixelNumber);
+			double cost = do_cost ? imageFilm->costProbe() : 0.0;
 			float toff = scrHalton(5, pass_offs+rstate.samplingOffs); // **shall be just the pass number...**
 
 			for(int sample=0; sample<n_samples; ++sample) //set n_samples = 1.
 			{
 				rstate.setDefaults();
 				rstate.pixelSample = pass_offs+sample;
+				rstate.sampleIndex = rstate.pixelSample;
 				rstate.time = addMod1((PFLOAT)sample*d1, toff); //(0.5+(PFLOAT)sample)*d1;
 				// the (1/n, Larcher&Pillichshammer-Seq.) only gives good coverage when total sample count is known
 				// hence we use scrambled (Sobol, van-der-Corput) for multipass AA
@@ -136,21 +147,14 @@ bool SPPM::renderTile(renderArea_t &a, int n_samples, int offset, bool adaptive,
 					lens_u = scrHalton(3, rstate.pixelSample+rstate.samplingOffs);
 					lens_v = scrHalton(4, rstate.pixelSample+rstate.samplingOffs);
 				}
-				c_ray = camera->shootRay(j+dx, i+dy, lens_u, lens_v, wt); // wt need to be considered
+				c_ray = camera->shootDiffRay(j+dx, i+dy, lens_u, lens_v, wt); // wt need to be considered
+				renderStats_t::primaryRay();
 				if(wt==0.0)
 				{
 					imageFilm->addSample(colorA_t(0.f), j, i, dx, dy, &a); //maybe not need
 					continue;
 				}
-				//setup ray differentials
-				d_ray = camera->shootRay(j+1+dx, i+dy, lens_u, lens_v, wt_dummy);
-				c_ray.xfrom = d_ray.from;
-				c_ray.xdir = d_ray.dir;
-				d_ray = camera->shootRay(j+dx, i+1+dy, lens_u, lens_v, wt_dummy);
-				c_ray.yfrom = d_ray.from;
-				c_ray.ydir = d_ray.dir;
 				c_ray.time = rstate.time;
-				c_ray.hasDifferentials = true;
 				// col = T * L_o + L_v
 				diffRay_t c_ray_copy = c_ray;
 
@@ -195,6 +199,7 @@ bool SPPM::renderTile(renderArea_t &a, int n_samples, int offset, bool adaptive,
 					imageFilm->addDepthSample(0, depth, j, i, dx, dy);
 				}
 			}
+			if(do_cost) imageFilm->addCost(j, i, imageFilm->costProbe() - cost);
 		}
 	}
 	return true;
@@ -203,6 +208,7 @@ bool SPPM::renderTile(renderArea_t &a, int n_samples, int offset, bool adaptive,
 //photon pass, scatter photon 
 void SPPM::prePass(int samples, int offset, bool adaptive)
 {
+	traceScope_t ts("photon pass", "photon", "offset", offset);
 	std::stringstream set;
 	gTimer.addEvent("prePass");
 	gTimer.start("prePass");
@@ -246,7 +252,7 @@ void SPPM::prePass(int samples, int offset, bool adaptive)
 
 	for (int i=0; i<numDLights; ++i) energies[i] = tmplights[i]->totalEnergy().energy();
 
-	lightPowerD = new pdf1D_t(energies, numDLights);
+	lightPowerD = new aliasPdf1D_t(energies, numDLights);
 
 	Y_INFO << integratorName << ": Light(s) photon color testing for photon map:" << yendl;
 
@@ -557,6 +563,7 @@ GatherInfo SPPM::traceGatherRay(yafaray::renderState_t &state, yafaray::diffRay_
 					gInfo.photonCount++;
 					vector3d_t pdir = gathered[i].photon->direction();
 					color_t surfCol = material->eval(state, sp, wo, pdir, BSDF_DIFFUSE); // seems could speed up using rho, (something pbrt made)
+					statCount(STAT_MATERIAL_EVALS);
 					gInfo.photonFlux += surfCol * gathered[i].photon->color();// * std::fabs(sp.N*pdir); //< wrong!?
 					//color_t  flux= surfCol * gathered[i].photon->color();// * std::fabs(sp.N*pdir); //< wrong!?
 
@@ -583,6 +590,7 @@ GatherInfo SPPM::traceGatherRay(yafaray::renderState_t &state, yafaray::diffRay_
 						vector3d_t pdir = gathered[i].photon->direction();
 						gInfo.photonCount++;
 						surfCol = material->eval(state, sp, wo, pdir, BSDF_ALL); // seems could speed up using rho, (something pbrt made)
+						statCount(STAT_MATERIAL_EVALS);
 						gInfo.photonFlux += surfCol * gathered[i].photon->color();// * std::fabs(sp.N*pdir); //< wrong!?
 						//color_t  flux= surfCol * gathered[i].photon->color();// * std::fabs(sp.N*pdir); //< wrong!?
 
@@ -809,7 +817,9 @@ void SPPM::initializePPM()
 	const camera_t* camera = scene->getCamera();
 	unsigned int resolution = camera->resX() * camera->resY();
 
+	hitPoints.clear();
 	hitPoints.reserve(resolution);
+	totalnPhotons = 0;
 	bound_t bBox = scene->getSceneBound(); // Now using Scene Bound, this could get a bigger initial radius, and need more tests
 
 	// initialize SPPM statistics
@@ -831,6 +841,28 @@ void SPPM::initializePPM()
 
 }
 
+void SPPM::saveCheckpointState(checkpoint_t &cp) const
+{
+	cp.putVector(hitPoints);
+	cp.put(totalnPhotons);
+	cp.put(hal1); cp.put(hal2); cp.put(hal3); cp.put(hal4);
+}
+
+bool SPPM::loadCheckpointState(checkpoint_t &cp)
+{
+	std::vector<HitPoint> points;
+	unsigned int photons = 0;
+	Halton h1, h2, h3, h4;
+	cp.getVector(points);
+	cp.get(photons);
+	cp.get(h1); cp.get(h2); cp.get(h3); cp.get(h4);
+	if(!cp.good() || points.size() != hitPoints.size()) return false;
+	hitPoints.swap(points);
+	totalnPhotons = photons;
+	hal1 = h1; hal2 = h2; hal3 = h3; hal4 = h4;
+	return true;
+}
+
 integrator_t* SPPM::factory(paraMap_t &params, renderEnvironment_t &render)
 {
 	bool transpShad=false;
@@ -216,6 +216,16 @@ bool xmlInterface_t::addInstance(unsigned int baseObjectId, matrix4x4_t objToWor
 	return true;
 }
 
+bool xmlInterface_t::addInstance(unsigned int baseObjectId, matrix4x4_t objToWorld, matrix4x4_t objToWorldEnd)
+{
+	xmlFile << "\n<instance base_object_id=\"" << baseObjectId << "\" >\n\t";
+	writeMatrix("transform",objToWorld,xmlFile);
+	xmlFile << "\n\t";
+	writeMatrix("transform_end",objToWorldEnd,xmlFile);
+	xmlFile << "\n</instance>\n";
+	return true;
+}
+
 void xmlInterface_t::writeParamMap(const paraMap_t &pmap, int indent)
 {
 	std::string tabs(indent, '\t');
@@ -5,6 +5,8 @@
 #include <core_api/imagefilm.h>
 #include <core_api/integrator.h>
 #include <core_api/matrix4.h>
+#include <yafraycore/renderstats.h>
+#include <yafraycore/trace.h>
 
 __BEGIN_YAFRAY
 
@@ -50,6 +52,8 @@ void yafrayInterface_t::loadPlugins(const char *path)
 void yafrayInterface_t::clearAll()
 {
 	Y_INFO << "Interface: Cleaning environment..." << yendl;
+	// textures may still be decoding into the image handlers freed here
+	if(scene) scene->getLoadQueue().wait();
 	env->clearAll();
 	Y_INFO << "Interface: Deleteing scene..." << yendl;
 	if(scene) delete scene;
@@ -142,6 +146,11 @@ bool yafrayInterface_t::addInstance(unsigned int baseObjectId, matrix4x4_t objTo
 {
 	return scene->addInstance(baseObjectId, objToWorld);
 }
+
+bool yafrayInterface_t::addInstance(unsigned int baseObjectId, matrix4x4_t objToWorld, matrix4x4_t objToWorldEnd)
+{
+	return scene->addInstance(baseObjectId, objToWorld, objToWorldEnd);
+}
 // paraMap_t related functions:
 void yafrayInterface_t::paramsSetPoint(const char* name, double x, double y, double z)
 {
@@ -284,6 +293,13 @@ bool yafrayInterface_t::getRenderedImage(colorOutput_t &output)
 	return true;
 }
 
+bool yafrayInterface_t::getCostMap(colorOutput_t &output, bool falseColor)
+{
+	if(!film || !film->doCostMap()) return false;
+	film->flushCostMap(output, falseColor);
+	return true;
+}
+
 std::vector<std::string> yafrayInterface_t::listImageHandlers()
 {
 	return env->listImageHandlers();
@@ -356,6 +372,27 @@ bool yafrayInterface_t::getDrawParams()
 	
 	return dp;
 }
+
+void yafrayInterface_t::setRenderStats(bool on)
+{
+	renderStats_t::setEnabled(on);
+}
+
+std::string yafrayInterface_t::getRenderStats()
+{
+	return gStats.toJSON();
+}
+
+void yafrayInterface_t::setRenderTrace(bool on)
+{
+	traceRecorder_t::setEnabled(on);
+}
+
+bool yafrayInterface_t::saveRenderTrace(const char *fileName)
+{
+	return gTrace.saveJSON(fileName);
+}
+
 void yafrayInterface_t::setVerbosityLevel(int vlevel)
 {
 	yafout.setMasterVerbosity(vlevel);
@@ -22,13 +22,17 @@
 #include <lights/bglight.h>
 #include <core_api/background.h>
 #include <core_api/texture.h>
+#include <core_api/scene.h>
 #include <utilities/sample_utils.h>
+#include <yafraycore/ccthreads.h>
 
 __BEGIN_YAFRAY
 
 #define MAX_VSAMPLES 360
 #define MAX_USAMPLES 720
 #define MIN_SAMPLES 16
+#define MAX_RES_USAMPLES 4096
+#define MAX_RES_VSAMPLES 2048
 
 #define SMPL_OFF 0.4999f
 
@@ -52,8 +56,8 @@ inline float sinSample(float s)
 	return fSin(s * M_PI);
 }
 
-bgLight_t::bgLight_t(int sampl, bool shootC, bool shootD, bool absIntersect):
-light_t(LIGHT_NONE), samples(sampl), shootCaustic(shootC), shootDiffuse(shootD), absInter(absIntersect)
+bgLight_t::bgLight_t(int sampl, bool shootC, bool shootD, bool absIntersect, bool resFromBg):
+light_t(LIGHT_NONE), samples(sampl), shootCaustic(shootC), shootDiffuse(shootD), absInter(absIntersect), resFromBackground(resFromBg)
 {
 	background = NULL;
 }
@@ -65,49 +69,76 @@ bgLight_t::~bgLight_t()
 	delete vDist;
 }
 
+//! builds the u distributions of a range of rows, rows are independent so they can be built in parallel
+class bgRowJob_t: public yafthreads::parallelJob_t
+{
+	public:
+		bgRowJob_t(const background_t *bg, aliasPdf1D_t **dist, float *integrals, int rows, int maxU):
+			background(bg), uDist(dist), fv(integrals), nv(rows), maxUSamples(maxU) {}
+		virtual void run(int start, int end)
+		{
+			float *fu = new float[maxUSamples];
+			float inv = 1.f / (float)nv;
+			ray_t ray;
+			ray.from = point3d_t(0.f);
+
+			for(int y = start; y < end; y++)
+			{
+				float fy = ((float)y + 0.5f) * inv;
+
+				float sintheta = sinSample(fy);
+
+				int nu = MIN_SAMPLES + (int)(sintheta * (maxUSamples - MIN_SAMPLES));
+				float inu = 1.f / (float)nu;
+
+				for(int x = 0; x < nu; x++)
+				{
+					float fx = ((float)x + 0.5f) * inu;
+
+					invSpheremap(fx, fy, ray.dir);
+
+					fu[x] = background->eval(ray).energy() * sintheta;
+				}
+
+				uDist[y] = new aliasPdf1D_t(fu, nu);
+
+				fv[y] = uDist[y]->integral;
+			}
+			delete[] fu;
+		}
+	protected:
+		const background_t *background;
+		aliasPdf1D_t **uDist;
+		float *fv;
+		int nv, maxUSamples;
+};
+
 void bgLight_t::init(scene_t &scene)
 {
-	float *fu = new float[MAX_USAMPLES];
-	float *fv = new float[MAX_VSAMPLES];
-	float inu = 0, inv = 0;
-	float fx = 0.f, fy = 0.f;
-	float sintheta = 0.f;
-	int nu = 0, nv = MAX_VSAMPLES;
-	
-	ray_t ray;
-	ray.from = point3d_t(0.f);
-	
-	inv = 1.f / (float)nv;
-	
-	uDist = new pdf1D_t*[nv];
-	
-	for (int y = 0; y < nv; y++)
+	int maxU = MAX_USAMPLES, nv = MAX_VSAMPLES;
+
+	if(resFromBackground)
 	{
-		fy = ((float)y + 0.5f) * inv;
-		
-		sintheta = sinSample(fy);
-		
-		nu = MIN_SAMPLES + (int)(sintheta * (MAX_USAMPLES - MIN_SAMPLES));
-		inu = 1.f / (float)nu;
-		
-		for(int x = 0; x < nu; x++)
+		int bgU = 0, bgV = 0;
+		background->resolution(bgU, bgV);
+		if(bgU > 0 && bgV > 0)
 		{
-			fx = ((float)x + 0.5f) * inu;
-			
-			invSpheremap(fx, fy, ray.dir);
-			
-			fu[x] = background->eval(ray).energy() * sintheta;
+			maxU = std::max(MIN_SAMPLES, std::min(bgU, MAX_RES_USAMPLES));
+			nv = std::max(MIN_SAMPLES, std::min(bgV, MAX_RES_VSAMPLES));
 		}
-		
-		uDist[y] = new pdf1D_t(fu, nu);
-		
-		fv[y] = uDist[y]->integral;
+		Y_INFO << "bgLight: Sampling table resolution " << maxU << "x" << nv << yendl;
 	}
-	
-	vDist = new pdf1D_t(fv, nv);
-	
+
+	float *fv = new float[nv];
+
+	uDist = new aliasPdf1D_t*[nv];
+
+	bgRowJob_t job(background, uDist, fv, nv, maxU);
+	yafthreads::runParallel(job, nv, scene.getNumThreads(), 8);
+
+	vDist = new aliasPdf1D_t(fv, nv);
+
 	delete[] fv;
-	delete[] fu;
 
 	bound_t w=scene.getSceneBound();
 	worldCenter = 0.5 * (w.a + w.g);
@@ -280,13 +311,15 @@ light_t* bgLight_t::factory(paraMap_t &params, renderEnvironment_t &render)
 	bool shootD = true;
 	bool shootC = true;
 	bool absInt = false;
+	bool resFromBg = false;
 	
 	params.getParam("samples", samples);
 	params.getParam("shoot_caustics", shootC);
 	params.getParam("shoot_diffuse", shootD);
 	params.getParam("abs_intersect", absInt);
+	params.getParam("res_from_background", resFromBg);
 
-	bgLight_t *light = new bgLight_t(samples, shootC, shootD, absInt);
+	bgLight_t *light = new bgLight_t(samples, shootC, shootD, absInt, resFromBg);
 
 	return light;
 }
@@ -61,7 +61,7 @@ void bgPortalLight_t::initIS()
 		areas[i] = tris[i]->surfaceArea();
 		totalArea += areas[i];
 	}
-	areaDist = new pdf1D_t(areas, nTris);
+	areaDist = new aliasPdf1D_t(areas, nTris);
 	area = (float)totalArea;
 	invArea = (float)(1.0/totalArea);
 	//delete[] tris;
@@ -92,19 +92,13 @@ void bgPortalLight_t::init(scene_t &scene)
 void bgPortalLight_t::sampleSurface(point3d_t &p, vector3d_t &n, float s1, float s2) const
 {
 	float primPdf;
-	int primNum = areaDist->DSample(s1, &primPdf);
+	float ss1;
+	int primNum = areaDist->DSample(s1, &primPdf, &ss1);
 	if(primNum >= areaDist->count)
 	{
 		Y_INFO << "bgPortalLight: Sampling error!" << yendl;
 		return;
 	}
-	float ss1, delta = areaDist->cdf[primNum+1];
-	if(primNum > 0)
-	{
-		delta -= areaDist->cdf[primNum];
-		ss1 = (s1 - areaDist->cdf[primNum]) / delta;
-	}
-	else ss1 = s1 / delta;
 	tris[primNum]->sample(ss1, s2, p, n);
 }
 
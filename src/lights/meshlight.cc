@@ -56,7 +56,7 @@ void meshLight_t::initIS()
 		areas[i] = tris[i]->surfaceArea();
 		totalArea += areas[i];
 	}
-	areaDist = new pdf1D_t(areas, nTris);
+	areaDist = new aliasPdf1D_t(areas, nTris);
 	area = (float)totalArea;
 	invArea = (float)(1.0/totalArea);
 	delete[] areas;
@@ -80,19 +80,13 @@ void meshLight_t::init(scene_t &scene)
 void meshLight_t::sampleSurface(point3d_t &p, vector3d_t &n, float s1, float s2) const
 {
 	float primPdf;
-	int primNum = areaDist->DSample(s1, &primPdf);
+	float ss1;
+	int primNum = areaDist->DSample(s1, &primPdf, &ss1);
 	if(primNum >= areaDist->count)
 	{
 		Y_INFO << "MeshLight: Sampling error!" << yendl;
 		return;
 	}
-	float ss1, delta = areaDist->cdf[primNum+1];
-	if(primNum > 0)
-	{
-		delta -= areaDist->cdf[primNum];
-		ss1 = (s1 - areaDist->cdf[primNum]) / delta;
-	}
-	else ss1 = s1 / delta;
 	tris[primNum]->sample(ss1, s2, p, n);
 //	++stats[primNum];
 }
@@ -54,7 +54,7 @@ inline void blendMat_t::getBlendVal(const renderState_t &state, const surfacePoi
 		void *old_dat = state.userdata;
 		
 		nodeStack_t stack(state.userdata);
-		evalNodes(state, sp, allSorted, stack);
+		evalNodes(state, sp, progSorted, stack);
 		val = blendS->getScalar(stack);
 		state.userdata = old_dat;
 	}
@@ -416,6 +416,15 @@ material_t* blendMat_t::factory(paraMap_t &params, std::list<paraMap_t> &eparams
 		return 0;
 	}
 	mat->solveNodesOrder(roots);
+	mat->compileNodes();
+	// only the scalar of the mask is read
+	mat->compileProgram(std::vector<const shaderNode_t *>(), mat->rootNodes, mat->allSorted, mat->progSorted);
+	if(mat->recalcBlend && mat->isConstantNode(mat->blendS))
+	{
+		// mask doesn't vary over the surface, use it like a blend value
+		mat->blendVal = mat->constResult[mat->blendS->ID].f;
+		mat->recalcBlend = false;
+	}
 	mat->reqMem = sizeof(bool) + mat->reqNodeMem;
 	return mat;
 }
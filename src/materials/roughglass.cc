@@ -47,8 +47,7 @@ void roughGlassMat_t::initBSDF(const renderState_t &state, const surfacePoint_t
 	if(bumpS) evalBump(stack, state, sp, bumpS);
 	
 	//eval viewindependent nodes
-	std::vector<shaderNode_t *>::const_iterator iter, end=allViewindep.end();
-	for(iter = allViewindep.begin(); iter!=end; ++iter) (*iter)->eval(stack, state, sp);
+	evalNodes(state, sp, progViewindep, stack);
 	bsdfTypes=bsdfFlags;
 }
 
@@ -245,6 +244,7 @@ material_t* roughGlassMat_t::factory(paraMap_t &params, std::list< paraMap_t > &
 		{
 			mat->getNodeList(mat->bumpS, mat->bumpNodes);
 		}
+		mat->compileNodes();
 	}
 	mat->reqMem = mat->reqNodeMem;
 
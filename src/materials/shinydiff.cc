@@ -156,8 +156,7 @@ void shinyDiffuseMat_t::initBSDF(const renderState_t &state, const surfacePoint_
     }
     
     //eval viewindependent nodes
-    std::vector<shaderNode_t *>::const_iterator iter, end=allViewindep.end();
-    for(iter = allViewindep.begin(); iter!=end; ++iter) (*iter)->eval(stack, state, sp);
+    evalNodes(state, sp, progViewindep, stack);
     bsdfTypes=bsdfFlags;
     
     getComponents(viNodes, stack, dat->component);
@@ -426,8 +425,7 @@ void shinyDiffuseMat_t::getSpecular(const renderState_t &state, const surfacePoi
 color_t shinyDiffuseMat_t::getTransparency(const renderState_t &state, const surfacePoint_t &sp, const vector3d_t &wo)const
 {
     nodeStack_t stack(state.userdata);
-    std::vector<shaderNode_t *>::const_iterator iter, end=allSorted.end();
-    for(iter = allSorted.begin(); iter!=end; ++iter) (*iter)->eval(stack, state, sp);
+    evalNodes(state, sp, progTransparency, stack);
     float accum=1.f;
     float Kr;
     vector3d_t N = FACE_FORWARD(sp.Ng, sp.N, wo);
@@ -547,6 +545,13 @@ material_t* shinyDiffuseMat_t::factory(paraMap_t &params, std::list<paraMap_t> &
         mat->filterNodes(colorNodes, mat->allViewindep, VIEW_INDEP);
 
         if(mat->mBumpShader)         mat->getNodeList(mat->mBumpShader, mat->bumpNodes);
+        mat->compileNodes();
+
+        std::vector<const shaderNode_t *> colorOutputs, scalarOutputs;
+        colorOutputs.push_back(mat->mDiffuseShader);
+        scalarOutputs.push_back(mat->mMirrorShader);
+        scalarOutputs.push_back(mat->mTransparencyShader);
+        mat->compileProgram(colorOutputs, scalarOutputs, mat->allSorted, mat->progTransparency);
     }
 
 
@@ -13,10 +13,11 @@ textureMapper_t::textureMapper_t(const texture_t *texture): tex(texture), bumpSt
 
 void textureMapper_t::setup()
 {
-	if(tex->discrete())
+	int u = 0, v = 0, w = 0;
+	// resolution() waits for an image texture that is still decoding, an image that failed to load has none
+	if(tex->discrete()) tex->resolution(u, v, w);
+	if(u > 0 && v > 0)
 	{
-		int u, v, w;
-		tex->resolution(u, v, w);
 		dU = 1.f/(float)u;
 		dV = 1.f/(float)v;
 		if(tex->isThreeD()) dW = 1.f/(float)w;
@@ -336,41 +337,19 @@ shaderNode_t* valueNode_t::factory(const paraMap_t &params,renderEnvironment_t &
 /  A simple mix node, could be used to derive other math nodes
 / ========================================== */
 
-mixNode_t::mixNode_t(): cfactor(0.f), input1(0), input2(0), factor(0)
-{}
-
-mixNode_t::mixNode_t(float val): cfactor(val), input1(0), input2(0), factor(0)
-{}
+mixNode_t::mixNode_t(mix_modes mode, float val)
+{
+	op.code = NOP_MIX;
+	op.mode = mode;
+	op.konst[2].f = val;
+}
 
 void mixNode_t::eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const
 {
-	float f2 = (factor) ? factor->getScalar(stack) : cfactor;
-	float f1 = 1.f - f2, fin1, fin2;
-	colorA_t cin1, cin2;
-	if(input1)
-	{
-		cin1 = input1->getColor(stack);
-		fin1 = input1->getScalar(stack);
-	}
-	else
-	{
-		cin1 = col1;
-		fin1 = val1;
-	}
-	if(input2)
-	{
-		cin2 = input2->getColor(stack);
-		fin2 = input2->getScalar(stack);
-	}
-	else
-	{
-		cin2 = col2;
-		fin2 = val2;
-	}
-
-	colorA_t color = f1 * cin1 + f2 * cin2;
-	float   scalar = f1 * fin1 + f2 * fin2;
-	stack[this->ID] = nodeResult_t(color, scalar);
+	const nodeResult_t &in1 = (op.in[0]) ? stack(op.in[0]->ID) : op.konst[0];
+	const nodeResult_t &in2 = (op.in[1]) ? stack(op.in[1]->ID) : op.konst[1];
+	float f2 = (op.in[2]) ? op.in[2]->getScalar(stack) : op.konst[2].f;
+	mixNodeOp(op.mode, f2, in1, in2, NV_BOTH, stack[this->ID]);
 }
 
 void mixNode_t::eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp, const vector3d_t &wo, const vector3d_t &wi)const
@@ -383,14 +362,14 @@ bool mixNode_t::configInputs(const paraMap_t &params, const nodeFinder_t &find)
 	const std::string *name=0;
 	if( params.getParam("input1", name) )
 	{
-		input1 = find(*name);
-		if(!input1)
+		op.in[0] = find(*name);
+		if(!op.in[0])
 		{
 			Y_ERROR << "MixNode: Couldn't get input1 " << *name << yendl;
 			return false;
 		}
 	}
-	else if(!params.getParam("color1", col1))
+	else if(!params.getParam("color1", op.konst[0].col))
 	{
 		Y_ERROR << "MixNode: Color1 not set" << yendl;
 		return false;
@@ -398,14 +377,14 @@ bool mixNode_t::configInputs(const paraMap_t &params, const nodeFinder_t &find)
 
 	if( params.getParam("input2", name) )
 	{
-		input2 = find(*name);
-		if(!input2)
+		op.in[1] = find(*name);
+		if(!op.in[1])
 		{
 			Y_ERROR << "MixNode: Couldn't get input2 " << *name << yendl;
 			return false;
 		}
 	}
-	else if(!params.getParam("color2", col2))
+	else if(!params.getParam("color2", op.konst[1].col))
 	{
 		Y_ERROR << "MixNode: Color2 not set" << yendl;
 		return false;
@@ -413,14 +392,14 @@ bool mixNode_t::configInputs(const paraMap_t &params, const nodeFinder_t &find)
 
 	if( params.getParam("factor", name) )
 	{
-		factor = find(*name);
-		if(!factor)
+		op.in[2] = find(*name);
+		if(!op.in[2])
 		{
 			Y_ERROR << "MixNode: Couldn't get factor " << *name << yendl;
 			return false;
 		}
 	}
-	else if(!params.getParam("value", cfactor))
+	else if(!params.getParam("value", op.konst[2].f))
 	{
 		Y_ERROR << "MixNode: Value not set" << yendl;
 		return false;
@@ -431,154 +410,10 @@ bool mixNode_t::configInputs(const paraMap_t &params, const nodeFinder_t &find)
 
 bool mixNode_t::getDependencies(std::vector<const shaderNode_t*> &dep) const
 {
-	if(input1) dep.push_back(input1);
-	if(input2) dep.push_back(input2);
-	if(factor) dep.push_back(factor);
+	for(int i=0; i<3; ++i) if(op.in[i]) dep.push_back(op.in[i]);
 	return !dep.empty();
 }
 
-class addNode_t: public mixNode_t
-{
-	public:
-		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const
-		{
-			float f2, fin1, fin2;
-			colorA_t cin1, cin2;
-			getInputs(stack, cin1, cin2, fin1, fin2, f2);
-
-			cin1 += f2 * cin2;
-			fin1 += f2 * fin2;
-			stack[this->ID] = nodeResult_t(cin1, fin1);
-		}
-};
-
-class multNode_t: public mixNode_t
-{
-	public:
-		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const
-		{
-			float f1, f2, fin1, fin2;
-			colorA_t cin1, cin2;
-			getInputs(stack, cin1, cin2, fin1, fin2, f2);
-			f1 = 1.f - f2;
-
-			cin1 *= colorA_t(f1) + f2 * cin2;
-			fin2 *= f1 + f2 * fin2;
-			stack[this->ID] = nodeResult_t(cin1, fin1);
-		}
-};
-
-class subNode_t: public mixNode_t
-{
-	public:
-		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const
-		{
-			float f2, fin1, fin2;
-			colorA_t cin1, cin2;
-			getInputs(stack, cin1, cin2, fin1, fin2, f2);
-
-			cin1 -= f2 * cin2;
-			fin1 -= f2 * fin2;
-			stack[this->ID] = nodeResult_t(cin1, fin1);
-		}
-};
-
-class screenNode_t: public mixNode_t
-{
-	public:
-		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const
-		{
-			float f1, f2, fin1, fin2;
-			colorA_t cin1, cin2;
-			getInputs(stack, cin1, cin2, fin1, fin2, f2);
-			f1 = 1.f - f2;
-
-			colorA_t color = colorA_t(1.f) - (colorA_t(f1) + f2 * (1.f - cin2)) * (1.f - cin1);
-			CFLOAT scalar   = 1.0 - (f1 + f2*(1.f - fin2)) * (1.f -  fin1);
-			stack[this->ID] = nodeResult_t(color, scalar);
-		}
-};
-
-class diffNode_t: public mixNode_t
-{
-	public:
-		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const
-		{
-			float f1, f2, fin1, fin2;
-			colorA_t cin1, cin2;
-			getInputs(stack, cin1, cin2, fin1, fin2, f2);
-			f1 = 1.f - f2;
-
-			cin1.R = f1*cin1.R + f2*std::fabs(cin1.R - cin2.R);
-			cin1.G = f1*cin1.G + f2*std::fabs(cin1.G - cin2.G);
-			cin1.B = f1*cin1.B + f2*std::fabs(cin1.B - cin2.B);
-			cin1.A = f1*cin1.A + f2*std::fabs(cin1.A - cin2.A);
-			fin1   = f1*fin1   + f2*std::fabs(fin1 - fin2);
-			stack[this->ID] = nodeResult_t(cin1, fin1);
-		}
-};
-
-class darkNode_t: public mixNode_t
-{
-	public:
-		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const
-		{
-			float f2, fin1, fin2;
-			colorA_t cin1, cin2;
-			getInputs(stack, cin1, cin2, fin1, fin2, f2);
-
-			cin2 *= f2;
-			if(cin2.R < cin1.R) cin1.R = cin2.R;
-			if(cin2.G < cin1.G) cin1.G = cin2.G;
-			if(cin2.B < cin1.B) cin1.B = cin2.B;
-			if(cin2.A < cin1.A) cin1.A = cin2.A;
-			fin2 *= f2;
-			if(fin2 < fin1) fin1 = fin2;
-			stack[this->ID] = nodeResult_t(cin1, fin1);
-		}
-};
-
-class lightNode_t: public mixNode_t
-{
-	public:
-		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const
-		{
-			float f2, fin1, fin2;
-			colorA_t cin1, cin2;
-			getInputs(stack, cin1, cin2, fin1, fin2, f2);
-
-			cin2 *= f2;
-			if(cin2.R > cin1.R) cin1.R = cin2.R;
-			if(cin2.G > cin1.G) cin1.G = cin2.G;
-			if(cin2.B > cin1.B) cin1.B = cin2.B;
-			if(cin2.A > cin1.A) cin1.A = cin2.A;
-			fin2 *= f2;
-			if(fin2 > fin1) fin1 = fin2;
-			stack[this->ID] = nodeResult_t(cin1, fin1);
-		}
-};
-
-class overlayNode_t: public mixNode_t
-{
-	public:
-		virtual void eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const
-		{
-			float f1, f2, fin1, fin2;
-			colorA_t cin1, cin2;
-			getInputs(stack, cin1, cin2, fin1, fin2, f2);
-			f1 = 1.f - f2;
-
-			colorA_t color;
-			color.R = (cin1.R < 0.5f) ? cin1.R * (f1 + 2.0f*f2*cin2.R) : 1.0 - (f1 + 2.0f*f2*(1.0 - cin2.R)) * (1.0 - cin1.R);
-			color.G = (cin1.G < 0.5f) ? cin1.G * (f1 + 2.0f*f2*cin2.G) : 1.0 - (f1 + 2.0f*f2*(1.0 - cin2.G)) * (1.0 - cin1.G);
-			color.B = (cin1.B < 0.5f) ? cin1.B * (f1 + 2.0f*f2*cin2.B) : 1.0 - (f1 + 2.0f*f2*(1.0 - cin2.B)) * (1.0 - cin1.B);
-			color.A = (cin1.A < 0.5f) ? cin1.A * (f1 + 2.0f*f2*cin2.A) : 1.0 - (f1 + 2.0f*f2*(1.0 - cin2.A)) * (1.0 - cin1.A);
-			CFLOAT scalar = (fin1 < 0.5f) ? fin1 * (f1 + 2.0f*f2*fin2) : 1.0 - (f1 + 2.0f*f2*(1.0 - fin2)) * (1.0 - fin1);
-			stack[this->ID] = nodeResult_t(color, scalar);
-		}
-};
-
-
 shaderNode_t* mixNode_t::factory(const paraMap_t &params,renderEnvironment_t &render)
 {
 	float val=0.5f;
@@ -586,19 +421,9 @@ shaderNode_t* mixNode_t::factory(const paraMap_t &params,renderEnvironment_t &re
 	params.getParam("cfactor", val);
 	params.getParam("mode", mode);
 
-	switch(mode)
-	{
-		case MN_MIX: 		return new mixNode_t(val);
-		case MN_ADD: 		return new addNode_t();
-		case MN_MULT: 		return new multNode_t();
-		case MN_SUB: 		return new subNode_t();
-		case MN_SCREEN:		return new screenNode_t();
-		case MN_DIFF:		return new diffNode_t();
-		case MN_DARK:		return new darkNode_t();
-		case MN_LIGHT:		return new lightNode_t();
-		case MN_OVERLAY:	return new overlayNode_t();
-	}
-	return new mixNode_t(val);
+	// there is no divide mix
+	if(mode < MN_MIX || mode > MN_OVERLAY || mode == MN_DIV) mode = MN_MIX;
+	return new mixNode_t((mix_modes)mode, val);
 }
 
 // ==================
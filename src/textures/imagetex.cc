@@ -23,15 +23,53 @@
 #include <cctype>
 #include <textures/imagetex.h>
 #include <utilities/stringUtils.h>
+#include <core_api/scene.h>
 
 __BEGIN_YAFRAY
 
 textureImage_t::textureImage_t(imageHandler_t *ih, interpolationType intp, float gamma):
-				image(ih), intp_type(intp), gamma(gamma)
+				image(ih), intp_type(intp), gamma(gamma), loadState(LOAD_PENDING)
 {
 	// Empty
 }
 
+// decodes the image file of a texture on a thread of the scene's load queue
+class imageLoadTask_t: public yafthreads::task_t
+{
+	public:
+		imageLoadTask_t(textureImage_t *t, const std::string &name): tex(t), fileName(name) {}
+		virtual void run()
+		{
+			if(!tex->loadImage(fileName)) Y_ERROR << "ImageTexture: Couldn't load image file \"" << fileName << "\", texture stays black." << yendl;
+		}
+	protected:
+		textureImage_t *tex;
+		std::string fileName;
+};
+
+bool textureImage_t::loadImage(const std::string &fileName)
+{
+	bool ok = image->loadFromFile(fileName);
+	loadCond.lock();
+	yafthreads::atomicStoreRelease(&loadState, ok ? LOAD_OK : LOAD_FAILED);
+	loadCond.signal();
+	loadCond.unlock();
+	return ok;
+}
+
+bool textureImage_t::isLoaded() const
+{
+	int state = yafthreads::atomicLoadAcquire(&loadState);
+	if(state == LOAD_PENDING)
+	{
+		loadCond.lock();
+		while((state = yafthreads::atomicLoadAcquire(&loadState)) == LOAD_PENDING) loadCond.wait();
+		loadCond.signal(); // wake the next thread waiting for this texture, if any
+		loadCond.unlock();
+	}
+	return state == LOAD_OK;
+}
+
 textureImage_t::~textureImage_t()
 {
 	// Here we simply clear the pointer, yafaray's core will handle the memory cleanup
@@ -40,6 +78,11 @@ textureImage_t::~textureImage_t()
 
 void textureImage_t::resolution(int &x, int &y, int &z) const
 {
+	if(!isLoaded())
+	{
+		x = y = z = 0;
+		return;
+	}
 	x=image->getWidth();
 	y=image->getHeight();
 	z=0;
@@ -49,6 +92,8 @@ colorA_t textureImage_t::interpolateImage(const point3d_t &p) const
 {
 	int x, y, x2, y2;
 	
+	if(!isLoaded()) return colorA_t(0.f);
+	
 	int resx=image->getWidth();
 	int resy=image->getHeight();
 	
@@ -154,6 +199,8 @@ colorA_t textureImage_t::getColor(int x, int y, int z) const
 
 colorA_t textureImage_t::getNoGammaColor(int x, int y, int z) const
 {
+	if(!isLoaded()) return colorA_t(0.f);
+	
 	int resx=image->getWidth();
 	int resy=image->getHeight();
 
@@ -311,12 +358,6 @@ texture_t *textureImage_t::factory(paraMap_t &params, renderEnvironment_t &rende
 		return NULL;
 	}
 	
-	if(!ih->loadFromFile(*name))
-	{
-		Y_ERROR << "ImageTexture: Couldn't load image file, dropping texture." << yendl;
-		return NULL;
-	}
-	
 	tex = new textureImage_t(ih, intp, gamma);
 
 	if(!tex)
@@ -324,6 +365,17 @@ texture_t *textureImage_t::factory(paraMap_t &params, renderEnvironment_t &rende
 		Y_ERROR << "ImageTexture: Couldn't create image texture." << yendl;
 		return NULL;
 	}
+	
+	// while a scene is being loaded the file is decoded in the background, scene_t::update() waits for
+	// the queue and isLoaded() for this texture's own decode
+	scene_t *scene = render.getScene();
+	if(scene) scene->getLoadQueue().add(new imageLoadTask_t(tex, *name));
+	else if(!tex->loadImage(*name))
+	{
+		Y_ERROR << "ImageTexture: Couldn't load image file, dropping texture." << yendl;
+		delete tex;
+		return NULL;
+	}
 
 	// setup image
 	bool rot90 = false;
@@ -3,91 +3,22 @@
 
 __BEGIN_YAFRAY
 
-layerNode_t::layerNode_t(unsigned tflag, CFLOAT col_fac, CFLOAT val_fac, CFLOAT def_val, colorA_t def_col, mix_modes mmod):
-			input(0), upperLayer(0), texflag(tflag), colfac(col_fac), valfac(val_fac), default_val(def_val),
-			default_col(def_col), mode(mmod), do_color(false), do_scalar(false), color_input(false)
-{}
+layerNode_t::layerNode_t(unsigned tflag, CFLOAT col_fac, CFLOAT val_fac, CFLOAT def_val, colorA_t def_col, mix_modes mmod)
+{
+	op.code = NOP_LAYER;
+	op.flags = tflag;
+	op.colfac = col_fac;
+	op.valfac = val_fac;
+	op.defVal = def_val;
+	op.defCol = def_col;
+	op.mode = mmod;
+}
 
 void layerNode_t::eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp)const
 {
-	colorA_t rcol, texcolor;
-	CFLOAT rval, Tin=0.f, Ta=1.f, stencilTin = 1.f;
 	// == get result of upper layer (or base values) ==
-	rcol = (upperLayer) ? upperLayer->getColor(stack) : upper_col;
-	rval = (upperLayer) ? upperLayer->getScalar(stack) : upper_val;
-	stencilTin = rcol.A;
-	
-	// == get texture input color ==
-	bool TEX_RGB = color_input;
-	
-	if(color_input)
-	{
-		texcolor = input->getColor(stack);
-		Ta = texcolor.A;
-	}
-	else Tin = input->getScalar(stack);
-	
-	if(texflag & TXF_RGBTOINT)
-	{
-		Tin = texcolor.col2bri();
-		TEX_RGB = false;
-	}
-	
-	if(texflag & TXF_NEGATIVE)
-	{
-		if (TEX_RGB) texcolor = colorA_t(1.f)-texcolor;
-		Tin = 1.f-Tin;
-	}
-	
-	CFLOAT fact;
-	
-	if(texflag & TXF_STENCIL)
-	{
-		if(TEX_RGB) // only scalar input affects stencil...?
-		{
-			fact = Ta;
-			Ta *= stencilTin;
-			stencilTin *= fact;
-		}
-		else
-		{
-			fact = Tin;
-			Tin *= stencilTin;
-			stencilTin *= fact;
-		}
-	}
-	
-	// color type modulation
-	if (do_color)
-	{
-		if(!TEX_RGB)	texcolor = default_col;
-		else			Tin = Ta;
-		
-		rcol = texture_rgb_blend(texcolor, rcol, Tin, stencilTin * colfac, mode);
-		rcol.clampRGB0();
-	}
-	
-	// intensity type modulation
-	if (do_scalar)
-	{
-		if(TEX_RGB)
-		{
-			if(use_alpha)
-			{
-				Tin = Ta;
-				if(texflag & TXF_NEGATIVE) Tin = 1.f - Tin;
-			}
-			else
-			{
-				Tin = texcolor.col2bri();
-			}
-		}
-		
-		rval = texture_value_blend(default_val, rval, Tin, stencilTin * valfac, mode, (do_scalar<0));
-		if(rval<0.f) rval=0.f;
-	}
-	rcol.A = stencilTin;
-	stack[this->ID] = nodeResult_t(rcol, rval);
+	const nodeResult_t &upper = (op.in[1]) ? stack(op.in[1]->ID) : op.konst[1];
+	layerNodeOp(op, stack(op.in[0]->ID), upper, NV_BOTH, stack[this->ID]);
 }
 
 void layerNode_t::eval(nodeStack_t &stack, const renderState_t &state, const surfacePoint_t &sp, const vector3d_t &wo, const vector3d_t &wi)const
@@ -102,19 +33,19 @@ void layerNode_t::evalDerivative(nodeStack_t &stack, const renderState_t &state,
 	CFLOAT stencilTin = 1.f;
 
 	// == get result of upper layer (or base values) ==
-	if(upperLayer)
+	if(op.in[1])
 	{
-		colorA_t ucol = upperLayer->getColor(stack);
+		colorA_t ucol = op.in[1]->getColor(stack);
 		rdu = ucol.R, rdv = ucol.G;
 		stencilTin = ucol.A;
 	}
 	
 	// == get texture input derivative ==
-	texcolor = input->getColor(stack);
+	texcolor = op.in[0]->getColor(stack);
 	tdu = texcolor.R;
 	tdv = texcolor.G;
 	
-	if(texflag & TXF_NEGATIVE)
+	if(op.flags & TXF_NEGATIVE)
 	{
 		tdu = -tdu;
 		tdv = -tdv;
@@ -130,8 +61,8 @@ void layerNode_t::evalDerivative(nodeStack_t &stack, const renderState_t &state,
 bool layerNode_t::isViewDependant() const
 {
 	bool viewDep = false;
-	if(input) viewDep = viewDep || input->isViewDependant();
-	if(upperLayer) viewDep = viewDep || upperLayer->isViewDependant();
+	if(op.in[0]) viewDep = viewDep || op.in[0]->isViewDependant();
+	if(op.in[1]) viewDep = viewDep || op.in[1]->isViewDependant();
 	return viewDep;
 }
 
@@ -140,8 +71,8 @@ bool layerNode_t::configInputs(const paraMap_t &params, const nodeFinder_t &find
 	const std::string *name=0;
 	if( params.getParam("input", name) )
 	{
-		input = find(*name);
-		if(!input)
+		op.in[0] = find(*name);
+		if(!op.in[0])
 		{
 			Y_INFO << "LayerNode: Couldn't get input " << *name << yendl;
 			return false;
@@ -155,8 +86,8 @@ bool layerNode_t::configInputs(const paraMap_t &params, const nodeFinder_t &find
 	
 	if( params.getParam("upper_layer", name) )
 	{
-		upperLayer = find(*name);
-		if(!upperLayer)
+		op.in[1] = find(*name);
+		if(!op.in[1])
 		{
 			Y_INFO << "LayerNode: Couldn't get upper_layer " << *name << yendl;
 			return false;
@@ -164,13 +95,13 @@ bool layerNode_t::configInputs(const paraMap_t &params, const nodeFinder_t &find
 	}
 	else
 	{
-		if(!params.getParam("upper_color", upper_col))
+		if(!params.getParam("upper_color", op.konst[1].col))
 		{
-			upper_col = color_t(0.f);
+			op.konst[1].col = color_t(0.f);
 		}
-		if(!params.getParam("upper_value", upper_val))
+		if(!params.getParam("upper_value", op.konst[1].f))
 		{
-			upper_val = 0.f;
+			op.konst[1].f = 0.f;
 		}
 	}
 	return true;
@@ -179,8 +110,8 @@ bool layerNode_t::configInputs(const paraMap_t &params, const nodeFinder_t &find
 bool layerNode_t::getDependencies(std::vector<const shaderNode_t*> &dep) const
 {
 	// input actually needs to exist, but well...
-	if(input) dep.push_back(input);
-	if(upperLayer) dep.push_back(upperLayer);
+	if(op.in[0]) dep.push_back(op.in[0]);
+	if(op.in[1]) dep.push_back(op.in[1]);
 	return !dep.empty();
 }
 
@@ -210,14 +141,11 @@ shaderNode_t* layerNode_t::factory(const paraMap_t &params,renderEnvironment_t &
 	if(stencil) flags |= TXF_STENCIL;
 	if(negative) flags |= TXF_NEGATIVE;
 	if(use_alpha) flags |= TXF_ALPHAMIX;
+	if(do_color) flags |= TXF_DOCOLOR;
+	if(do_scalar) flags |= TXF_DOSCALAR;
+	if(color_input) flags |= TXF_COLORINPUT;
 	
-	layerNode_t *node = new layerNode_t(flags, colfac, valfac, def_val, def_col, (mix_modes)mode);
-	node->do_color = do_color;
-	node->do_scalar = do_scalar;
-	node->color_input = color_input;
-	node->use_alpha = use_alpha;
-	
-	return node;
+	return new layerNode_t(flags, colfac, valfac, def_val, def_col, (mix_modes)mode);
 }
 
 __END_YAFRAY
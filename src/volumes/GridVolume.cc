@@ -8,9 +8,11 @@
 #include <core_api/texture.h>
 #include <core_api/environment.h>
 #include <utilities/mcqmc.h>
+#include <utilities/sparseGrid.h>
 
 #include <fstream>
-#include <cstdlib>
+#include <vector>
+#include <string>
 
 __BEGIN_YAFRAY
 
@@ -20,131 +22,147 @@ class pSample_t;
 class GridVolume : public DensityVolume {
 	public:
 	
-		GridVolume(color_t sa, color_t ss, color_t le, float gg, point3d_t pmin, point3d_t pmax)
+		GridVolume(color_t sa, color_t ss, color_t le, float gg, point3d_t pmin, point3d_t pmax, int attgridScale) :
+			DensityVolume(sa, ss, le, gg, pmin, pmax, attgridScale)
 		{
-			bBox = bound_t(pmin, pmax);
-			s_a = sa;
-			s_s = ss;
-			l_e = le;
-			g = gg;
-			haveS_a = (s_a.energy() > 1e-4f);
-			haveS_s = (s_s.energy() > 1e-4f);
-			haveL_e = (l_e.energy() > 1e-4f);
-			
-			std::ifstream inputStream;
- 			inputStream.open("/home/public/3dkram/cloud2_3.df3");
- 			if(!inputStream) Y_ERROR << "GridVolume: Error opening input stream" << yendl;
-
-			inputStream.seekg(0, std::ios_base::beg);
-			std::ifstream::pos_type begin_pos = inputStream.tellg();
-			inputStream.seekg(0, std::ios_base::end);
-			int fileSize = static_cast<int>(inputStream.tellg() - begin_pos);
-			fileSize -= 6;
-			inputStream.seekg(0, std::ios_base::beg);
-
-			int dim[3];
-			for (int i = 0; i < 3; ++i) {
-				short i0 = 0, i1 = 0;
-				inputStream.read( (char*)&i0, 1 );
-				inputStream.read( (char*)&i1, 1 );
-				Y_INFO << "GridVolume: " << i0 << " " << i1 << yendl;
-				dim[i] = (((unsigned short)i0 << 8) | (unsigned short)i1);
-			}
-			
-			int sizePerVoxel = fileSize / (dim[0] * dim[1] * dim[2]);
-
-			Y_INFO << "GridVolume: " <<  dim[0] <<  " " << dim[1] <<  " " << dim[2] << " " << fileSize << " " << sizePerVoxel << yendl;
-
-			sizeX = dim[0];
-			sizeY = dim[1];
-			sizeZ = dim[2];
-
-			/*
-			sizeX = 60;
-			sizeY = 60;
-			sizeZ = 60;
-			*/
-			
-			grid = (float***)malloc(sizeX * sizeof(float));
-			for (int x = 0; x < sizeX; ++x) {
-				grid[x] = (float**)malloc(sizeY * sizeof(float));
-				for (int y = 0; y < sizeY; ++y) {
-					grid[x][y] = (float*)malloc(sizeZ * sizeof(float));
-				}
-			}
-
-			for (int z = 0; z < sizeZ; ++z) {
-				for (int y = 0; y < sizeY; ++y) {
-					for (int x = 0; x < sizeX; ++x) {
-						int voxel = 0;
-						inputStream.read( (char*)&voxel, 1 );
-						grid[x][y][z] = voxel / 255.f;
-						/*
-						float r = sizeX / 2.f;
-						float r2 = r*r;
-						float dist = sqrt((x-r)*(x-r) + (y-r)*(y-r) + (z-r)*(z-r));
-						grid[x][y][z] = (dist < r) ? 1.f-dist/r : 0.0f;
-						*/
-					}
-				}
-			}
-			
+			haveEmptySpaceInfo = true;
 			Y_INFO << "GridVolume: Vol.[" << s_a << ", " << s_s << ", " << l_e << "]" << yendl;
 		}
 		
-		~GridVolume() {
-			Y_INFO << "GridVolume: Freeing grid data" << yendl;
-			
-			for (int x = 0; x < sizeX; ++x) {
-				for (int y = 0; y < sizeY; ++y) {
-					free(grid[x][y]);	
-				}
-				free(grid[x]);
-			}
-			free(grid);
-		}
-		
 		virtual float Density(point3d_t p);
+		virtual float skipEmpty(const ray_t &ray, float t, float tMax);
+
+		/*! reads a povray density file (df3) into the sparse grid, one slab of tiles at a time.
+			df3: 3 big endian 16 bit dimensions followed by 8, 16 or 32 bit big endian voxels, x running fastest */
+		bool loadDF3(const std::string &fileName, sparseVoxelGrid_t::quantization_t quant);
 				
 		static VolumeRegion* factory(paraMap_t &params, renderEnvironment_t &render);
 	
 	protected:
-		float*** grid;
+		sparseVoxelGrid_t grid;
 		int sizeX, sizeY, sizeZ;
 };
 
-inline float min(float a, float b) { return (a > b) ? b : a; }
-inline float max(float a, float b) { return (a < b) ? b : a; }
+bool GridVolume::loadDF3(const std::string &fileName, sparseVoxelGrid_t::quantization_t quant)
+{
+	std::ifstream inputStream(fileName.c_str(), std::ios::in | std::ios::binary);
+	if(!inputStream)
+	{
+		Y_ERROR << "GridVolume: Error opening density file \"" << fileName << "\"" << yendl;
+		return false;
+	}
+
+	inputStream.seekg(0, std::ios_base::end);
+	std::streamoff fileSize = inputStream.tellg();
+	inputStream.seekg(0, std::ios_base::beg);
+
+	unsigned char header[6];
+	if(!inputStream.read((char*)header, 6))
+	{
+		Y_ERROR << "GridVolume: Density file \"" << fileName << "\" is too short" << yendl;
+		return false;
+	}
+
+	sizeX = (header[0] << 8) | header[1];
+	sizeY = (header[2] << 8) | header[3];
+	sizeZ = (header[4] << 8) | header[5];
+
+	std::streamoff nVoxels = (std::streamoff)sizeX * sizeY * sizeZ;
+	int sizePerVoxel = (nVoxels > 0) ? (int)((fileSize - 6) / nVoxels) : 0;
+
+	if(sizePerVoxel != 1 && sizePerVoxel != 2 && sizePerVoxel != 4)
+	{
+		Y_ERROR << "GridVolume: Invalid density file \"" << fileName << "\" (" << sizeX << "x" << sizeY << "x" << sizeZ
+				<< ", " << fileSize << " bytes)" << yendl;
+		return false;
+	}
+
+	Y_INFO << "GridVolume: " << sizeX << " " << sizeY << " " << sizeZ << " " << fileSize << " " << sizePerVoxel << yendl;
+
+	float norm = 1.f / (float)((sizePerVoxel == 4) ? 4294967295.0 : (double)((1 << (8 * sizePerVoxel)) - 1));
+
+	grid.init(sizeX, sizeY, sizeZ, quant);
+
+	int sliceVoxels = sizeX * sizeY;
+	std::vector<unsigned char> raw(sliceVoxels * sizePerVoxel);
+	std::vector<float> slab(sliceVoxels * VOXEL_TILE);
+
+	for (int tz = 0; tz < grid.tilesZ(); ++tz)
+	{
+		int slices = std::min(VOXEL_TILE, sizeZ - tz * VOXEL_TILE);
+		for (int z = 0; z < slices; ++z)
+		{
+			if(!inputStream.read((char*)&raw[0], raw.size()))
+			{
+				Y_ERROR << "GridVolume: Unexpected end of density file \"" << fileName << "\"" << yendl;
+				return false;
+			}
+			float *dst = &slab[z * sliceVoxels];
+			const unsigned char *src = &raw[0];
+			for (int i = 0; i < sliceVoxels; ++i, src += sizePerVoxel)
+			{
+				unsigned int voxel = 0;
+				for (int b = 0; b < sizePerVoxel; ++b) voxel = (voxel << 8) | src[b];
+				dst[i] = voxel * norm;
+			}
+		}
+		grid.addSlab(tz, &slab[0]);
+	}
+	grid.finish();
+
+	Y_INFO << "GridVolume: Stored " << grid.nStoredTiles() << " of " << grid.tilesX() * grid.tilesY() * grid.tilesZ()
+		   << " tiles, " << grid.memUsage() / 1024 << " KB" << yendl;
 
+	return true;
+}
 
 float GridVolume::Density(const point3d_t p) {
 	float x = (p.x - bBox.a.x) / bBox.longX() * sizeX - .5f;
 	float y = (p.y - bBox.a.y) / bBox.longY() * sizeY - .5f;
 	float z = (p.z - bBox.a.z) / bBox.longZ() * sizeZ - .5f;
-			
-	int x0 = max(0, floor(x));
-	int y0 = max(0, floor(y));
-	int z0 = max(0, floor(z));
-
-	int x1 = min(sizeX - 1, ceil(x));
-	int y1 = min(sizeY - 1, ceil(y));
-	int z1 = min(sizeZ - 1, ceil(z));
-
-	float xd = x - x0;
-	float yd = y - y0;
-	float zd = z - z0;
-	
-	float i1 = grid[x0][y0][z0] * (1-zd) + grid[x0][y0][z1] * zd;
-	float i2 = grid[x0][y1][z0] * (1-zd) + grid[x0][y1][z1] * zd;
-	float j1 = grid[x1][y0][z0] * (1-zd) + grid[x1][y0][z1] * zd;
-	float j2 = grid[x1][y1][z0] * (1-zd) + grid[x1][y1][z1] * zd;
-	
-	float w1 = i1 * (1 - yd) + i2 * yd;
-	float w2 = j1 * (1 - yd) + j2 * yd;
-	
-	float dens = w1 * (1 - xd) + w2 * xd;
 
-	return dens;
+	return grid.lookup(x, y, z);
+}
+
+float GridVolume::skipEmpty(const ray_t &ray, float t, float tMax)
+{
+	float t0 = -1, t1 = -1;
+	if (!intersect(ray, t0, t1) || t1 < t) return tMax;
+	if (t0 > t) return std::min(t0, tMax);
+
+	// inside the bounding box, step through tiles whose lookups can only return zero
+	float tEnd = std::min(t1, tMax);
+	float eps = 1e-4f * std::min(bBox.longX() / sizeX, std::min(bBox.longY() / sizeY, bBox.longZ() / sizeZ));
+	int tile[3];
+	point3d_t tMin, tMaxP;
+
+	while (t < tEnd)
+	{
+		point3d_t p = ray.from + ray.dir * t;
+		float v[3] = { (p.x - bBox.a.x) / bBox.longX() * sizeX - .5f,
+					   (p.y - bBox.a.y) / bBox.longY() * sizeY - .5f,
+					   (p.z - bBox.a.z) / bBox.longZ() * sizeZ - .5f };
+		int nTiles[3] = { grid.tilesX(), grid.tilesY(), grid.tilesZ() };
+		int size[3] = { sizeX, sizeY, sizeZ };
+
+		for (int i = 0; i < 3; ++i)
+		{
+			tile[i] = std::max(0, std::min((int)std::max(0.f, v[i]) >> VOXEL_TILE_LOG, nTiles[i] - 1));
+			// world space range of voxel coordinates [tile * VOXEL_TILE, (tile + 1) * VOXEL_TILE)
+			float lo = (tile[i] == 0) ? 0.f : (float)(tile[i] * VOXEL_TILE) + .5f;
+			float hi = (tile[i] == nTiles[i] - 1) ? (float)size[i] : (float)((tile[i] + 1) * VOXEL_TILE) + .5f;
+			tMin[i] = bBox.a[i] + (bBox.g[i] - bBox.a[i]) * lo / (float)size[i];
+			tMaxP[i] = bBox.a[i] + (bBox.g[i] - bBox.a[i]) * hi / (float)size[i];
+		}
+
+		if (grid.lookupMax(tile[0], tile[1], tile[2]) > 0.f) return t;
+
+		float enter, leave;
+		if (!bound_t(tMin, tMaxP).cross(ray, enter, leave, tEnd) || leave <= t) return t;
+		t = leave + eps;
+	}
+
+	return tMax;
 }
 
 VolumeRegion* GridVolume::factory(paraMap_t &params,renderEnvironment_t &render) {
@@ -154,6 +172,9 @@ VolumeRegion* GridVolume::factory(paraMap_t &params,renderEnvironment_t &render)
 	float g = .0f;
 	float min[] = {0, 0, 0};
 	float max[] = {0, 0, 0};
+	int attSc = 1;
+	const std::string *densityFile = 0;
+	const std::string *quantization = 0;
 	params.getParam("sigma_s", ss);
 	params.getParam("sigma_a", sa);
 	params.getParam("l_e", le);
@@ -164,9 +185,28 @@ VolumeRegion* GridVolume::factory(paraMap_t &params,renderEnvironment_t &render)
 	params.getParam("maxX", max[0]);
 	params.getParam("maxY", max[1]);
 	params.getParam("maxZ", max[2]);
+	params.getParam("attgridScale", attSc);
+	params.getParam("density_file", densityFile);
+	params.getParam("quantization", quantization); // "8bit" (default) or "half"
+
+	if (!densityFile)
+	{
+		Y_ERROR << "GridVolume: No density_file given, the volume region won't be created." << yendl;
+		return 0;
+	}
+
+	sparseVoxelGrid_t::quantization_t quant = sparseVoxelGrid_t::QUANT_8BIT;
+	if (quantization && *quantization == "half") quant = sparseVoxelGrid_t::QUANT_HALF;
 	
 	GridVolume *vol = new GridVolume(color_t(sa), color_t(ss), color_t(le), g,
-						point3d_t(min[0], min[1], min[2]), point3d_t(max[0], max[1], max[2]));
+						point3d_t(min[0], min[1], min[2]), point3d_t(max[0], max[1], max[2]), attSc);
+
+	if (!vol->loadDF3(*densityFile, quant))
+	{
+		delete vol;
+		return 0;
+	}
+
 	return vol;
 }
 
@@ -0,0 +1,555 @@
+#include "distributed.h"
+
+#include <core_api/scene.h>
+#include <core_api/environment.h>
+#include <core_api/imagefilm.h>
+#include <core_api/imagesplitter.h>
+#include <core_api/output.h>
+#include <yafraycore/monitor.h>
+#include <yafraycore/timer.h>
+
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <deque>
+
+#ifndef _WIN32
+	#include <sys/types.h>
+	#include <sys/socket.h>
+	#include <sys/un.h>
+	#include <sys/wait.h>
+	#include <netinet/in.h>
+	#include <netdb.h>
+	#include <poll.h>
+	#include <signal.h>
+	#include <unistd.h>
+	#include <errno.h>
+#endif
+
+__BEGIN_YAFRAY
+
+#ifndef _WIN32
+
+enum msgType_t { MSG_HELLO = 1, MSG_REGION, MSG_RESULT, MSG_ERROR, MSG_QUIT };
+
+static const int protocolMagic = 0x59414631; // "YAF1"
+static const int headerSize = 2 * sizeof(int); // type, payload length in bytes
+static const int maxControlSize = 1024; // longest message a worker accepts, regions and errors are far shorter
+
+//! opens the coordinator's listening socket or a worker's connection, -1 on failure
+static int openSocket(const std::string &address, bool listening)
+{
+	int fd = -1;
+
+	if(address.compare(0, 5, "unix:") == 0)
+	{
+		sockaddr_un addr;
+		std::string path = address.substr(5);
+		if(path.size() >= sizeof(addr.sun_path))
+		{
+			Y_ERROR << "Distributed: Socket path too long: " << path << yendl;
+			return -1;
+		}
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strcpy(addr.sun_path, path.c_str());
+
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(fd < 0) return -1;
+		if(listening)
+		{
+			unlink(path.c_str());
+			if(bind(fd, (sockaddr *)&addr, sizeof(addr)) == 0 && listen(fd, 16) == 0) return fd;
+		}
+		else if(connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0) return fd;
+	}
+	else
+	{
+		std::string host, port = address;
+		size_t colon = address.rfind(':');
+		if(colon != std::string::npos)
+		{
+			host = address.substr(0, colon);
+			port = address.substr(colon + 1);
+		}
+		if(host.empty() && !listening) host = "127.0.0.1";
+
+		addrinfo hints, *res = 0;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		if(listening) hints.ai_flags = AI_PASSIVE;
+		if(getaddrinfo(host.empty() ? 0 : host.c_str(), port.c_str(), &hints, &res) != 0 || !res)
+		{
+			Y_ERROR << "Distributed: Can't resolve address " << address << yendl;
+			return -1;
+		}
+
+		fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+		if(fd >= 0)
+		{
+			if(listening)
+			{
+				int on = 1;
+				setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+				if(bind(fd, res->ai_addr, res->ai_addrlen) == 0 && listen(fd, 16) == 0)
+				{
+					freeaddrinfo(res);
+					return fd;
+				}
+			}
+			else if(connect(fd, res->ai_addr, res->ai_addrlen) == 0)
+			{
+				freeaddrinfo(res);
+				return fd;
+			}
+		}
+		freeaddrinfo(res);
+	}
+
+	Y_ERROR << "Distributed: Can't " << (listening ? "listen on " : "connect to ") << address << ": " << strerror(errno) << yendl;
+	if(fd >= 0) close(fd);
+	return -1;
+}
+
+static bool sendAll(int fd, const void *data, size_t size)
+{
+	const char *p = (const char *)data;
+	while(size > 0)
+	{
+		ssize_t n = send(fd, p, size, 0);
+		if(n < 0 && errno == EINTR) continue;
+		if(n <= 0) return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+static bool recvAll(int fd, void *data, size_t size)
+{
+	char *p = (char *)data;
+	while(size > 0)
+	{
+		ssize_t n = recv(fd, p, size, 0);
+		if(n < 0 && errno == EINTR) continue;
+		if(n <= 0) return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+static bool sendMessage(int fd, int type, const void *payload, int length)
+{
+	int header[2] = { type, length };
+	return sendAll(fd, header, headerSize) && (length == 0 || sendAll(fd, payload, length));
+}
+
+//! a connected worker as seen by the coordinator
+struct workerConn_t
+{
+	workerConn_t(int f): fd(f), region(-1), ready(false), started(0.0), deadline(0.0) {}
+	int fd;
+	int region; //!< region being rendered, -1 when idle
+	bool ready; //!< sent a valid hello
+	double started; //!< when the region was handed out, timer_t::now()
+	double deadline; //!< the region goes to another worker if it is not back by then
+	std::vector<char> input; //!< received bytes not yet parsed into messages
+};
+
+//! starts a local worker process, returns its pid or -1
+static pid_t spawnWorker(const std::vector<std::string> &cmd)
+{
+	pid_t pid = fork();
+	if(pid != 0) return pid;
+
+	std::vector<char *> argv;
+	for(size_t i = 0; i < cmd.size(); ++i) argv.push_back(const_cast<char *>(cmd[i].c_str()));
+	argv.push_back(0);
+	execv(argv[0], &argv[0]);
+	_exit(127);
+}
+
+//! waits a few seconds for the local workers to exit, then kills those that are still busy or stalled
+static void reapWorkers(std::vector<pid_t> &children)
+{
+	for(int tries = 0; tries < 50; ++tries)
+	{
+		bool alive = false;
+		for(size_t i = 0; i < children.size(); ++i)
+		{
+			if(children[i] > 0 && waitpid(children[i], 0, WNOHANG) == children[i]) children[i] = -1;
+			if(children[i] > 0) alive = true;
+		}
+		if(!alive) return;
+		usleep(100000);
+	}
+	for(size_t i = 0; i < children.size(); ++i)
+	{
+		if(children[i] <= 0) continue;
+		Y_WARNING << "Distributed: Killing local worker " << children[i] << " that did not quit" << yendl;
+		kill(children[i], SIGKILL);
+		waitpid(children[i], 0, 0);
+	}
+}
+
+bool runCoordinator(const std::string &address, scene_t &scene, const distWindow_t &window, int regionSize,
+					int localWorkers, const std::vector<std::string> &workerCmd, double regionTimeout)
+{
+	signal(SIGPIPE, SIG_IGN);
+
+	// a freshly set up film is empty, the worker results are added as they come in
+	imageFilm_t *film = scene.getImageFilm();
+
+	std::vector<renderArea_t> regions;
+	imageSpliter_t splitter(window.width, window.height, window.x0, window.y0, regionSize, imageSpliter_t::LINEAR);
+	for(int i = 0; i < splitter.size(); ++i)
+	{
+		renderArea_t a;
+		splitter.getArea(i, a);
+		regions.push_back(a);
+	}
+
+	int listenFd = openSocket(address, true);
+	if(listenFd < 0) return false;
+
+	std::vector<pid_t> children;
+	for(int i = 0; i < localWorkers; ++i)
+	{
+		pid_t pid = spawnWorker(workerCmd);
+		if(pid > 0) children.push_back(pid);
+		else Y_ERROR << "Distributed: Can't start local worker: " << strerror(errno) << yendl;
+	}
+
+	Y_INFO << "Distributed: Coordinating " << regions.size() << " regions on " << address << yendl;
+
+	std::deque<int> pending;
+	for(int i = 0; i < (int)regions.size(); ++i) pending.push_back(i);
+	std::vector<bool> finished(regions.size(), false);
+	std::vector<int> timeouts(regions.size(), 0); //!< how often each region was not returned in time
+	double slowest = 0.0; //!< longest time a worker took for a region so far
+	int nFinished = 0;
+	std::vector<workerConn_t> workers;
+	bool failed = false;
+	int nErrors = 0; //!< workers dropped because they reported an error
+	// a result holds at most the whole window
+	size_t maxResultSize = 5 * sizeof(int) + 5 * sizeof(float) * (size_t)window.width * window.height;
+
+	ConsoleProgressBar_t pb(80);
+	pb.init(regions.size());
+
+	while(nFinished < (int)regions.size() && !failed)
+	{
+		// hand out regions to idle workers
+		for(size_t w = 0; w < workers.size(); ++w)
+		{
+			workerConn_t &wk = workers[w];
+			if(!wk.ready || wk.region >= 0 || pending.empty() || wk.fd < 0) continue;
+			int r = pending.front();
+			pending.pop_front();
+			const renderArea_t &a = regions[r];
+			int msg[5] = { r, a.X, a.Y, a.W, a.H };
+			wk.region = r;
+			// without a fixed timeout allow generously more than the slowest region so far; the
+			// limit doubles each time the region timed out, so a region that is simply slow
+			// eventually gets the time it needs
+			double limit = (regionTimeout > 0.0) ? regionTimeout : std::max(60.0, 4.0 * slowest);
+			wk.started = timer_t::now();
+			wk.deadline = wk.started + limit * (1 << std::min(timeouts[r], 10));
+			if(!sendMessage(wk.fd, MSG_REGION, msg, sizeof(msg)))
+			{
+				close(wk.fd);
+				wk.fd = -1;
+			}
+		}
+
+		// a worker that hangs or stalls is dropped, which hands its region out again below
+		double now = timer_t::now();
+		for(size_t w = 0; w < workers.size(); ++w)
+		{
+			workerConn_t &wk = workers[w];
+			if(wk.fd < 0 || wk.region < 0 || now < wk.deadline) continue;
+			Y_WARNING << "Distributed: Worker did not return region " << wk.region << " in " << (int)(now - wk.started) << "s, dropping it" << yendl;
+			++timeouts[wk.region];
+			close(wk.fd);
+			wk.fd = -1;
+		}
+
+		// workers that disconnected give back their region
+		for(size_t w = 0; w < workers.size(); )
+		{
+			if(workers[w].fd >= 0) { ++w; continue; }
+			int r = workers[w].region;
+			if(r >= 0 && !finished[r])
+			{
+				Y_WARNING << "Distributed: Worker lost, reassigning region " << r << yendl;
+				pending.push_front(r);
+			}
+			workers.erase(workers.begin() + w);
+		}
+
+		if(workers.empty() && (localWorkers > 0 || nErrors > 0))
+		{
+			// nobody connected: give up once every local worker has exited; remote workers may
+			// still connect later unless the ones before failed
+			bool alive = false;
+			for(size_t i = 0; i < children.size(); ++i)
+			{
+				if(children[i] > 0 && waitpid(children[i], 0, WNOHANG) == children[i]) children[i] = -1;
+				if(children[i] > 0) alive = true;
+			}
+			if(!alive)
+			{
+				Y_ERROR << "Distributed: No workers left, " << regions.size() - nFinished << " regions not rendered" << yendl;
+				failed = true;
+				break;
+			}
+		}
+
+		std::vector<pollfd> fds(workers.size() + 1);
+		fds[0].fd = listenFd;
+		fds[0].events = POLLIN;
+		for(size_t w = 0; w < workers.size(); ++w)
+		{
+			fds[w+1].fd = workers[w].fd;
+			fds[w+1].events = POLLIN;
+		}
+
+		if(poll(&fds[0], fds.size(), 1000) < 0)
+		{
+			if(errno == EINTR) continue;
+			Y_ERROR << "Distributed: poll failed: " << strerror(errno) << yendl;
+			failed = true;
+			break;
+		}
+
+		for(size_t w = 0; w < workers.size(); ++w)
+		{
+			if(!fds[w+1].revents) continue;
+			workerConn_t &wk = workers[w];
+
+			char buf[65536];
+			ssize_t n = recv(wk.fd, buf, sizeof(buf), 0);
+			if(n <= 0)
+			{
+				if(n < 0 && errno == EINTR) continue;
+				close(wk.fd);
+				wk.fd = -1;
+				continue;
+			}
+			wk.input.insert(wk.input.end(), buf, buf + n);
+
+			// handle all complete messages
+			while(wk.fd >= 0 && wk.input.size() >= (size_t)headerSize)
+			{
+				int header[2];
+				memcpy(header, &wk.input[0], headerSize);
+				if(header[1] < 0 || (size_t)header[1] > maxResultSize)
+				{
+					Y_WARNING << "Distributed: Dropping worker that sent a message of " << header[1] << " bytes" << yendl;
+					close(wk.fd);
+					wk.fd = -1;
+					break;
+				}
+				if(wk.input.size() < (size_t)(headerSize + header[1])) break;
+				const char *payload = &wk.input[0] + headerSize;
+
+				if(header[0] == MSG_HELLO && header[1] == 5 * (int)sizeof(int))
+				{
+					int hello[5];
+					memcpy(hello, payload, sizeof(hello));
+					if(hello[0] == protocolMagic && hello[1] == window.x0 && hello[2] == window.y0 &&
+						hello[3] == window.width && hello[4] == window.height) wk.ready = true;
+					else
+					{
+						Y_WARNING << "Distributed: Rejecting worker with a different protocol or image window" << yendl;
+						sendMessage(wk.fd, MSG_QUIT, 0, 0);
+						close(wk.fd);
+						wk.fd = -1;
+					}
+				}
+				else if(header[0] == MSG_RESULT && header[1] >= 5 * (int)sizeof(int))
+				{
+					int res[5];
+					memcpy(res, payload, sizeof(res));
+					int r = res[0], x0 = res[1], y0 = res[2], rw = res[3], rh = res[4];
+					bool valid = r >= 0 && r < (int)regions.size() && rw >= 0 && rh >= 0 &&
+						x0 >= window.x0 && y0 >= window.y0 && x0 + rw <= window.x0 + window.width && y0 + rh <= window.y0 + window.height &&
+						header[1] == (int)(sizeof(res) + 5 * sizeof(float) * rw * rh);
+					if(valid && !finished[r])
+					{
+						const char *p = payload + sizeof(res);
+						for(int y = y0; y < y0 + rh; ++y)
+						{
+							for(int x = x0; x < x0 + rw; ++x)
+							{
+								float v[5];
+								memcpy(v, p, sizeof(v));
+								p += sizeof(v);
+								film->addPixelSum(x, y, colorA_t(v[0], v[1], v[2], v[3]), v[4]);
+							}
+						}
+						finished[r] = true;
+						++nFinished;
+						if(r == wk.region) slowest = std::max(slowest, timer_t::now() - wk.started);
+						pb.update(1);
+					}
+					if(r == wk.region) wk.region = -1;
+				}
+				else if(header[0] == MSG_ERROR)
+				{
+					// dropping the worker hands its region to another one
+					Y_WARNING << "Distributed: Worker failed: " << std::string(payload, header[1]) << yendl;
+					++nErrors;
+					close(wk.fd);
+					wk.fd = -1;
+					break;
+				}
+
+				wk.input.erase(wk.input.begin(), wk.input.begin() + headerSize + header[1]);
+			}
+		}
+
+		if(fds[0].revents & POLLIN)
+		{
+			int fd = accept(listenFd, 0, 0);
+			if(fd >= 0) workers.push_back(workerConn_t(fd));
+		}
+	}
+
+	pb.done();
+
+	for(size_t w = 0; w < workers.size(); ++w)
+	{
+		if(workers[w].fd < 0) continue;
+		sendMessage(workers[w].fd, MSG_QUIT, 0, 0);
+		close(workers[w].fd);
+	}
+	close(listenFd);
+	if(address.compare(0, 5, "unix:") == 0) unlink(address.substr(5).c_str());
+
+	reapWorkers(children);
+
+	return !failed;
+}
+
+//! the worker's film output goes nowhere, results travel as pixel sums
+class discardOutput_t: public colorOutput_t
+{
+	public:
+		virtual bool putPixel(int x, int y, const float *c, bool alpha = true, bool depth = false, float z = 0.f) { return true; }
+		virtual bool putArea(int x0, int y0, int w, int h, const float *c, int stride, bool alpha = true, const float *z = 0, int zStride = 0) { return true; }
+		virtual void flush() {}
+		virtual void flushArea(int x0, int y0, int x1, int y1) {}
+};
+
+//! many workers share a terminal, only the coordinator shows progress
+class silentProgressBar_t: public progressBar_t
+{
+	public:
+		virtual void init(int totalSteps) {}
+		virtual void update(int steps = 1) {}
+		virtual void done() {}
+		virtual void setTag(const char* text) {}
+};
+
+bool runWorker(const std::string &address, renderEnvironment_t &env, scene_t &scene, paraMap_t &render, const distWindow_t &window)
+{
+	signal(SIGPIPE, SIG_IGN);
+
+	int fd = openSocket(address, false);
+	if(fd < 0) return false;
+
+	render["drawParams"] = false;
+	render["z_channel"] = false;
+	discardOutput_t out;
+	if(!env.setupScene(scene, render, out, new silentProgressBar_t))
+	{
+		std::string msg = "scene setup failed";
+		sendMessage(fd, MSG_ERROR, msg.data(), msg.size());
+		close(fd);
+		return false;
+	}
+	imageFilm_t *film = scene.getImageFilm();
+
+	int hello[5] = { protocolMagic, window.x0, window.y0, window.width, window.height };
+	bool ok = sendMessage(fd, MSG_HELLO, hello, sizeof(hello));
+	std::vector<char> result;
+
+	while(ok)
+	{
+		int header[2];
+		if(!recvAll(fd, header, headerSize) || header[0] == MSG_QUIT) break;
+		if(header[1] < 0 || header[1] > maxControlSize)
+		{
+			Y_ERROR << "Distributed: Invalid message from the coordinator (" << header[1] << " bytes), quitting" << yendl;
+			ok = false;
+			break;
+		}
+		std::vector<char> payload(header[1]);
+		if(header[1] > 0 && !recvAll(fd, &payload[0], header[1])) break;
+		if(header[0] != MSG_REGION || header[1] != 5 * (int)sizeof(int)) continue;
+
+		int region[5];
+		memcpy(region, &payload[0], sizeof(region));
+		int rx = region[1], ry = region[2], rw = region[3], rh = region[4];
+		Y_INFO << "Distributed: Rendering region " << region[0] << " (" << rx << ", " << ry << ", " << rw << "x" << rh << ")" << yendl;
+
+		// only the region and its border get cleared, and the film is not flushed: the sums
+		// are read below, so the cost per region does not depend on the frame size
+		film->setSampleWindow(rx, ry, rx + rw, ry + rh);
+		if(!scene.render(false))
+		{
+			std::string msg = "render failed";
+			sendMessage(fd, MSG_ERROR, msg.data(), msg.size());
+			ok = false;
+			break;
+		}
+
+		// the region plus the pixels its samples reach
+		int r = film->filterRadius();
+		int x0 = std::max(window.x0, rx - r), x1 = std::min(window.x0 + window.width, rx + rw + r);
+		int y0 = std::max(window.y0, ry - r), y1 = std::min(window.y0 + window.height, ry + rh + r);
+		int res[5] = { region[0], x0, y0, x1 - x0, y1 - y0 };
+
+		result.resize(sizeof(res) + 5 * sizeof(float) * (x1 - x0) * (y1 - y0));
+		memcpy(&result[0], res, sizeof(res));
+		char *p = &result[0] + sizeof(res);
+		for(int y = y0; y < y1; ++y)
+		{
+			for(int x = x0; x < x1; ++x)
+			{
+				colorA_t col;
+				float v[5];
+				film->getPixelSum(x, y, col, v[4]);
+				v[0] = col.R; v[1] = col.G; v[2] = col.B; v[3] = col.A;
+				memcpy(p, v, sizeof(v));
+				p += sizeof(v);
+			}
+		}
+		ok = sendMessage(fd, MSG_RESULT, &result[0], result.size());
+	}
+
+	close(fd);
+	return ok;
+}
+
+#else // _WIN32
+
+bool runCoordinator(const std::string &address, scene_t &scene, const distWindow_t &window, int regionSize,
+					int localWorkers, const std::vector<std::string> &workerCmd, double regionTimeout)
+{
+	Y_ERROR << "Distributed: Distributed rendering is not available on this platform" << yendl;
+	return false;
+}
+
+bool runWorker(const std::string &address, renderEnvironment_t &env, scene_t &scene, paraMap_t &render, const distWindow_t &window)
+{
+	Y_ERROR << "Distributed: Distributed rendering is not available on this platform" << yendl;
+	return false;
+}
+
+#endif
+
+__END_YAFRAY
@@ -0,0 +1,56 @@
+#ifndef Y_DISTRIBUTED_H
+#define Y_DISTRIBUTED_H
+
+#include <yafray_config.h>
+
+#include <string>
+#include <vector>
+
+__BEGIN_YAFRAY
+
+class scene_t;
+class renderEnvironment_t;
+class paraMap_t;
+
+/*! Distributed rendering of one frame by image regions.
+
+	The coordinator splits the frame into regions and hands them to worker processes that
+	connect over a socket; addresses are "unix:<path>", "<host>:<port>" or "<port>" (the
+	coordinator then listens on all interfaces, workers connect to localhost). Every worker
+	loads the same scene file itself and renders each region it is given into a film that
+	reaches filterRadius() pixels beyond the region, then returns the weighted color and
+	filter weight sums of all those pixels. The coordinator adds the sums into its own film,
+	so pixels along region borders get the contributions of both sides as in a single process
+	render. A worker that disconnects, reports an error or misses the region's deadline is
+	dropped and its region handed out again; the render fails only when no workers are left.
+	Messages are sent in host byte order, coordinator and workers must run on the same
+	architecture.
+
+	Adaptive antialiasing is not supported: a worker's film only holds its own region and part
+	of the border around it, so the resample flags of later passes would differ from those of
+	the full frame along region edges. yafaray-xml sets the AA threshold to 0 for distributed
+	renders, which makes every pass resample all pixels.
+
+	Not transferred: depth channel, cost map and the light image of the bidirectional
+	integrator. */
+
+//! the window rendered, in image coordinates
+struct distWindow_t
+{
+	int x0, y0, width, height;
+};
+
+/*! Renders the frame with the workers and leaves the merged result in the scene's film,
+	which must be set up already; the caller flushes it.
+	\param workerCmd command line to start a local worker, used when localWorkers > 0
+	\param regionTimeout seconds a worker gets for a region before it is handed to another one;
+		0 picks max(60, 4 times the slowest region so far). Doubles with every timeout of the region. */
+bool runCoordinator(const std::string &address, scene_t &scene, const distWindow_t &window, int regionSize,
+					int localWorkers, const std::vector<std::string> &workerCmd, double regionTimeout = 0.0);
+
+//! Sets up the scene with a discarding output and renders the regions the coordinator sends until it says quit
+bool runWorker(const std::string &address, renderEnvironment_t &env, scene_t &scene, paraMap_t &render, const distWindow_t &window);
+
+__END_YAFRAY
+
+#endif // Y_DISTRIBUTED_H
@@ -1,5 +1,6 @@
 #include <yafray_config.h>
 #include <cstdlib>
+#include <cstdio>
 #include <cctype>
 #include <algorithm>
 
@@ -15,6 +16,10 @@
 #include <yaf_revision.h>
 #include <utilities/console_utils.h>
 #include <yafraycore/imageOutput.h>
+#include <yafraycore/renderstats.h>
+#include <yafraycore/trace.h>
+#include <yafraycore/timer.h>
+#include "distributed.h"
 
 #include <gui/yafqtapi.h>
 
@@ -80,6 +85,17 @@ int main(int argc, char *argv[])
 	parse.setOption("cs","custom-string", false, "Sets the custom string to be used on the settings badge.");
 	parse.setOption("z","z-buffer", true, "Enables the rendering of the depth map (Z-Buffer) (this flag overrides XML setting).");
 	parse.setOption("nz","no-z-buffer", true, "Disables the rendering of the depth map (Z-Buffer) (this flag overrides XML setting).");
+	parse.setOption("so","stream-output", true, "Writes the image to disk while rendering instead of keeping a full frame copy until the end.\n                                       TGA files are updated as tiles finish, PNG and HDR are written row by row on completion;\n                                       other formats are saved as usual.");
+	parse.setOption("cm","cost-map", false, "Renders a per pixel cost map next to the output image, named <output>.cost.<format>.\n                                       Measures: time, rays, nodes (kd-tree node visits). EXR and HDR get raw values,\n                                       other formats a false color image.");
+	parse.setOption("co","coordinator", false, "Distributes the render to worker processes connecting to <value>, which is\n                                       unix:<path>, <host>:<port> or <port>. Saves the merged image as usual.");
+	parse.setOption("wk","worker", false, "Renders image regions for the coordinator at <value> (see --coordinator);\n                                       the worker needs the same XML file and writes no image.");
+	parse.setOption("lw","local-workers", false, "Number of worker processes the coordinator starts on this machine.");
+	parse.setOption("rs","region-size", false, "Size of the image regions the coordinator hands out. Default: 64.");
+	parse.setOption("rt","region-timeout", false, "Seconds a worker gets for a region before the coordinator drops it and hands the region\n                                       to another worker; doubles each time the region times out.\n                                       Default: 4 times the slowest region so far, at least 60.");
+	parse.setOption("ck","checkpoint", false, "Saves the progress of multi pass renders after a pass once <value> seconds passed since\n                                       the last save (0: after every pass), to <output>.ckpt. Removed when the render finishes.");
+	parse.setOption("rc","resume", true, "Continues the render from the last pass saved in <output>.ckpt (see --checkpoint).");
+	parse.setOption("tr","trace", true, "Writes a timeline of tiles, passes and preprocess phases per thread in Chrome trace\n                                       format (chrome://tracing, Perfetto) next to the output image, named <output>.trace.json.");
+	parse.setOption("st","stats", true, "Writes render statistics (rays, kd-tree work, material evaluations, phase times)\n                                       as JSON next to the output image, named <output>.stats.json.");
 	
 	bool parseOk = parse.parseCommandLine();
 	
@@ -110,7 +126,19 @@ int main(int argc, char *argv[])
 	bool nodrawparams = parse.getFlag("ndp");
 	std::string customString = parse.getOptionString("cs");
 	bool zbuf = parse.getFlag("z");
+	bool streamOutput = parse.getFlag("so");
 	bool nozbuf = parse.getFlag("nz");
+	bool stats = parse.getFlag("st");
+	bool trace = parse.getFlag("tr");
+	std::string coordinator = parse.getOptionString("co");
+	std::string worker = parse.getOptionString("wk");
+	int localWorkers = parse.getOptionInteger("lw");
+	int regionSize = parse.getOptionInteger("rs");
+	if(regionSize <= 0) regionSize = 64;
+	int regionTimeout = parse.getOptionInteger("rt");
+	std::string costMap = parse.getOptionString("cm");
+	int checkpointInterval = parse.getOptionInteger("ck");
+	bool resume = parse.getFlag("rc");
 	
 	if(format.empty()) format = "tga";
 	bool formatValid = false;
@@ -159,8 +187,13 @@ int main(int argc, char *argv[])
 	env->setScene(scene);
 	paraMap_t render;
 	
+	renderStats_t::setEnabled(stats);
+	traceRecorder_t::setEnabled(trace);
+	gTimer.addEvent("parse");
+	gTimer.start("parse");
 	bool success = parse_xml_file(xmlFile.c_str(), scene, env, render);
 	if(!success) exit(1);
+	gTimer.stop("parse");
 	
 	int width=320, height=240;
 	int bx = 0, by = 0;
@@ -179,9 +212,44 @@ int main(int argc, char *argv[])
 	
 	if(nodrawparams) render["drawParams"] = false;
 	
+	if(!costMap.empty()) render["cost_map"] = costMap;
+	
+	std::string checkpointPath;
+	if((checkpointInterval >= 0 || resume) && coordinator.empty() && worker.empty())
+	{
+		checkpointPath = outputPath.substr(0, outputPath.rfind('.')) + ".ckpt";
+		render["checkpoint_file"] = checkpointPath;
+		render["checkpoint_interval"] = (float)std::max(checkpointInterval, 0);
+		render["resume"] = resume;
+	}
+	
 	if(zbuf) render["z_channel"] = true;
 	if(nozbuf) render["z_channel"] = false;
 	
+	if(!coordinator.empty() || !worker.empty())
+	{
+		// the resample flags of a pass would come from each worker's partial film, see distributed.h
+		int passes = 1;
+		double threshold = 0.05;
+		render.getParam("AA_passes", passes);
+		render.getParam("AA_threshold", threshold);
+		if(passes > 1 && threshold > 0.0)
+		{
+			if(!coordinator.empty()) Y_WARNING << "Distributed: Adaptive antialiasing is not supported, every pass resamples all pixels" << yendl;
+			render["AA_threshold"] = 0.f;
+		}
+	}
+
+	distWindow_t window = { bx, by, width, height };
+	if(!worker.empty())
+	{
+		bool ok = runWorker(worker, *env, *scene, render, window);
+		scene->getLoadQueue().wait(); // textures still decoding if the worker never rendered
+		env->clearAll();
+		delete scene->getImageFilm();
+		return ok ? 0 : 1;
+	}
+	
 	bool use_zbuf = false;
 	render.getParam("z_channel", use_zbuf);
 	
@@ -194,25 +262,81 @@ int main(int argc, char *argv[])
 	ihParams["height"] = height;
 	ihParams["alpha_channel"] = alpha;
 	ihParams["z_channel"] = use_zbuf;
+	ihParams["streaming"] = streamOutput;
 	
-	imageHandler_t *ih = env->createImageHandler("outFile", ihParams);
+	// kept out of the environment's table, the file may still be written while the scene is cleared
+	imageHandler_t *ih = env->createImageHandler("outFile", ihParams, false);
+	imageOutput_t *imageOut = NULL;
 
 	if(ih)
 	{
-		out = new imageOutput_t(ih, outputPath, bx, by);
+		out = imageOut = new imageOutput_t(ih, outputPath, bx, by);
 		if(!out) return 1;				
+		imageOut->setAsyncSave(true);
 	}
 	else return 1;
 	
 	if(! env->setupScene(*scene, render, *out) ) return 1;
+	ih->setNumThreads(scene->getNumThreads());
+	// setupScene() starts a fresh statistics record, the parse time goes in afterwards
+	gStats.addPhase("parse", gTimer.getTime("parse"));
 	
-	scene->render();
-	env->clearAll();
+	if(!coordinator.empty())
+	{
+		// local workers run this program on the same scene
+		std::vector<std::string> workerCmd;
+		workerCmd.push_back(argv[0]);
+		workerCmd.push_back("-pp"); workerCmd.push_back(ppath);
+		workerCmd.push_back("-vl"); workerCmd.push_back(verbLevel >= 0 ? parse.getOptionString("vl") : "1");
+		if(threads >= -1) { workerCmd.push_back("-t"); workerCmd.push_back(parse.getOptionString("t")); }
+		workerCmd.push_back("-wk"); workerCmd.push_back(coordinator);
+		workerCmd.push_back(xmlFile);
+
+		if(!runCoordinator(coordinator, *scene, window, regionSize, std::max(localWorkers, 0), workerCmd, std::max(regionTimeout, 0))) return 1;
+		scene->getImageFilm()->flush();
+	}
+	else scene->render();
 
 	imageFilm_t *film = scene->getImageFilm();
 
+	// the image is complete, a later resume would only repeat passes
+	if(!checkpointPath.empty()) remove(checkpointPath.c_str());
+
+	if(film->doCostMap())
+	{
+		paraMap_t costParams;
+		costParams["type"] = format;
+		costParams["width"] = width;
+		costParams["height"] = height;
+		imageHandler_t *costHandler = env->createImageHandler("costFile", costParams);
+		if(costHandler)
+		{
+			std::string costPath = outputPath.substr(0, outputPath.rfind('.')) + ".cost." + format;
+			imageOutput_t costOut(costHandler, costPath, bx, by);
+			film->flushCostMap(costOut, format != "exr" && format != "hdr");
+		}
+	}
+
+	if(trace)
+	{
+		std::string tracePath = outputPath.substr(0, outputPath.rfind('.')) + ".trace.json";
+		if(gTrace.saveJSON(tracePath)) Y_INFO << "Render timeline saved to " << tracePath << yendl;
+		else Y_ERROR << "Couldn't write render timeline to " << tracePath << yendl;
+	}
+
+	if(stats)
+	{
+		std::string statsPath = outputPath.substr(0, outputPath.rfind('.')) + ".stats.json";
+		if(gStats.saveJSON(statsPath)) Y_INFO << "Render statistics saved to " << statsPath << yendl;
+		else Y_ERROR << "Couldn't write render statistics to " << statsPath << yendl;
+	}
+
+	env->clearAll();
+
 	delete film;
+	bool saved = imageOut->waitSave();
 	delete out;
+	delete ih;
 	
-	return 0;
+	return saved ? 0 : 1;
 }
@@ -1,9 +1,15 @@
 #include <yafraycore/ccthreads.h>
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
+#include <vector>
 
 #ifdef __APPLE__
 #include <AvailabilityMacros.h>
+#include <sys/sysctl.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
 #endif
 
 namespace yafthreads {
@@ -257,4 +263,152 @@ thread_t::~thread_t()
 }
 #endif
 
+#ifdef USING_THREADS
+struct parallelJobData_t
+{
+	parallelJobData_t(parallelJob_t &j, int n, int chunk): job(j), count(n), chunkSize(chunk), fetched(0) {}
+	parallelJob_t &job;
+	int count;
+	int chunkSize;
+	volatile int fetched;
+	mutex_t mutex;
+};
+
+class parallelJobWorker_t: public thread_t
+{
+	public:
+		parallelJobWorker_t(parallelJobData_t *dat): data(dat) {}
+		virtual void body()
+		{
+			while(true)
+			{
+				data->mutex.lock();
+				int start = data->fetched;
+				int end = std::min(data->count, start + data->chunkSize);
+				data->fetched = end;
+				data->mutex.unlock();
+
+				if(start >= end) break;
+				data->job.run(start, end);
+			}
+		}
+	protected:
+		parallelJobData_t *data;
+};
+#endif
+
+void runParallel(parallelJob_t &job, int count, int nThreads, int chunkSize)
+{
+	if(count <= 0) return;
+	if(chunkSize < 1) chunkSize = 1;
+	nThreads = std::min(nThreads, (count + chunkSize - 1) / chunkSize);
+
+#ifdef USING_THREADS
+	if(nThreads > 1)
+	{
+		parallelJobData_t data(job, count, chunkSize);
+		std::vector<parallelJobWorker_t *> workers;
+		for(int i=0; i<nThreads; ++i) workers.push_back(new parallelJobWorker_t(&data));
+		for(int i=0; i<nThreads; ++i) workers[i]->run();
+		for(int i=0; i<nThreads; ++i) workers[i]->wait();
+		for(int i=0; i<nThreads; ++i) delete workers[i];
+		return;
+	}
+#endif
+	job.run(0, count);
+}
+
+int numCPUs()
+{
+	int n = 1;
+#ifdef WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	n = (int) info.dwNumberOfProcessors;
+#elif defined(__APPLE__)
+	int mib[2];
+	size_t len = sizeof(int);
+	mib[0] = CTL_HW;
+	mib[1] = HW_NCPU;
+	sysctl(mib, 2, &n, &len, NULL, 0);
+#elif defined(__sgi)
+	n = sysconf(_SC_NPROC_ONLN);
+#else
+	n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return std::max(n, 1);
+}
+
+class taskWorker_t: public thread_t
+{
+	public:
+		taskWorker_t(taskQueue_t *q): queue(q) {}
+		virtual void body()
+		{
+			while(task_t *t = queue->next())
+			{
+				t->run();
+				delete t;
+			}
+		}
+	protected:
+		taskQueue_t *queue;
+};
+
+taskQueue_t::taskQueue_t(int threads): nThreads(threads > 0 ? threads : numCPUs()), stopping(false) {}
+
+taskQueue_t::~taskQueue_t()
+{
+	wait();
+}
+
+void taskQueue_t::add(task_t *t)
+{
+#ifdef USING_THREADS
+	cond.lock();
+	tasks.push_back(t);
+	if(workers.empty())
+	{
+		for(int i=0; i<nThreads; ++i) workers.push_back(new taskWorker_t(this));
+		for(int i=0; i<nThreads; ++i) workers[i]->run();
+	}
+	cond.signal();
+	cond.unlock();
+#else
+	t->run();
+	delete t;
+#endif
+}
+
+task_t *taskQueue_t::next()
+{
+	cond.lock();
+	while(tasks.empty() && !stopping) cond.wait();
+	task_t *t = 0;
+	if(!tasks.empty())
+	{
+		t = tasks.front();
+		tasks.pop_front();
+	}
+	else cond.signal(); // pass the stop on to the next waiting worker
+	cond.unlock();
+	return t;
+}
+
+void taskQueue_t::wait()
+{
+	if(workers.empty()) return;
+	cond.lock();
+	stopping = true;
+	for(size_t i=0; i<workers.size(); ++i) cond.signal();
+	cond.unlock();
+	for(size_t i=0; i<workers.size(); ++i)
+	{
+		workers[i]->wait();
+		delete workers[i];
+	}
+	workers.clear();
+	stopping = false;
+}
+
 } // yafthreads
@@ -0,0 +1,137 @@
+#include <yafraycore/checkpoint.h>
+#include <yafraycore/ccthreads.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+__BEGIN_YAFRAY
+
+static const char checkpointMagic[8] = { 'Y', 'A', 'F', 'C', 'K', 'P', 'T', 0 };
+static const unsigned int checkpointVersion = 1;
+
+// writes one snapshot; the buffer is swapped in by saveAsync() and only touched by body() while running
+class checkpointWriter_t: public yafthreads::thread_t
+{
+	public:
+		checkpointWriter_t(): ok(true) {}
+		virtual void body();
+		std::vector<char> buffer;
+		std::string fileName;
+		bool ok;
+};
+
+void checkpointWriter_t::body()
+{
+	std::string tmpName = fileName + ".tmp";
+	{
+		std::ofstream file(tmpName.c_str(), std::ios::binary | std::ios::trunc);
+		unsigned long long size = buffer.size();
+		file.write(checkpointMagic, sizeof(checkpointMagic));
+		file.write((const char *)&checkpointVersion, sizeof(checkpointVersion));
+		file.write((const char *)&size, sizeof(size));
+		if(!buffer.empty()) file.write(&buffer[0], buffer.size());
+		file.flush();
+		ok = file.good();
+	}
+#ifdef _WIN32
+	if(ok) remove(fileName.c_str()); // rename() does not replace existing files here
+#endif
+	if(ok) ok = (rename(tmpName.c_str(), fileName.c_str()) == 0);
+	if(!ok)
+	{
+		remove(tmpName.c_str());
+		Y_WARNING << "Checkpoint: Could not write \"" << fileName << "\"" << yendl;
+	}
+}
+
+checkpoint_t::checkpoint_t(): readPos(0), valid(true), writer(0) {}
+
+checkpoint_t::~checkpoint_t()
+{
+	wait();
+	delete writer;
+}
+
+void checkpoint_t::clear()
+{
+	data.clear();
+	readPos = 0;
+	valid = true;
+}
+
+void checkpoint_t::put(const void *src, size_t bytes)
+{
+	const char *p = (const char *)src;
+	data.insert(data.end(), p, p + bytes);
+}
+
+void checkpoint_t::putString(const std::string &s)
+{
+	put((unsigned int)s.size());
+	put(s.data(), s.size());
+}
+
+bool checkpoint_t::get(void *dst, size_t bytes)
+{
+	if(!valid || bytes > data.size() - readPos) return (valid = false);
+	if(bytes) memcpy(dst, &data[readPos], bytes);
+	readPos += bytes;
+	return true;
+}
+
+bool checkpoint_t::getString(std::string &s)
+{
+	unsigned int n = 0;
+	if(!get(n) || n > data.size() - readPos) return (valid = false);
+	s.assign(data.begin() + readPos, data.begin() + readPos + n);
+	readPos += n;
+	return true;
+}
+
+bool checkpoint_t::load(const std::string &fileName)
+{
+	clear();
+	std::ifstream file(fileName.c_str(), std::ios::binary);
+	if(!file) return (valid = false);
+
+	char magic[sizeof(checkpointMagic)];
+	unsigned int version = 0;
+	unsigned long long size = 0;
+	file.read(magic, sizeof(magic));
+	file.read((char *)&version, sizeof(version));
+	file.read((char *)&size, sizeof(size));
+	if(!file || memcmp(magic, checkpointMagic, sizeof(magic)) != 0 || version != checkpointVersion)
+	{
+		Y_WARNING << "Checkpoint: \"" << fileName << "\" is no checkpoint of this version" << yendl;
+		return (valid = false);
+	}
+	data.resize(size);
+	if(size) file.read(&data[0], size);
+	if(!file)
+	{
+		Y_WARNING << "Checkpoint: \"" << fileName << "\" is truncated" << yendl;
+		clear();
+		return (valid = false);
+	}
+	return true;
+}
+
+void checkpoint_t::saveAsync(const std::string &fileName)
+{
+	wait();
+	if(!writer) writer = new checkpointWriter_t;
+	writer->buffer.swap(data);
+	writer->fileName = fileName;
+	clear();
+	writer->run();
+}
+
+bool checkpoint_t::wait()
+{
+	if(!writer) return true;
+	writer->wait();
+	return writer->ok;
+}
+
+__END_YAFRAY
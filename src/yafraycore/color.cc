@@ -20,8 +20,11 @@
  *      
  */
 #include <core_api/color.h>
+#include <utilities/simdMath.h>
 using namespace std;
 #include<iostream>
+#include <cmath>
+#include <cstring>
 
 __BEGIN_YAFRAY
 
@@ -144,6 +147,116 @@ color_t convergenceAccell(const color_t &cn_1,const color_t &cn0,const color_t &
 	return color_t(r,g,b);
 }
 
+/* colorA_t is R, G, B, A in 16 bytes with and without SIMD_MATH, so the SSE versions
+	below take one pixel per register in any build; the comparisons are ordered like the
+	scalar ones, which keeps NaNs and gives identical results. */
+
+// the compiler vectorizes this loop by itself, hand written SSE was slower
+void scaleColors(colorA_t *c, const CFLOAT *f, int n)
+{
+	for(int i=0; i<n; ++i) c[i] *= f[i];
+}
+
+void clampColorsRGB0(colorA_t *c, int n)
+{
+#ifdef Y_HAVE_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	float *p = &c[0].R;
+	for(int i=0; i<n; ++i, p+=4)
+	{
+		__m128 v = _mm_loadu_ps(p);
+		_mm_storeu_ps(p, sseSelect3(_mm_max_ps(zero, v), v));
+	}
+#else
+	for(int i=0; i<n; ++i) c[i].clampRGB0();
+#endif
+}
+
+void clampColorsRGB01(colorA_t *c, int n)
+{
+#ifdef Y_HAVE_SSE2
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f);
+	float *p = &c[0].R;
+	for(int i=0; i<n; ++i, p+=4)
+	{
+		__m128 v = _mm_loadu_ps(p);
+		_mm_storeu_ps(p, sseSelect3(_mm_min_ps(one, _mm_max_ps(zero, v)), v));
+	}
+#else
+	for(int i=0; i<n; ++i) c[i].clampRGB01();
+#endif
+}
+
+void gammaAdjustColors(colorA_t *c, int n, CFLOAT g)
+{
+	if(g == 1.f) return;
+#ifdef Y_HAVE_SSE2
+	// only the pow approximation has a vector version, exact builds keep using libm
+	if(useFastMath(MATH_DEFAULT))
+	{
+		const __m128 e = _mm_set1_ps(g);
+		float *p = &c[0].R;
+		for(int i=0; i<n; ++i, p+=4)
+		{
+			__m128 v = _mm_loadu_ps(p);
+			_mm_storeu_ps(p, sseSelect3(fPow_ps(v, e), v));
+		}
+		return;
+	}
+#endif
+	for(int i=0; i<n; ++i) c[i].gammaAdjust(g);
+}
+
+static const int gammaOctaveMin = -20, gammaOctaves = 32, gammaSegmentBits = 8;
+static const unsigned int gammaBitsMin = (unsigned int)(gammaOctaveMin + 127) << 23;
+static const unsigned int gammaBitsRange = (unsigned int)gammaOctaves << 23;
+
+static inline unsigned int floatBits(float f)
+{
+	unsigned int u;
+	std::memcpy(&u, &f, sizeof(u));
+	return u;
+}
+
+void gammaTable_t::init(CFLOAT gamma)
+{
+	g = gamma;
+	table.resize((gammaOctaves << gammaSegmentBits) + 1);
+	for(size_t i=0; i<table.size(); ++i)
+	{
+		unsigned int u = gammaBitsMin + ((unsigned int)i << (23 - gammaSegmentBits));
+		float v;
+		std::memcpy(&v, &u, sizeof(v));
+		table[i] = (float)std::pow((double)v, (double)g);
+	}
+}
+
+CFLOAT gammaTable_t::operator()(CFLOAT v) const
+{
+	// zero, negative values, NaN and infinity end up outside the table as well
+	unsigned int u = floatBits(v) - gammaBitsMin;
+	if(u >= gammaBitsRange) return fPow(v, g);
+	unsigned int i = u >> (23 - gammaSegmentBits);
+	float t = (float)(u & ((1u << (23 - gammaSegmentBits)) - 1)) * (1.f / (float)(1u << (23 - gammaSegmentBits)));
+	return table[i] + t * (table[i+1] - table[i]);
+}
+
+void gammaTable_t::apply(colorA_t *c, int n) const
+{
+	if(g == 1.f) return;
+	if(table.empty())
+	{
+		gammaAdjustColors(c, n, g);
+		return;
+	}
+	for(int i=0; i<n; ++i)
+	{
+		c[i].R = (*this)(c[i].R);
+		c[i].G = (*this)(c[i].G);
+		c[i].B = (*this)(c[i].B);
+	}
+}
+
 rgbe_t::rgbe_t(const color_t &s)
 {
 	CFLOAT v = s.getR();
@@ -0,0 +1,282 @@
+#include <yafraycore/curve.h>
+#include <core_api/surface.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+__BEGIN_YAFRAY
+
+//==========================================
+// curveSegment_t methods
+//==========================================
+
+bound_t curveSegment_t::getBound() const
+{
+	const curveVertex_t &v0 = curve->vertices[vert], &v1 = curve->vertices[vert+1];
+	PFLOAT r = std::max(v0.radius, v1.radius);
+	point3d_t l(std::min(v0.p.x, v1.p.x) - r, std::min(v0.p.y, v1.p.y) - r, std::min(v0.p.z, v1.p.z) - r);
+	point3d_t h(std::max(v0.p.x, v1.p.x) + r, std::max(v0.p.y, v1.p.y) + r, std::max(v0.p.z, v1.p.z) + r);
+	return bound_t(l, h);
+}
+
+bool curveSegment_t::clipToBound(double bound[2][3], int axis, bound_t &clipped, void *d_old, void *d_new) const
+{
+	// the part of the axis within the box grown by the radius, found like a ray-box test
+	const curveVertex_t &v0 = curve->vertices[vert], &v1 = curve->vertices[vert+1];
+	double r = std::max(v0.radius, v1.radius);
+	double s0 = 0.0, s1 = 1.0;
+	for(int i=0; i<3; ++i)
+	{
+		double p = v0.p[i], d = (double)v1.p[i] - p;
+		double lo = bound[0][i] - r, hi = bound[1][i] + r;
+		if(d == 0.0)
+		{
+			if(p < lo || p > hi) return false;
+			continue;
+		}
+		double ta = (lo - p) / d, tb = (hi - p) / d;
+		if(ta > tb) std::swap(ta, tb);
+		s0 = std::max(s0, ta);
+		s1 = std::min(s1, tb);
+		if(s0 > s1) return false;
+	}
+	point3d_t l, h;
+	for(int i=0; i<3; ++i)
+	{
+		double d = (double)v1.p[i] - v0.p[i];
+		double a = v0.p[i] + s0 * d, b = v0.p[i] + s1 * d;
+		l[i] = std::max(std::min(a, b) - r, bound[0][i]);
+		h[i] = std::min(std::max(a, b) + r, bound[1][i]);
+	}
+	clipped = bound_t(l, h);
+	return true;
+}
+
+bool curveSegment_t::intersect(const ray_t &ray, PFLOAT *t, intersectData_t &data) const
+{
+	const curveVertex_t &v0 = curve->vertices[vert], &v1 = curve->vertices[vert+1];
+	vector3d_t e = v1.p - v0.p;
+	vector3d_t w = ray.from - v0.p;
+	PFLOAT a = ray.dir * ray.dir, b = ray.dir * e, c = e * e;
+	PFLOAT d = ray.dir * w, f = e * w;
+	if(c == 0.f) return false;
+
+	// closest approach of ray and segment axis; clamping to the segment gives the round ends
+	PFLOAT den = a*c - b*b, s = 0.f;
+	if(den > 1e-12f * a * c) s = (a*f - b*d) / den;
+	if(s < 0.f) s = 0.f;
+	else if(s > 1.f) s = 1.f;
+	point3d_t q = v0.p + s * e;
+	PFLOAT tHit = ((q - ray.from) * ray.dir) / a;
+	if(tHit < 0.f) return false;
+	vector3d_t off = (ray.from + tHit * ray.dir) - q;
+	PFLOAT r = v0.radius + s * (v1.radius - v0.radius);
+	PFLOAT dist2 = off * off;
+	if(dist2 >= r*r) return false;
+
+	// rays leaving the strand's surface start inside the ribbon and must not hit it again
+	PFLOAT so = f / c;
+	if(so < 0.f) so = 0.f;
+	else if(so > 1.f) so = 1.f;
+	vector3d_t wo = w - so * e;
+	PFLOAT ro = v0.radius + so * (v1.radius - v0.radius);
+	if(wo * wo < ro * ro) return false;
+
+	// the ribbon faces the ray: front is the ray direction flipped and made normal to the axis
+	vector3d_t T = e / fSqrt(c);
+	vector3d_t F = (ray.dir * T) * T - ray.dir;
+	if(F * F < 1e-12f * a)
+	{
+		vector3d_t tmp;
+		createCS(T, F, tmp);
+	}
+	else F.normalize();
+	vector3d_t U, V;
+	createCS(T, U, V);
+
+	*t = tHit;
+	data.b0 = F * U;
+	data.b1 = F * V;
+	data.b2 = s;
+	data.t = (off * (T ^ F)) / r;
+	return true;
+}
+
+void curveSegment_t::getSurface(surfacePoint_t &sp, const point3d_t &hit, intersectData_t &data) const
+{
+	const curveVertex_t &v0 = curve->vertices[vert], &v1 = curve->vertices[vert+1];
+	vector3d_t T = (v1.p - v0.p).normalize();
+	vector3d_t U, V;
+	createCS(T, U, V);
+	vector3d_t F = data.b0 * U + data.b1 * V;
+	vector3d_t S = T ^ F;
+	PFLOAT h = data.t;
+	PFLOAT cosh2 = std::max(0.f, 1.f - h*h);
+
+	sp.Ng = F;
+	sp.N = (h * S + fSqrt(cosh2) * F).normalize();
+	sp.orcoP = hit;
+	sp.hasOrco = false;
+	sp.orcoNg = sp.Ng;
+
+	// 1D mapping along the strand, like the particle uv of blender
+	sp.U = sp.V = v0.u + data.b2 * (v1.u - v0.u);
+	sp.dPdU = T;
+	sp.dPdV = S;
+
+	sp.object = curve;
+	sp.primNum = this - &curve->segments[0];
+	sp.material = getMaterial();
+	sp.P = hit;
+	createCS(sp.N, sp.NU, sp.NV);
+	// transform dPdU and dPdV in shading space
+	sp.dSdU.x = sp.NU * sp.dPdU;
+	sp.dSdU.y = sp.NV * sp.dPdU;
+	sp.dSdU.z = sp.N * sp.dPdU;
+	sp.dSdV.x = sp.NU * sp.dPdV;
+	sp.dSdV.y = sp.NV * sp.dPdV;
+	sp.dSdV.z = sp.N * sp.dPdV;
+	sp.light = curve->light;
+}
+
+const material_t* curveSegment_t::getMaterial() const
+{
+	return curve->materials[matId];
+}
+
+//==========================================
+// curveObject_t methods
+//==========================================
+
+int curveObject_t::getPrimitives(const primitive_t **prims) const
+{
+	for(size_t i=0; i<segments.size(); ++i) prims[i] = &segments[i];
+	return segments.size();
+}
+
+void curveObject_t::startStrand(unsigned int id, int vertices)
+{
+	strandBegin = this->vertices.size();
+	std::map<unsigned int, curveRange_t>::iterator it = meshes.find(id);
+	if(it == meshes.end()) curMesh = &(meshes[id] = endRange());
+	else
+	{
+		curMesh = &it->second;
+		// a mesh is one block of strands, instances copy it from there
+		if(curMesh->endVertex != strandBegin)
+		{
+			Y_WARNING << "Curve: Strands of curve mesh " << id << " are not added in one block, instances only get the last ones" << yendl;
+			*curMesh = endRange();
+		}
+	}
+	if(vertices > 1) this->vertices.reserve(strandBegin + vertices);
+}
+
+int curveObject_t::addVertex(const point3d_t &p)
+{
+	curveVertex_t v;
+	v.p = p;
+	v.radius = 0.f;
+	v.u = 0.f;
+	vertices.push_back(v);
+	return vertices.size() - 1 - strandBegin;
+}
+
+bool curveObject_t::endStrand(const material_t *mat, float strandStart, float strandEnd, float strandShape)
+{
+	int n = vertices.size() - strandBegin;
+	if(n < 2)
+	{
+		vertices.resize(strandBegin);
+		return false;
+	}
+	if(segments.size() + n - 1 > std::numeric_limits<unsigned int>::max())
+	{
+		Y_WARNING << "Curve: Too many strand segments, strand dropped" << yendl;
+		vertices.resize(strandBegin);
+		return false;
+	}
+
+	size_t id = std::find(materials.begin(), materials.end(), mat) - materials.begin();
+	if(id == materials.size())
+	{
+		if(id > std::numeric_limits<unsigned short>::max())
+		{
+			Y_WARNING << "Curve: More than " << id << " hair materials, using the first one instead" << yendl;
+			id = 0;
+		}
+		else materials.push_back(mat);
+	}
+
+	// the strands used to be triangular prisms of this radius; a ribbon of the same mean
+	// width (perimeter / pi of the prism's cross section) covers as much of the image
+	const float widthScale = (2.f + std::sqrt(3.f)) / (2.f * M_PI);
+	for(int i=0; i<n; ++i)
+	{
+		float r;
+		if(strandShape < 0)
+		{
+			r = strandStart + pow((float)i/(n-1) ,1+strandShape) * ( strandEnd - strandStart );
+		}
+		else
+		{
+			r = strandStart + (1 - pow(((float)(n-i-1))/(n-1) ,1-strandShape)) * ( strandEnd - strandStart );
+		}
+		curveVertex_t &v = vertices[strandBegin + i];
+		v.radius = widthScale * r;
+		v.u = (float)i / (n-1);
+	}
+	for(int i=0; i<n-1; ++i) segments.push_back(curveSegment_t(this, strandBegin + i, id));
+	++strands;
+	curMesh->endVertex = vertices.size();
+	curMesh->endSegment = segments.size();
+	++curMesh->strands;
+	return true;
+}
+
+curveRange_t curveObject_t::endRange() const
+{
+	curveRange_t r = { vertices.size(), vertices.size(), segments.size(), segments.size(), 0 };
+	return r;
+}
+
+bool curveObject_t::addInstance(unsigned int baseId, unsigned int id, const matrix4x4_t &m)
+{
+	std::map<unsigned int, curveRange_t>::const_iterator it = meshes.find(baseId);
+	if(it == meshes.end() || hasMesh(id)) return false;
+	const curveRange_t r = it->second;
+	curveRange_t inst = endRange();
+	// the radius follows the average scale of the transform
+	PFLOAT det = m[0][0] * (m[1][1]*m[2][2] - m[1][2]*m[2][1])
+				- m[0][1] * (m[1][0]*m[2][2] - m[1][2]*m[2][0])
+				+ m[0][2] * (m[1][0]*m[2][1] - m[1][1]*m[2][0]);
+	PFLOAT scale = std::pow(std::fabs(det), PFLOAT(1.0/3.0));
+	vertices.reserve(vertices.size() + r.endVertex - r.firstVertex);
+	for(size_t i=r.firstVertex; i<r.endVertex; ++i)
+	{
+		curveVertex_t v = vertices[i];
+		v.p = m * v.p;
+		v.radius *= scale;
+		vertices.push_back(v);
+	}
+	segments.reserve(segments.size() + r.endSegment - r.firstSegment);
+	for(size_t i=r.firstSegment; i<r.endSegment; ++i)
+	{
+		const curveSegment_t &s = segments[i];
+		segments.push_back(curveSegment_t(this, s.vert - r.firstVertex + inst.firstVertex, s.matId));
+	}
+	strands += r.strands;
+	inst.strands = r.strands;
+	inst.endVertex = vertices.size();
+	inst.endSegment = segments.size();
+	meshes[id] = inst;
+	return true;
+}
+
+size_t curveObject_t::memory() const
+{
+	return vertices.capacity() * sizeof(curveVertex_t) + segments.capacity() * sizeof(curveSegment_t);
+}
+
+__END_YAFRAY
@@ -40,6 +40,8 @@
 #include <core_api/object3d.h>
 #include <core_api/volume.h>
 #include <yafraycore/std_primitives.h>
+#include <yafraycore/renderstats.h>
+#include <yafraycore/trace.h>
 #include <yaf_revision.h>
 #include <string>
 #include <sstream>
@@ -69,6 +71,7 @@ renderEnvironment_t::renderEnvironment_t()
 #endif
 	object_factory["sphere"] = sphere_factory;
 	Debug=0;
+	curren_scene=0;
 }
 
 template <class T>
@@ -412,6 +415,8 @@ imageHandler_t* renderEnvironment_t::createImageHandler(const std::string &name,
 	
 	if(ih)
 	{
+		int threads = 1;
+		if(params.getParam("threads", threads)) ih->setNumThreads(threads);
 		if(addToTable) imagehandler_table[newname.str()] = ih;
 		
 		InfoSucces(newname.str(), type);
@@ -515,6 +520,7 @@ imageFilm_t* renderEnvironment_t::createImageFilm(const paraMap_t &params, color
 {
 	const std::string *name=0;
 	const std::string *tiles_order=0;
+	const std::string *cost_map=0;
 	int width=320, height=240, xstart=0, ystart=0;
 	float filt_sz = 1.5, gamma=1.f;
 	bool clamp = false;
@@ -536,6 +542,7 @@ imageFilm_t* renderEnvironment_t::createImageFilm(const paraMap_t &params, color
 	params.getParam("tiles_order", tiles_order); // Order of the render buckets or tiles
 	params.getParam("premult", premult); // Premultipy Alpha channel for better alpha antialiasing against bg
 	params.getParam("drawParams", drawParams);
+	params.getParam("cost_map", cost_map); // Per pixel cost measure: "time", "rays" or "nodes"
 	
 	imageFilm_t::filterType type=imageFilm_t::BOX;
 	if(name)
@@ -560,6 +567,14 @@ imageFilm_t* renderEnvironment_t::createImageFilm(const paraMap_t &params, color
 	film->setClamp(clamp);
 	if(gamma > 0 && std::fabs(1.f-gamma) > 0.001) film->setGamma(gamma, true);
 
+	if(cost_map)
+	{
+		if(*cost_map == "time") film->initCostMap(imageFilm_t::COST_TIME);
+		else if(*cost_map == "rays") film->initCostMap(imageFilm_t::COST_RAYS);
+		else if(*cost_map == "nodes") film->initCostMap(imageFilm_t::COST_NODES);
+		else if(*cost_map != "none") Y_WARN_ENV << "Unknown cost map measure \"" << *cost_map << "\", no cost map is rendered." << yendl;
+	}
+
 	return film;
 }
 
@@ -634,7 +649,14 @@ bool renderEnvironment_t::setupScene(scene_t &scene, const paraMap_t &params, co
 	bool z_chan = false;
 	bool drawParams = false;
 	const std::string *custString = 0;
+	const std::string *checkpointFile = 0;
+	double checkpointInterval = 0.0;
+	bool resume = false;
 	std::stringstream aaSettings;
+
+	// statistics and timeline cover one render, they start from zero with every scene setup
+	gStats.reset();
+	gTrace.reset();
 	
 	if(! params.getParam("camera_name", name) )
 	{
@@ -693,6 +715,9 @@ bool renderEnvironment_t::setupScene(scene_t &scene, const paraMap_t &params, co
 	params.getParam("z_channel", z_chan); // render z-buffer
 	params.getParam("drawParams", drawParams);
 	params.getParam("customString", custString);
+	params.getParam("checkpoint_file", checkpointFile);
+	params.getParam("checkpoint_interval", checkpointInterval); // seconds between checkpoints, 0 = every pass
+	params.getParam("resume", resume);
 	
 	imageFilm_t *film = createImageFilm(params, output);
 	
@@ -718,6 +743,7 @@ bool renderEnvironment_t::setupScene(scene_t &scene, const paraMap_t &params, co
 	scene.setVolIntegrator((volumeIntegrator_t*)volInte);
 	scene.setAntialiasing(AA_samples, AA_passes, AA_inc_samples, AA_threshold);
 	scene.setNumThreads(nthreads);
+	scene.setCheckpoint(checkpointFile ? *checkpointFile : std::string(), (float)checkpointInterval, resume);
 	if(backg) scene.setBackground(backg);
 	
 	return true;
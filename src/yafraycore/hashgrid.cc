@@ -1,9 +1,10 @@
 #include <yafraycore/hashgrid.h>
+#include <yafraycore/renderstats.h>
 
 __BEGIN_YAFRAY
 
 hashGrid_t::hashGrid_t(double _cellSize, unsigned int _gridSize, yafaray::bound_t _bBox)
-:cellSize(_cellSize), gridSize(_gridSize), bBox(_bBox)
+:cellSize(_cellSize), gridSize(_gridSize), bBox(_bBox), hashGrid(NULL)
 {
 	invcellSize = 1. / cellSize;
 }
@@ -77,6 +78,7 @@ void hashGrid_t::updateGrid()
 
 unsigned int hashGrid_t::gather(const point3d_t &P, foundPhoton_t *found, unsigned int K, PFLOAT sqRadius)
 {
+	statCount(STAT_PHOTON_GATHERS);
 	unsigned int count = 0;
 	PFLOAT radius = sqrt(sqRadius);
 
@@ -22,42 +22,158 @@
  */
 
 #include <yafraycore/imageOutput.h>
+#include <yafraycore/ccthreads.h>
 
 __BEGIN_YAFRAY
 
-imageOutput_t::imageOutput_t(imageHandler_t * handle, const std::string &name, int bx, int by) : image(handle), fname(name), bX(bx), bY(by)
+class imageSaver_t: public yafthreads::thread_t
+{
+	public:
+		imageSaver_t(): image(NULL), ok(true) {}
+		virtual void body() { ok = image->saveToFile(fileName); }
+		imageHandler_t *image;
+		std::string fileName;
+		bool ok;
+};
+
+imageOutput_t::imageOutput_t(imageHandler_t * handle, const std::string &name, int bx, int by) : image(handle), fname(name), bX(bx), bY(by),
+	streamOpen(false), runX(0), runY(0), asyncSave(false), saver(NULL)
 {
 	//empty
 }
 
-imageOutput_t::imageOutput_t()
+imageOutput_t::imageOutput_t(): streamOpen(false), runX(0), runY(0), asyncSave(false), saver(NULL)
 {
 	image = NULL;
 }
 
 imageOutput_t::~imageOutput_t()
 {
+	waitSave();
+	delete saver;
 	image = NULL;
 }
 
+bool imageOutput_t::waitSave()
+{
+	if(!saver) return true;
+	saver->wait();
+	return saver->ok;
+}
+
 bool imageOutput_t::putPixel(int x, int y, const float *c, bool alpha, bool depth, float z)
 {
 	if(image)
 	{
+		waitSave();
 		colorA_t col(0.f);
 		col.set(c[0], c[1], c[2], ( (alpha) ? c[3] : 1.f ) );
-		image->putPixel(x + bX , y + bY, col, z);
+		if(image->streamMode() == imageHandler_t::STREAM_NONE)
+		{
+			image->putPixel(x + bX , y + bY, col, z);
+			return true;
+		}
+		return appendRun(x + bX, y + bY, &col, &z, 1);
+	}
+	return true;
+}
+
+bool imageOutput_t::putArea(int x0, int y0, int w, int h, const float *c, int stride, bool alpha, const float *z, int zStride)
+{
+	if(!image) return true;
+	waitSave();
+	bool stream = (image->streamMode() != imageHandler_t::STREAM_NONE);
+
+	// colorA_t is four packed floats, so the rows can be handed on in place unless alpha needs to be set
+	if(alpha && stride % 4 == 0)
+	{
+		const colorA_t *rgba = (const colorA_t *)c;
+		if(!stream)
+		{
+			image->putArea(x0 + bX, y0 + bY, w, h, rgba, stride / 4, z, zStride);
+			return true;
+		}
+		for(int j = 0; j < h; ++j)
+		{
+			if(!appendRun(x0 + bX, y0 + bY + j, rgba + j * (stride / 4), (z) ? z + j * zStride : 0, w)) return false;
+		}
+		return writeRun();
+	}
+
+	std::vector<colorA_t> row(w);
+	for(int j = 0; j < h; ++j)
+	{
+		const float *src = c + j * stride;
+		for(int i = 0; i < w; ++i) row[i].set(src[i*4], src[i*4+1], src[i*4+2], ( (alpha) ? src[i*4+3] : 1.f ));
+		const float *zRow = (z) ? z + j * zStride : 0;
+		if(!stream) image->putArea(x0 + bX, y0 + bY + j, w, 1, &row[0], w, zRow, w);
+		else if(!appendRun(x0 + bX, y0 + bY + j, &row[0], zRow, w)) return false;
+	}
+	return !stream || writeRun();
+}
+
+bool imageOutput_t::appendRun(int x, int y, const colorA_t *c, const float *z, int n)
+{
+	// the film sends rows left to right, consecutive pixels form one segment
+	if(!run.empty() && (y != runY || x != runX + (int)run.size()) && !writeRun()) return false;
+	if(run.empty())
+	{
+		runX = x;
+		runY = y;
 	}
+	run.insert(run.end(), c, c + n);
+	if(z) runDepth.insert(runDepth.end(), z, z + n);
+	else runDepth.resize(run.size(), 0.f);
+	if((int)run.size() == image->getWidth()) return writeRun();
 	return true;
 }
 
+bool imageOutput_t::writeRun()
+{
+	if(run.empty()) return true;
+	if(!streamOpen)
+	{
+		streamOpen = image->openStream(fname);
+		if(!streamOpen) Y_ERROR << "imageOutput: Could not open \"" << fname << "\" for writing" << yendl;
+	}
+	bool ok = streamOpen && image->writeStream(runX, runY, (int)run.size(), &run[0], &runDepth[0]);
+	run.clear();
+	runDepth.clear();
+	return ok;
+}
+
+void imageOutput_t::flushArea(int x0, int y0, int x1, int y1)
+{
+	if(image && image->streamMode() != imageHandler_t::STREAM_NONE) writeRun();
+}
+
+bool imageOutput_t::wantsAreas() const
+{
+	return !image || image->streamMode() != imageHandler_t::STREAM_ROWS;
+}
+
 void imageOutput_t::flush()
 {
 	if(image)
 	{
-		image->saveToFile(fname);
+		if(image->streamMode() == imageHandler_t::STREAM_NONE)
+		{
+			if(!asyncSave)
+			{
+				image->saveToFile(fname);
+				return;
+			}
+			waitSave();
+			if(!saver) saver = new imageSaver_t;
+			saver->image = image;
+			saver->fileName = fname;
+			saver->run();
+			return;
+		}
+		writeRun();
+		if(streamOpen) image->closeStream();
+		streamOpen = false;
 	}
 }
 
 __END_YAFRAY
-
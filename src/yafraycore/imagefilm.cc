@@ -24,6 +24,9 @@
 #include <core_api/imagehandler.h>
 #include <yafraycore/monitor.h>
 #include <yafraycore/timer.h>
+#include <yafraycore/renderstats.h>
+#include <yafraycore/trace.h>
+#include <yafraycore/checkpoint.h>
 #include <utilities/math_utils.h>
 #include <resources/yafLogoTiny.h>
 
@@ -34,6 +37,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <iomanip>
+#include <algorithm>
 
 #if HAVE_FREETYPE
 #include <resources/guifont.h>
@@ -117,18 +121,22 @@ float Lanczos2(float dx, float dy)
 
 imageFilm_t::imageFilm_t (int width, int height, int xstart, int ystart, colorOutput_t &out, float filterSize, filterType filt,
 						  renderEnvironment_t *e, bool showSamMask, int tSize, imageSpliter_t::tilesOrderType tOrder, bool pmA, bool drawParams):
-	flags(0), w(width), h(height), cx0(xstart), cy0(ystart), gamma(1.0), filterw(filterSize*0.5), output(&out),
+	flags(0), w(width), h(height), cx0(xstart), cy0(ystart), gamma(1.0), nThreads(1), filterw(filterSize*0.5), output(&out),
 	clamp(false), split(true), interactive(true), abort(false), correctGamma(false), splitter(0), pbar(0),
 	env(e), showMask(showSamMask), tileSize(tSize), tilesOrder(tOrder), premultAlpha(pmA), drawParams(drawParams)
 {
 	cx1 = xstart + width;
 	cy1 = ystart + height;
+	sx0 = cx0; sx1 = cx1;
+	sy0 = cy0; sy1 = cy1;
 	filterTable = new float[FILTER_TABLE_SIZE * FILTER_TABLE_SIZE];
 	
 	image = new rgba2DImage_t(width, height);
 	densityImage = NULL;
 	estimateDensity = false;
 	depthMap = NULL;
+	costMap = NULL;
+	costMeasure = COST_NONE;
 	dpimage = NULL;
 	
 	// fill filter table:
@@ -166,6 +174,7 @@ imageFilm_t::~imageFilm_t ()
 {
 	delete image;
 	if(depthMap) delete depthMap;
+	if(costMap) delete costMap;
 	if(densityImage) delete densityImage;
 	delete[] filterTable;
 	if(splitter) delete splitter;
@@ -175,13 +184,20 @@ imageFilm_t::~imageFilm_t ()
 
 void imageFilm_t::init(int numPasses)
 {
-	// Clear color buffer
-	image->clear();
+	// Clear color buffer; with a sample window only the pixels its samples reach, the
+	// rest of a full frame film would cost as much as the window itself for small windows
+	bool windowed = (sx0 > cx0 || sx1 < cx1 || sy0 > cy0 || sy1 < cy1);
+	int r = filterRadius();
+	int x0 = std::max(sx0 - r, cx0) - cx0, x1 = std::min(sx1 + r, cx1) - cx0;
+	int y0 = std::max(sy0 - r, cy0) - cy0, y1 = std::min(sy1 + r, cy1) - cy0;
+	if(windowed) image->clearArea(x0, y0, x1, y1);
+	else image->clear();
 
 	// Clear density image
 	if(estimateDensity)
 	{
 		if(!densityImage) densityImage = new rgb2DImage_nw_t(w, h);
+		else if(windowed) densityImage->clearArea(x0, y0, x1, y1);
 		else densityImage->clear();
 	}
 	
@@ -189,7 +205,8 @@ void imageFilm_t::init(int numPasses)
 	if(split)
 	{
 		next_area = 0;
-		splitter = new imageSpliter_t(w, h, cx0, cy0, tileSize, tilesOrder);
+		if(splitter) delete splitter;
+		splitter = new imageSpliter_t(sx1 - sx0, sy1 - sy0, sx0, sy0, tileSize, tilesOrder);
 		area_cnt = splitter->size();
 	}
 	else area_cnt = 1;
@@ -207,8 +224,118 @@ void imageFilm_t::initDepthMap()
 	if(!depthMap) depthMap = new gray2DImage_t(w, h);
 	else depthMap->clear();
 }
+
+void imageFilm_t::setSampleWindow(int x0, int y0, int x1, int y1)
+{
+	sx0 = std::max(x0, cx0); sx1 = std::min(x1, cx1);
+	sy0 = std::max(y0, cy0); sy1 = std::min(y1, cy1);
+}
+
+int imageFilm_t::filterRadius() const
+{
+	// addSample() reaches Round2Int(d +/- filterw) pixels from a sample at subpixel offset d
+	return (int)ceil(filterw) + 1;
+}
+
+void imageFilm_t::getPixelSum(int x, int y, colorA_t &col, float &weight) const
+{
+	const pixel_t &pixel = (*image)(x - cx0, y - cy0);
+	col = pixel.col;
+	weight = pixel.weight;
+}
+
+void imageFilm_t::addPixelSum(int x, int y, const colorA_t &col, float weight)
+{
+	imageMutex.lock();
+	pixel_t &pixel = (*image)(x - cx0, y - cy0);
+	pixel.col += col;
+	pixel.weight += weight;
+	imageMutex.unlock();
+}
+
+void imageFilm_t::saveState(checkpoint_t &cp) const
+{
+	cp.put(w); cp.put(h);
+	cp.put(nPass); cp.put(numSamples);
+	cp.put((bool)(depthMap != 0));
+	cp.put((bool)(estimateDensity && densityImage));
+
+	for(int x = 0; x < w; ++x)
+	{
+		for(int y = 0; y < h; ++y) cp.put((*image)(x, y));
+	}
+	if(depthMap)
+	{
+		for(int x = 0; x < w; ++x)
+		{
+			for(int y = 0; y < h; ++y) cp.put((*depthMap)(x, y));
+		}
+	}
+	if(estimateDensity && densityImage)
+	{
+		for(int x = 0; x < w; ++x)
+		{
+			for(int y = 0; y < h; ++y) cp.put((*densityImage)(x, y));
+		}
+	}
+}
+
+bool imageFilm_t::loadState(checkpoint_t &cp)
+{
+	int cw = 0, ch = 0, pass = 0, samples = 0;
+	bool hasDepth = false, hasDensity = false;
+	cp.get(cw); cp.get(ch);
+	cp.get(pass); cp.get(samples);
+	cp.get(hasDepth); cp.get(hasDensity);
+	if(!cp.good() || cw != w || ch != h || hasDepth != (depthMap != 0) || hasDensity != (estimateDensity && densityImage)) return false;
+
+	for(int x = 0; x < w; ++x)
+	{
+		for(int y = 0; y < h; ++y) cp.get((*image)(x, y));
+	}
+	if(hasDepth)
+	{
+		for(int x = 0; x < w; ++x)
+		{
+			for(int y = 0; y < h; ++y) cp.get((*depthMap)(x, y));
+		}
+	}
+	if(hasDensity)
+	{
+		for(int x = 0; x < w; ++x)
+		{
+			for(int y = 0; y < h; ++y) cp.get((*densityImage)(x, y));
+		}
+	}
+	if(!cp.good()) return false;
+	nPass = pass;
+	numSamples = samples;
+	return true;
+}
+
+void imageFilm_t::initCostMap(costType type)
+{
+	if(type == COST_NONE)
+	{
+		delete costMap;
+		costMap = NULL;
+		costMeasure = COST_NONE;
+		return;
+	}
+
+	if(!costMap) costMap = new gray2DImage_nw_t(w, h);
+	else costMap->clear();
+	costMeasure = type;
+
+	if(type != COST_TIME && !renderStats_t::isEnabled())
+	{
+		Y_INFO << "imageFilm: Cost map counts rays, enabling render statistics" << yendl;
+		renderStats_t::setEnabled(true);
+	}
+}
 void imageFilm_t::nextPass(bool adaptive_AA, std::string integratorName)
 {
+	traceScope_t ts("nextPass", "film", "pass", nPass + 1);
 	int n_resample=0;
 	
 	splitterMutex.lock();
@@ -222,9 +349,13 @@ void imageFilm_t::nextPass(bool adaptive_AA, std::string integratorName)
 	
 	if(adaptive_AA && AA_thesh > 0.f)
 	{
-		for(int y=0; y<h-1; ++y)
+		// only pixels the next pass samples need flags; pixel (x,y) is flagged by comparisons
+		// made from its row and the one above, and from its left and right neighbours
+		int fx0 = std::max(0, sx0 - cx0 - 1), fx1 = std::min(w-1, sx1 - cx0 + 1);
+		int fy0 = std::max(0, sy0 - cy0 - 1), fy1 = std::min(h-1, sy1 - cy0);
+		for(int y=fy0; y<fy1; ++y)
 		{
-			for(int x = 0; x < w-1; ++x)
+			for(int x = fx0; x < fx1; ++x)
 			{
 				bool needAA = false;
 				float c = (*image)(x, y).normalized().abscol2bri();
@@ -267,7 +398,7 @@ void imageFilm_t::nextPass(bool adaptive_AA, std::string integratorName)
 	}
 	else
 	{
-		n_resample = h*w;
+		n_resample = (sx1 - sx0) * (sy1 - sy0);
 	}
 	
 	if(interactive) output->flush();
@@ -332,33 +463,81 @@ bool imageFilm_t::nextArea(renderArea_t &a)
 	return false;
 }
 
-void imageFilm_t::finishArea(renderArea_t &a)
+//! resolves a band of rows per item, for imageFilm_t::resolveArea()
+class filmResolveJob_t: public yafthreads::parallelJob_t
 {
-	outMutex.lock();
-	
-	int end_x = a.X+a.W-cx0, end_y = a.Y+a.H-cy0;
-	colorA_t col;
-	
-	for(int j=a.Y-cy0; j<end_y; ++j)
+	public:
+		filmResolveJob_t(const imageFilm_t &f, int x0, int y0, int rw, colorA_t *rgba, float *depth, int flags):
+			film(f), x0(x0), y0(y0), rw(rw), rgba(rgba), depth(depth), flags(flags) {}
+		virtual void run(int start, int end)
+		{
+			film.resolveArea(x0, y0 + start, rw, end - start, rgba + start * rw, depth ? depth + start * rw : 0, flags, 1);
+		}
+	protected:
+		const imageFilm_t &film;
+		int x0, y0, rw;
+		colorA_t *rgba;
+		float *depth;
+		int flags;
+};
+
+void imageFilm_t::resolveArea(int x0, int y0, int rw, int rh, colorA_t *rgba, float *depth, int flags, int nThreads) const
+{
+	if(rw <= 0 || rh <= 0) return;
+
+	if(nThreads > 1 && rh > 1)
+	{
+		filmResolveJob_t job(*this, x0, y0, rw, rgba, depth, flags);
+		yafthreads::runParallel(job, rh, nThreads);
+		return;
+	}
+
+	float multi = 0.f;
+	bool addDensity = estimateDensity && (flags & IF_DENSITYIMAGE);
+	if(addDensity) multi = (float) (w * h) / (float) numSamples;
+
+	for(int j = 0; j < rh; ++j)
 	{
-		for(int i=a.X-cx0; i<end_x; ++i)
+		colorA_t *row = rgba + j * rw;
+		if(flags & IF_IMAGE)
 		{
-			col = (*image)(i, j).normalized();
-			col.clampRGB0();
+			for(int i = 0; i < rw; ++i) row[i] = (*image)(x0 + i, y0 + j).normalized();
+		}
+		else std::fill(row, row + rw, colorA_t(0.f));
 
-			if(correctGamma) col.gammaAdjust(gamma);
+		if(addDensity)
+		{
+			for(int i = 0; i < rw; ++i) row[i] += (*densityImage)(x0 + i, y0 + j) * multi;
+		}
 
-			if(depthMap)
-			{
-				if( !output->putPixel(i, j, (const float*)&col, true, true, (*depthMap)(i, j).normalized()) ) abort=true;
-			}
-			else
-			{
-				if( !output->putPixel(i, j, (const float *)&col) ) abort=true;
-			}
-			
+		clampColorsRGB0(row, rw);
+		if(correctGamma) gammaTable.apply(row, rw);
+
+		if(depth && depthMap)
+		{
+			float *rowDepth = depth + j * rw;
+			for(int i = 0; i < rw; ++i) rowDepth[i] = (*depthMap)(x0 + i, y0 + j).normalized();
 		}
 	}
+}
+
+void imageFilm_t::finishArea(renderArea_t &a)
+{
+	int end_x = a.X+a.W-cx0, end_y = a.Y+a.H-cy0;
+	int x0 = a.X-cx0, y0 = a.Y-cy0;
+	int tw = end_x - x0, th = end_y - y0;
+	bool putTile = output->wantsAreas() && tw > 0 && th > 0;
+
+	// the tile is resolved before taking the output lock, the other threads only wait for the output call
+	std::vector<colorA_t> tile(putTile ? tw * th : 0);
+	std::vector<float> tileDepth(putTile && depthMap ? tw * th : 0);
+	if(putTile) resolveArea(x0, y0, tw, th, &tile[0], depthMap ? &tileDepth[0] : 0);
+
+	outMutex.lock();
+	traceScope_t ts("finishArea", "film", "x,y,w,h", a.X, a.Y, a.W, a.H); // spans the time the output lock is held
+
+	// the whole area goes to the output in one call, colorA_t rows are packed RGBA floats
+	if(putTile && !output->putArea(x0, y0, tw, th, (const float *)&tile[0], tw * 4, true, depthMap ? &tileDepth[0] : 0, tw) ) abort=true;
 
 	if(interactive) output->flushArea(a.X, a.Y, end_x+cx0, end_y+cy0);
 
@@ -371,8 +550,71 @@ void imageFilm_t::finishArea(renderArea_t &a)
 	outMutex.unlock();
 }
 
+double imageFilm_t::costProbe() const
+{
+	switch(costMeasure)
+	{
+		case COST_RAYS: return (double)renderStats_t::threadSum(STAT_RAYS, RAY_CLASSES);
+		case COST_NODES: return (double)renderStats_t::threadSum(STAT_KD_NODES, RAY_CLASSES);
+		case COST_TIME: return timer_t::now() * 1.0e6;
+		default: return 0.0;
+	}
+}
+
+//! maps [0,1] to black, blue, red, yellow and white
+static colorA_t heatColor(float v)
+{
+	static const float ramp[5][3] = { {0.f, 0.f, 0.f}, {0.f, 0.f, 1.f}, {1.f, 0.f, 0.f}, {1.f, 1.f, 0.f}, {1.f, 1.f, 1.f} };
+	v = std::min(std::max(v, 0.f), 1.f) * 4.f;
+	int i = std::min((int)v, 3);
+	float t = v - i;
+	return colorA_t(ramp[i][0] + t * (ramp[i+1][0] - ramp[i][0]),
+					ramp[i][1] + t * (ramp[i+1][1] - ramp[i][1]),
+					ramp[i][2] + t * (ramp[i+1][2] - ramp[i][2]), 1.f);
+}
+
+void imageFilm_t::flushCostMap(colorOutput_t &out, bool falseColor)
+{
+	if(!costMap || w * h == 0) return;
+
+	static const char *units[4] = { "", "us", "rays", "kd-tree nodes" };
+
+	std::vector<float> sorted(w * h);
+	double total = 0.0;
+	for(int j = 0; j < h; j++)
+	{
+		for(int i = 0; i < w; i++)
+		{
+			sorted[j * w + i] = (*costMap)(i, j);
+			total += (*costMap)(i, j);
+		}
+	}
+	// scale to a high percentile instead of the maximum, so a handful of extreme pixels doesn't turn the rest black
+	std::vector<float>::iterator pct = sorted.begin() + (sorted.size() * 99) / 100;
+	std::nth_element(sorted.begin(), pct, sorted.end());
+	float scale = *pct;
+	float maxCost = *std::max_element(pct, sorted.end());
+
+	Y_INFO << "imageFilm: Cost map total " << total << " " << units[costMeasure] << ", pixel maximum " << maxCost
+		<< ", 99th percentile " << scale << yendl;
+
+	float invScale = (scale > 0.f) ? 1.f / scale : 0.f;
+	for(int j = 0; j < h; j++)
+	{
+		for(int i = 0; i < w; i++)
+		{
+			float c = (*costMap)(i, j);
+			colorA_t col = falseColor ? heatColor(c * invScale) : colorA_t(c, c, c, 1.f);
+			out.putPixel(i, j, (const float *)&col, false);
+		}
+	}
+
+	out.flush();
+}
+
 void imageFilm_t::flush(int flags, colorOutput_t *out)
 {
+	traceScope_t ts("flush", "film");
 	outMutex.lock();
 
 	Y_INFO << "imageFilm: Flushing buffer..." << yendl;
@@ -386,42 +628,34 @@ void imageFilm_t::flush(int flags, colorOutput_t *out)
 	Y_WARNING << "imageFilm: Text on the parameters badge won't be available." << yendl;
 #endif
 
-	float multi = 0.f;
-	colorA_t col;
-	int k = 0;
-
-	if(estimateDensity) multi = (float) (w * h) / (float) numSamples;
+	// bands of rows are resolved in parallel and passed on with one output call each,
+	// which bounds the extra memory and lets streaming outputs write while the rest is resolved
+	const int bandRows = 64;
+	std::vector<colorA_t> band(w * std::min(h, bandRows));
+	std::vector<float> bandDepth(depthMap ? band.size() : 0);
 
-	for(int j = 0; j < h; j++)
+	for(int j0 = 0; j0 < h && w > 0; j0 += bandRows)
 	{
-		for(int i = 0; i < w; i++)
-		{
-			if(flags & IF_IMAGE) col = (*image)(i, j).normalized();
-			else col = colorA_t(0.f);
+		int bh = std::min(bandRows, h - j0);
+		resolveArea(0, j0, w, bh, &band[0], depthMap ? &bandDepth[0] : 0, flags, nThreads);
 
-			if(estimateDensity && (flags & IF_DENSITYIMAGE)) col += (*densityImage)(i, j) * multi;
-			
-			col.clampRGB0();
-			
-			if(correctGamma) col.gammaAdjust(gamma);
-			
-			if(drawParams && h - j <= dpHeight && dpimage)
-			{
-				colorA_t &dpcol = (*dpimage)(i, k);
-				col = colorA_t( alphaBlend(col, dpcol, dpcol.getA()), std::max(col.getA(), dpcol.getA()) );
-			}
-			
-			if(depthMap)
-			{
-				colout->putPixel(i, j, (const float*)&col, true, true, (*depthMap)(i, j).normalized());
-			}
-			else
+		if(drawParams && dpimage)
+		{
+			int dpStart = std::max(0, h - dpHeight);
+			for(int j = std::max(j0, dpStart); j < j0 + bh; j++)
 			{
-				colout->putPixel(i, j, (const float*)&col);
+				colorA_t *row = &band[(j - j0) * w];
+				int k = j - dpStart;
+				for(int i = 0; i < w; i++)
+				{
+					colorA_t &col = row[i];
+					colorA_t &dpcol = (*dpimage)(i, k);
+					col = colorA_t( alphaBlend(col, dpcol, dpcol.getA()), std::max(col.getA(), dpcol.getA()) );
+				}
 			}
 		}
-		
-		if(drawParams && h - j <= dpHeight) k++;
+
+		colout->putArea(0, j0, w, bh, (const float *)&band[0], w * 4, true, depthMap ? &bandDepth[0] : 0, w);
 	}
 
 	colout->flush();
@@ -620,6 +854,7 @@ void imageFilm_t::setGamma(float gammaVal, bool enable)
 {
 	correctGamma = enable;
 	if(gammaVal > 0) gamma = 1.f/gammaVal; //gamma correction means applying gamma curve with 1/gamma
+	if(correctGamma && gammaTable.getGamma() != gamma) gammaTable.init(gamma);
 }
 
 void imageFilm_t::setProgressBar(progressBar_t *pb)
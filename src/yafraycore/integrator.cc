@@ -24,7 +24,9 @@
  */
 
 #include <yafraycore/timer.h>
-#include <yafraycore/scr_halton.h>
+#include <yafraycore/renderstats.h>
+#include <yafraycore/trace.h>
+#include <utilities/sobol.h>
 #include <yafraycore/spectrum.h>
 
 #include <core_api/tiledintegrator.h>
@@ -63,12 +65,16 @@ class renderWorker_t: public yafthreads::thread_t
 
 void renderWorker_t::body()
 {
+	setWorkerIndex(threadID);
 	renderArea_t a;
 	while(imageFilm->nextArea(a))
 	{
 		if(scene->getSignals() & Y_SIG_ABORT) break;
-		integrator->preTile(a, samples, offset, adaptive, threadID);
-		integrator->renderTile(a, samples, offset, adaptive, threadID);
+		{
+			traceScope_t ts("tile", "render", "x,y,w,h", a.X, a.Y, a.W, a.H);
+			integrator->preTile(a, samples, offset, adaptive, threadID);
+			integrator->renderTile(a, samples, offset, adaptive, threadID);
+		}
 		control->countCV.lock();
 		control->areas.push_back(a);
 		control->countCV.signal();
@@ -146,14 +152,23 @@ bool tiledIntegrator_t::render(imageFilm_t *image)
 	
 	preRender();
 
-	renderPass(AA_samples, 0, false);
-	for(int i=1; i<AA_passes; ++i)
+	// the sample offsets of a pass follow from its number and the adaptive flags from the
+	// accumulated image, so the film alone is enough to continue a render
+	int donePasses = resumeCheckpoint(AA_passes);
+	if(donePasses == 0)
+	{
+		renderPass(AA_samples, 0, false);
+		checkpointPass(1, AA_passes);
+	}
+	for(int i=std::max(1, donePasses); i<AA_passes; ++i)
 	{
 		if(scene->getSignals() & Y_SIG_ABORT) break;
 		imageFilm->setAAThreshold(AA_threshold);
 		imageFilm->nextPass(true, integratorName);
 		renderPass(AA_inc_samples, AA_samples + (i-1)*AA_inc_samples, true);
+		checkpointPass(i+1, AA_passes);
 	}
+	checkpoint.wait();
 	maxDepth = 0.f;
 	gTimer.stop("rendert");
 	Y_INFO << integratorName << ": Overall rendertime: " << gTimer.getTime("rendert") << "s" << yendl;
@@ -162,8 +177,72 @@ bool tiledIntegrator_t::render(imageFilm_t *image)
 }
 
 
+int tiledIntegrator_t::resumeCheckpoint(int passes)
+{
+	lastCheckpoint = timer_t::now();
+	const std::string &file = scene->getCheckpointFile();
+	if(file.empty() || !scene->doResume()) return 0;
+
+	checkpoint.clear();
+	if(!checkpoint.load(file))
+	{
+		Y_INFO << integratorName << ": No checkpoint to resume from in \"" << file << "\", rendering from the start" << yendl;
+		return 0;
+	}
+
+	std::string name;
+	int cpPasses = 0, donePasses = 0, seed = 0;
+	checkpoint.getString(name);
+	checkpoint.get(cpPasses);
+	checkpoint.get(donePasses);
+	checkpoint.get(seed);
+	if(!checkpoint.good() || name != integratorName || cpPasses != passes || donePasses < 1 || donePasses >= passes)
+	{
+		Y_WARNING << integratorName << ": Checkpoint \"" << file << "\" belongs to a different render, rendering from the start" << yendl;
+		return 0;
+	}
+	if(!imageFilm->loadState(checkpoint) || !loadCheckpointState(checkpoint))
+	{
+		Y_WARNING << integratorName << ": Checkpoint \"" << file << "\" does not match the scene, rendering from the start" << yendl;
+		// the film may hold part of the checkpoint by now
+		imageFilm->init(passes);
+		if(scene->doDepth()) imageFilm->initDepthMap();
+		return 0;
+	}
+	myseed = seed;
+	checkpoint.clear();
+	Y_INFO << integratorName << ": Resuming after pass " << donePasses << " of " << passes << " from \"" << file << "\"" << yendl;
+	return donePasses;
+}
+
+void tiledIntegrator_t::checkpointPass(int pass, int passes)
+{
+	const std::string &file = scene->getCheckpointFile();
+	// an aborted pass is incomplete, the last checkpoint stays the one to resume from
+	if(file.empty() || pass >= passes || (scene->getSignals() & Y_SIG_ABORT)) return;
+	double now = timer_t::now();
+	if(now - lastCheckpoint < scene->getCheckpointInterval()) return;
+	lastCheckpoint = now;
+
+	traceScope_t ts("checkpoint", "film", "pass", pass);
+	checkpoint.clear();
+	checkpoint.putString(integratorName);
+	checkpoint.put(passes);
+	checkpoint.put(pass);
+	checkpoint.put(myseed); // state of ourRandom(), photon scattering draws from it
+	imageFilm->saveState(checkpoint);
+	saveCheckpointState(checkpoint);
+	checkpoint.saveAsync(file);
+	Y_INFO << integratorName << ": Saving checkpoint of pass " << pass << " to \"" << file << "\"" << yendl;
+}
+
 bool tiledIntegrator_t::renderPass(int samples, int offset, bool adaptive)
 {
+	traceScope_t ts("pass", "render", "samples,offset", samples, offset);
+	timer_t passTimer;
+	passTimer.addEvent("pass");
+	passTimer.start("pass");
+
 	prePass(samples, offset, adaptive);
 	
 	int nthreads = scene->getNumThreads();
@@ -197,13 +276,18 @@ bool tiledIntegrator_t::renderPass(int samples, int offset, bool adaptive)
 		while(imageFilm->nextArea(a))
 		{
 			if(scene->getSignals() & Y_SIG_ABORT) break;
-			preTile(a, samples, offset, adaptive, 0);
-			renderTile(a, samples, offset, adaptive, 0);
+			{
+				traceScope_t ts("tile", "render", "x,y,w,h", a.X, a.Y, a.W, a.H);
+				preTile(a, samples, offset, adaptive, 0);
+				renderTile(a, samples, offset, adaptive, 0);
+			}
 			imageFilm->finishArea(a);
 		}
 #ifdef USING_THREADS
 	}
 #endif
+	passTimer.stop("pass");
+	gStats.addPass(passTimer.getTime("pass"));
 	return true; //hm...quite useless the return value :)
 }
 
@@ -212,13 +296,13 @@ bool tiledIntegrator_t::renderTile(renderArea_t &a, int n_samples, int offset, b
 	int x, y;
 	const camera_t* camera = scene->getCamera();
 	bool do_depth = scene->doDepth();
+	bool do_cost = imageFilm->doCostMap();
 	x=camera->resX();
 	y=camera->resY();
 	diffRay_t c_ray;
-	ray_t d_ray;
-	PFLOAT dx=0.5, dy=0.5, d1=1.0/(PFLOAT)n_samples;
+	PFLOAT dx=0.5, dy=0.5;
 	float lens_u=0.5f, lens_v=0.5f;
-	PFLOAT wt, wt_dummy;
+	PFLOAT wt;
 	random_t prng(offset*(x*a.Y+a.X)+123);
 	renderState_t rstate(&prng);
 	rstate.threadID = threadID;
@@ -226,9 +310,6 @@ bool tiledIntegrator_t::renderTile(renderArea_t &a, int n_samples, int offset, b
 	bool sampleLns = camera->sampleLense();
 	int pass_offs=offset, end_x=a.X+a.W, end_y=a.Y+a.H;
 
-	Halton halU(3);
-	Halton halV(5);
-
 	for(int i=a.Y; i<end_y; ++i)
 	{
 		for(int j=a.X; j<end_x; ++j)
@@ -242,49 +323,35 @@ bool tiledIntegrator_t::renderTile(renderArea_t &a, int n_samples, int offset, b
 
 			rstate.pixelNumber = x*i+j;
 			rstate.samplingOffs = fnv_32a_buf(i*fnv_32a_buf(j));//fnv_32a_buf(rstate.pixelNumber);
-			float toff = scrHalton(5, pass_offs+rstate.samplingOffs); // **shall be just the pass number...**
-			
-			halU.setStart(pass_offs+rstate.samplingOffs);
-			halV.setStart(pass_offs+rstate.samplingOffs);
+			double cost = do_cost ? imageFilm->costProbe() : 0.0;
 
 			for(int sample=0; sample<n_samples; ++sample)
 			{
 				rstate.setDefaults();
 				rstate.pixelSample = pass_offs+sample;
-				rstate.time = addMod1((PFLOAT)sample*d1, toff);//(0.5+(PFLOAT)sample)*d1;
+				rstate.sampleIndex = rstate.pixelSample;
+				rstate.time = sobolSample(rstate.pixelSample, SD_TIME, rstate.samplingOffs);
 				
-				// the (1/n, Larcher&Pillichshammer-Seq.) only gives good coverage when total sample count is known
-				// hence we use scrambled (Sobol, van-der-Corput) for multipass AA
-				if(AA_passes>1)
-				{
-					dx = RI_vdC(rstate.pixelSample, rstate.samplingOffs);
-					dy = RI_S(rstate.pixelSample, rstate.samplingOffs);
-				}
-				else if(n_samples > 1)
+				// scrambled Sobol points stay well stratified for any sample count, so they
+				// work for single and multipass AA alike
+				if(n_samples > 1 || AA_passes > 1)
 				{
-					dx = (0.5+(PFLOAT)sample)*d1;
-					dy = RI_LP(sample+rstate.samplingOffs);
+					dx = sobolSample(rstate.pixelSample, SD_PIXEL, rstate.samplingOffs);
+					dy = sobolSample(rstate.pixelSample, SD_PIXEL+1, rstate.samplingOffs);
 				}
 				if(sampleLns)
 				{
-					lens_u = halU.getNext();
-					lens_v = halV.getNext();
+					lens_u = sobolSample(rstate.pixelSample, SD_LENS, rstate.samplingOffs);
+					lens_v = sobolSample(rstate.pixelSample, SD_LENS+1, rstate.samplingOffs);
 				}
-				c_ray = camera->shootRay(j+dx, i+dy, lens_u, lens_v, wt);
+				c_ray = camera->shootDiffRay(j+dx, i+dy, lens_u, lens_v, wt);
+				renderStats_t::primaryRay();
 				if(wt==0.0)
 				{
 					imageFilm->addSample(colorA_t(0.f), j, i, dx, dy, &a);
 					continue;
 				}
-				//setup ray differentials
-				d_ray = camera->shootRay(j+1+dx, i+dy, lens_u, lens_v, wt_dummy);
-				c_ray.xfrom = d_ray.from;
-				c_ray.xdir = d_ray.dir;
-				d_ray = camera->shootRay(j+dx, i+1+dy, lens_u, lens_v, wt_dummy);
-				c_ray.yfrom = d_ray.from;
-				c_ray.ydir = d_ray.dir;
 				c_ray.time = rstate.time;
-				c_ray.hasDifferentials = true;
 				// col = T * L_o + L_v
 				colorA_t col = integrate(rstate, c_ray); // L_o
 				col *= scene->volIntegrator->transmittance(rstate, c_ray); // T
@@ -302,6 +369,7 @@ bool tiledIntegrator_t::renderTile(renderArea_t &a, int n_samples, int offset, b
 					imageFilm->addDepthSample(0, depth, j, i, dx, dy);
 				}
 			}
+			if(do_cost) imageFilm->addCost(j, i, imageFilm->costProbe() - cost);
 		}
 	}
 	return true;
@@ -1,6 +1,7 @@
 // search for "todo" and "IMPLEMENT" and "<<" or ">>"...
 
 #include <yafraycore/kdtree.h>
+#include <yafraycore/renderstats.h>
 #include <core_api/material.h>
 #include <core_api/scene.h>
 #include <stdexcept>
@@ -656,6 +657,7 @@ int triKdTree_t::buildTree(u_int32 nPrims, bound_t &nodeBound, u_int32 *primNums
 
 bool triKdTree_t::Intersect(const ray_t &ray, PFLOAT dist, triangle_t **tr, PFLOAT &Z, intersectData_t &data) const
 {
+	kdQueryStats_t qs(false);
 	Z=dist;
 	PFLOAT a, b, t; // entry/exit/splitting plane signed distance
 	PFLOAT t_hit;
@@ -692,6 +694,7 @@ bool triKdTree_t::Intersect(const ray_t &ray, PFLOAT dist, triangle_t **tr, PFLO
 		// loop until leaf is found
 		while( !currNode->IsLeaf() )
 		{
+			++qs.nodes;
 			int axis = currNode->SplitAxis();
 			PFLOAT splitVal = currNode->SplitPos();
 			
@@ -743,12 +746,14 @@ bool triKdTree_t::Intersect(const ray_t &ray, PFLOAT dist, triangle_t **tr, PFLO
 		}
 				 
 		// Check for intersections inside leaf node
+		++qs.nodes;
 		u_int32 nPrimitives = currNode->nPrimitives();
 		
 		if (nPrimitives == 1)
 		{
 			triangle_t *mp = currNode->onePrimitive;
 
+			++qs.tests;
 			if (mp->intersect(ray, &t_hit, tempData))
 			{
 				if(t_hit < Z && t_hit >= ray.tmin)
@@ -768,6 +773,7 @@ bool triKdTree_t::Intersect(const ray_t &ray, PFLOAT dist, triangle_t **tr, PFLO
 			{
 				triangle_t *mp = prims[i];
 
+				++qs.tests;
 				if (mp->intersect(ray, &t_hit, tempData))
 				{
 					if(t_hit < Z && t_hit >= ray.tmin)
@@ -801,6 +807,7 @@ bool triKdTree_t::Intersect(const ray_t &ray, PFLOAT dist, triangle_t **tr, PFLO
 
 bool triKdTree_t::IntersectS(const ray_t &ray, PFLOAT dist, triangle_t **tr) const
 {
+	kdQueryStats_t qs(true);
 	PFLOAT a, b, t; // entry/exit/splitting plane signed distance
 	PFLOAT t_hit;
 	
@@ -837,6 +844,7 @@ bool triKdTree_t::IntersectS(const ray_t &ray, PFLOAT dist, triangle_t **tr) con
 		// loop until leaf is found
 		while( !currNode->IsLeaf() )
 		{
+			++qs.nodes;
 			int axis = currNode->SplitAxis();
 			PFLOAT splitVal = currNode->SplitPos();
 			
@@ -889,10 +897,12 @@ bool triKdTree_t::IntersectS(const ray_t &ray, PFLOAT dist, triangle_t **tr) con
 		}
 				 
 		// Check for intersections inside leaf node
+		++qs.nodes;
 		u_int32 nPrimitives = currNode->nPrimitives();
 		if (nPrimitives == 1)
 		{
 			triangle_t *mp = currNode->onePrimitive;
+			++qs.tests;
 			if (mp->intersect(ray, &t_hit, bary))
 			{
 				if(t_hit < dist && t_hit >= 0.f ) // '>=' ?
@@ -908,6 +918,7 @@ bool triKdTree_t::IntersectS(const ray_t &ray, PFLOAT dist, triangle_t **tr) con
 			for (u_int32 i = 0; i < nPrimitives; ++i)
 			{
 				triangle_t *mp = prims[i];
+				++qs.tests;
 				if (mp->intersect(ray, &t_hit, bary))
 				{
 					if(t_hit < dist && t_hit >= 0.f )
@@ -932,8 +943,9 @@ bool triKdTree_t::IntersectS(const ray_t &ray, PFLOAT dist, triangle_t **tr) con
 	allow for transparent shadows.
 =============================================================*/
 
-bool triKdTree_t::IntersectTS(renderState_t &state, const ray_t &ray, int maxDepth, PFLOAT dist, triangle_t **tr, color_t &filt) const
+bool triKdTree_t::IntersectTS(renderState_t &state, const ray_t &ray, int maxDepth, PFLOAT dist, triangle_t **tr, color_t &filt, int *layers) const
 {
+	kdQueryStats_t qs(true);
 	PFLOAT a, b, t; // entry/exit/splitting plane signed distance
 	PFLOAT t_hit;
 	
@@ -942,7 +954,8 @@ bool triKdTree_t::IntersectTS(renderState_t &state, const ray_t &ray, int maxDep
 	
 	intersectData_t bary;
 	vector3d_t invDir(1.f/ray.dir.x, 1.f/ray.dir.y, 1.f/ray.dir.z);
-	int depth=0;
+	int ownDepth=0;
+	int &depth = layers ? *layers : ownDepth;
 
 #if ( HAVE_PTHREAD && defined (__GNUC__) )
 	std::set<const triangle_t *, std::less<const triangle_t *>, __gnu_cxx::__mt_alloc<const triangle_t *> > filtered;
@@ -976,6 +989,7 @@ bool triKdTree_t::IntersectTS(renderState_t &state, const ray_t &ray, int maxDep
 		// loop until leaf is found
 		while( !currNode->IsLeaf() )
 		{
+			++qs.nodes;
 			int axis = currNode->SplitAxis();
 			PFLOAT splitVal = currNode->SplitPos();
 			
@@ -1027,11 +1041,13 @@ bool triKdTree_t::IntersectTS(renderState_t &state, const ray_t &ray, int maxDep
 		}
 				 
 		// Check for intersections inside leaf node
+		++qs.nodes;
 		u_int32 nPrimitives = currNode->nPrimitives();
 
 		if (nPrimitives == 1)
 		{
 			triangle_t *mp = currNode->onePrimitive;
+			++qs.tests;
 			if (mp->intersect(ray, &t_hit, bary))
 			{
 				if(t_hit < dist && t_hit >= ray.tmin ) // '>=' ?
@@ -1058,6 +1074,7 @@ bool triKdTree_t::IntersectTS(renderState_t &state, const ray_t &ray, int maxDep
 			for (u_int32 i = 0; i < nPrimitives; ++i)
 			{
 				triangle_t *mp = prims[i];
+				++qs.tests;
 				if (mp->intersect(ray, &t_hit, bary))
 				{
 					if(t_hit < dist && t_hit >= ray.tmin)
@@ -25,13 +25,15 @@
 #include <core_api/light.h>
 #include <yafraycore/photon.h>
 #include <yafraycore/scr_halton.h>
+#include <utilities/sobol.h>
 #include <yafraycore/spectrum.h>
 #include <utilities/mcqmc.h>
+#include <yafraycore/renderstats.h>
+#include <yafraycore/trace.h>
 
 __BEGIN_YAFRAY
 
 #define allBSDFIntersect (BSDF_GLOSSY | BSDF_DIFFUSE | BSDF_DISPERSIVE | BSDF_REFLECT | BSDF_TRANSMIT);
-#define loffsDelta 4567 //just some number to have different sequences per light...and it's a prime even...
 
 inline color_t mcIntegrator_t::estimateAllDirectLight(renderState_t &state, const surfacePoint_t &sp, const vector3d_t &wo) const
 {
@@ -46,16 +48,13 @@ inline color_t mcIntegrator_t::estimateAllDirectLight(renderState_t &state, cons
 	return col;
 }
 
-inline color_t mcIntegrator_t::estimateOneDirectLight(renderState_t &state, const surfacePoint_t &sp, vector3d_t wo, int n) const
+inline color_t mcIntegrator_t::estimateOneDirectLight(renderState_t &state, const surfacePoint_t &sp, vector3d_t wo) const
 {
 	int lightNum = lights.size();
 	
 	if(lightNum == 0) return color_t(0.f); //??? if you get this far the lights must be >= 1 but, what the hell... :)
 	
-	Halton hal2(2);
-	hal2.setStart(n-1);
-	
-	int lnum = std::min((int)(hal2.getNext() * (float)lightNum), lightNum - 1);
+	int lnum = std::min((int)(state.sample(state.sampleIndex, SD_LIGHT_SELECT) * (float)lightNum), lightNum - 1);
 	
 	return doLightEstimation(state, lights[lnum], sp, wo, lnum) * lightNum;
 	//return col * nLights;
@@ -65,7 +64,7 @@ inline color_t mcIntegrator_t::doLightEstimation(renderState_t &state, light_t *
 {
 	color_t col(0.f);
 	bool shadowed;
-	unsigned int l_offs = loffs * loffsDelta;
+	unsigned int lDim = SD_LIGHT + 2 * loffs;
 	const material_t *material = sp.material;
 	ray_t lightRay;
 	lightRay.from = sp.P;
@@ -75,6 +74,7 @@ inline color_t mcIntegrator_t::doLightEstimation(renderState_t &state, light_t *
 	// handle lights with delta distribution, e.g. point and directional lights
 	if( light->diracLight() )
 	{
+		statCount(STAT_LIGHT_SAMPLES);
 		if( light->illuminate(sp, lcol, lightRay) )
 		{
 			// ...shadowed...
@@ -84,6 +84,7 @@ inline color_t mcIntegrator_t::doLightEstimation(renderState_t &state, light_t *
 			{
 				if(trShad) lcol *= scol;
 				color_t surfCol = material->eval(state, sp, wo, lightRay.dir, BSDF_ALL);
+				statCount(STAT_MATERIAL_EVALS);
 				color_t transmitCol = scene->volIntegrator->transmittance(state, lightRay);
 				col += surfCol * lcol * std::fabs(sp.N*lightRay.dir) * transmitCol;
 			}
@@ -91,24 +92,20 @@ inline color_t mcIntegrator_t::doLightEstimation(renderState_t &state, light_t *
 	}
 	else // area light and suchlike
 	{
-		Halton hal2(2);
-		Halton hal3(3);
 		int n = light->nSamples();
 		if(state.rayDivision > 1) n = std::max(1, n/state.rayDivision);
 		float invNS = 1.f / (float)n;
-		unsigned int offs = n * state.pixelSample + state.samplingOffs + l_offs;
+		unsigned int offs = n * state.sampleIndex;
 		bool canIntersect=light->canIntersect();
 		color_t ccol(0.0);
 		lSample_t ls;
-
-		hal2.setStart(offs-1);
-		hal3.setStart(offs-1);
+		statCount(STAT_LIGHT_SAMPLES, n);
 
 		for(int i=0; i<n; ++i)
 		{
 			// ...get sample val...
-			ls.s1 = hal2.getNext();
-			ls.s2 = hal3.getNext();
+			ls.s1 = state.sample(offs + i, lDim);
+			ls.s2 = state.sample(offs + i, lDim + 1);
 			
 			if( light->illumSample (sp, ls, lightRay) )
 			{
@@ -122,6 +119,7 @@ inline color_t mcIntegrator_t::doLightEstimation(renderState_t &state, light_t *
 					color_t transmitCol = scene->volIntegrator->transmittance(state, lightRay);
 					ls.col *= transmitCol;
 					color_t surfCol = material->eval(state, sp, wo, lightRay.dir, BSDF_ALL);
+					statCount(STAT_MATERIAL_EVALS);
 					if( canIntersect)
 					{
 						float mPdf = material->pdf(state, sp, wo, lightRay.dir, BSDF_GLOSSY | BSDF_DIFFUSE | BSDF_DISPERSIVE | BSDF_REFLECT | BSDF_TRANSMIT);
@@ -148,16 +146,13 @@ inline color_t mcIntegrator_t::doLightEstimation(renderState_t &state, light_t *
 		{
 			color_t ccol2(0.f);
 
-			hal2.setStart(offs-1);
-			hal3.setStart(offs-1);
-
 			for(int i=0; i<n; ++i)
 			{
 				ray_t bRay;
 				bRay.tmin = MIN_RAYDIST; bRay.from = sp.P;
 
-				float s1 = hal2.getNext();
-				float s2 = hal3.getNext();
+				float s1 = state.sample(offs + i, lDim);
+				float s2 = state.sample(offs + i, lDim + 1);
 				float W = 0.f;
 
 				sample_t s(s1, s2, BSDF_GLOSSY | BSDF_DIFFUSE | BSDF_DISPERSIVE | BSDF_REFLECT | BSDF_TRANSMIT);
@@ -186,6 +181,7 @@ inline color_t mcIntegrator_t::doLightEstimation(renderState_t &state, light_t *
 
 bool mcIntegrator_t::createCausticMap()
 {
+	traceScope_t ts("caustic map", "photon");
 	causticMap.clear();
 	ray_t ray;
 	std::vector<light_t *> causLights;
@@ -210,7 +206,7 @@ bool mcIntegrator_t::createCausticMap()
 		float fNumLights = (float)numLights;
 		float *energies = new float[numLights];
 		for(int i=0;i<numLights;++i) energies[i] = causLights[i]->totalEnergy().energy();
-		pdf1D_t *lightPowerD = new pdf1D_t(energies, numLights);
+		aliasPdf1D_t *lightPowerD = new aliasPdf1D_t(energies, numLights);
 		
 		Y_INFO << integratorName << ": Light(s) photon color testing for caustics map:" << yendl;
 		color_t pcol(0.f);
@@ -241,11 +237,11 @@ bool mcIntegrator_t::createCausticMap()
 		while(!done)
 		{
 			state.chromatic = true;
-			state.wavelength = RI_S(curr);
-			s1 = RI_vdC(curr);
-			s2 = scrHalton(2, curr);
-			s3 = scrHalton(3, curr);
-			s4 = scrHalton(4, curr);
+			state.wavelength = sobolSample(curr, SD_PHOTON_WAVELENGTH, CAUSTIC_PHOTON_SEED);
+			s1 = sobolSample(curr, SD_PHOTON_EMIT, CAUSTIC_PHOTON_SEED);
+			s2 = sobolSample(curr, SD_PHOTON_EMIT+1, CAUSTIC_PHOTON_SEED);
+			s3 = sobolSample(curr, SD_PHOTON_EMIT+2, CAUSTIC_PHOTON_SEED);
+			s4 = sobolSample(curr, SD_PHOTON_EMIT+3, CAUSTIC_PHOTON_SEED);
 			
 			sL = float(curr) / float(nCausPhotons);
 			
@@ -310,12 +306,11 @@ bool mcIntegrator_t::createCausticMap()
 				// need to break in the middle otherwise we scatter the photon and then discard it => redundant
 				if(nBounces == causDepth) break;
 				// scatter photon
-				int d5 = 3*nBounces + 5;
-				//int d6 = d5 + 1;
+				unsigned int d5 = SD_VERTEX + nBounces * SD_VERTEX_STRIDE;
 
-				s5 = scrHalton(d5, curr);
-				s6 = scrHalton(d5+1, curr);
-				s7 = scrHalton(d5+2, curr);
+				s5 = sobolSample(curr, d5 + SD_BSDF, CAUSTIC_PHOTON_SEED);
+				s6 = sobolSample(curr, d5 + SD_BSDF+1, CAUSTIC_PHOTON_SEED);
+				s7 = sobolSample(curr, d5 + SD_BSDF_COMP, CAUSTIC_PHOTON_SEED);
 
 				pSample_t sample(s5, s6, s7, BSDF_ALL_SPECULAR | BSDF_GLOSSY | BSDF_FILTER | BSDF_DISPERSIVE, pcol, transm);
 				bool scattered = material->scatterPhoton(state, *hit, wi, wo, sample);
@@ -393,6 +388,7 @@ inline color_t mcIntegrator_t::estimateCausticPhotons(renderState_t &state, cons
 		color_t surfCol(0.f);
 		float k = 0.f;
 		const photon_t *photon;
+		statCount(STAT_MATERIAL_EVALS, nGathered);
 
 		for(int i=0; i<nGathered; ++i)
 		{
@@ -418,8 +414,7 @@ inline void mcIntegrator_t::recursiveRaytrace(renderState_t &state, diffRay_t &r
     
 	if(state.raylevel <= rDepth)
 	{
-		Halton hal2(2);
-		Halton hal3(3);
+		unsigned int oldIndex = state.sampleIndex, oldDim = state.sampleDim;
 
 		// dispersive effects with recursive raytracing:
 		if( (bsdfs & BSDF_DISPERSIVE) && state.chromatic)
@@ -433,7 +428,7 @@ inline void mcIntegrator_t::recursiveRaytrace(renderState_t &state, diffRay_t &r
 			state.rayDivision *= dsam;
 			int branch = state.rayDivision*oldOffset;
 			float d_1 = 1.f/(float)dsam;
-			float ss1 = RI_S(state.pixelSample + state.samplingOffs);
+			float ss1 = state.sample(state.sampleIndex, SD_SPECTRAL);
 			color_t dcol(0.f), vcol(1.f);
 			vector3d_t wi;
 			const volumeHandler_t *vol;
@@ -448,6 +443,8 @@ inline void mcIntegrator_t::recursiveRaytrace(renderState_t &state, diffRay_t &r
 				if(oldDivision > 1)  state.wavelength = addMod1(state.wavelength, old_dc1);
 				state.rayOffset = branch;
 				++branch;
+				state.sampleIndex = dsam * oldIndex + ns;
+				state.sampleDim = oldDim + SD_VERTEX_STRIDE;
 				sample_t s(0.5f, 0.5f, BSDF_REFLECT|BSDF_TRANSMIT|BSDF_DISPERSIVE);
 				color_t mcol = material->sample(state, sp, wo, wi, s, W);
 				
@@ -469,6 +466,8 @@ inline void mcIntegrator_t::recursiveRaytrace(renderState_t &state, diffRay_t &r
 			}
 			
 			col += dcol * d_1;
+			state.sampleIndex = oldIndex;
+			state.sampleDim = oldDim;
 			state.rayDivision = oldDivision;
 			state.rayOffset = oldOffset;
 			state.dc1 = old_dc1;
@@ -486,26 +485,26 @@ inline void mcIntegrator_t::recursiveRaytrace(renderState_t &state, diffRay_t &r
 			if(state.rayDivision > 1) gsam = std::max(1, gsam/oldDivision);
 			state.rayDivision *= gsam;
 			int branch = state.rayDivision*oldOffset;
-			unsigned int offs = gsam * state.pixelSample + state.samplingOffs;
+			unsigned int offs = gsam * oldIndex;
 			float d_1 = 1.f/(float)gsam;
 			color_t gcol(0.f), vcol(1.f);
 			vector3d_t wi;
 			const volumeHandler_t *vol;
 			diffRay_t refRay;
 
-			hal2.setStart(offs);
-			hal3.setStart(offs);
-
 			for(int ns=0; ns<gsam; ++ns)
 			{
 				state.dc1 = scrHalton(2*state.raylevel+1, branch + state.samplingOffs);
 				state.dc2 = scrHalton(2*state.raylevel+2, branch + state.samplingOffs);
 				state.rayOffset = branch;
-				++offs;
 				++branch;
 
-				float s1 = hal2.getNext();
-				float s2 = hal3.getNext();
+				state.sampleDim = oldDim;
+				float s1 = state.sample(offs + ns, SD_BSDF);
+				float s2 = state.sample(offs + ns, SD_BSDF+1);
+				// the glossy ray starts a new path vertex
+				state.sampleIndex = offs + ns;
+				state.sampleDim = oldDim + SD_VERTEX_STRIDE;
 				
 				float W = 0.f;
 
@@ -527,6 +526,8 @@ inline void mcIntegrator_t::recursiveRaytrace(renderState_t &state, diffRay_t &r
 			}
 
 			col += gcol * d_1;
+			state.sampleIndex = oldIndex;
+			state.sampleDim = oldDim;
 			state.rayDivision = oldDivision;
 			state.rayOffset = oldOffset;
 			state.dc1 = old_dc1;
@@ -537,6 +538,7 @@ inline void mcIntegrator_t::recursiveRaytrace(renderState_t &state, diffRay_t &r
 		if(bsdfs & (BSDF_SPECULAR | BSDF_FILTER) && state.raylevel < 20)
 		{
 			state.includeLights = true;
+			state.sampleDim = oldDim + SD_VERTEX_STRIDE;
 			bool reflect=false, refract=false;
 			vector3d_t dir[2];
 			color_t rcol[2], vcol;
@@ -569,6 +571,7 @@ inline void mcIntegrator_t::recursiveRaytrace(renderState_t &state, diffRay_t &r
 				col += (color_t)integ * rcol[1];
 				alpha = integ.A;
 			}
+			state.sampleDim = oldDim;
 		}
 
 	}
@@ -586,18 +589,12 @@ color_t mcIntegrator_t::sampleAmbientOcclusion(renderState_t &state, const surfa
 	int n = aoSamples;
 	if(state.rayDivision > 1) n = std::max(1, n / state.rayDivision);
 
-	unsigned int offs = n * state.pixelSample + state.samplingOffs;
-	
-	Halton hal2(2);
-	Halton hal3(3);
-
-	hal2.setStart(offs-1);
-	hal3.setStart(offs-1);
+	unsigned int offs = n * state.sampleIndex;
 
 	for(int i = 0; i < n; ++i)
 	{
-		float s1 = hal2.getNext();
-		float s2 = hal3.getNext();
+		float s1 = state.sample(offs + i, SD_BSDF);
+		float s2 = state.sample(offs + i, SD_BSDF+1);
 		
 		if(state.rayDivision > 1)
 		{
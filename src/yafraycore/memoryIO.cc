@@ -3,6 +3,7 @@
 #include <core_api/output.h>
 #include <yafraycore/memoryIO.h>
 #include <cstdlib>
+#include <cstring>
 
 __BEGIN_YAFRAY
 
@@ -25,6 +26,24 @@ bool memoryIO_t::putPixel ( int x, int y, const float *c, bool alpha, bool depth
 	return true;
 }
 
+bool memoryIO_t::putArea(int x0, int y0, int w, int h, const float *c, int stride, bool alpha, const float *z, int zStride)
+{
+	for(int j = 0; j < h; ++j)
+	{
+		float *dst = imageMem + (x0 + sizex * (y0 + j)) * 4;
+		const float *src = c + j * stride;
+		if(alpha) memcpy(dst, src, w * 4 * sizeof(float));
+		else
+		{
+			for(int i = 0; i < w * 4; i += 4)
+			{
+				dst[i] = src[i]; dst[i+1] = src[i+1]; dst[i+2] = src[i+2]; dst[i+3] = 1.f;
+			}
+		}
+	}
+	return true;
+}
+
 void memoryIO_t::flush() { }
 
 memoryIO_t::~memoryIO_t() { }
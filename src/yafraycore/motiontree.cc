@@ -0,0 +1,56 @@
+#include <yafraycore/motiontree.h>
+#include <yafraycore/triangle.h>
+
+__BEGIN_YAFRAY
+
+// summed half surface of the primitive bounds, averaged over nSeg equal time segments
+template<class T> static double motionBoundArea(const T **v, int np, int nSeg)
+{
+	double area = 0.0;
+	for(int s=0; s<nSeg; ++s)
+	{
+		PFLOAT t0 = (PFLOAT)s / nSeg, t1 = (PFLOAT)(s+1) / nSeg;
+		for(int i=0; i<np; ++i)
+		{
+			bound_t b = v[i]->getMotionBound(t0, t1);
+			double x = b.longX(), y = b.longY(), z = b.longZ();
+			area += x*y + y*z + z*x;
+		}
+	}
+	return area / nSeg;
+}
+
+template<class T>
+motionTree_t<T>::motionTree_t(const T **v, int np, int maxSegments)
+{
+	int nSeg = 1;
+	double area = motionBoundArea(v, np, 1);
+	while(2*nSeg <= maxSegments)
+	{
+		double nextArea = motionBoundArea(v, np, 2*nSeg);
+		// each segment costs a tree build and the memory of a tree, so demand a clear gain
+		if(nextArea > 0.8 * area) break;
+		area = nextArea;
+		nSeg *= 2;
+	}
+	Y_INFO << "MotionTree: " << np << " moving prims, " << nSeg << " time segments" << yendl;
+
+	segments.resize(nSeg);
+	for(int s=0; s<nSeg; ++s)
+	{
+		segments[s] = new kdTree_t<T>(v, np, -1, 1, 0.8, 0.33, (PFLOAT)s / nSeg, (PFLOAT)(s+1) / nSeg);
+		treeBound = s ? bound_t(treeBound, segments[s]->getBound()) : segments[s]->getBound();
+	}
+}
+
+template<class T>
+motionTree_t<T>::~motionTree_t()
+{
+	for(size_t i=0; i<segments.size(); ++i) delete segments[i];
+}
+
+// explicit instantiation of template:
+template class motionTree_t<triangle_t>;
+template class motionTree_t<primitive_t>;
+
+__END_YAFRAY
@@ -62,6 +62,7 @@ void nodeMaterial_t::solveNodesOrder(const std::vector<shaderNode_t *> &roots)
 	//set all IDs = 0 to indicate "not tested yet"
 	for(unsigned int i=0; i<allNodes.size(); ++i) allNodes[i]->ID=0;
 	for(unsigned int i=0; i<roots.size(); ++i) recursiveSolver(roots[i], allSorted);
+	rootNodes.assign(roots.begin(), roots.end());
 	if(allNodes.size() != allSorted.size()) Y_WARNING << "NodeMaterial: Unreachable nodes!" << yendl;
 	//give the nodes an index to be used as the "stack"-index. 
 	//using the order of evaluation can't hurt, can it?
@@ -77,6 +78,130 @@ void nodeMaterial_t::solveNodesOrder(const std::vector<shaderNode_t *> &roots)
 	reqNodeMem = allSorted.size() * sizeof(nodeResult_t);
 }
 
+void nodeMaterial_t::compileNodes()
+{
+	size_t n = allSorted.size();
+	if(n == 0) return;
+	constNode.assign(n, false);
+	constResult.assign(n, nodeResult_t(colorA_t(0.f), 0.f));
+
+	// allSorted is in evaluation order, so dependencies are always decided before the nodes using them
+	renderState_t state;
+	surfacePoint_t sp;
+	nodeStack_t stack(&constResult[0]);
+	int nConst = 0;
+	for(size_t i=0; i<n; ++i)
+	{
+		shaderNode_t *node = allSorted[i];
+		if(!node->isConstant()) continue;
+		std::vector<const shaderNode_t*> deps;
+		bool depsConst = true;
+		if(node->getDependencies(deps))
+		{
+			for(unsigned int j=0; j<deps.size(); ++j) depsConst = depsConst && isConstantNode(deps[j]);
+		}
+		if(!depsConst) continue;
+		node->eval(stack, state, sp);
+		constNode[node->ID] = true;
+		++nConst;
+	}
+
+	compileProgram(rootNodes, rootNodes, allSorted, progSorted);
+	compileProgram(rootNodes, rootNodes, allViewindep, progViewindep);
+
+	if(nConst > 0) Y_INFO << "NodeMaterial: Folded " << nConst << " of " << n << " shader nodes into constants" << yendl;
+}
+
+void nodeMaterial_t::compileProgram(const std::vector<const shaderNode_t *> &colorOutputs, const std::vector<const shaderNode_t *> &scalarOutputs,
+									const std::vector<shaderNode_t *> &nodes, nodeProgram_t &prog) const
+{
+	prog.code.clear();
+	size_t n = allSorted.size();
+	if(n == 0) return;
+	// parts of the node results that are read, and whether they are read from the stack
+	std::vector<int> need(n, 0);
+	std::vector<bool> stored(n, false);
+	for(unsigned int i=0; i<colorOutputs.size(); ++i)
+	{
+		const shaderNode_t *node = colorOutputs[i];
+		if(node) { need[node->ID] |= NV_COLOR; stored[node->ID] = true; }
+	}
+	for(unsigned int i=0; i<scalarOutputs.size(); ++i)
+	{
+		const shaderNode_t *node = scalarOutputs[i];
+		if(node) { need[node->ID] |= NV_SCALAR; stored[node->ID] = true; }
+	}
+
+	// the needs go through all nodes in evaluation order, going backwards every node is decided
+	// before its inputs; a root missing from a filtered list (e.g. a view dependent one) still
+	// marks the inputs it reads from the list
+	std::vector<nodeOp_t> ops(n);
+	for(int i=(int)n-1; i>=0; --i)
+	{
+		const shaderNode_t *node = allSorted[i];
+		int nodeNeed = need[node->ID];
+		if(!nodeNeed || isConstantNode(node)) continue;
+		nodeOp_t &op = ops[node->ID];
+		int reads[3] = { 0, 0, 0 };
+		if(!node->getOp(op)) op.code = NOP_EVAL;
+		switch(op.code)
+		{
+			case NOP_MIX:
+				reads[0] = reads[1] = nodeNeed;
+				reads[2] = NV_SCALAR;
+				break;
+			case NOP_LAYER:
+				reads[0] = (op.flags & TXF_COLORINPUT) ? NV_COLOR : NV_SCALAR;
+				// the stencil comes from the alpha of the upper layer
+				reads[1] = NV_COLOR | (nodeNeed & NV_SCALAR);
+				break;
+			case NOP_CONST:
+				break;
+			default:
+			{
+				// eval() reads whole results from the stack
+				std::vector<const shaderNode_t*> deps;
+				node->getDependencies(deps);
+				for(unsigned int j=0; j<deps.size(); ++j)
+				{
+					need[deps[j]->ID] = NV_BOTH;
+					stored[deps[j]->ID] = true;
+				}
+			}
+		}
+		for(int j=0; j<3; ++j) if(reads[j] && op.in[j]) need[op.in[j]->ID] |= reads[j];
+	}
+
+	for(unsigned int i=0; i<nodes.size(); ++i)
+	{
+		const shaderNode_t *node = nodes[i];
+		unsigned int id = node->ID;
+		if(!need[id]) continue;
+		nodeInstr_t ins;
+		ins.dst = id;
+		ins.need = need[id];
+		ins.node = node;
+		if(isConstantNode(node))
+		{
+			if(!stored[id]) continue;
+			ins.op.code = NOP_CONST;
+			ins.op.konst[0] = constResult[id];
+		}
+		else
+		{
+			ins.op = ops[id];
+			for(int j=0; j<3; ++j)
+			{
+				const shaderNode_t *in = ins.op.in[j];
+				if(!in) continue;
+				if(isConstantNode(in)) ins.op.konst[j] = constResult[in->ID];
+				else ins.reg[j] = in->ID;
+			}
+		}
+		prog.code.push_back(ins);
+	}
+}
+
 /*! get a list of all nodes that are in the tree given by root
 	prerequisite: nodes have been successfully loaded and stored into allSorted
 	since "solveNodesOrder" sorts allNodes, calling getNodeList afterwards gives
@@ -1,12 +1,15 @@
 #include <yafraycore/meshtypes.h>
 #include <cstdlib>
+#include <algorithm>
+#include <limits>
 
 __BEGIN_YAFRAY
 
 triangleObject_t::triangleObject_t(int ntris, bool hasUV, bool hasOrco):
-    has_orco(hasOrco), has_uv(hasUV), is_smooth(false), normals_exported(false)
+    normals_shift(0), has_orco(hasOrco), has_uv(hasUV), is_smooth(false), normals_exported(false)
 {
 	triangles.reserve(ntris);
+	material_ids.reserve(ntris);
 	if(hasUV)
 	{
 		uv_offsets.reserve(ntris);
@@ -31,19 +34,37 @@ int triangleObject_t::getPrimitives(const triangle_t **prims)
 	return triangles.size();
 }
 
-triangle_t* triangleObject_t::addTriangle(const triangle_t &t)
+triangle_t* triangleObject_t::addTriangle(const triangle_t &t, const material_t *mat)
 {
+	// meshes mostly use few materials, often in runs, so check the last one first
+	size_t id = material_ids.empty() ? 0 : material_ids.back();
+	if(id >= materials.size() || materials[id] != mat)
+	{
+		id = std::find(materials.begin(), materials.end(), mat) - materials.begin();
+		if(id == materials.size())
+		{
+			if(id > std::numeric_limits<unsigned short>::max())
+			{
+				Y_WARNING << "Mesh: More than " << id << " materials in one mesh, using the first one instead" << yendl;
+				id = 0;
+			}
+			else materials.push_back(mat);
+		}
+	}
 	triangles.push_back(t);
-	triangles.back().selfIndex = triangles.size() - 1;
+	material_ids.push_back(id);
 	return &(triangles.back());
 }
 
 void triangleObject_t::finish()
 {
-	for(std::vector<triangle_t>::iterator i=triangles.begin(); i!= triangles.end(); ++i)
-	{
-		(*i).recNormal();
-	}
+	// the geometric normals are computed on demand, see triangle_t::getNormal()
+}
+
+size_t triangleObject_t::triangleMemory() const
+{
+	return triangles.capacity() * sizeof(triangle_t) + material_ids.capacity() * sizeof(unsigned short) +
+		uv_offsets.capacity() * sizeof(int) + normal_offsets.capacity() * sizeof(int);
 }
 
 // triangleObjectInstance_t Methods
@@ -51,7 +72,27 @@ void triangleObject_t::finish()
 triangleObjectInstance_t::triangleObjectInstance_t(triangleObject_t *base, matrix4x4_t obj2World)
 {
 	objToWorld = obj2World;
+	objToWorldEnd = obj2World;
+	moving = false;
 	mBase = base;
+	init();
+}
+
+triangleObjectInstance_t::triangleObjectInstance_t(triangleObject_t *base, matrix4x4_t obj2World, matrix4x4_t obj2WorldEnd)
+{
+	objToWorld = obj2World;
+	objToWorldEnd = obj2WorldEnd;
+	moving = false;
+	for(int i=0; i<4; ++i) for(int j=0; j<4; ++j)
+	{
+		if(obj2World[i][j] != obj2WorldEnd[i][j]) moving = true;
+	}
+	mBase = base;
+	init();
+}
+
+void triangleObjectInstance_t::init()
+{
 	has_orco = mBase->has_orco;
 	has_uv = mBase->has_uv;
 	is_smooth = mBase->is_smooth;
@@ -118,7 +159,7 @@ primitive_t* meshObject_t::addTriangle(const vTriangle_t &t)
 primitive_t* meshObject_t::addBsTriangle(const bsTriangle_t &t)
 {
 	s_triangles.push_back(t);
-	return &(triangles.back());
+	return &(s_triangles.back());
 }
 
 void meshObject_t::finish()
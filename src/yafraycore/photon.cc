@@ -1,5 +1,6 @@
 
 #include <yafraycore/photon.h>
+#include <yafraycore/renderstats.h>
 
 __BEGIN_YAFRAY
 
@@ -62,6 +63,7 @@ void photonMap_t::updateTree()
 int photonMap_t::gather(const point3d_t &P, foundPhoton_t *found, unsigned int K, PFLOAT &sqRadius) const
 {
 	photonGather_t proc(K, P);
+	statCount(STAT_PHOTON_GATHERS);
 	proc.photons = found;
 	tree->lookup(P, proc, sqRadius);
 	return proc.foundPhotons;
@@ -1,8 +1,11 @@
 // search for "todo" and "IMPLEMENT" and "<<" or ">>"...
 
 #include <yafraycore/ray_kdtree.h>
+#include <yafraycore/triangle.h>
+#include <yafraycore/std_primitives.h>
 #include <core_api/material.h>
 #include <core_api/scene.h>
+#include <yafraycore/renderstats.h>
 #include <stdexcept>
 //#include <math.h>
 #include <limits>
@@ -55,6 +58,282 @@ inline int Y_Float2Int(double val) {
 #endif
 }
 
+// leaves of universal mode trees get the primitives bucketed by shape, see primLeaf_t
+template<>
+void rkdTreeNode<primitive_t>::createLeaf(u_int32 *primIdx, int np, const primitive_t **prims, MemoryArena &arena)
+{
+	leaf = 0;
+	flags = np << 2;
+	flags |= 3;
+	if(np>0)
+	{
+		point3d_t p[3];
+		PFLOAT r;
+		u_int32 nTris=0, nSpheres=0;
+		for(int i=0;i<np;i++)
+		{
+			int shape = prims[primIdx[i]]->getShape(p, r);
+			if(shape == PRIM_TRIANGLE) ++nTris;
+			else if(shape == PRIM_SPHERE) ++nSpheres;
+		}
+		u_int32 nOther = np - nTris - nSpheres;
+		leaf = (primLeaf_t *)arena.Alloc(sizeof(primLeaf_t) + nTris * sizeof(kdTriangle_t)
+										+ nSpheres * sizeof(kdSphere_t) + nOther * sizeof(primitive_t *));
+		leaf->nTris = nTris, leaf->nSpheres = nSpheres, leaf->nOther = nOther;
+		kdTriangle_t *tris = (kdTriangle_t *)leaf->tris();
+		kdSphere_t *spheres = (kdSphere_t *)leaf->spheres();
+		primitive_t **others = (primitive_t **)leaf->others();
+		// keep the order of the primitives within each bucket
+		for(int i=0;i<np;i++)
+		{
+			primitive_t *prim = (primitive_t *)prims[primIdx[i]];
+			switch(prim->getShape(p, r))
+			{
+				case PRIM_TRIANGLE:
+					tris->a = p[0];
+					tris->edge1 = p[1] - p[0];
+					tris->edge2 = p[2] - p[0];
+					tris->prim = prim;
+					++tris;
+					break;
+				case PRIM_SPHERE:
+					spheres->center = p[0];
+					spheres->radius = r;
+					spheres->prim = prim;
+					++spheres;
+					break;
+				default: *others++ = prim;
+			}
+		}
+		Kd_prims+=np; //stat
+	}
+	else _emptyKd_leaves++; //stat
+	Kd_leaves++; //stat
+}
+
+// ============================================================
+/*! leaf tests of the traversal functions. The templates call the virtual intersect()
+	of each primitive, the overloads for universal mode trees run the bucketed leaves
+	through the inlined triangle and sphere tests first.
+*/
+
+//! closest hit in [tmin, Z), updates Z, tr and data
+template<class T>
+static inline bool leafIntersect(const rkdTreeNode<T> *node, const ray_t &ray, PFLOAT &Z, T **tr, intersectData_t &data, kdQueryStats_t &qs)
+{
+	bool hit = false;
+	PFLOAT t_hit;
+	intersectData_t tempData;
+	u_int32 nPrimitives = node->nPrimitives();
+	T * const *prims = (nPrimitives == 1) ? &node->onePrimitive : node->primitives;
+	for (u_int32 i = 0; i < nPrimitives; ++i) {
+		T *mp = prims[i];
+		++qs.tests;
+		if (mp->intersect(ray, &t_hit, tempData))
+		{
+			if(t_hit < Z && t_hit >= ray.tmin)
+			{
+				Z = t_hit;
+				*tr = mp;
+				data = tempData;
+				hit = true;
+			}
+		}
+	}
+	return hit;
+}
+
+static inline bool leafIntersect(const rkdTreeNode<primitive_t> *node, const ray_t &ray, PFLOAT &Z, primitive_t **tr, intersectData_t &data, kdQueryStats_t &qs)
+{
+	const primLeaf_t *leaf = node->leaf;
+	if(!leaf) return false;
+	bool hit = false;
+	PFLOAT t_hit;
+	intersectData_t tempData;
+	const kdTriangle_t *tris = leaf->tris();
+	for (u_int32 i = 0; i < leaf->nTris; ++i) {
+		++qs.tests;
+		if (intersectTriangle(tris[i].a, tris[i].edge1, tris[i].edge2, ray, &t_hit, tempData))
+		{
+			if(t_hit < Z && t_hit >= ray.tmin)
+			{
+				Z = t_hit;
+				*tr = tris[i].prim;
+				data = tempData;
+				hit = true;
+			}
+		}
+	}
+	const kdSphere_t *spheres = leaf->spheres();
+	for (u_int32 i = 0; i < leaf->nSpheres; ++i) {
+		++qs.tests;
+		if (intersectSphere(spheres[i].center, spheres[i].radius, ray, &t_hit))
+		{
+			if(t_hit < Z && t_hit >= ray.tmin)
+			{
+				Z = t_hit;
+				*tr = spheres[i].prim;
+				data = tempData;
+				hit = true;
+			}
+		}
+	}
+	primitive_t * const *others = leaf->others();
+	for (u_int32 i = 0; i < leaf->nOther; ++i) {
+		primitive_t *mp = others[i];
+		++qs.tests;
+		if (mp->intersect(ray, &t_hit, tempData))
+		{
+			if(t_hit < Z && t_hit >= ray.tmin)
+			{
+				Z = t_hit;
+				*tr = mp;
+				data = tempData;
+				hit = true;
+			}
+		}
+	}
+	return hit;
+}
+
+//! any hit in (tmin, dist)
+template<class T>
+static inline bool leafIntersectS(const rkdTreeNode<T> *node, const ray_t &ray, PFLOAT dist, T **tr, kdQueryStats_t &qs)
+{
+	PFLOAT t_hit;
+	intersectData_t bary;
+	u_int32 nPrimitives = node->nPrimitives();
+	T * const *prims = (nPrimitives == 1) ? &node->onePrimitive : node->primitives;
+	for (u_int32 i = 0; i < nPrimitives; ++i)
+	{
+		T *mp = prims[i];
+		++qs.tests;
+		if (mp->intersect(ray, &t_hit, bary))
+		{
+			if(t_hit < dist && t_hit > ray.tmin )
+			{
+				*tr = mp;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static inline bool leafIntersectS(const rkdTreeNode<primitive_t> *node, const ray_t &ray, PFLOAT dist, primitive_t **tr, kdQueryStats_t &qs)
+{
+	const primLeaf_t *leaf = node->leaf;
+	if(!leaf) return false;
+	PFLOAT t_hit;
+	intersectData_t bary;
+	const kdTriangle_t *tris = leaf->tris();
+	for (u_int32 i = 0; i < leaf->nTris; ++i)
+	{
+		++qs.tests;
+		if (intersectTriangle(tris[i].a, tris[i].edge1, tris[i].edge2, ray, &t_hit, bary) && t_hit < dist && t_hit > ray.tmin)
+		{
+			*tr = tris[i].prim;
+			return true;
+		}
+	}
+	const kdSphere_t *spheres = leaf->spheres();
+	for (u_int32 i = 0; i < leaf->nSpheres; ++i)
+	{
+		++qs.tests;
+		if (intersectSphere(spheres[i].center, spheres[i].radius, ray, &t_hit) && t_hit < dist && t_hit > ray.tmin)
+		{
+			*tr = spheres[i].prim;
+			return true;
+		}
+	}
+	primitive_t * const *others = leaf->others();
+	for (u_int32 i = 0; i < leaf->nOther; ++i)
+	{
+		++qs.tests;
+		if (others[i]->intersect(ray, &t_hit, bary) && t_hit < dist && t_hit > ray.tmin)
+		{
+			*tr = others[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+/*! hit of a transparent shadow ray in [tmin, dist): multiplies the transparency into filt
+	once per primitive; true if the hit blocks the ray */
+template<class T, class S>
+static inline bool shadowHit(T *mp, PFLOAT t_hit, intersectData_t &bary, renderState_t &state, const ray_t &ray,
+							int maxDepth, int &depth, S &filtered, color_t &filt)
+{
+	const material_t *mat = mp->getMaterial();
+	if(!mat->isTransparent() ) return true;
+	if(filtered.insert(mp).second)
+	{
+		if(depth>=maxDepth) return true;
+		point3d_t h=ray.from + t_hit*ray.dir;
+		surfacePoint_t sp;
+		mp->getSurface(sp, h, bary);
+		filt *= mat->getTransparency(state, sp, ray.dir);
+		++depth;
+	}
+	return false;
+}
+
+template<class T, class S>
+static inline bool leafIntersectTS(const rkdTreeNode<T> *node, renderState_t &state, const ray_t &ray, int maxDepth, PFLOAT dist,
+									int &depth, S &filtered, color_t &filt, kdQueryStats_t &qs)
+{
+	PFLOAT t_hit;
+	intersectData_t bary;
+	u_int32 nPrimitives = node->nPrimitives();
+	T * const *prims = (nPrimitives == 1) ? &node->onePrimitive : node->primitives;
+	for (u_int32 i = 0; i < nPrimitives; ++i) {
+		T *mp = prims[i];
+		++qs.tests;
+		if (mp->intersect(ray, &t_hit, bary))
+		{
+			if(t_hit < dist && t_hit >= ray.tmin && shadowHit(mp, t_hit, bary, state, ray, maxDepth, depth, filtered, filt)) return true;
+		}
+	}
+	return false;
+}
+
+template<class S>
+static inline bool leafIntersectTS(const rkdTreeNode<primitive_t> *node, renderState_t &state, const ray_t &ray, int maxDepth, PFLOAT dist,
+									int &depth, S &filtered, color_t &filt, kdQueryStats_t &qs)
+{
+	const primLeaf_t *leaf = node->leaf;
+	if(!leaf) return false;
+	PFLOAT t_hit;
+	intersectData_t bary;
+	const kdTriangle_t *tris = leaf->tris();
+	for (u_int32 i = 0; i < leaf->nTris; ++i) {
+		++qs.tests;
+		if (intersectTriangle(tris[i].a, tris[i].edge1, tris[i].edge2, ray, &t_hit, bary))
+		{
+			if(t_hit < dist && t_hit >= ray.tmin && shadowHit(tris[i].prim, t_hit, bary, state, ray, maxDepth, depth, filtered, filt)) return true;
+		}
+	}
+	const kdSphere_t *spheres = leaf->spheres();
+	for (u_int32 i = 0; i < leaf->nSpheres; ++i) {
+		++qs.tests;
+		if (intersectSphere(spheres[i].center, spheres[i].radius, ray, &t_hit))
+		{
+			if(t_hit < dist && t_hit >= ray.tmin && shadowHit(spheres[i].prim, t_hit, bary, state, ray, maxDepth, depth, filtered, filt)) return true;
+		}
+	}
+	primitive_t * const *others = leaf->others();
+	for (u_int32 i = 0; i < leaf->nOther; ++i) {
+		primitive_t *mp = others[i];
+		++qs.tests;
+		if (mp->intersect(ray, &t_hit, bary))
+		{
+			if(t_hit < dist && t_hit >= ray.tmin && shadowHit(mp, t_hit, bary, state, ray, maxDepth, depth, filtered, filt)) return true;
+		}
+	}
+	return false;
+}
+
 //still in old file...
 //int Kd_inodes=0, Kd_leaves=0, _emptyKd_leaves=0, Kd_prims=0, _clip=0, _bad_clip=0, _null_clip=0, _early_out=0;
 
@@ -64,7 +343,7 @@ inline int Y_Float2Int(double val) {
 
 template<class T>
 kdTree_t<T>::kdTree_t(const T **v, int np, int depth, int leafSize,
-			float cost_ratio, float emptyBonus)
+			float cost_ratio, float emptyBonus, PFLOAT t0, PFLOAT t1)
 	: costRatio(cost_ratio), eBonus(emptyBonus), maxDepth(depth)
 {
 	std::cout << "starting build of kd-tree ("<<np<<" prims, cr:"<<costRatio<<" eb:"<<eBonus<<")\n";
@@ -93,7 +372,7 @@ kdTree_t<T>::kdTree_t(const T **v, int np, int depth, int leafSize,
 	std::cout << "getting triangle bounds...";
 	for(u_int32 i=0; i<totalPrims; i++)
 	{
-		allBounds[i] = v[i]->getBound();
+		allBounds[i] = v[i]->getMotionBound(t0, t1);
 		/* calc tree bound. Remember to upgrade bound_t class... */
 		if(i) treeBound = bound_t(treeBound, allBounds[i]);
 		else treeBound = allBounds[i];
@@ -690,15 +969,15 @@ int kdTree_t<T>::buildTree(u_int32 nPrims, bound_t &nodeBound, u_int32 *primNums
 template<class T>
 bool kdTree_t<T>::Intersect(const ray_t &ray, PFLOAT dist, T **tr, PFLOAT &Z, intersectData_t &data) const
 {
+	kdQueryStats_t qs(false);
 	Z=dist;
 	
 	PFLOAT a, b, t; // entry/exit/splitting plane signed distance
-	PFLOAT t_hit;
 	
 	if (!treeBound.cross(ray, a, b, dist))
 	{ return false; }
 	
-	intersectData_t currentData, tempData;
+	intersectData_t currentData;
 	vector3d_t invDir(1.0/ray.dir.x, 1.0/ray.dir.y, 1.0/ray.dir.z); //was 1.f!
 //	int rayId = curMailboxId++;
 	bool hit = false;
@@ -729,6 +1008,7 @@ bool kdTree_t<T>::Intersect(const ray_t &ray, PFLOAT dist, T **tr, PFLOAT &Z, in
 		// loop until leaf is found
 		while( !currNode->IsLeaf() )
 		{
+			++qs.nodes;
 			int axis = currNode->SplitAxis();
 			PFLOAT splitVal = currNode->SplitPos();
 			
@@ -779,38 +1059,8 @@ bool kdTree_t<T>::Intersect(const ray_t &ray, PFLOAT dist, T **tr, PFLOAT &Z, in
 			stack[exPt].pb[prevAxis] = ray.from[prevAxis] + t * ray.dir[prevAxis];
 		}
 				 
-		u_int32 nPrimitives = currNode->nPrimitives();
-		if (nPrimitives == 1)
-		{
-			T *mp = currNode->onePrimitive;
-			if (mp->intersect(ray, &t_hit, tempData))
-			{
-				if(t_hit < Z && t_hit >= ray.tmin)
-				{
-					Z = t_hit;
-					*tr = mp;
-					currentData = tempData;
-					hit = true;
-				}
-			}
-		}
-		else
-		{
-			T **prims = currNode->primitives;
-			for (u_int32 i = 0; i < nPrimitives; ++i) {
-				T *mp = prims[i];
-				if (mp->intersect(ray, &t_hit, tempData))
-				{
-					if(t_hit < Z && t_hit >= ray.tmin)
-					{
-						Z = t_hit;
-						*tr = mp;
-						currentData = tempData;
-						hit = true;
-					}
-				}
-			}
-		}
+		++qs.nodes;
+		if(leafIntersect(currNode, ray, Z, tr, currentData, qs)) hit = true;
 		
 		if(hit && Z <= stack[exPt].t)
 		{
@@ -832,13 +1082,12 @@ bool kdTree_t<T>::Intersect(const ray_t &ray, PFLOAT dist, T **tr, PFLOAT &Z, in
 template<class T>
 bool kdTree_t<T>::IntersectS(const ray_t &ray, PFLOAT dist, T **tr) const
 {
+	kdQueryStats_t qs(true);
 	PFLOAT a, b, t; // entry/exit/splitting plane signed distance
-	PFLOAT t_hit;
 	
 	if (!treeBound.cross(ray, a, b, dist))
 		return false;
 	
-	intersectData_t bary;
 	vector3d_t invDir(1.f/ray.dir.x, 1.f/ray.dir.y, 1.f/ray.dir.z);
 	
 	rKdStack<T> stack[KD_MAX_STACK];
@@ -867,6 +1116,7 @@ bool kdTree_t<T>::IntersectS(const ray_t &ray, PFLOAT dist, T **tr) const
 		// loop until leaf is found
 		while( !currNode->IsLeaf() )
 		{
+			++qs.nodes;
 			int axis = currNode->SplitAxis();
 			PFLOAT splitVal = currNode->SplitPos();
 			
@@ -918,35 +1168,8 @@ bool kdTree_t<T>::IntersectS(const ray_t &ray, PFLOAT dist, T **tr) const
 		}
 				 
 		// Check for intersections inside leaf node
-		u_int32 nPrimitives = currNode->nPrimitives();
-		if (nPrimitives == 1)
-		{
-			T *mp = currNode->onePrimitive;
-			if (mp->intersect(ray, &t_hit, bary))
-			{
-				if(t_hit < dist && t_hit > ray.tmin )
-				{
-					*tr = mp;
-					return true;
-				}
-			}
-		}
-		else
-		{
-			T **prims = currNode->primitives;
-			for (u_int32 i = 0; i < nPrimitives; ++i)
-			{
-				T *mp = prims[i];
-					if (mp->intersect(ray, &t_hit, bary))
-					{
-						if(t_hit < dist && t_hit > ray.tmin )
-						{
-							*tr = mp;
-							return true;
-						}
-					}
-			}
-		}
+		++qs.nodes;
+		if(leafIntersectS(currNode, ray, dist, tr, qs)) return true;
 		
 		enPt = exPt;
 		currNode = stack[exPt].node;
@@ -962,18 +1185,18 @@ bool kdTree_t<T>::IntersectS(const ray_t &ray, PFLOAT dist, T **tr) const
 =============================================================*/
 
 template<class T>
-bool kdTree_t<T>::IntersectTS(renderState_t &state, const ray_t &ray, int maxDepth, PFLOAT dist, T **tr, color_t &filt) const
+bool kdTree_t<T>::IntersectTS(renderState_t &state, const ray_t &ray, int maxDepth, PFLOAT dist, T **tr, color_t &filt, int *layers) const
 {
+	kdQueryStats_t qs(true);
 	PFLOAT a, b, t; // entry/exit/splitting plane signed distance
-	PFLOAT t_hit;
 	
 	if (!treeBound.cross(ray, a, b, dist))
 		return false;
 	
-	intersectData_t bary;
 	vector3d_t invDir(1.f/ray.dir.x, 1.f/ray.dir.y, 1.f/ray.dir.z);
 
-	int depth=0;
+	int ownDepth=0;
+	int &depth = layers ? *layers : ownDepth;
 #if ( HAVE_PTHREAD && defined (__GNUC__) )
 	std::set<const T *, std::less<const T *>, __gnu_cxx::__mt_alloc<const T *> > filtered;
 #else
@@ -1005,6 +1228,7 @@ bool kdTree_t<T>::IntersectTS(renderState_t &state, const ray_t &ray, int maxDep
 		// loop until leaf is found
 		while( !currNode->IsLeaf() )
 		{
+			++qs.nodes;
 			int axis = currNode->SplitAxis();
 			PFLOAT splitVal = currNode->SplitPos();
 			
@@ -1056,52 +1280,8 @@ bool kdTree_t<T>::IntersectTS(renderState_t &state, const ray_t &ray, int maxDep
 		}
 				 
 		// Check for intersections inside leaf node
-		u_int32 nPrimitives = currNode->nPrimitives();
-		if (nPrimitives == 1)
-		{
-			T *mp = currNode->onePrimitive;
-			if (mp->intersect(ray, &t_hit, bary))
-			{
-				if(t_hit < dist && t_hit >= ray.tmin )
-				{
-					const material_t *mat = mp->getMaterial();
-					if(!mat->isTransparent() ) return true;
-					if(filtered.insert(mp).second)
-					{
-						if(depth>=maxDepth) return true;
-						point3d_t h=ray.from + t_hit*ray.dir;
-						surfacePoint_t sp;
-						mp->getSurface(sp, h, bary);
-						filt *= mat->getTransparency(state, sp, ray.dir);
-						++depth;
-					}
-				}
-			}
-		}
-		else 
-		{
-			T **prims = currNode->primitives;
-			for (u_int32 i = 0; i < nPrimitives; ++i) {
-				T *mp = prims[i];
-				if (mp->intersect(ray, &t_hit, bary))
-				{
-					if(t_hit < dist && t_hit >= ray.tmin )
-					{
-						const material_t *mat = mp->getMaterial();
-						if(!mat->isTransparent() ) return true;
-						if(filtered.insert(mp).second)
-						{
-							if(depth>=maxDepth) return true;
-							point3d_t h=ray.from + t_hit*ray.dir;
-							surfacePoint_t sp;
-							mp->getSurface(sp, h, bary);
-							filt *= mat->getTransparency(state, sp, ray.dir);
-							++depth;
-						}
-					}
-				}
-			}
-		}
+		++qs.nodes;
+		if(leafIntersectTS(currNode, state, ray, maxDepth, dist, depth, filtered, filt, qs)) return true;
 		
 		enPt = exPt;
 		currNode = stack[exPt].node;
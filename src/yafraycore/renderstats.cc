@@ -0,0 +1,180 @@
+#include <yafraycore/renderstats.h>
+
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+__BEGIN_YAFRAY
+
+renderStats_t gStats;
+bool renderStats_t::enabled = false;
+
+// the counter block of the calling thread, valid while localGeneration matches the global one
+static Y_THREAD_LOCAL threadStats_t *localStats = 0;
+static Y_THREAD_LOCAL unsigned int localGeneration = 0;
+
+void threadStats_t::clear()
+{
+	memset(counters, 0, sizeof(counters));
+	pendingPrimary = false;
+}
+
+renderStats_t::renderStats_t(): blocks(mutex), passes(0) {}
+
+renderStats_t::~renderStats_t() {}
+
+static void clearStats(threadStats_t *s)
+{
+	s->clear();
+}
+
+threadStats_t *renderStats_t::local()
+{
+	return gStats.blocks.local(localStats, localGeneration, clearStats);
+}
+
+void renderStats_t::count(statCounter_t c, unsigned long long n)
+{
+	local()->counters[c] += n;
+}
+
+void renderStats_t::primaryRay()
+{
+	if(enabled) local()->pendingPrimary = true;
+}
+
+void renderStats_t::traversal(bool shadow, unsigned int nodes, unsigned int tests)
+{
+	threadStats_t *s = local();
+	int rc = RAY_SHADOW;
+	if(!shadow)
+	{
+		rc = s->pendingPrimary ? RAY_PRIMARY : RAY_SECONDARY;
+		s->pendingPrimary = false;
+	}
+	s->counters[STAT_RAYS + rc] += 1;
+	s->counters[STAT_KD_NODES + rc] += nodes;
+	s->counters[STAT_KD_TESTS + rc] += tests;
+}
+
+unsigned long long renderStats_t::threadSum(int first, int n)
+{
+	const threadStats_t *s = local();
+	unsigned long long sum = 0;
+	for(int i = first; i < first + n; ++i) sum += s->counters[i];
+	return sum;
+}
+
+void renderStats_t::reset()
+{
+	mutex.lock();
+	blocks.reset();
+	phases.clear();
+	values.clear();
+	passes = 0;
+	mutex.unlock();
+}
+
+void renderStats_t::addPhase(const std::string &name, double seconds)
+{
+	mutex.lock();
+	size_t i = 0;
+	while(i < phases.size() && phases[i].first != name) ++i;
+	if(i == phases.size()) phases.push_back(std::make_pair(name, seconds));
+	else phases[i].second += seconds;
+	mutex.unlock();
+}
+
+void renderStats_t::addPass(double seconds)
+{
+	mutex.lock();
+	std::stringstream name;
+	name << "pass " << ++passes;
+	phases.push_back(std::make_pair(name.str(), seconds));
+	mutex.unlock();
+}
+
+void renderStats_t::setValue(const std::string &name, double value)
+{
+	mutex.lock();
+	size_t i = 0;
+	while(i < values.size() && values[i].first != name) ++i;
+	if(i == values.size()) values.push_back(std::make_pair(name, value));
+	else values[i].second = value;
+	mutex.unlock();
+}
+
+unsigned long long renderStats_t::total(statCounter_t c) const
+{
+	unsigned long long sum = 0;
+	mutex.lock();
+	for(size_t i = 0; i < blocks.size(); ++i) sum += blocks[i]->counters[c];
+	mutex.unlock();
+	return sum;
+}
+
+int renderStats_t::threads() const
+{
+	mutex.lock();
+	int n = (int)blocks.size();
+	mutex.unlock();
+	return n;
+}
+
+static void countersJSON(std::ostream &out, const unsigned long long *c, const char *indent)
+{
+	static const char *classes[RAY_CLASSES] = { "primary", "secondary", "shadow" };
+	static const char *groups[3] = { "rays", "kd_nodes", "kd_tests" };
+	static const int bases[3] = { STAT_RAYS, STAT_KD_NODES, STAT_KD_TESTS };
+	out << "{\n";
+	for(int g = 0; g < 3; ++g)
+	{
+		out << indent << "  \"" << groups[g] << "\": {";
+		for(int r = 0; r < RAY_CLASSES; ++r) out << (r ? ", " : " ") << "\"" << classes[r] << "\": " << c[bases[g] + r];
+		out << " },\n";
+	}
+	out << indent << "  \"material_evals\": " << c[STAT_MATERIAL_EVALS] << ",\n";
+	out << indent << "  \"light_samples\": " << c[STAT_LIGHT_SAMPLES] << ",\n";
+	out << indent << "  \"photon_gathers\": " << c[STAT_PHOTON_GATHERS] << "\n";
+	out << indent << "}";
+}
+
+std::string renderStats_t::toJSON() const
+{
+	std::stringstream out;
+	mutex.lock();
+
+	unsigned long long totals[STAT_COUNTERS];
+	memset(totals, 0, sizeof(totals));
+	for(size_t i = 0; i < blocks.size(); ++i)
+		for(int c = 0; c < STAT_COUNTERS; ++c) totals[c] += blocks[i]->counters[c];
+
+	out << "{\n  \"enabled\": " << (enabled ? "true" : "false") << ",\n";
+	out << "  \"phases\": {";
+	for(size_t i = 0; i < phases.size(); ++i) out << (i ? ", " : " ") << "\"" << phases[i].first << "\": " << phases[i].second;
+	out << " },\n  \"values\": {";
+	for(size_t i = 0; i < values.size(); ++i) out << (i ? ", " : " ") << "\"" << values[i].first << "\": " << values[i].second;
+	out << " },\n  \"totals\": ";
+	countersJSON(out, totals, "  ");
+	out << ",\n  \"threads\": [";
+	for(size_t i = 0; i < blocks.size(); ++i)
+	{
+		out << (i ? ", " : "");
+		countersJSON(out, blocks[i]->counters, "  ");
+	}
+	out << "]\n}\n";
+
+	mutex.unlock();
+	return out.str();
+}
+
+bool renderStats_t::saveJSON(const std::string &fileName) const
+{
+	std::ofstream file(fileName.c_str());
+	if(!file) return false;
+	file << toJSON();
+	return file.good();
+}
+
+__END_YAFRAY
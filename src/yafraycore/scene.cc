@@ -29,24 +29,24 @@
 #include <yafraycore/triangle.h>
 #include <yafraycore/kdtree.h>
 #include <yafraycore/ray_kdtree.h>
+#include <yafraycore/motiontree.h>
+#include <yafraycore/curve.h>
 #include <yafraycore/timer.h>
+#include <yafraycore/renderstats.h>
+#include <yafraycore/trace.h>
 #include <yafraycore/scr_halton.h>
 #include <utilities/mcqmc.h>
 #include <utilities/sample_utils.h>
-#ifdef __APPLE__
-	#include <sys/sysctl.h>
-#endif
 #include <iostream>
+#include <algorithm>
 #include <limits>
 #include <sstream>
-#if HAVE_UNISTD_H
-	#include <unistd.h>
-#endif
 
 __BEGIN_YAFRAY
 
-scene_t::scene_t():  volIntegrator(0), camera(0), imageFilm(0), tree(0), vtree(0), background(0), surfIntegrator(0),
-					AA_samples(1), AA_passes(1), AA_threshold(0.05), nthreads(1), mode(1), do_depth(false), signals(0)
+scene_t::scene_t():  volIntegrator(0), camera(0), imageFilm(0), tree(0), vtree(0), mtree(0), mvtree(0), curves(0), ctree(0), background(0), surfIntegrator(0),
+					AA_samples(1), AA_passes(1), AA_threshold(0.05), nthreads(1), mode(1), do_depth(false), signals(0),
+					checkpointInterval(0.f), checkpointResume(false)
 {
 	state.changes = C_ALL;
 	state.stack.push_front(READY);
@@ -58,6 +58,10 @@ scene_t::~scene_t()
 {
 	if(tree) delete tree;
 	if(vtree) delete vtree;
+	if(mtree) delete mtree;
+	if(mvtree) delete mvtree;
+	if(ctree) delete ctree;
+	if(curves) delete curves;
 	std::map<objID_t, objData_t>::iterator i;
 	for(i = meshes.begin(); i != meshes.end(); ++i)
 	{
@@ -118,146 +122,22 @@ bool scene_t::endGeometry()
 bool scene_t::startCurveMesh(objID_t id, int vertices)
 {
 	if(state.stack.front() != GEOMETRY) return false;
-	int ptype = 0 & 0xFF;
-
-	objData_t &nObj = meshes[id];
-
-	//TODO: switch?
-	// Allocate triangles to render the curve
-	nObj.obj = new triangleObject_t( 2 * (vertices-1) , true, false);
-	nObj.type = ptype;
-	state.stack.push_front(OBJECT);
+	// all strands share one curve object, the strands started with one ID form a curve mesh
+	if(!curves) curves = new curveObject_t();
+	curves->startStrand(id, vertices);
+	state.stack.push_front(CURVE);
 	state.changes |= C_GEOM;
 	state.orco=false;
-	state.curObj = &nObj;
-
-	nObj.obj->points.reserve(2*vertices);
 	return true;
 }
 
 bool scene_t::endCurveMesh(const material_t *mat, float strandStart, float strandEnd, float strandShape)
 {
-	if(state.stack.front() != OBJECT) return false;
-
-	// TODO: Check if we have at least 2 vertex...
-	// TODO: math optimizations
-	
-	// extrude vertices and create faces
-	std::vector<point3d_t> &points = state.curObj->obj->points;
-	float r;	//current radius
-	int i;
-	point3d_t o,a,b;
-	vector3d_t N(0),u(0),v(0);
-	int n = points.size();
-	// Vertex extruding
-	for (i=0;i<n;i++){
-		o = points[i];
-		if (strandShape < 0)
-		{
-			r = strandStart + pow((float)i/(n-1) ,1+strandShape) * ( strandEnd - strandStart );
-		}
-		else
-		{
-			r = strandStart + (1 - pow(((float)(n-i-1))/(n-1) ,1-strandShape)) * ( strandEnd - strandStart );
-		}
-		// Last point keep previous tangent plane
-		if (i<n-1)
-		{
-			N = points[i+1]-points[i];
-			N.normalize();
-			createCS(N,u,v);
-		}
-		// TODO: thikness?
-		a = o - (0.5 * r *v) - 1.5 * r / sqrt(3.f) * u;
-		b = o - (0.5 * r *v) + 1.5 * r / sqrt(3.f) * u;
-		
-		state.curObj->obj->points.push_back(a);
-		state.curObj->obj->points.push_back(b);
-	}
-
-	// Face fill
-	triangle_t tri;
-	int a1,a2,a3,b1,b2,b3;
-	float su,sv;
-	int iu,iv;
-	for (i=0;i<n-1;i++){
-		// 1D particles UV mapping
-		su = (float)i / (n-1);
-		sv = su + 1. / (n-1);
-		iu = addUV(su,su);
-		iv = addUV(sv,sv);
-		a1 = i;
-		a2 = 2*i+n;
-		a3 = a2 +1;
-		b1 = i+1;
-		b2 = a2 +2;
-		b3 = b2 +1;
-		// Close bottom
-		if (i == 0)
-		{
-			tri = triangle_t(a1, a3, a2, state.curObj->obj);
-			tri.setMaterial(mat);
-			state.curTri = state.curObj->obj->addTriangle(tri);
-			state.curObj->obj->uv_offsets.push_back(iu);
-			state.curObj->obj->uv_offsets.push_back(iu);
-			state.curObj->obj->uv_offsets.push_back(iu);
-		}
-		
-		// Fill
-		tri = triangle_t(a1, b2, b1, state.curObj->obj);
-		tri.setMaterial(mat);
-		state.curTri = state.curObj->obj->addTriangle(tri);
-		// StrandUV
-		state.curObj->obj->uv_offsets.push_back(iu);
-		state.curObj->obj->uv_offsets.push_back(iv);
-		state.curObj->obj->uv_offsets.push_back(iv);
-
-		tri = triangle_t(a1, a2, b2, state.curObj->obj);
-		tri.setMaterial(mat);
-		state.curTri = state.curObj->obj->addTriangle(tri);
-		state.curObj->obj->uv_offsets.push_back(iu);
-		state.curObj->obj->uv_offsets.push_back(iu);
-		state.curObj->obj->uv_offsets.push_back(iv);
-		
-		tri = triangle_t(a2, b3, b2, state.curObj->obj);
-		tri.setMaterial(mat);
-		state.curTri = state.curObj->obj->addTriangle(tri);
-		state.curObj->obj->uv_offsets.push_back(iu);
-		state.curObj->obj->uv_offsets.push_back(iv);
-		state.curObj->obj->uv_offsets.push_back(iv);
-
-		tri = triangle_t(a2, a3, b3, state.curObj->obj);
-		tri.setMaterial(mat);
-		state.curTri = state.curObj->obj->addTriangle(tri);
-		state.curObj->obj->uv_offsets.push_back(iu);
-		state.curObj->obj->uv_offsets.push_back(iu);
-		state.curObj->obj->uv_offsets.push_back(iv);
-		
-		tri = triangle_t(b3, a3, a1, state.curObj->obj);
-		tri.setMaterial(mat);
-		state.curTri = state.curObj->obj->addTriangle(tri);
-		state.curObj->obj->uv_offsets.push_back(iv);
-		state.curObj->obj->uv_offsets.push_back(iu);
-		state.curObj->obj->uv_offsets.push_back(iu);
-
-		tri = triangle_t(b3, a1, b1, state.curObj->obj);
-		tri.setMaterial(mat);
-		state.curTri = state.curObj->obj->addTriangle(tri);
-		state.curObj->obj->uv_offsets.push_back(iv);
-		state.curObj->obj->uv_offsets.push_back(iu);
-		state.curObj->obj->uv_offsets.push_back(iv);
-		
+	if(state.stack.front() != CURVE) return false;
+	if(!curves->endStrand(mat, strandStart, strandEnd, strandShape))
+	{
+		Y_WARNING << "Scene: Curve needs at least 2 vertices, strand ignored" << yendl;
 	}
-	// Close top
-	tri = triangle_t(i, 2*i+n, 2*i+n+1, state.curObj->obj);
-	tri.setMaterial(mat);
-	state.curTri = state.curObj->obj->addTriangle(tri);
-	state.curObj->obj->uv_offsets.push_back(iv);
-	state.curObj->obj->uv_offsets.push_back(iv);
-	state.curObj->obj->uv_offsets.push_back(iv);
-
-	state.curObj->obj->finish();
-
 	state.stack.pop_front();
 	return true;
 }
@@ -305,14 +185,12 @@ bool scene_t::endTriMesh()
 			}
 		}
 
-		//calculate geometric normals of tris
-		state.curObj->obj->finish();
-	}
-	else
-	{
-		state.curObj->mobj->finish();
 	}
 	
+	// calculating the geometric normals of the tris is deferred to update(), meshes get finished in parallel there
+	pendingMesh_t pm = { state.curObj, true, -1.f };
+	pendingMeshes.push_back(pm);
+	
 	state.stack.pop_front();
 	return true;
 }
@@ -325,25 +203,7 @@ void scene_t::setNumThreads(int threads)
 	{
 		Y_INFO << "Automatic Detection of Threads: Active." << yendl;
 
-#ifdef WIN32
-		SYSTEM_INFO info;
-		GetSystemInfo(&info);
-		nthreads = (int) info.dwNumberOfProcessors;
-#else 
-	#	ifdef __APPLE__
-		int mib[2];
-		size_t len;
-		
-		mib[0] = CTL_HW;
-		mib[1] = HW_NCPU;
-		len = sizeof(int);
-		sysctl(mib, 2, &nthreads, &len, NULL, 0);
-	#	elif defined(__sgi)
-		nthreads = sysconf(_SC_NPROC_ONLN);
-	#	else
-		nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
-	#	endif
-#endif
+		nthreads = yafthreads::numCPUs();
 
 		Y_INFO << "Number of Threads supported: [" << nthreads << "]." << yendl;
 	}
@@ -353,11 +213,14 @@ void scene_t::setNumThreads(int threads)
 	}
 	
 	Y_INFO << "Using [" << nthreads << "] Threads." << yendl;
+	if(imageFilm) imageFilm->setNumThreads(nthreads);
 }	
 
 bool scene_t::smoothMesh(objID_t id, PFLOAT angle)
 {
 	if( state.stack.front() != GEOMETRY ) return false;
+	// strands always shade like round fibers, there is nothing to smooth
+	if(id && curves && curves->hasMesh(id)) return true;
 	objData_t *odat;
 	if(id)
 	{
@@ -378,112 +241,247 @@ bool scene_t::smoothMesh(objID_t id, PFLOAT angle)
 	
 	// cannot smooth other mesh types yet...
 	if(odat->type > 0) return false;
-	unsigned int i1, i2, i3;
-	std::vector<normal_t> &normals = odat->obj->normals;
-	std::vector<triangle_t> &triangles = odat->obj->triangles;
-	std::vector<point3d_t> &points = odat->obj->points;
-	std::vector<triangle_t>::iterator tri;
-	if (angle>=180)
+	
+	// the smoothing needs the finished triangles, so it runs along with the deferred finish()
+	for(std::vector<pendingMesh_t>::reverse_iterator pm=pendingMeshes.rbegin(); pm!=pendingMeshes.rend(); ++pm)
 	{
-		normals.reserve(points.size());
-		normals.resize(points.size(), normal_t(0,0,0));
-		for (tri=triangles.begin(); tri!=triangles.end(); ++tri)
+		if(pm->odat != odat) continue;
+		if(pm->smoothAngle < 0)
 		{
-			i1 = tri->pa;
-			i2 = tri->pb;
-			i3 = tri->pc;
-			// hm somehow it was a stupid idea not allowing calculation with normal_t class
-			vector3d_t normal = (vector3d_t)tri->getNormal();
-			normals[i1] = normal_t( (vector3d_t)normals[i1] + normal );
-			normals[i2] = normal_t( (vector3d_t)normals[i2] + normal );
-			normals[i3] = normal_t( (vector3d_t)normals[i3] + normal );
-			tri->setNormals(i1, i2, i3);
+			pm->smoothAngle = angle;
+			return true;
 		}
-
-		for (i1=0;i1<normals.size();i1++)
-			normals[i1] = normal_t( vector3d_t(normals[i1]).normalize() );
-
-		odat->obj->is_smooth = true;
+		finishGeometry();
+		break;
 	}
-	else if(angle>0.1)// angle dependant smoothing
+	pendingMesh_t pm = { odat, false, angle };
+	pendingMeshes.push_back(pm);
+	return true;
+}
+
+// vertex -> face adjacency in compressed row form: the faces using vertex v are
+// faces[offsets[v]] to faces[offsets[v+1]-1], in the order of the triangle list
+struct vertexFaces_t
+{
+	vertexFaces_t(const std::vector<triangle_t> &triangles, size_t nVertices): offsets(nVertices + 1, 0), faces(3 * triangles.size())
 	{
-		PFLOAT thresh = fCos(degToRad(angle));
-		std::vector<vector3d_t> vnormals;
-		std::vector<int> vn_index;
-		// create list of faces that include given vertex
-		std::vector<std::vector<triangle_t*> > vface(points.size());
-		for (tri=triangles.begin(); tri!=triangles.end(); ++tri)
+		for(size_t i=0; i<triangles.size(); ++i)
+		{
+			++offsets[triangles[i].pa + 1];
+			++offsets[triangles[i].pb + 1];
+			++offsets[triangles[i].pc + 1];
+		}
+		for(size_t v=0; v<nVertices; ++v) offsets[v + 1] += offsets[v];
+		std::vector<unsigned int> next(offsets.begin(), offsets.end() - 1);
+		for(size_t i=0; i<triangles.size(); ++i)
+		{
+			faces[next[triangles[i].pa]++] = i;
+			faces[next[triangles[i].pb]++] = i;
+			faces[next[triangles[i].pc]++] = i;
+		}
+	}
+	std::vector<unsigned int> offsets;
+	std::vector<unsigned int> faces;
+};
+
+// sums the normals of all faces around each vertex
+class smoothAllJob_t: public yafthreads::parallelJob_t
+{
+	public:
+		smoothAllJob_t(const std::vector<triangle_t> &t, const vertexFaces_t &a, std::vector<normal_t> &n): tris(t), adj(a), normals(n) {}
+		virtual void run(int start, int end)
+		{
+			for(int v=start; v<end; ++v)
+			{
+				vector3d_t normal = (vector3d_t)normals[v];
+				for(unsigned int j=adj.offsets[v]; j<adj.offsets[v+1]; ++j) normal += tris[adj.faces[j]].getNormal();
+				normals[v] = normal_t(normal.normalize());
+			}
+		}
+	protected:
+		const std::vector<triangle_t> &tris;
+		const vertexFaces_t &adj;
+		std::vector<normal_t> &normals;
+};
+
+/* Angle dependant smoothing: every face around a vertex gets the average normal of the faces
+	around it within the angle threshold; faces whose averages (nearly) match share one normal.
+	The first pass finds the shared normals per vertex, then their indices are laid out in vertex
+	order and the second pass writes them, so the result doesn't depend on the thread count. */
+class smoothAngleJob_t: public yafthreads::parallelJob_t
+{
+	public:
+		smoothAngleJob_t(const std::vector<triangle_t> &t, const vertexFaces_t &a, std::vector<normal_t> &n, std::vector<int> &o, PFLOAT thresh):
+			tris(t), adj(a), normals(n), offsets(o), threshold(thresh), entryIndex(a.faces.size()), first(a.offsets.size(), 0), assign(false) {}
+		
+		virtual void run(int start, int end)
+		{
+			if(assign) assignNormals(start, end);
+			else findNormals(start, end);
+		}
+		
+		//! lays out the normals found in the first pass after the existing ones, the second run() assigns them
+		void layout()
+		{
+			size_t nVertices = first.size() - 1;
+			unsigned int idx = normals.size();
+			for(size_t v=0; v<nVertices; ++v)
+			{
+				unsigned int count = first[v];
+				first[v] = idx;
+				idx += count;
+			}
+			first[nVertices] = idx;
+			normals.resize(idx);
+			offsets.assign(3 * tris.size(), -1);
+			assign = true;
+		}
+		
+	protected:
+		// the normal of the face at adjacency entry j for its vertex, false if no other face is within the threshold
+		bool vertexNormal(unsigned int s, unsigned int e, unsigned int j, vector3d_t &vnorm) const
 		{
-			vface[tri->pa].push_back(&(*tri));
-			vface[tri->pb].push_back(&(*tri));
-			vface[tri->pc].push_back(&(*tri));
+			vector3d_t fnorm = tris[adj.faces[j]].getNormal();
+			bool smooth = false;
+			vnorm = fnorm;
+			for(unsigned int k=s; k<e; ++k)
+			{
+				if(k == j) continue;
+				vector3d_t f2norm = tris[adj.faces[k]].getNormal();
+				if((fnorm * f2norm) > threshold)
+				{
+					smooth = true;
+					vnorm += f2norm;
+				}
+			}
+			if(smooth) vnorm.normalize();
+			return smooth;
 		}
-		for(int i=0; i<(int)vface.size(); ++i)
+		
+		// stores per adjacency entry the index of its normal among those of the vertex, -1 for the face normal
+		void findNormals(int start, int end)
 		{
-			std::vector<triangle_t*> &tris = vface[i];
-			for(std::vector<triangle_t*>::iterator fi=tris.begin(); fi!=tris.end(); ++fi)
+			std::vector<vector3d_t> vnormals;
+			for(int v=start; v<end; ++v)
 			{
-				triangle_t* f = *fi;
-				bool smooth = false;
-				// calculate vertex normal for face
-				vector3d_t vnorm, fnorm;
-				
-				vnorm = fnorm = f->getNormal();
-				
-				for(std::vector<triangle_t*>::iterator f2=tris.begin(); f2!=tris.end(); ++f2)
+				unsigned int s = adj.offsets[v], e = adj.offsets[v+1];
+				vnormals.clear();
+				for(unsigned int j=s; j<e; ++j)
 				{
-					if(fi == f2) continue;
-					vector3d_t f2norm = (*f2)->getNormal();
-					if((fnorm * f2norm) > thresh)
+					vector3d_t vnorm;
+					int n_idx = -1;
+					if(vertexNormal(s, e, j, vnorm))
 					{
-						smooth = true;
-						vnorm += f2norm;
+						//search for existing normal
+						for(unsigned int k=0; k<vnormals.size(); ++k)
+						{
+							if(vnorm*vnormals[k] > 0.999){ n_idx = k; break; }
+						}
+						// create new if none found
+						if(n_idx == -1)
+						{
+							n_idx = vnormals.size();
+							vnormals.push_back(vnorm);
+						}
 					}
+					entryIndex[j] = n_idx;
 				}
-				int n_idx = -1;
-				if(smooth)
+				first[v] = vnormals.size();
+			}
+		}
+		
+		// a vertex' normals were created in the order of its entries, so entry j made normal c if it is the first with index c
+		void assignNormals(int start, int end)
+		{
+			for(int v=start; v<end; ++v)
+			{
+				unsigned int s = adj.offsets[v], e = adj.offsets[v+1];
+				int created = 0;
+				for(unsigned int j=s; j<e; ++j)
 				{
-					vnorm.normalize();
-					//search for existing normal
-					for(unsigned int j=0; j<vnormals.size(); ++j)
-					{
-						if(vnorm*vnormals[j] > 0.999){ n_idx = vn_index[j]; break; }
-					}
-					// create new if none found
-					if(n_idx == -1)
+					int n_idx = entryIndex[j];
+					if(n_idx == created)
 					{
-						n_idx = normals.size();
-						vnormals.push_back(vnorm);
-						vn_index.push_back(n_idx);
-						normals.push_back( normal_t(vnorm) );
+						vector3d_t vnorm;
+						vertexNormal(s, e, j, vnorm);
+						normals[first[v] + created] = normal_t(vnorm);
+						++created;
 					}
-				}
-				// set vertex normal to idx
-				if	   (f->pa == i) f->na = n_idx;
-				else if(f->pb == i) f->nb = n_idx;
-				else if(f->pc == i) f->nc = n_idx;
-				else
-				{
-					Y_ERROR << "Scene: Mesh smoothing error!" << yendl;
-					return false;
+					if(n_idx >= 0) n_idx += first[v];
+					// set vertex normal to idx
+					unsigned int f = adj.faces[j];
+					if	   (tris[f].pa == v) offsets[3*f] = n_idx;
+					else if(tris[f].pb == v) offsets[3*f + 1] = n_idx;
+					else					 offsets[3*f + 2] = n_idx;
 				}
 			}
-			vnormals.clear();
-			vn_index.clear();
 		}
-
-		odat->obj->is_smooth = true;
+		
+		const std::vector<triangle_t> &tris;
+		const vertexFaces_t &adj;
+		std::vector<normal_t> &normals;
+		std::vector<int> &offsets; //!< the normal indices of the triangle corners
+		PFLOAT threshold;
+		std::vector<int> entryIndex;
+		std::vector<unsigned int> first; //!< normal count per vertex after the first pass, index of the first normal after layout()
+		bool assign;
+};
+
+bool scene_t::smoothObject(objData_t *odat, PFLOAT angle)
+{
+	std::vector<normal_t> &normals = odat->obj->normals;
+	std::vector<triangle_t> &triangles = odat->obj->triangles;
+	std::vector<point3d_t> &points = odat->obj->points;
+	if(angle <= 0.1) return true;
+	
+	traceScope_t ts("smooth mesh", "update", "vertices,triangles", (int)points.size(), (int)triangles.size());
+	for(std::vector<triangle_t>::const_iterator tri=triangles.begin(); tri!=triangles.end(); ++tri)
+	{
+		if(tri->pa < 0 || tri->pb < 0 || tri->pc < 0 || tri->pa >= (int)points.size() || tri->pb >= (int)points.size() || tri->pc >= (int)points.size())
+		{
+			Y_ERROR << "Scene: Mesh smoothing error, triangle with invalid vertex index!" << yendl;
+			return false;
+		}
+	}
+	vertexFaces_t adj(triangles, points.size());
+	const int chunk = 1024;
+	
+	if (angle>=180)
+	{
+		normals.resize(points.size(), normal_t(0,0,0));
+		smoothAllJob_t job(triangles, adj, normals);
+		yafthreads::runParallel(job, (int)points.size(), std::max(nthreads, 1), chunk);
+		// one normal per vertex, same index
+		std::vector<int>().swap(odat->obj->normal_offsets);
+		odat->obj->normals_shift = 0;
+	}
+	else // angle dependant smoothing
+	{
+		smoothAngleJob_t job(triangles, adj, normals, odat->obj->normal_offsets, fCos(degToRad(angle)));
+		yafthreads::runParallel(job, (int)points.size(), std::max(nthreads, 1), chunk);
+		job.layout();
+		yafthreads::runParallel(job, (int)points.size(), std::max(nthreads, 1), chunk);
 	}
+	
+	odat->obj->is_smooth = true;
 	return true;
 }
 
 int scene_t::addVertex(const point3d_t &p)
 {
+	if(state.stack.front() == CURVE) return curves->addVertex(p);
 	if(state.stack.front() != OBJECT) return -1;
-	state.curObj->obj->points.push_back(p);
+	if(state.curObj->type == TRIM)
+	{
+		state.curObj->obj->points.push_back(p);
+		state.curObj->lastVertId = state.curObj->obj->points.size()-1;
+		return state.curObj->lastVertId;
+	}
+	
+	std::vector<point3d_t> &points = state.curObj->mobj->points;
+	points.push_back(p);
 	if(state.curObj->type == MTRIM)
 	{
-		std::vector<point3d_t> &points = state.curObj->mobj->points;
 		int n = points.size();
 		if(n%3==0)
 		{
@@ -493,13 +491,14 @@ int scene_t::addVertex(const point3d_t &p)
 		return (n-1)/3;
 	}
 	
-	state.curObj->lastVertId = state.curObj->obj->points.size()-1;
+	state.curObj->lastVertId = points.size()-1;
 	
 	return state.curObj->lastVertId;
 }
 
 int scene_t::addVertex(const point3d_t &p, const point3d_t &orco)
 {
+	if(state.stack.front() == CURVE) return curves->addVertex(p);
 	if(state.stack.front() != OBJECT) return -1;
 
 	switch(state.curObj->type)
@@ -560,25 +559,10 @@ bool scene_t::addTriangle(int a, int b, int c, const material_t *mat)
 	{
 		if(state.orco) a*=2, b*=2, c*=2;
 		triangle_t tri(a, b, c, state.curObj->obj);
-		tri.setMaterial(mat);
-		if(state.curObj->obj->normals_exported)
-		{
-			if(state.orco)
-			{
-				// Since the vertex indexes are duplicated with orco
-				// we divide by 2: a / 2 == a >> 1 since is an integer division
-				tri.na = a >> 1;
-				tri.nb = b >> 1;
-				tri.nc = c >> 1;
-			}
-			else
-			{
-				tri.na = a;
-				tri.nb = b;
-				tri.nc = c;
-			}
-		}
-		state.curTri = state.curObj->obj->addTriangle(tri);
+		// Since the vertex indexes are duplicated with orco the
+		// exported normal of vertex a is a / 2 == a >> 1
+		if(state.curObj->obj->normals_exported) state.curObj->obj->normals_shift = state.orco ? 1 : 0;
+		state.curTri = state.curObj->obj->addTriangle(tri, mat);
 	}
 	return true;
 }
@@ -638,6 +622,7 @@ void scene_t::setCamera(camera_t *cam)
 void scene_t::setImageFilm(imageFilm_t *film)
 {
 	imageFilm = film;
+	if(imageFilm) imageFilm->setNumThreads(nthreads);
 }
 
 void scene_t::setBackground(background_t *bg)
@@ -699,6 +684,68 @@ void scene_t::setAntialiasing(int numSamples, int numPasses, int incSamples, dou
 	AA_threshold = (CFLOAT)threshold;
 }
 
+//! hands the build time and shape of a freshly built kd-tree to the render statistics
+static void kdTreeStats()
+{
+	gStats.addPhase("kdtree", gTimer.getTime("kdtree"));
+	gStats.setValue("kd_interior_nodes", Kd_inodes);
+	gStats.setValue("kd_leaves", Kd_leaves);
+	gStats.setValue("kd_empty_leaves", _emptyKd_leaves);
+	gStats.setValue("kd_leaf_prims", Kd_prims);
+}
+
+template<class T> static bool isStaticPrim(const T *p) { return !p->hasMotion(); }
+
+//! builds the tree for the moving primitives and hands its build time to the render statistics
+template<class T> static motionTree_t<T> *buildMotionTree(const T **prims, int nprims)
+{
+	gTimer.addEvent("motion kdtree");
+	gTimer.start("motion kdtree");
+	motionTree_t<T> *mt;
+	{
+		traceScope_t ts("motion kdtree", "update", "prims", nprims);
+		mt = new motionTree_t<T>(prims, nprims);
+	}
+	gTimer.stop("motion kdtree");
+	gStats.addPhase("motion kdtree", gTimer.getTime("motion kdtree"));
+	gStats.setValue("motion_segments", mt->numSegments());
+	return mt;
+}
+
+class meshFinishJob_t: public yafthreads::parallelJob_t
+{
+	public:
+		meshFinishJob_t(std::vector<pendingMesh_t> &p): pending(p) {}
+		virtual void run(int start, int end)
+		{
+			for(int i=start; i<end; ++i)
+			{
+				pendingMesh_t &pm = pending[i];
+				if(!pm.finish) continue;
+				if(pm.odat->type == TRIM) pm.odat->obj->finish();
+				else pm.odat->mobj->finish();
+			}
+		}
+	protected:
+		std::vector<pendingMesh_t> &pending;
+};
+
+void scene_t::finishGeometry()
+{
+	if(pendingMeshes.empty()) return;
+	
+	traceScope_t ts("finish meshes", "update", "meshes", (int)pendingMeshes.size());
+	// meshes are independent of each other, so they are handed out one by one
+	meshFinishJob_t job(pendingMeshes);
+	yafthreads::runParallel(job, (int)pendingMeshes.size(), std::max(nthreads, 1));
+	// smoothing runs parallel per vertex, one mesh after the other
+	for(size_t i=0; i<pendingMeshes.size(); ++i)
+	{
+		if(pendingMeshes[i].smoothAngle >= 0) smoothObject(pendingMeshes[i].odat, pendingMeshes[i].smoothAngle);
+	}
+	pendingMeshes.clear();
+}
+
 /*! update scene state to prepare for rendering.
 	\return false if something vital to render the scene is missing
 			true otherwise
@@ -707,23 +754,38 @@ bool scene_t::update()
 {
 	Y_INFO << "Scene: Mode \"" << ((mode == 0) ? "Triangle" : "Universal" ) << "\"" << yendl;
 	if(!camera || !imageFilm) return false;
+	finishGeometry();
 	if(state.changes & C_GEOM)
 	{
 		if(tree) delete tree;
 		if(vtree) delete vtree;
-		tree = 0, vtree = 0;
+		if(mtree) delete mtree;
+		if(mvtree) delete mvtree;
+		if(ctree) delete ctree;
+		tree = 0, vtree = 0, mtree = 0, mvtree = 0, ctree = 0;
 		int nprims=0;
+		int ncurves = curves ? curves->numPrimitives() : 0;
+		if(curves)
+		{
+			Y_INFO << "Scene: " << curves->numStrands() << " hair strands with " << ncurves << " segments use "
+				<< curves->memory() / (1024.0 * 1024.0) << " MB" << yendl;
+		}
 		if(mode==0)
 		{
+			size_t triMemory = 0;
 			for(std::map<objID_t, objData_t>::iterator i=meshes.begin(); i!=meshes.end(); ++i)
 			{
                 objData_t &dat = (*i).second;
 
+				if(dat.type == TRIM) triMemory += dat.obj->triangleMemory();
+
                 if (!dat.obj->isVisible()) continue;
                 if (dat.obj->isBaseObject()) continue;
 
 				if(dat.type == TRIM) nprims += dat.obj->numPrimitives();
 			}
+			Y_INFO << "Scene: Triangle data uses " << triMemory / (1024.0 * 1024.0) << " MB (" << sizeof(triangle_t) << " bytes per triangle)" << yendl;
+			gStats.setValue("triangle_memory_mb", triMemory / (1024.0 * 1024.0));
 			if(nprims > 0)
 			{
 				const triangle_t **tris = new const triangle_t*[nprims];
@@ -737,9 +799,46 @@ bool scene_t::update()
 					
 					if(dat.type == TRIM) insert += dat.obj->getPrimitives(insert);
 				}
-				tree = new triKdTree_t(tris, nprims, -1, 1, 0.8, 0.33 /* -1, 1.2, 0.40 */ );
+				// triangles of moving instances go to the motion tree, the order of the others is kept
+				const triangle_t **moving = std::stable_partition(tris, tris + nprims, isStaticPrim<triangle_t>);
+				int nStatic = moving - tris;
+				if(nStatic > 0)
+				{
+					gTimer.addEvent("kdtree");
+					gTimer.start("kdtree");
+					{
+						traceScope_t ts("kdtree", "update", "prims", nStatic);
+						tree = new triKdTree_t(tris, nStatic, -1, 1, 0.8, 0.33 /* -1, 1.2, 0.40 */ );
+					}
+					gTimer.stop("kdtree");
+					kdTreeStats();
+					sceneBound = tree->getBound();
+				}
+				if(nStatic < nprims)
+				{
+					mtree = buildMotionTree(moving, nprims - nStatic);
+					sceneBound = tree ? bound_t(sceneBound, mtree->getBound()) : mtree->getBound();
+				}
 				delete [] tris;
-				sceneBound = tree->getBound();
+			}
+			// the strands are no triangles, they get a tree of their own
+			if(ncurves > 0)
+			{
+				const primitive_t **segs = new const primitive_t*[ncurves];
+				curves->getPrimitives(segs);
+				gTimer.addEvent("curve kdtree");
+				gTimer.start("curve kdtree");
+				{
+					traceScope_t ts("curve kdtree", "update", "prims", ncurves);
+					ctree = new kdTree_t<primitive_t>(segs, ncurves, -1, 1, 0.8, 0.33);
+				}
+				gTimer.stop("curve kdtree");
+				gStats.addPhase("curve kdtree", gTimer.getTime("curve kdtree"));
+				sceneBound = nprims > 0 ? bound_t(sceneBound, ctree->getBound()) : ctree->getBound();
+				delete [] segs;
+			}
+			if(nprims > 0 || ncurves > 0)
+			{
 				Y_INFO << "Scene: New scene bound is:" << 
 				"(" << sceneBound.a.x << ", " << sceneBound.a.y << ", " << sceneBound.a.z << "), (" <<
 				sceneBound.g.x << ", " << sceneBound.g.y << ", " << sceneBound.g.z << ")" << yendl;
@@ -758,6 +857,7 @@ bool scene_t::update()
 			{
 				nprims += i->second->numPrimitives();
 			}
+			nprims += ncurves;
 			if(nprims > 0)
 			{
 				const primitive_t **tris = new const primitive_t*[nprims];
@@ -771,9 +871,28 @@ bool scene_t::update()
 				{
 					insert += i->second->getPrimitives(insert);
 				}
-				vtree = new kdTree_t<primitive_t>(tris, nprims, -1, 1, 0.8, 0.33 /* -1, 1.2, 0.40 */ );
+				if(curves) insert += curves->getPrimitives(insert);
+				// time deformed primitives go to the motion tree, the order of the others is kept
+				const primitive_t **moving = std::stable_partition(tris, tris + nprims, isStaticPrim<primitive_t>);
+				int nStatic = moving - tris;
+				if(nStatic > 0)
+				{
+					gTimer.addEvent("kdtree");
+					gTimer.start("kdtree");
+					{
+						traceScope_t ts("kdtree", "update", "prims", nStatic);
+						vtree = new kdTree_t<primitive_t>(tris, nStatic, -1, 1, 0.8, 0.33 /* -1, 1.2, 0.40 */ );
+					}
+					gTimer.stop("kdtree");
+					kdTreeStats();
+					sceneBound = vtree->getBound();
+				}
+				if(nStatic < nprims)
+				{
+					mvtree = buildMotionTree(moving, nprims - nStatic);
+					sceneBound = vtree ? bound_t(sceneBound, mvtree->getBound()) : mvtree->getBound();
+				}
 				delete [] tris;
-				sceneBound = vtree->getBound();
 				Y_INFO << "Scene: New scene bound is:" << yendl <<
 				"(" << sceneBound.a.x << ", " << sceneBound.a.y << ", " << sceneBound.a.z << "), (" <<
 				sceneBound.g.x << ", " << sceneBound.g.y << ", " << sceneBound.g.z << ")" << yendl;
@@ -782,7 +901,29 @@ bool scene_t::update()
 		}
 	}
 	
-	for(unsigned int i=0; i<lights.size(); ++i) lights[i]->init(*this);
+	timer_t phaseTimer;
+	// textures decoded in the background while the tree was built must be ready for the lights
+	phaseTimer.addEvent("texture load");
+	phaseTimer.start("texture load");
+	{
+		traceScope_t ts("texture load wait", "update");
+		loadQueue.wait();
+	}
+	phaseTimer.stop("texture load");
+	gStats.addPhase("texture load", phaseTimer.getTime("texture load"));
+	
+	phaseTimer.addEvent("light init");
+	phaseTimer.start("light init");
+
+	{
+		traceScope_t ts("light init", "update", "lights", (int)lights.size());
+		if(background) background->init(*this);
+		
+		for(unsigned int i=0; i<lights.size(); ++i) lights[i]->init(*this);
+	}
+
+	phaseTimer.stop("light init");
+	gStats.addPhase("light init", phaseTimer.getTime("light init"));
 	
 	if(!surfIntegrator)
 	{
@@ -794,7 +935,15 @@ bool scene_t::update()
 	{
 		std::stringstream inteSettings;
 
-		bool success = (surfIntegrator->preprocess() && volIntegrator->preprocess());
+		phaseTimer.addEvent("preprocess");
+		phaseTimer.start("preprocess");
+		bool success;
+		{
+			traceScope_t ts("preprocess", "update");
+			success = (surfIntegrator->preprocess() && volIntegrator->preprocess());
+		}
+		phaseTimer.stop("preprocess");
+		gStats.addPhase("preprocess", phaseTimer.getTime("preprocess"));
 		
 		inteSettings << surfIntegrator->getName() << " (" << surfIntegrator->getSettings() << ")";
 		imageFilm->setIntegParams(inteSettings.str());
@@ -813,21 +962,49 @@ bool scene_t::intersect(const ray_t &ray, surfacePoint_t &sp) const
 	intersectData_t data;
 	if(ray.tmax<0) dis=std::numeric_limits<PFLOAT>::infinity();
 	else dis=ray.tmax;
-	// intersect with tree:
+	// intersect with tree, moving geometry only has to be closer than a static hit:
 	if(mode == 0)
 	{
-		if(!tree) return false;
 		triangle_t *hitt=0;
-		if( ! tree->Intersect(ray, dis, &hitt, Z, data) ){ return false; }
+		if(tree && tree->Intersect(ray, dis, &hitt, Z, data)) dis = Z;
+		if(mtree)
+		{
+			triangle_t *mhit=0;
+			PFLOAT mZ;
+			intersectData_t mdata;
+			if(mtree->Intersect(ray, dis, &mhit, mZ, mdata)) hitt = mhit, Z = mZ, data = mdata, dis = Z;
+		}
+		if(ctree)
+		{
+			primitive_t *chit=0;
+			PFLOAT cZ;
+			intersectData_t cdata;
+			if(ctree->Intersect(ray, dis, &chit, cZ, cdata))
+			{
+				point3d_t h=ray.from + cZ*ray.dir;
+				chit->getSurface(sp, h, cdata);
+				sp.origin = chit;
+				ray.tmax = cZ;
+				return true;
+			}
+		}
+		if(!hitt) return false;
 		point3d_t h=ray.from + Z*ray.dir;
 		hitt->getSurface(sp, h, data);
 		sp.origin = hitt;
 	}
 	else
 	{
-		if(!vtree) return false;
 		primitive_t *hitprim=0;
-		if( ! vtree->Intersect(ray, dis, &hitprim, Z, data) ){ return false; }
+		if(vtree && vtree->Intersect(ray, dis, &hitprim, Z, data)) dis = Z;
+		if(mvtree)
+		{
+			primitive_t *mhit=0;
+			PFLOAT mZ;
+			intersectData_t mdata;
+			if(mvtree->Intersect(ray, dis, &mhit, mZ, mdata)) hitprim = mhit, Z = mZ, data = mdata;
+		}
+		if(!hitprim) return false;
 		point3d_t h=ray.from + Z*ray.dir;
 		hitprim->getSurface(sp, h, data);
 		sp.origin = hitprim;
@@ -848,14 +1025,16 @@ bool scene_t::isShadowed(renderState_t &state, const ray_t &ray) const
 	if(mode==0)
 	{
 		triangle_t *hitt=0;
-		if(!tree) return false;
-		return tree->IntersectS(sray, dis, &hitt);
+		if(tree && tree->IntersectS(sray, dis, &hitt)) return true;
+		if(mtree && mtree->IntersectS(sray, dis, &hitt)) return true;
+		primitive_t *chit=0;
+		return ctree && ctree->IntersectS(sray, dis, &chit);
 	}
 	else
 	{
 		primitive_t *hitt=0;
-		if(!vtree) return false;
-		return vtree->IntersectS(sray, dis, &hitt);
+		if(vtree && vtree->IntersectS(sray, dis, &hitt)) return true;
+		return mvtree && mvtree->IntersectS(sray, dis, &hitt);
 	}
 }
 
@@ -863,6 +1042,7 @@ bool scene_t::isShadowed(renderState_t &state, const ray_t &ray, int maxDepth, c
 {
 	ray_t sray(ray);
 	sray.from += sray.dir * sray.tmin; //argh...kill that!
+	sray.time = state.time;
 	PFLOAT dis;
 	if(ray.tmax<0)	dis=std::numeric_limits<PFLOAT>::infinity();
 	else  dis = sray.tmax - 2*sray.tmin;
@@ -871,22 +1051,30 @@ bool scene_t::isShadowed(renderState_t &state, const ray_t &ray, int maxDepth, c
 	unsigned char userdata[USER_DATA_SIZE+7];
 	state.userdata = (void *)( ((size_t)&userdata[7])&(~7 ) ); // pad userdata to 8 bytes
 	bool isect=false;
+	// all trees multiply their transparent hits into filt and share one layer count, so at most
+	// maxDepth surfaces get filtered. The trees are queried one after the other though, so once the
+	// limit is reached the surfaces that made it in are not necessarily the closest ones.
+	int layers=0;
 	if(mode==0)
 	{
 		triangle_t *hitt=0;
-		if(tree) isect = tree->IntersectTS(state, sray, maxDepth, dis, &hitt, filt);
+		if(tree) isect = tree->IntersectTS(state, sray, maxDepth, dis, &hitt, filt, &layers);
+		if(!isect && mtree) isect = mtree->IntersectTS(state, sray, maxDepth, dis, &hitt, filt, &layers);
+		primitive_t *chit=0;
+		if(!isect && ctree) isect = ctree->IntersectTS(state, sray, maxDepth, dis, &chit, filt, &layers);
 	}
 	else
 	{
 		primitive_t *hitt=0;
-		if(vtree) isect = vtree->IntersectTS(state, sray, maxDepth, dis, &hitt, filt);
+		if(vtree) isect = vtree->IntersectTS(state, sray, maxDepth, dis, &hitt, filt, &layers);
+		if(!isect && mvtree) isect = mvtree->IntersectTS(state, sray, maxDepth, dis, &hitt, filt, &layers);
 	}
 	state.userdata = odat;
 	return isect;
 }
 
 
-bool scene_t::render()
+bool scene_t::render(bool flushFilm)
 {
 	sig_mutex.lock();
 	signals = 0;
@@ -894,10 +1082,20 @@ bool scene_t::render()
 
 	if(!update()) return false;
 
+	timer_t renderTimer;
+	renderTimer.addEvent("render");
+	renderTimer.start("render");
 	bool success = surfIntegrator->render(imageFilm);
+	renderTimer.stop("render");
+	gStats.addPhase("render", renderTimer.getTime("render"));
 
 	surfIntegrator->cleanup();
+	if(!flushFilm) return success;
+	gTimer.addEvent("flush");
+	gTimer.start("flush");
 	imageFilm->flush();
+	gTimer.stop("flush");
+	gStats.addPhase("flush", gTimer.getTime("flush"));
 
 	return success;
 }
@@ -911,7 +1109,7 @@ objID_t scene_t::getNextFreeID()
 	id = state.nextFreeID;
 	
 	//create new entry for object, assert that no ID collision happens:
-	if(meshes.find(id) != meshes.end())
+	if(meshes.find(id) != meshes.end() || (curves && curves->hasMesh(id)))
 	{
 		Y_ERROR << "Scene: Object ID already in use!" << yendl;
 		--state.nextFreeID;
@@ -940,6 +1138,23 @@ bool scene_t::addObject(object3d_t *obj, objID_t &id)
 
 bool scene_t::addInstance(objID_t baseObjectId, matrix4x4_t objToWorld)
 {
+	return addInstance(baseObjectId, objToWorld, objToWorld);
+}
+
+bool scene_t::addInstance(objID_t baseObjectId, matrix4x4_t objToWorld, matrix4x4_t objToWorldEnd)
+{
+	if(curves && curves->hasMesh(baseObjectId))
+	{
+		// strands are copied into the curve object, which works in both modes but cannot move
+		bool moving = false;
+		for(int i=0; i<4; ++i) for(int j=0; j<4; ++j) moving |= objToWorld[i][j] != objToWorldEnd[i][j];
+		if(moving) Y_WARNING << "Scene: Curve instances cannot move, instance of " << baseObjectId << " uses its start transform" << yendl;
+		objID_t id = getNextFreeID();
+		if(id <= 0 || !curves->addInstance(baseObjectId, id, objToWorld)) return false;
+		state.changes |= C_GEOM;
+		return true;
+	}
+
 	if(mode != 0) return false;
 
 	if (meshes.find(baseObjectId) == meshes.end())
@@ -948,6 +1163,9 @@ bool scene_t::addInstance(objID_t baseObjectId, matrix4x4_t objToWorld)
 		return false;
 	}
 
+	// the instance copies the smoothing state of its base
+	finishGeometry();
+	
 	int id = getNextFreeID();
 
 	if (id > 0)
@@ -955,7 +1173,7 @@ bool scene_t::addInstance(objID_t baseObjectId, matrix4x4_t objToWorld)
 		objData_t &od = meshes[id];
 		objData_t &base = meshes[baseObjectId];
 
-		od.obj = new triangleObjectInstance_t(base.obj, objToWorld);
+		od.obj = new triangleObjectInstance_t(base.obj, objToWorld, objToWorldEnd);
 
 		return true;
 	}
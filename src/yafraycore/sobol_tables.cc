@@ -0,0 +1,274 @@
+#include <yafray_config.h>
+#include <utilities/sobol.h>
+
+// Sobol direction numbers of the first two dimensions (van der Corput and x+1),
+// xor-ed together for all values of each index byte: table[dim][byte][value]
+// so a sample of index i is table[dim][0][i&255]^table[dim][1][(i>>8)&255]^...
+
+const unsigned int sobolTable[2][4][256] = {
+	{
+		{
+			0x00000000, 0x80000000, 0x40000000, 0xc0000000, 0x20000000, 0xa0000000, 0x60000000, 0xe0000000,
+			0x10000000, 0x90000000, 0x50000000, 0xd0000000, 0x30000000, 0xb0000000, 0x70000000, 0xf0000000,
+			0x08000000, 0x88000000, 0x48000000, 0xc8000000, 0x28000000, 0xa8000000, 0x68000000, 0xe8000000,
+			0x18000000, 0x98000000, 0x58000000, 0xd8000000, 0x38000000, 0xb8000000, 0x78000000, 0xf8000000,
+			0x04000000, 0x84000000, 0x44000000, 0xc4000000, 0x24000000, 0xa4000000, 0x64000000, 0xe4000000,
+			0x14000000, 0x94000000, 0x54000000, 0xd4000000, 0x34000000, 0xb4000000, 0x74000000, 0xf4000000,
+			0x0c000000, 0x8c000000, 0x4c000000, 0xcc000000, 0x2c000000, 0xac000000, 0x6c000000, 0xec000000,
+			0x1c000000, 0x9c000000, 0x5c000000, 0xdc000000, 0x3c000000, 0xbc000000, 0x7c000000, 0xfc000000,
+			0x02000000, 0x82000000, 0x42000000, 0xc2000000, 0x22000000, 0xa2000000, 0x62000000, 0xe2000000,
+			0x12000000, 0x92000000, 0x52000000, 0xd2000000, 0x32000000, 0xb2000000, 0x72000000, 0xf2000000,
+			0x0a000000, 0x8a000000, 0x4a000000, 0xca000000, 0x2a000000, 0xaa000000, 0x6a000000, 0xea000000,
+			0x1a000000, 0x9a000000, 0x5a000000, 0xda000000, 0x3a000000, 0xba000000, 0x7a000000, 0xfa000000,
+			0x06000000, 0x86000000, 0x46000000, 0xc6000000, 0x26000000, 0xa6000000, 0x66000000, 0xe6000000,
+			0x16000000, 0x96000000, 0x56000000, 0xd6000000, 0x36000000, 0xb6000000, 0x76000000, 0xf6000000,
+			0x0e000000, 0x8e000000, 0x4e000000, 0xce000000, 0x2e000000, 0xae000000, 0x6e000000, 0xee000000,
+			0x1e000000, 0x9e000000, 0x5e000000, 0xde000000, 0x3e000000, 0xbe000000, 0x7e000000, 0xfe000000,
+			0x01000000, 0x81000000, 0x41000000, 0xc1000000, 0x21000000, 0xa1000000, 0x61000000, 0xe1000000,
+			0x11000000, 0x91000000, 0x51000000, 0xd1000000, 0x31000000, 0xb1000000, 0x71000000, 0xf1000000,
+			0x09000000, 0x89000000, 0x49000000, 0xc9000000, 0x29000000, 0xa9000000, 0x69000000, 0xe9000000,
+			0x19000000, 0x99000000, 0x59000000, 0xd9000000, 0x39000000, 0xb9000000, 0x79000000, 0xf9000000,
+			0x05000000, 0x85000000, 0x45000000, 0xc5000000, 0x25000000, 0xa5000000, 0x65000000, 0xe5000000,
+			0x15000000, 0x95000000, 0x55000000, 0xd5000000, 0x35000000, 0xb5000000, 0x75000000, 0xf5000000,
+			0x0d000000, 0x8d000000, 0x4d000000, 0xcd000000, 0x2d000000, 0xad000000, 0x6d000000, 0xed000000,
+			0x1d000000, 0x9d000000, 0x5d000000, 0xdd000000, 0x3d000000, 0xbd000000, 0x7d000000, 0xfd000000,
+			0x03000000, 0x83000000, 0x43000000, 0xc3000000, 0x23000000, 0xa3000000, 0x63000000, 0xe3000000,
+			0x13000000, 0x93000000, 0x53000000, 0xd3000000, 0x33000000, 0xb3000000, 0x73000000, 0xf3000000,
+			0x0b000000, 0x8b000000, 0x4b000000, 0xcb000000, 0x2b000000, 0xab000000, 0x6b000000, 0xeb000000,
+			0x1b000000, 0x9b000000, 0x5b000000, 0xdb000000, 0x3b000000, 0xbb000000, 0x7b000000, 0xfb000000,
+			0x07000000, 0x87000000, 0x47000000, 0xc7000000, 0x27000000, 0xa7000000, 0x67000000, 0xe7000000,
+			0x17000000, 0x97000000, 0x57000000, 0xd7000000, 0x37000000, 0xb7000000, 0x77000000, 0xf7000000,
+			0x0f000000, 0x8f000000, 0x4f000000, 0xcf000000, 0x2f000000, 0xaf000000, 0x6f000000, 0xef000000,
+			0x1f000000, 0x9f000000, 0x5f000000, 0xdf000000, 0x3f000000, 0xbf000000, 0x7f000000, 0xff000000 },
+		{
+			0x00000000, 0x00800000, 0x00400000, 0x00c00000, 0x00200000, 0x00a00000, 0x00600000, 0x00e00000,
+			0x00100000, 0x00900000, 0x00500000, 0x00d00000, 0x00300000, 0x00b00000, 0x00700000, 0x00f00000,
+			0x00080000, 0x00880000, 0x00480000, 0x00c80000, 0x00280000, 0x00a80000, 0x00680000, 0x00e80000,
+			0x00180000, 0x00980000, 0x00580000, 0x00d80000, 0x00380000, 0x00b80000, 0x00780000, 0x00f80000,
+			0x00040000, 0x00840000, 0x00440000, 0x00c40000, 0x00240000, 0x00a40000, 0x00640000, 0x00e40000,
+			0x00140000, 0x00940000, 0x00540000, 0x00d40000, 0x00340000, 0x00b40000, 0x00740000, 0x00f40000,
+			0x000c0000, 0x008c0000, 0x004c0000, 0x00cc0000, 0x002c0000, 0x00ac0000, 0x006c0000, 0x00ec0000,
+			0x001c0000, 0x009c0000, 0x005c0000, 0x00dc0000, 0x003c0000, 0x00bc0000, 0x007c0000, 0x00fc0000,
+			0x00020000, 0x00820000, 0x00420000, 0x00c20000, 0x00220000, 0x00a20000, 0x00620000, 0x00e20000,
+			0x00120000, 0x00920000, 0x00520000, 0x00d20000, 0x00320000, 0x00b20000, 0x00720000, 0x00f20000,
+			0x000a0000, 0x008a0000, 0x004a0000, 0x00ca0000, 0x002a0000, 0x00aa0000, 0x006a0000, 0x00ea0000,
+			0x001a0000, 0x009a0000, 0x005a0000, 0x00da0000, 0x003a0000, 0x00ba0000, 0x007a0000, 0x00fa0000,
+			0x00060000, 0x00860000, 0x00460000, 0x00c60000, 0x00260000, 0x00a60000, 0x00660000, 0x00e60000,
+			0x00160000, 0x00960000, 0x00560000, 0x00d60000, 0x00360000, 0x00b60000, 0x00760000, 0x00f60000,
+			0x000e0000, 0x008e0000, 0x004e0000, 0x00ce0000, 0x002e0000, 0x00ae0000, 0x006e0000, 0x00ee0000,
+			0x001e0000, 0x009e0000, 0x005e0000, 0x00de0000, 0x003e0000, 0x00be0000, 0x007e0000, 0x00fe0000,
+			0x00010000, 0x00810000, 0x00410000, 0x00c10000, 0x00210000, 0x00a10000, 0x00610000, 0x00e10000,
+			0x00110000, 0x00910000, 0x00510000, 0x00d10000, 0x00310000, 0x00b10000, 0x00710000, 0x00f10000,
+			0x00090000, 0x00890000, 0x00490000, 0x00c90000, 0x00290000, 0x00a90000, 0x00690000, 0x00e90000,
+			0x00190000, 0x00990000, 0x00590000, 0x00d90000, 0x00390000, 0x00b90000, 0x00790000, 0x00f90000,
+			0x00050000, 0x00850000, 0x00450000, 0x00c50000, 0x00250000, 0x00a50000, 0x00650000, 0x00e50000,
+			0x00150000, 0x00950000, 0x00550000, 0x00d50000, 0x00350000, 0x00b50000, 0x00750000, 0x00f50000,
+			0x000d0000, 0x008d0000, 0x004d0000, 0x00cd0000, 0x002d0000, 0x00ad0000, 0x006d0000, 0x00ed0000,
+			0x001d0000, 0x009d0000, 0x005d0000, 0x00dd0000, 0x003d0000, 0x00bd0000, 0x007d0000, 0x00fd0000,
+			0x00030000, 0x00830000, 0x00430000, 0x00c30000, 0x00230000, 0x00a30000, 0x00630000, 0x00e30000,
+			0x00130000, 0x00930000, 0x00530000, 0x00d30000, 0x00330000, 0x00b30000, 0x00730000, 0x00f30000,
+			0x000b0000, 0x008b0000, 0x004b0000, 0x00cb0000, 0x002b0000, 0x00ab0000, 0x006b0000, 0x00eb0000,
+			0x001b0000, 0x009b0000, 0x005b0000, 0x00db0000, 0x003b0000, 0x00bb0000, 0x007b0000, 0x00fb0000,
+			0x00070000, 0x00870000, 0x00470000, 0x00c70000, 0x00270000, 0x00a70000, 0x00670000, 0x00e70000,
+			0x00170000, 0x00970000, 0x00570000, 0x00d70000, 0x00370000, 0x00b70000, 0x00770000, 0x00f70000,
+			0x000f0000, 0x008f0000, 0x004f0000, 0x00cf0000, 0x002f0000, 0x00af0000, 0x006f0000, 0x00ef0000,
+			0x001f0000, 0x009f0000, 0x005f0000, 0x00df0000, 0x003f0000, 0x00bf0000, 0x007f0000, 0x00ff0000 },
+		{
+			0x00000000, 0x00008000, 0x00004000, 0x0000c000, 0x00002000, 0x0000a000, 0x00006000, 0x0000e000,
+			0x00001000, 0x00009000, 0x00005000, 0x0000d000, 0x00003000, 0x0000b000, 0x00007000, 0x0000f000,
+			0x00000800, 0x00008800, 0x00004800, 0x0000c800, 0x00002800, 0x0000a800, 0x00006800, 0x0000e800,
+			0x00001800, 0x00009800, 0x00005800, 0x0000d800, 0x00003800, 0x0000b800, 0x00007800, 0x0000f800,
+			0x00000400, 0x00008400, 0x00004400, 0x0000c400, 0x00002400, 0x0000a400, 0x00006400, 0x0000e400,
+			0x00001400, 0x00009400, 0x00005400, 0x0000d400, 0x00003400, 0x0000b400, 0x00007400, 0x0000f400,
+			0x00000c00, 0x00008c00, 0x00004c00, 0x0000cc00, 0x00002c00, 0x0000ac00, 0x00006c00, 0x0000ec00,
+			0x00001c00, 0x00009c00, 0x00005c00, 0x0000dc00, 0x00003c00, 0x0000bc00, 0x00007c00, 0x0000fc00,
+			0x00000200, 0x00008200, 0x00004200, 0x0000c200, 0x00002200, 0x0000a200, 0x00006200, 0x0000e200,
+			0x00001200, 0x00009200, 0x00005200, 0x0000d200, 0x00003200, 0x0000b200, 0x00007200, 0x0000f200,
+			0x00000a00, 0x00008a00, 0x00004a00, 0x0000ca00, 0x00002a00, 0x0000aa00, 0x00006a00, 0x0000ea00,
+			0x00001a00, 0x00009a00, 0x00005a00, 0x0000da00, 0x00003a00, 0x0000ba00, 0x00007a00, 0x0000fa00,
+			0x00000600, 0x00008600, 0x00004600, 0x0000c600, 0x00002600, 0x0000a600, 0x00006600, 0x0000e600,
+			0x00001600, 0x00009600, 0x00005600, 0x0000d600, 0x00003600, 0x0000b600, 0x00007600, 0x0000f600,
+			0x00000e00, 0x00008e00, 0x00004e00, 0x0000ce00, 0x00002e00, 0x0000ae00, 0x00006e00, 0x0000ee00,
+			0x00001e00, 0x00009e00, 0x00005e00, 0x0000de00, 0x00003e00, 0x0000be00, 0x00007e00, 0x0000fe00,
+			0x00000100, 0x00008100, 0x00004100, 0x0000c100, 0x00002100, 0x0000a100, 0x00006100, 0x0000e100,
+			0x00001100, 0x00009100, 0x00005100, 0x0000d100, 0x00003100, 0x0000b100, 0x00007100, 0x0000f100,
+			0x00000900, 0x00008900, 0x00004900, 0x0000c900, 0x00002900, 0x0000a900, 0x00006900, 0x0000e900,
+			0x00001900, 0x00009900, 0x00005900, 0x0000d900, 0x00003900, 0x0000b900, 0x00007900, 0x0000f900,
+			0x00000500, 0x00008500, 0x00004500, 0x0000c500, 0x00002500, 0x0000a500, 0x00006500, 0x0000e500,
+			0x00001500, 0x00009500, 0x00005500, 0x0000d500, 0x00003500, 0x0000b500, 0x00007500, 0x0000f500,
+			0x00000d00, 0x00008d00, 0x00004d00, 0x0000cd00, 0x00002d00, 0x0000ad00, 0x00006d00, 0x0000ed00,
+			0x00001d00, 0x00009d00, 0x00005d00, 0x0000dd00, 0x00003d00, 0x0000bd00, 0x00007d00, 0x0000fd00,
+			0x00000300, 0x00008300, 0x00004300, 0x0000c300, 0x00002300, 0x0000a300, 0x00006300, 0x0000e300,
+			0x00001300, 0x00009300, 0x00005300, 0x0000d300, 0x00003300, 0x0000b300, 0x00007300, 0x0000f300,
+			0x00000b00, 0x00008b00, 0x00004b00, 0x0000cb00, 0x00002b00, 0x0000ab00, 0x00006b00, 0x0000eb00,
+			0x00001b00, 0x00009b00, 0x00005b00, 0x0000db00, 0x00003b00, 0x0000bb00, 0x00007b00, 0x0000fb00,
+			0x00000700, 0x00008700, 0x00004700, 0x0000c700, 0x00002700, 0x0000a700, 0x00006700, 0x0000e700,
+			0x00001700, 0x00009700, 0x00005700, 0x0000d700, 0x00003700, 0x0000b700, 0x00007700, 0x0000f700,
+			0x00000f00, 0x00008f00, 0x00004f00, 0x0000cf00, 0x00002f00, 0x0000af00, 0x00006f00, 0x0000ef00,
+			0x00001f00, 0x00009f00, 0x00005f00, 0x0000df00, 0x00003f00, 0x0000bf00, 0x00007f00, 0x0000ff00 },
+		{
+			0x00000000, 0x00000080, 0x00000040, 0x000000c0, 0x00000020, 0x000000a0, 0x00000060, 0x000000e0,
+			0x00000010, 0x00000090, 0x00000050, 0x000000d0, 0x00000030, 0x000000b0, 0x00000070, 0x000000f0,
+			0x00000008, 0x00000088, 0x00000048, 0x000000c8, 0x00000028, 0x000000a8, 0x00000068, 0x000000e8,
+			0x00000018, 0x00000098, 0x00000058, 0x000000d8, 0x00000038, 0x000000b8, 0x00000078, 0x000000f8,
+			0x00000004, 0x00000084, 0x00000044, 0x000000c4, 0x00000024, 0x000000a4, 0x00000064, 0x000000e4,
+			0x00000014, 0x00000094, 0x00000054, 0x000000d4, 0x00000034, 0x000000b4, 0x00000074, 0x000000f4,
+			0x0000000c, 0x0000008c, 0x0000004c, 0x000000cc, 0x0000002c, 0x000000ac, 0x0000006c, 0x000000ec,
+			0x0000001c, 0x0000009c, 0x0000005c, 0x000000dc, 0x0000003c, 0x000000bc, 0x0000007c, 0x000000fc,
+			0x00000002, 0x00000082, 0x00000042, 0x000000c2, 0x00000022, 0x000000a2, 0x00000062, 0x000000e2,
+			0x00000012, 0x00000092, 0x00000052, 0x000000d2, 0x00000032, 0x000000b2, 0x00000072, 0x000000f2,
+			0x0000000a, 0x0000008a, 0x0000004a, 0x000000ca, 0x0000002a, 0x000000aa, 0x0000006a, 0x000000ea,
+			0x0000001a, 0x0000009a, 0x0000005a, 0x000000da, 0x0000003a, 0x000000ba, 0x0000007a, 0x000000fa,
+			0x00000006, 0x00000086, 0x00000046, 0x000000c6, 0x00000026, 0x000000a6, 0x00000066, 0x000000e6,
+			0x00000016, 0x00000096, 0x00000056, 0x000000d6, 0x00000036, 0x000000b6, 0x00000076, 0x000000f6,
+			0x0000000e, 0x0000008e, 0x0000004e, 0x000000ce, 0x0000002e, 0x000000ae, 0x0000006e, 0x000000ee,
+			0x0000001e, 0x0000009e, 0x0000005e, 0x000000de, 0x0000003e, 0x000000be, 0x0000007e, 0x000000fe,
+			0x00000001, 0x00000081, 0x00000041, 0x000000c1, 0x00000021, 0x000000a1, 0x00000061, 0x000000e1,
+			0x00000011, 0x00000091, 0x00000051, 0x000000d1, 0x00000031, 0x000000b1, 0x00000071, 0x000000f1,
+			0x00000009, 0x00000089, 0x00000049, 0x000000c9, 0x00000029, 0x000000a9, 0x00000069, 0x000000e9,
+			0x00000019, 0x00000099, 0x00000059, 0x000000d9, 0x00000039, 0x000000b9, 0x00000079, 0x000000f9,
+			0x00000005, 0x00000085, 0x00000045, 0x000000c5, 0x00000025, 0x000000a5, 0x00000065, 0x000000e5,
+			0x00000015, 0x00000095, 0x00000055, 0x000000d5, 0x00000035, 0x000000b5, 0x00000075, 0x000000f5,
+			0x0000000d, 0x0000008d, 0x0000004d, 0x000000cd, 0x0000002d, 0x000000ad, 0x0000006d, 0x000000ed,
+			0x0000001d, 0x0000009d, 0x0000005d, 0x000000dd, 0x0000003d, 0x000000bd, 0x0000007d, 0x000000fd,
+			0x00000003, 0x00000083, 0x00000043, 0x000000c3, 0x00000023, 0x000000a3, 0x00000063, 0x000000e3,
+			0x00000013, 0x00000093, 0x00000053, 0x000000d3, 0x00000033, 0x000000b3, 0x00000073, 0x000000f3,
+			0x0000000b, 0x0000008b, 0x0000004b, 0x000000cb, 0x0000002b, 0x000000ab, 0x0000006b, 0x000000eb,
+			0x0000001b, 0x0000009b, 0x0000005b, 0x000000db, 0x0000003b, 0x000000bb, 0x0000007b, 0x000000fb,
+			0x00000007, 0x00000087, 0x00000047, 0x000000c7, 0x00000027, 0x000000a7, 0x00000067, 0x000000e7,
+			0x00000017, 0x00000097, 0x00000057, 0x000000d7, 0x00000037, 0x000000b7, 0x00000077, 0x000000f7,
+			0x0000000f, 0x0000008f, 0x0000004f, 0x000000cf, 0x0000002f, 0x000000af, 0x0000006f, 0x000000ef,
+			0x0000001f, 0x0000009f, 0x0000005f, 0x000000df, 0x0000003f, 0x000000bf, 0x0000007f, 0x000000ff } },
+	{
+		{
+			0x00000000, 0x80000000, 0xc0000000, 0x40000000, 0xa0000000, 0x20000000, 0x60000000, 0xe0000000,
+			0xf0000000, 0x70000000, 0x30000000, 0xb0000000, 0x50000000, 0xd0000000, 0x90000000, 0x10000000,
+			0x88000000, 0x08000000, 0x48000000, 0xc8000000, 0x28000000, 0xa8000000, 0xe8000000, 0x68000000,
+			0x78000000, 0xf8000000, 0xb8000000, 0x38000000, 0xd8000000, 0x58000000, 0x18000000, 0x98000000,
+			0xcc000000, 0x4c000000, 0x0c000000, 0x8c000000, 0x6c000000, 0xec000000, 0xac000000, 0x2c000000,
+			0x3c000000, 0xbc000000, 0xfc000000, 0x7c000000, 0x9c000000, 0x1c000000, 0x5c000000, 0xdc000000,
+			0x44000000, 0xc4000000, 0x84000000, 0x04000000, 0xe4000000, 0x64000000, 0x24000000, 0xa4000000,
+			0xb4000000, 0x34000000, 0x74000000, 0xf4000000, 0x14000000, 0x94000000, 0xd4000000, 0x54000000,
+			0xaa000000, 0x2a000000, 0x6a000000, 0xea000000, 0x0a000000, 0x8a000000, 0xca000000, 0x4a000000,
+			0x5a000000, 0xda000000, 0x9a000000, 0x1a000000, 0xfa000000, 0x7a000000, 0x3a000000, 0xba000000,
+			0x22000000, 0xa2000000, 0xe2000000, 0x62000000, 0x82000000, 0x02000000, 0x42000000, 0xc2000000,
+			0xd2000000, 0x52000000, 0x12000000, 0x92000000, 0x72000000, 0xf2000000, 0xb2000000, 0x32000000,
+			0x66000000, 0xe6000000, 0xa6000000, 0x26000000, 0xc6000000, 0x46000000, 0x06000000, 0x86000000,
+			0x96000000, 0x16000000, 0x56000000, 0xd6000000, 0x36000000, 0xb6000000, 0xf6000000, 0x76000000,
+			0xee000000, 0x6e000000, 0x2e000000, 0xae000000, 0x4e000000, 0xce000000, 0x8e000000, 0x0e000000,
+			0x1e000000, 0x9e000000, 0xde000000, 0x5e000000, 0xbe000000, 0x3e000000, 0x7e000000, 0xfe000000,
+			0xff000000, 0x7f000000, 0x3f000000, 0xbf000000, 0x5f000000, 0xdf000000, 0x9f000000, 0x1f000000,
+			0x0f000000, 0x8f000000, 0xcf000000, 0x4f000000, 0xaf000000, 0x2f000000, 0x6f000000, 0xef000000,
+			0x77000000, 0xf7000000, 0xb7000000, 0x37000000, 0xd7000000, 0x57000000, 0x17000000, 0x97000000,
+			0x87000000, 0x07000000, 0x47000000, 0xc7000000, 0x27000000, 0xa7000000, 0xe7000000, 0x67000000,
+			0x33000000, 0xb3000000, 0xf3000000, 0x73000000, 0x93000000, 0x13000000, 0x53000000, 0xd3000000,
+			0xc3000000, 0x43000000, 0x03000000, 0x83000000, 0x63000000, 0xe3000000, 0xa3000000, 0x23000000,
+			0xbb000000, 0x3b000000, 0x7b000000, 0xfb000000, 0x1b000000, 0x9b000000, 0xdb000000, 0x5b000000,
+			0x4b000000, 0xcb000000, 0x8b000000, 0x0b000000, 0xeb000000, 0x6b000000, 0x2b000000, 0xab000000,
+			0x55000000, 0xd5000000, 0x95000000, 0x15000000, 0xf5000000, 0x75000000, 0x35000000, 0xb5000000,
+			0xa5000000, 0x25000000, 0x65000000, 0xe5000000, 0x05000000, 0x85000000, 0xc5000000, 0x45000000,
+			0xdd000000, 0x5d000000, 0x1d000000, 0x9d000000, 0x7d000000, 0xfd000000, 0xbd000000, 0x3d000000,
+			0x2d000000, 0xad000000, 0xed000000, 0x6d000000, 0x8d000000, 0x0d000000, 0x4d000000, 0xcd000000,
+			0x99000000, 0x19000000, 0x59000000, 0xd9000000, 0x39000000, 0xb9000000, 0xf9000000, 0x79000000,
+			0x69000000, 0xe9000000, 0xa9000000, 0x29000000, 0xc9000000, 0x49000000, 0x09000000, 0x89000000,
+			0x11000000, 0x91000000, 0xd1000000, 0x51000000, 0xb1000000, 0x31000000, 0x71000000, 0xf1000000,
+			0xe1000000, 0x61000000, 0x21000000, 0xa1000000, 0x41000000, 0xc1000000, 0x81000000, 0x01000000 },
+		{
+			0x00000000, 0x80800000, 0xc0c00000, 0x40400000, 0xa0a00000, 0x20200000, 0x60600000, 0xe0e00000,
+			0xf0f00000, 0x70700000, 0x30300000, 0xb0b00000, 0x50500000, 0xd0d00000, 0x90900000, 0x10100000,
+			0x88880000, 0x08080000, 0x48480000, 0xc8c80000, 0x28280000, 0xa8a80000, 0xe8e80000, 0x68680000,
+			0x78780000, 0xf8f80000, 0xb8b80000, 0x38380000, 0xd8d80000, 0x58580000, 0x18180000, 0x98980000,
+			0xcccc0000, 0x4c4c0000, 0x0c0c0000, 0x8c8c0000, 0x6c6c0000, 0xecec0000, 0xacac0000, 0x2c2c0000,
+			0x3c3c0000, 0xbcbc0000, 0xfcfc0000, 0x7c7c0000, 0x9c9c0000, 0x1c1c0000, 0x5c5c0000, 0xdcdc0000,
+			0x44440000, 0xc4c40000, 0x84840000, 0x04040000, 0xe4e40000, 0x64640000, 0x24240000, 0xa4a40000,
+			0xb4b40000, 0x34340000, 0x74740000, 0xf4f40000, 0x14140000, 0x94940000, 0xd4d40000, 0x54540000,
+			0xaaaa0000, 0x2a2a0000, 0x6a6a0000, 0xeaea0000, 0x0a0a0000, 0x8a8a0000, 0xcaca0000, 0x4a4a0000,
+			0x5a5a0000, 0xdada0000, 0x9a9a0000, 0x1a1a0000, 0xfafa0000, 0x7a7a0000, 0x3a3a0000, 0xbaba0000,
+			0x22220000, 0xa2a20000, 0xe2e20000, 0x62620000, 0x82820000, 0x02020000, 0x42420000, 0xc2c20000,
+			0xd2d20000, 0x52520000, 0x12120000, 0x92920000, 0x72720000, 0xf2f20000, 0xb2b20000, 0x32320000,
+			0x66660000, 0xe6e60000, 0xa6a60000, 0x26260000, 0xc6c60000, 0x46460000, 0x06060000, 0x86860000,
+			0x96960000, 0x16160000, 0x56560000, 0xd6d60000, 0x36360000, 0xb6b60000, 0xf6f60000, 0x76760000,
+			0xeeee0000, 0x6e6e0000, 0x2e2e0000, 0xaeae0000, 0x4e4e0000, 0xcece0000, 0x8e8e0000, 0x0e0e0000,
+			0x1e1e0000, 0x9e9e0000, 0xdede0000, 0x5e5e0000, 0xbebe0000, 0x3e3e0000, 0x7e7e0000, 0xfefe0000,
+			0xffff0000, 0x7f7f0000, 0x3f3f0000, 0xbfbf0000, 0x5f5f0000, 0xdfdf0000, 0x9f9f0000, 0x1f1f0000,
+			0x0f0f0000, 0x8f8f0000, 0xcfcf0000, 0x4f4f0000, 0xafaf0000, 0x2f2f0000, 0x6f6f0000, 0xefef0000,
+			0x77770000, 0xf7f70000, 0xb7b70000, 0x37370000, 0xd7d70000, 0x57570000, 0x17170000, 0x97970000,
+			0x87870000, 0x07070000, 0x47470000, 0xc7c70000, 0x27270000, 0xa7a70000, 0xe7e70000, 0x67670000,
+			0x33330000, 0xb3b30000, 0xf3f30000, 0x73730000, 0x93930000, 0x13130000, 0x53530000, 0xd3d30000,
+			0xc3c30000, 0x43430000, 0x03030000, 0x83830000, 0x63630000, 0xe3e30000, 0xa3a30000, 0x23230000,
+			0xbbbb0000, 0x3b3b0000, 0x7b7b0000, 0xfbfb0000, 0x1b1b0000, 0x9b9b0000, 0xdbdb0000, 0x5b5b0000,
+			0x4b4b0000, 0xcbcb0000, 0x8b8b0000, 0x0b0b0000, 0xebeb0000, 0x6b6b0000, 0x2b2b0000, 0xabab0000,
+			0x55550000, 0xd5d50000, 0x95950000, 0x15150000, 0xf5f50000, 0x75750000, 0x35350000, 0xb5b50000,
+			0xa5a50000, 0x25250000, 0x65650000, 0xe5e50000, 0x05050000, 0x85850000, 0xc5c50000, 0x45450000,
+			0xdddd0000, 0x5d5d0000, 0x1d1d0000, 0x9d9d0000, 0x7d7d0000, 0xfdfd0000, 0xbdbd0000, 0x3d3d0000,
+			0x2d2d0000, 0xadad0000, 0xeded0000, 0x6d6d0000, 0x8d8d0000, 0x0d0d0000, 0x4d4d0000, 0xcdcd0000,
+			0x99990000, 0x19190000, 0x59590000, 0xd9d90000, 0x39390000, 0xb9b90000, 0xf9f90000, 0x79790000,
+			0x69690000, 0xe9e90000, 0xa9a90000, 0x29290000, 0xc9c90000, 0x49490000, 0x09090000, 0x89890000,
+			0x11110000, 0x91910000, 0xd1d10000, 0x51510000, 0xb1b10000, 0x31310000, 0x71710000, 0xf1f10000,
+			0xe1e10000, 0x61610000, 0x21210000, 0xa1a10000, 0x41410000, 0xc1c10000, 0x81810000, 0x01010000 },
+		{
+			0x00000000, 0x80008000, 0xc000c000, 0x40004000, 0xa000a000, 0x20002000, 0x60006000, 0xe000e000,
+			0xf000f000, 0x70007000, 0x30003000, 0xb000b000, 0x50005000, 0xd000d000, 0x90009000, 0x10001000,
+			0x88008800, 0x08000800, 0x48004800, 0xc800c800, 0x28002800, 0xa800a800, 0xe800e800, 0x68006800,
+			0x78007800, 0xf800f800, 0xb800b800, 0x38003800, 0xd800d800, 0x58005800, 0x18001800, 0x98009800,
+			0xcc00cc00, 0x4c004c00, 0x0c000c00, 0x8c008c00, 0x6c006c00, 0xec00ec00, 0xac00ac00, 0x2c002c00,
+			0x3c003c00, 0xbc00bc00, 0xfc00fc00, 0x7c007c00, 0x9c009c00, 0x1c001c00, 0x5c005c00, 0xdc00dc00,
+			0x44004400, 0xc400c400, 0x84008400, 0x04000400, 0xe400e400, 0x64006400, 0x24002400, 0xa400a400,
+			0xb400b400, 0x34003400, 0x74007400, 0xf400f400, 0x14001400, 0x94009400, 0xd400d400, 0x54005400,
+			0xaa00aa00, 0x2a002a00, 0x6a006a00, 0xea00ea00, 0x0a000a00, 0x8a008a00, 0xca00ca00, 0x4a004a00,
+			0x5a005a00, 0xda00da00, 0x9a009a00, 0x1a001a00, 0xfa00fa00, 0x7a007a00, 0x3a003a00, 0xba00ba00,
+			0x22002200, 0xa200a200, 0xe200e200, 0x62006200, 0x82008200, 0x02000200, 0x42004200, 0xc200c200,
+			0xd200d200, 0x52005200, 0x12001200, 0x92009200, 0x72007200, 0xf200f200, 0xb200b200, 0x32003200,
+			0x66006600, 0xe600e600, 0xa600a600, 0x26002600, 0xc600c600, 0x46004600, 0x06000600, 0x86008600,
+			0x96009600, 0x16001600, 0x56005600, 0xd600d600, 0x36003600, 0xb600b600, 0xf600f600, 0x76007600,
+			0xee00ee00, 0x6e006e00, 0x2e002e00, 0xae00ae00, 0x4e004e00, 0xce00ce00, 0x8e008e00, 0x0e000e00,
+			0x1e001e00, 0x9e009e00, 0xde00de00, 0x5e005e00, 0xbe00be00, 0x3e003e00, 0x7e007e00, 0xfe00fe00,
+			0xff00ff00, 0x7f007f00, 0x3f003f00, 0xbf00bf00, 0x5f005f00, 0xdf00df00, 0x9f009f00, 0x1f001f00,
+			0x0f000f00, 0x8f008f00, 0xcf00cf00, 0x4f004f00, 0xaf00af00, 0x2f002f00, 0x6f006f00, 0xef00ef00,
+			0x77007700, 0xf700f700, 0xb700b700, 0x37003700, 0xd700d700, 0x57005700, 0x17001700, 0x97009700,
+			0x87008700, 0x07000700, 0x47004700, 0xc700c700, 0x27002700, 0xa700a700, 0xe700e700, 0x67006700,
+			0x33003300, 0xb300b300, 0xf300f300, 0x73007300, 0x93009300, 0x13001300, 0x53005300, 0xd300d300,
+			0xc300c300, 0x43004300, 0x03000300, 0x83008300, 0x63006300, 0xe300e300, 0xa300a300, 0x23002300,
+			0xbb00bb00, 0x3b003b00, 0x7b007b00, 0xfb00fb00, 0x1b001b00, 0x9b009b00, 0xdb00db00, 0x5b005b00,
+			0x4b004b00, 0xcb00cb00, 0x8b008b00, 0x0b000b00, 0xeb00eb00, 0x6b006b00, 0x2b002b00, 0xab00ab00,
+			0x55005500, 0xd500d500, 0x95009500, 0x15001500, 0xf500f500, 0x75007500, 0x35003500, 0xb500b500,
+			0xa500a500, 0x25002500, 0x65006500, 0xe500e500, 0x05000500, 0x85008500, 0xc500c500, 0x45004500,
+			0xdd00dd00, 0x5d005d00, 0x1d001d00, 0x9d009d00, 0x7d007d00, 0xfd00fd00, 0xbd00bd00, 0x3d003d00,
+			0x2d002d00, 0xad00ad00, 0xed00ed00, 0x6d006d00, 0x8d008d00, 0x0d000d00, 0x4d004d00, 0xcd00cd00,
+			0x99009900, 0x19001900, 0x59005900, 0xd900d900, 0x39003900, 0xb900b900, 0xf900f900, 0x79007900,
+			0x69006900, 0xe900e900, 0xa900a900, 0x29002900, 0xc900c900, 0x49004900, 0x09000900, 0x89008900,
+			0x11001100, 0x91009100, 0xd100d100, 0x51005100, 0xb100b100, 0x31003100, 0x71007100, 0xf100f100,
+			0xe100e100, 0x61006100, 0x21002100, 0xa100a100, 0x41004100, 0xc100c100, 0x81008100, 0x01000100 },
+		{
+			0x00000000, 0x80808080, 0xc0c0c0c0, 0x40404040, 0xa0a0a0a0, 0x20202020, 0x60606060, 0xe0e0e0e0,
+			0xf0f0f0f0, 0x70707070, 0x30303030, 0xb0b0b0b0, 0x50505050, 0xd0d0d0d0, 0x90909090, 0x10101010,
+			0x88888888, 0x08080808, 0x48484848, 0xc8c8c8c8, 0x28282828, 0xa8a8a8a8, 0xe8e8e8e8, 0x68686868,
+			0x78787878, 0xf8f8f8f8, 0xb8b8b8b8, 0x38383838, 0xd8d8d8d8, 0x58585858, 0x18181818, 0x98989898,
+			0xcccccccc, 0x4c4c4c4c, 0x0c0c0c0c, 0x8c8c8c8c, 0x6c6c6c6c, 0xecececec, 0xacacacac, 0x2c2c2c2c,
+			0x3c3c3c3c, 0xbcbcbcbc, 0xfcfcfcfc, 0x7c7c7c7c, 0x9c9c9c9c, 0x1c1c1c1c, 0x5c5c5c5c, 0xdcdcdcdc,
+			0x44444444, 0xc4c4c4c4, 0x84848484, 0x04040404, 0xe4e4e4e4, 0x64646464, 0x24242424, 0xa4a4a4a4,
+			0xb4b4b4b4, 0x34343434, 0x74747474, 0xf4f4f4f4, 0x14141414, 0x94949494, 0xd4d4d4d4, 0x54545454,
+			0xaaaaaaaa, 0x2a2a2a2a, 0x6a6a6a6a, 0xeaeaeaea, 0x0a0a0a0a, 0x8a8a8a8a, 0xcacacaca, 0x4a4a4a4a,
+			0x5a5a5a5a, 0xdadadada, 0x9a9a9a9a, 0x1a1a1a1a, 0xfafafafa, 0x7a7a7a7a, 0x3a3a3a3a, 0xbabababa,
+			0x22222222, 0xa2a2a2a2, 0xe2e2e2e2, 0x62626262, 0x82828282, 0x02020202, 0x42424242, 0xc2c2c2c2,
+			0xd2d2d2d2, 0x52525252, 0x12121212, 0x92929292, 0x72727272, 0xf2f2f2f2, 0xb2b2b2b2, 0x32323232,
+			0x66666666, 0xe6e6e6e6, 0xa6a6a6a6, 0x26262626, 0xc6c6c6c6, 0x46464646, 0x06060606, 0x86868686,
+			0x96969696, 0x16161616, 0x56565656, 0xd6d6d6d6, 0x36363636, 0xb6b6b6b6, 0xf6f6f6f6, 0x76767676,
+			0xeeeeeeee, 0x6e6e6e6e, 0x2e2e2e2e, 0xaeaeaeae, 0x4e4e4e4e, 0xcececece, 0x8e8e8e8e, 0x0e0e0e0e,
+			0x1e1e1e1e, 0x9e9e9e9e, 0xdededede, 0x5e5e5e5e, 0xbebebebe, 0x3e3e3e3e, 0x7e7e7e7e, 0xfefefefe,
+			0xffffffff, 0x7f7f7f7f, 0x3f3f3f3f, 0xbfbfbfbf, 0x5f5f5f5f, 0xdfdfdfdf, 0x9f9f9f9f, 0x1f1f1f1f,
+			0x0f0f0f0f, 0x8f8f8f8f, 0xcfcfcfcf, 0x4f4f4f4f, 0xafafafaf, 0x2f2f2f2f, 0x6f6f6f6f, 0xefefefef,
+			0x77777777, 0xf7f7f7f7, 0xb7b7b7b7, 0x37373737, 0xd7d7d7d7, 0x57575757, 0x17171717, 0x97979797,
+			0x87878787, 0x07070707, 0x47474747, 0xc7c7c7c7, 0x27272727, 0xa7a7a7a7, 0xe7e7e7e7, 0x67676767,
+			0x33333333, 0xb3b3b3b3, 0xf3f3f3f3, 0x73737373, 0x93939393, 0x13131313, 0x53535353, 0xd3d3d3d3,
+			0xc3c3c3c3, 0x43434343, 0x03030303, 0x83838383, 0x63636363, 0xe3e3e3e3, 0xa3a3a3a3, 0x23232323,
+			0xbbbbbbbb, 0x3b3b3b3b, 0x7b7b7b7b, 0xfbfbfbfb, 0x1b1b1b1b, 0x9b9b9b9b, 0xdbdbdbdb, 0x5b5b5b5b,
+			0x4b4b4b4b, 0xcbcbcbcb, 0x8b8b8b8b, 0x0b0b0b0b, 0xebebebeb, 0x6b6b6b6b, 0x2b2b2b2b, 0xabababab,
+			0x55555555, 0xd5d5d5d5, 0x95959595, 0x15151515, 0xf5f5f5f5, 0x75757575, 0x35353535, 0xb5b5b5b5,
+			0xa5a5a5a5, 0x25252525, 0x65656565, 0xe5e5e5e5, 0x05050505, 0x85858585, 0xc5c5c5c5, 0x45454545,
+			0xdddddddd, 0x5d5d5d5d, 0x1d1d1d1d, 0x9d9d9d9d, 0x7d7d7d7d, 0xfdfdfdfd, 0xbdbdbdbd, 0x3d3d3d3d,
+			0x2d2d2d2d, 0xadadadad, 0xedededed, 0x6d6d6d6d, 0x8d8d8d8d, 0x0d0d0d0d, 0x4d4d4d4d, 0xcdcdcdcd,
+			0x99999999, 0x19191919, 0x59595959, 0xd9d9d9d9, 0x39393939, 0xb9b9b9b9, 0xf9f9f9f9, 0x79797979,
+			0x69696969, 0xe9e9e9e9, 0xa9a9a9a9, 0x29292929, 0xc9c9c9c9, 0x49494949, 0x09090909, 0x89898989,
+			0x11111111, 0x91919191, 0xd1d1d1d1, 0x51515151, 0xb1b1b1b1, 0x31313131, 0x71717171, 0xf1f1f1f1,
+			0xe1e1e1e1, 0x61616161, 0x21212121, 0xa1a1a1a1, 0x41414141, 0xc1c1c1c1, 0x81818181, 0x01010101 } } };
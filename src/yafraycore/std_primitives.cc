@@ -30,28 +30,6 @@ bound_t sphere_t::getBound() const
 	return bound_t(center - r, center + r);
 }
 
-bool sphere_t::intersect(const ray_t &ray, PFLOAT *t, intersectData_t &data) const
-{
-	vector3d_t vf = ray.from - center;
-	PFLOAT ea = ray.dir*ray.dir;
-	PFLOAT eb = 2.0*(vf*ray.dir);
-	PFLOAT ec = vf*vf - radius*radius;
-	PFLOAT osc = eb*eb-4.0*ea*ec;
-	if(osc<0) return false;
-	osc=fSqrt(osc);
-	PFLOAT sol1=(-eb-osc)/(2.0*ea);
-	PFLOAT sol2=(-eb+osc)/(2.0*ea);
-	PFLOAT sol=sol1;
-	if(sol < ray.tmin)
-	{
-		sol = sol2;
-		if(sol < ray.tmin) return false;
-	}
-	//if(sol > ray.tmax) return false; //tmax = -1 is not substituted yet...
-	*t = sol;
-	return true;
-}
-
 void sphere_t::getSurface(surfacePoint_t &sp, const point3d_t &hit, intersectData_t &data) const
 {
 	vector3d_t normal = hit - center;
@@ -0,0 +1,17 @@
+#include <yafraycore/threadslots.h>
+
+__BEGIN_YAFRAY
+
+static Y_THREAD_LOCAL int localWorker = -1;
+
+void setWorkerIndex(int index)
+{
+	localWorker = index;
+}
+
+int workerIndex()
+{
+	return localWorker;
+}
+
+__END_YAFRAY
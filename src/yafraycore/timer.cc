@@ -71,6 +71,20 @@ double timer_t::getTime(const std::string &name)
 }
 
 
+double timer_t::now()
+{
+#ifdef WIN32
+	LARGE_INTEGER count, freq;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&freq);
+	return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + double(tv.tv_usec)/1.0e6;
+#endif
+}
+
 bool timer_t::includes(const std::string &label)const
 {
 	std::map<std::string, tdata_t>::const_iterator i=events.find(label);
@@ -0,0 +1,131 @@
+#include <yafraycore/trace.h>
+#include <yafraycore/timer.h>
+
+#include <fstream>
+#include <sstream>
+
+__BEGIN_YAFRAY
+
+traceRecorder_t gTrace;
+bool traceRecorder_t::enabled = false;
+
+// the ring of the calling thread, valid while localGeneration matches the global one
+static Y_THREAD_LOCAL traceBuffer_t *localBuffer = 0;
+static Y_THREAD_LOCAL unsigned int localGeneration = 0;
+
+traceRecorder_t::traceRecorder_t(): buffers(mutex), capacity(1 << 16)
+{
+	epoch = timer_t::now();
+}
+
+traceRecorder_t::~traceRecorder_t() {}
+
+double traceRecorder_t::now() const
+{
+	return (timer_t::now() - epoch) * 1.0e6;
+}
+
+// rings are sized when handed out, so a capacity change reaches recycled ones too
+struct ringInit_t
+{
+	ringInit_t(unsigned int c): capacity(c) {}
+	void operator()(traceBuffer_t *b) const
+	{
+		if(b->capacity != capacity)
+		{
+			delete [] b->events;
+			b->capacity = capacity;
+			b->events = new traceEvent_t[capacity];
+		}
+		b->next = 0;
+	}
+	unsigned int capacity;
+};
+
+traceBuffer_t *traceRecorder_t::local()
+{
+	return gTrace.buffers.local(localBuffer, localGeneration, ringInit_t(gTrace.capacity));
+}
+
+void traceRecorder_t::record(const char *name, const char *category, const char *argNames, double start, const int *arg)
+{
+	double end = gTrace.now();
+	traceBuffer_t *b = local();
+	traceEvent_t &e = b->events[b->next++ % b->capacity];
+	e.name = name;
+	e.category = category;
+	e.argNames = argNames;
+	e.start = start;
+	e.duration = end - start;
+	for(int i = 0; i < 4; ++i) e.arg[i] = arg[i];
+}
+
+void traceRecorder_t::reset()
+{
+	mutex.lock();
+	buffers.reset();
+	epoch = timer_t::now();
+	mutex.unlock();
+}
+
+static void eventJSON(std::ostream &out, const traceEvent_t &e, int tid)
+{
+	out << "{\"name\": \"" << e.name << "\", \"cat\": \"" << e.category << "\", \"ph\": \"X\", \"ts\": " << e.start
+		<< ", \"dur\": " << e.duration << ", \"pid\": 0, \"tid\": " << tid;
+	if(e.argNames)
+	{
+		out << ", \"args\": {";
+		const char *n = e.argNames;
+		for(int i = 0; i < 4 && *n; ++i)
+		{
+			out << (i ? ", \"" : "\"");
+			while(*n && *n != ',') out << *n++;
+			out << "\": " << e.arg[i];
+			if(*n == ',') ++n;
+		}
+		out << "}";
+	}
+	out << "}";
+}
+
+std::string traceRecorder_t::toJSON() const
+{
+	std::stringstream out;
+	out.precision(3);
+	out << std::fixed;
+	mutex.lock();
+
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	bool first = true;
+	// workers keep their index as row, the other threads follow them
+	int other = buffers.workerSlots();
+	for(size_t t = 0; t < buffers.size(); ++t)
+	{
+		const traceBuffer_t *b = buffers[t];
+		int w = buffers.worker(t), tid = w >= 0 ? w : other++;
+		out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << tid
+			<< ", \"args\": {\"name\": \"" << (w >= 0 ? "worker " : "thread ") << tid << "\"}}";
+		first = false;
+		unsigned long long n = b->next, cap = b->capacity;
+		if(n > cap) Y_WARNING << "Trace: Thread " << tid << " recorded " << n << " events, only the last " << cap << " are kept" << yendl;
+		for(unsigned long long i = (n > cap ? n - cap : 0); i < n; ++i)
+		{
+			out << ",\n";
+			eventJSON(out, b->events[i % cap], tid);
+		}
+	}
+	out << "\n]}\n";
+
+	mutex.unlock();
+	return out.str();
+}
+
+bool traceRecorder_t::saveJSON(const std::string &fileName) const
+{
+	std::ofstream file(fileName.c_str());
+	if(!file) return false;
+	file << toJSON();
+	return file.good();
+}
+
+__END_YAFRAY
@@ -11,12 +11,16 @@ inline void triangle_t::getSurface(surfacePoint_t &sp, const point3d_t &hit, int
 	sp.Ng = getNormal();
 	data.calcB0();
 
+	size_t selfIndex = getIndex();
+
 	float u = data.b0, v = data.b1, w = data.b2;
 	
 	if(mesh->is_smooth || mesh->normals_exported)
 	{
 		// assume the smoothed normals exist, if the mesh is smoothed; if they don't, fix this
 		// assert(na > 0 && nb > 0 && nc > 0);
+		int na, nb, nc;
+		getNormalIndices(na, nb, nc);
 
 		vector3d_t va = (na > 0) ? mesh->getVertexNormal(na) : sp.Ng;
 		vector3d_t vb = (nb > 0) ? mesh->getVertexNormal(nb) : sp.Ng;
@@ -94,7 +98,7 @@ inline void triangle_t::getSurface(surfacePoint_t &sp, const point3d_t &hit, int
 
 	sp.object = mesh;
 	sp.primNum = selfIndex;
-	sp.material = material;
+	sp.material = getMaterial();
 	sp.P = hit;
 	createCS(sp.N, sp.NU, sp.NV);
 	// transform dPdU and dPdV in shading space
@@ -170,17 +174,18 @@ inline void triangle_t::sample(float s1, float s2, point3d_t &p, vector3d_t &n)
 
 inline void triangleInstance_t::getSurface(surfacePoint_t &sp, const point3d_t &hit, intersectData_t &data) const
 {
-	sp.Ng = getNormal();
+	// data.t holds the frame time of the ray, moving instances are evaluated there
+	const PFLOAT time = data.t;
+	sp.Ng = getNormal(time);
 	int pa = mBase->pa;
 	int pb = mBase->pb;
 	int pc = mBase->pc;
-	int na = mBase->na;
-	int nb = mBase->nb;
-	int nc = mBase->nc;
+	int na, nb, nc;
+	mBase->getNormalIndices(na, nb, nc);
 
 	data.calcB0();
 
-	size_t selfIndex = mBase->selfIndex;
+	size_t selfIndex = mBase->getIndex();
 
 	float u = data.b0, v = data.b1, w = data.b2;
 	
@@ -189,9 +194,9 @@ inline void triangleInstance_t::getSurface(surfacePoint_t &sp, const point3d_t &
 		// assume the smoothed normals exist, if the mesh is smoothed; if they don't, fix this
 		// assert(na > 0 && nb > 0 && nc > 0);
 
-		vector3d_t va = (na > 0) ? mesh->getVertexNormal(na) : sp.Ng;
-		vector3d_t vb = (nb > 0) ? mesh->getVertexNormal(nb) : sp.Ng;
-		vector3d_t vc = (nc > 0) ? mesh->getVertexNormal(nc) : sp.Ng;
+		vector3d_t va = (na > 0) ? mesh->getVertexNormal(na, time) : sp.Ng;
+		vector3d_t vb = (nb > 0) ? mesh->getVertexNormal(nb, time) : sp.Ng;
+		vector3d_t vc = (nc > 0) ? mesh->getVertexNormal(nc, time) : sp.Ng;
 
 		sp.N = u*va + v*vb + w*vc;
 		sp.N.normalize();
@@ -217,9 +222,9 @@ inline void triangleInstance_t::getSurface(surfacePoint_t &sp, const point3d_t &
 		sp.orcoNg = sp.Ng;
 	}
 
-	point3d_t const& p0 = mesh->getVertex(pa);
-	point3d_t const& p1 = mesh->getVertex(pb);
-	point3d_t const& p2 = mesh->getVertex(pc);
+	point3d_t const& p0 = mesh->getVertex(pa, time);
+	point3d_t const& p1 = mesh->getVertex(pb, time);
+	point3d_t const& p2 = mesh->getVertex(pc, time);
 	
 	if(mesh->has_uv)
 	{
@@ -270,7 +275,7 @@ inline void triangleInstance_t::getSurface(surfacePoint_t &sp, const point3d_t &
 
 	sp.object = mesh;
 	sp.primNum = selfIndex;
-	sp.material = mBase->material;
+	sp.material = mBase->getMaterial();
 	sp.P = hit;
 	createCS(sp.N, sp.NU, sp.NV);
 	vector3d_t U, V;
@@ -368,24 +373,15 @@ bool vTriangle_t::intersect(const ray_t &ray, float *t, intersectData_t &data) c
 {
 	//Tomas M??ller and Ben Trumbore ray intersection scheme
 	const point3d_t &a=mesh->points[pa], &b=mesh->points[pb], &c=mesh->points[pc];
-	vector3d_t edge1, edge2, tvec, pvec, qvec;
-	float det, inv_det, u, v;
-	edge1 = b - a;
-	edge2 = c - a;
-	pvec = ray.dir ^ edge2;
-	det = edge1 * pvec;
-	if (/*(det>-0.000001) && (det<0.000001)*/ det == 0.0) return false;
-	inv_det = 1.0 / det;
-	tvec = ray.from - a;
-	u = (tvec*pvec) * inv_det;
-	if (u < 0.0 || u > 1.0) return false;
-	qvec = tvec^edge1;
-	v = (ray.dir*qvec) * inv_det;
-	if ((v<0.0) || ((u+v)>1.0) ) return false;
-	*t = edge2 * qvec * inv_det;
-	data.b1 = u;
-	data.b2 = v;
-	return true;
+	return intersectTriangle(a, b - a, c - a, ray, t, data);
+}
+
+int vTriangle_t::getShape(point3d_t p[3], PFLOAT &r) const
+{
+	p[0] = mesh->points[pa];
+	p[1] = mesh->points[pb];
+	p[2] = mesh->points[pc];
+	return PRIM_TRIANGLE;
 }
 
 bound_t vTriangle_t::getBound() const
@@ -584,40 +580,42 @@ bool bsTriangle_t::intersect(const ray_t &ray, float *t, intersectData_t &data)
 	*t = edge2 * qvec * inv_det;
 	
 	data.b1 = u;
-	data.b1 = v;
+	data.b2 = v;
 	data.t = ray.time;
 	return true;
 }
 
 bound_t bsTriangle_t::getBound() const
 {
-	const point3d_t *an=&mesh->points[pa], *bn=&mesh->points[pb], *cn=&mesh->points[pc];
-	point3d_t amin, bmin, cmin, amax, bmax, cmax;
-	amin.x = Y_MIN3(an[0].x, an[1].x, an[2].x);
-	amin.y = Y_MIN3(an[0].y, an[1].y, an[2].y);
-	amin.z = Y_MIN3(an[0].z, an[1].z, an[2].z);
-	bmin.x = Y_MIN3(bn[0].x, bn[1].x, bn[2].x);
-	bmin.y = Y_MIN3(bn[0].y, bn[1].y, bn[2].y);
-	bmin.z = Y_MIN3(bn[0].z, bn[1].z, bn[2].z);
-	cmin.x = Y_MIN3(cn[0].x, cn[1].x, cn[2].x);
-	cmin.y = Y_MIN3(cn[0].y, cn[1].y, cn[2].y);
-	cmin.z = Y_MIN3(cn[0].z, cn[1].z, cn[2].z);
-	amax.x = Y_MAX3(an[0].x, an[1].x, an[2].x);
-	amax.y = Y_MAX3(an[0].y, an[1].y, an[2].y);
-	amax.z = Y_MAX3(an[0].z, an[1].z, an[2].z);
-	bmax.x = Y_MAX3(bn[0].x, bn[1].x, bn[2].x);
-	bmax.y = Y_MAX3(bn[0].y, bn[1].y, bn[2].y);
-	bmax.z = Y_MAX3(bn[0].z, bn[1].z, bn[2].z);
-	cmax.x = Y_MAX3(cn[0].x, cn[1].x, cn[2].x);
-	cmax.y = Y_MAX3(cn[0].y, cn[1].y, cn[2].y);
-	cmax.z = Y_MAX3(cn[0].z, cn[1].z, cn[2].z);
+	return getMotionBound(0.f, 1.f);
+}
+
+bound_t bsTriangle_t::getMotionBound(PFLOAT t0, PFLOAT t1) const
+{
+	// the control points of the bezier restricted to [t0;t1] come from its blossom
+	// f(u,v) = (1-u)(1-v)P0 + ((1-u)v + u(1-v))P1 + uvP2 and enclose it on that interval
+	const float w[3][3] =
+	{
+		{ (1.f-t0)*(1.f-t0), 2.f*t0*(1.f-t0), t0*t0 },
+		{ (1.f-t0)*(1.f-t1), (1.f-t0)*t1 + t0*(1.f-t1), t0*t1 },
+		{ (1.f-t1)*(1.f-t1), 2.f*t1*(1.f-t1), t1*t1 }
+	};
+	const point3d_t *pn[3] = { &mesh->points[pa], &mesh->points[pb], &mesh->points[pc] };
 	point3d_t l, h;
-	l.x = Y_MIN3(amin.x, bmin.x, cmin.x);
-	l.y = Y_MIN3(amin.y, bmin.y, cmin.y);
-	l.z = Y_MIN3(amin.z, bmin.z, cmin.z);
-	h.x = Y_MAX3(amax.x, bmax.x, cmax.x);
-	h.y = Y_MAX3(amax.y, bmax.y, cmax.y);
-	h.z = Y_MAX3(amax.z, bmax.z, cmax.z);
+	for(int v=0; v<3; ++v)
+	{
+		const point3d_t *cp = pn[v];
+		for(int k=0; k<3; ++k)
+		{
+			point3d_t q = w[k][0]*cp[0] + w[k][1]*cp[1] + w[k][2]*cp[2];
+			if(v == 0 && k == 0) l = h = q;
+			else
+			{
+				l.x = std::min(l.x, q.x), l.y = std::min(l.y, q.y), l.z = std::min(l.z, q.z);
+				h.x = std::max(h.x, q.x), h.y = std::max(h.y, q.y), h.z = std::max(h.z, q.z);
+			}
+		}
+	}
 	return bound_t(l, h);
 }
 
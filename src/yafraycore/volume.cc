@@ -1,6 +1,8 @@
 #include <core_api/volume.h>
 #include <core_api/ray.h>
 #include <core_api/color.h>
+#include <utilities/halfFloat.h>
+#include <algorithm>
 
 __BEGIN_YAFRAY
 
@@ -32,6 +34,14 @@ color_t DensityVolume::tau(const ray_t &ray, float stepSize, float offset)
 
 		while (pos < t1)
 		{
+			// jump over empty space in whole steps, so the remaining sample positions don't change
+			float skipTo = haveEmptySpaceInfo ? skipEmpty(ray, pos, t1) : pos;
+			if (skipTo > pos)
+			{
+				pos += std::ceil((skipTo - pos) / step) * step;
+				continue;
+			}
+
 			color_t tauTmp = sigma_t(ray.from + (ray.dir * pos), ray.dir);
 
 
@@ -62,6 +72,13 @@ color_t DensityVolume::tau(const ray_t &ray, float stepSize, float offset)
 		return tauVal;
 	}
 
+float VolumeRegion::skipEmpty(const ray_t &ray, float t, float tMax)
+{
+	float t0 = -1, t1 = -1;
+	if (!intersect(ray, t0, t1) || t1 < t) return tMax;
+	return (t0 > t) ? std::min(t0, tMax) : t;
+}
+
 inline float min(float a, float b) { return (a > b) ? b : a; }
 inline float max(float a, float b) { return (a < b) ? b : a; }
 
@@ -73,14 +90,163 @@ inline double cosInter(double y1, double y2, double mu)
 	return y1 * (1.0f - mu2) + y2 * mu2;
 }
 
-float VolumeRegion::attenuation(const point3d_t p, light_t *l)
+#define ATT_BRICK 4
+// lazy bricks whose corner transmittances differ less than this get interpolated instead of sampled
+#define ATT_REFINE_THRESH 0.02f
+
+point3d_t VolumeRegion::attGridPoint(int x, int y, int z) const
+{
+	return point3d_t(bBox.a.x + bBox.longX() * ((float)x + 0.5f) / (float)attGridX,
+					 bBox.a.y + bBox.longY() * ((float)y + 0.5f) / (float)attGridY,
+					 bBox.a.z + bBox.longZ() * ((float)z + 0.5f) / (float)attGridZ);
+}
+
+inline float VolumeRegion::attValue(int idx) const
 {
-	if (attenuationGridMap.find(l) == attenuationGridMap.end())
+	return attHalf ? halfToFloat(attGridHalf[idx]) : attGrid[idx];
+}
+
+inline void VolumeRegion::setAttValue(int idx, float val)
+{
+	if(attHalf) attGridHalf[idx] = floatToHalf(val);
+	else attGrid[idx] = val;
+}
+
+void VolumeRegion::initAttenuationGrids(int nLights, bool halfPrecision, const attenuationSampler_t *lazySampler)
+{
+	int gridSize = attGridX * attGridY * attGridZ;
+	nAttLights = nLights;
+	attHalf = halfPrecision;
+	attSampler = lazySampler;
+
+	attGrid.clear();
+	attGridHalf.clear();
+	attCoarse.clear();
+	attBrickReady.clear();
+
+	if(attHalf) attGridHalf.resize(gridSize * nLights, 0);
+	else attGrid.resize(gridSize * nLights, 0.f);
+
+	if(attSampler)
 	{
-		Y_WARNING << "VolumeRegion: Attenuation Map is missing" << yendl;
+		attBricksX = (attGridX + ATT_BRICK - 1) / ATT_BRICK;
+		attBricksY = (attGridY + ATT_BRICK - 1) / ATT_BRICK;
+		attBricksZ = (attGridZ + ATT_BRICK - 1) / ATT_BRICK;
+		attCoarse.resize((attBricksX + 1) * (attBricksY + 1) * (attBricksZ + 1) * nLights, 0.f);
+		attBrickReady.resize(attBricksX * attBricksY * attBricksZ * nLights, 0);
 	}
+}
 
-	float* attenuationGrid = attenuationGridMap[l];
+int VolumeRegion::attenuationSlices() const
+{
+	return attSampler ? attBricksZ + 1 : attGridZ;
+}
+
+void VolumeRegion::fillAttenuationSlice(const attenuationSampler_t &sampler, int light, int z)
+{
+	if(attSampler)
+	{
+		int cx = attBricksX + 1, cy = attBricksY + 1;
+		float *coarse = &attCoarse[(light * (attBricksZ + 1) + z) * cx * cy];
+
+		for (int y = 0; y < cy; ++y)
+		{
+			for (int x = 0; x < cx; ++x)
+			{
+				coarse[x + y * cx] = sampler.lightTransmittance(attGridPoint(x * ATT_BRICK, y * ATT_BRICK, z * ATT_BRICK), light);
+			}
+		}
+	}
+	else
+	{
+		int offs = (light * attGridZ + z) * attGridX * attGridY;
+
+		for (int y = 0; y < attGridY; ++y)
+		{
+			for (int x = 0; x < attGridX; ++x)
+			{
+				setAttValue(offs + x + y * attGridX, sampler.lightTransmittance(attGridPoint(x, y, z), light));
+			}
+		}
+	}
+}
+
+void VolumeRegion::buildAttBrick(int light, int bx, int by, int bz)
+{
+	int cx = attBricksX + 1, cy = attBricksY + 1;
+	const float *coarse = &attCoarse[light * cx * cy * (attBricksZ + 1)];
+
+	// coarse samples at the brick corners, bit 0: +x, bit 1: +y, bit 2: +z
+	float c[8];
+	float cMin = 1e10f, cMax = -1e10f;
+	for (int i = 0; i < 8; ++i)
+	{
+		c[i] = coarse[(bx + (i & 1)) + (by + ((i >> 1) & 1)) * cx + (bz + (i >> 2)) * cx * cy];
+		cMin = std::min(cMin, c[i]);
+		cMax = std::max(cMax, c[i]);
+	}
+
+	bool interpolate = (cMax - cMin) < ATT_REFINE_THRESH;
+	float iBrick = 1.f / (float)ATT_BRICK;
+
+	int x0 = bx * ATT_BRICK, y0 = by * ATT_BRICK, z0 = bz * ATT_BRICK;
+	int x1 = std::min(x0 + ATT_BRICK, attGridX);
+	int y1 = std::min(y0 + ATT_BRICK, attGridY);
+	int z1 = std::min(z0 + ATT_BRICK, attGridZ);
+	int offs = light * attGridX * attGridY * attGridZ;
+
+	for (int z = z0; z < z1; ++z)
+	{
+		float zd = (z - z0) * iBrick;
+		for (int y = y0; y < y1; ++y)
+		{
+			float yd = (y - y0) * iBrick;
+			for (int x = x0; x < x1; ++x)
+			{
+				float val;
+				if (interpolate)
+				{
+					float xd = (x - x0) * iBrick;
+					float w1 = (c[0] * (1 - xd) + c[1] * xd) * (1 - yd) + (c[2] * (1 - xd) + c[3] * xd) * yd;
+					float w2 = (c[4] * (1 - xd) + c[5] * xd) * (1 - yd) + (c[6] * (1 - xd) + c[7] * xd) * yd;
+					val = w1 * (1 - zd) + w2 * zd;
+				}
+				else if (x == x0 && y == y0 && z == z0) val = c[0];
+				else val = attSampler->lightTransmittance(attGridPoint(x, y, z), light);
+
+				setAttValue(offs + x + y * attGridX + z * attGridX * attGridY, val);
+			}
+		}
+	}
+}
+
+inline void VolumeRegion::checkAttBrick(int light, int x, int y, int z)
+{
+	int bx = x / ATT_BRICK, by = y / ATT_BRICK, bz = z / ATT_BRICK;
+	int b = ((light * attBricksZ + bz) * attBricksY + by) * attBricksX + bx;
+
+	volatile int *ready = &attBrickReady[b];
+
+	// the release store publishes the brick data together with its ready flag
+	if (yafthreads::atomicLoadAcquire(ready)) return;
+
+	yafthreads::mutex_t &m = attMutex[b % attLocks];
+	m.lock();
+	if (!yafthreads::atomicLoadAcquire(ready))
+	{
+		buildAttBrick(light, bx, by, bz);
+		yafthreads::atomicStoreRelease(ready, 1);
+	}
+	m.unlock();
+}
+
+float VolumeRegion::attenuation(const point3d_t p, int light)
+{
+	if (light < 0 || light >= nAttLights)
+	{
+		Y_WARNING << "VolumeRegion: Attenuation Map is missing" << yendl;
+		return 1.f;
+	}
 
 	float x = (p.x - bBox.a.x) / bBox.longX() * attGridX - 0.5f;
 	float y = (p.y - bBox.a.y) / bBox.longY() * attGridY - 0.5f;
@@ -95,16 +261,24 @@ float VolumeRegion::attenuation(const point3d_t p, light_t *l)
 	int y1 = min(attGridY - 1, ceil(y));
 	int z1 = min(attGridZ - 1, ceil(z));
 
+	if (attSampler)
+	{
+		for (int i = 0; i < 8; ++i) checkAttBrick(light, (i & 1) ? x1 : x0, (i & 2) ? y1 : y0, (i & 4) ? z1 : z0);
+	}
+
 	// offsets
-	float xd = x - x0;
-	float yd = y - y0;
-	float zd = z - z0;
-	
+	float xd = std::max(0.f, x - x0);
+	float yd = std::max(0.f, y - y0);
+	float zd = std::max(0.f, z - z0);
+
+	int offs = light * attGridX * attGridY * attGridZ;
+	int sx = 1, sy = attGridX, sz = attGridX * attGridY;
+
 	// trilinear combination
-	float i1 = attenuationGrid[x0 + y0 * attGridX + attGridY * attGridX * z0] * (1-zd) + attenuationGrid[x0 + y0 * attGridX + attGridY * attGridX * z1] * zd;
-	float i2 = attenuationGrid[x0 + y1 * attGridX + attGridY * attGridX * z0] * (1-zd) + attenuationGrid[x0 + y1 * attGridX + attGridY * attGridX * z1] * zd;
-	float j1 = attenuationGrid[x1 + y0 * attGridX + attGridY * attGridX * z0] * (1-zd) + attenuationGrid[x1 + y0 * attGridX + attGridY * attGridX * z1] * zd;
-	float j2 = attenuationGrid[x1 + y1 * attGridX + attGridY * attGridX * z0] * (1-zd) + attenuationGrid[x1 + y1 * attGridX + attGridY * attGridX * z1] * zd;
+	float i1 = attValue(offs + x0 * sx + y0 * sy + z0 * sz) * (1-zd) + attValue(offs + x0 * sx + y0 * sy + z1 * sz) * zd;
+	float i2 = attValue(offs + x0 * sx + y1 * sy + z0 * sz) * (1-zd) + attValue(offs + x0 * sx + y1 * sy + z1 * sz) * zd;
+	float j1 = attValue(offs + x1 * sx + y0 * sy + z0 * sz) * (1-zd) + attValue(offs + x1 * sx + y0 * sy + z1 * sz) * zd;
+	float j2 = attValue(offs + x1 * sx + y1 * sy + z0 * sz) * (1-zd) + attValue(offs + x1 * sx + y1 * sy + z1 * sz) * zd;
 	
 	float w1 = i1 * (1 - yd) + i2 * yd;
 	float w2 = j1 * (1 - yd) + j2 * yd;
@@ -298,6 +298,21 @@ struct mesh_dat_t
 	const material_t *mat;
 };
 
+struct curve_dat_t
+{
+	curve_dat_t(): mat(0), strandStart(0), strandEnd(0), strandShape(0) {};
+	const material_t *mat;
+	float strandStart, strandEnd, strandShape;
+};
+
+struct instance_dat_t
+{
+	instance_dat_t(objID_t id): baseID(id), pending(false) {};
+	objID_t baseID;
+	float m[4][4]; //!< last transform, added once it is known whether a transform_end follows
+	bool pending;
+};
+
 // scene-state, i.e. expect only primary elements
 // such as light, material, texture, object, integrator, render...
 
@@ -346,6 +361,24 @@ void startEl_scene(xmlParser_t &parser, const char *element, const char **attrs)
 			Y_ERROR << "XMLParser: Invalid scene state on startTriMesh()!" << yendl;
 		}
 	}
+	else if(el == "curve")
+	{
+		curve_dat_t *cd = new curve_dat_t();
+		int vertices=0, id=-1;
+		for(int n=0; attrs[n]; ++n)
+		{
+			std::string name(attrs[n]);
+			if(name == "vertices") vertices = atoi(attrs[n+1]);
+			else if(name == "id" ) id = atoi(attrs[n+1]);
+		}
+		parser.pushState(startEl_curve, endEl_curve, cd);
+		if(!parser.scene->startGeometry()) Y_ERROR << "XMLParser: Invalid scene state on startGeometry()!" << yendl;
+		if(id == -1) id = parser.scene->getNextFreeID();
+		if(!parser.scene->startCurveMesh(id, vertices))
+		{
+			Y_ERROR << "XMLParser: Invalid scene state on startCurveMesh()!" << yendl;
+		}
+	}
 	else if(el == "smooth")
 	{
 		unsigned int ID=0;
@@ -370,14 +403,13 @@ void startEl_scene(xmlParser_t &parser, const char *element, const char **attrs)
 	}
     else if(el == "instance")
 	{
-		objID_t * base_object_id = new objID_t();
-        *base_object_id = -1;
+		instance_dat_t *idat = new instance_dat_t(-1);
 		for(int n=0; attrs[n]; n++)
 		{
 			std::string name(attrs[n]);
-			if(name == "base_object_id") *base_object_id = atoi(attrs[n+1]);
+			if(name == "base_object_id") idat->baseID = atoi(attrs[n+1]);
 		}
-		parser.pushState(startEl_instance,endEl_instance, base_object_id);	
+		parser.pushState(startEl_instance,endEl_instance, idat);	
 	}
 	else Y_WARNING << "XMLParser: Skipping unrecognized scene element" << yendl;
 }
@@ -466,35 +498,89 @@ void endEl_mesh(xmlParser_t &parser, const char *element)
 	}
 }
 
+// curve-state, i.e. expect the points of one strand and its material and shape settings
+void startEl_curve(xmlParser_t &parser, const char *element, const char **attrs)
+{
+	std::string el(element);
+	curve_dat_t *dat = (curve_dat_t *)parser.stateData();
+	if(el == "p")
+	{
+		point3d_t p, op;
+		if(!parsePoint(attrs, p, op)) return;
+		parser.scene->addVertex(p);
+	}
+	else if(el == "set_material")
+	{
+		std::string mat_name(attrs[1]);
+		dat->mat = parser.env->getMaterial(mat_name);
+		if(!dat->mat) Y_WARNING << "XMLParser: Unknown material!" << yendl;
+	}
+	else if(el == "strand_start" || el == "strand_end" || el == "strand_shape")
+	{
+		float val = 0.f;
+		for(int n=0; attrs[n]; n+=2)
+		{
+			if(!strcmp(attrs[n], "fval")) val = atof(attrs[n+1]);
+		}
+		if(el == "strand_start") dat->strandStart = val;
+		else if(el == "strand_end") dat->strandEnd = val;
+		else dat->strandShape = val;
+	}
+}
+
+void endEl_curve(xmlParser_t &parser, const char *element)
+{
+	if(std::string(element) == "curve")
+	{
+		curve_dat_t *cd = (curve_dat_t *)parser.stateData();
+		if(!parser.scene->endCurveMesh(cd->mat, cd->strandStart, cd->strandEnd, cd->strandShape))
+		{
+			Y_ERROR << "XMLParser: Invalid scene state on endCurveMesh()!" << yendl;
+		}
+		if(!parser.scene->endGeometry()) Y_ERROR << "XMLParser: Invalid scene state on endGeometry()!" << yendl;
+		delete cd;
+		parser.popState();
+	}
+}
+
+static void parseMatrix(const char **attrs, float m[4][4])
+{
+	for(int n=0; attrs[n]; ++n)
+	{
+		const char *name = attrs[n];
+		// m00 .. m33
+		if(name[0] == 'm' && name[1] >= '0' && name[1] <= '3' && name[2] >= '0' && name[2] <= '3' && !name[3])
+		{
+			m[name[1] - '0'][name[2] - '0'] = atof(attrs[n+1]);
+		}
+	}
+}
+
+// instance-state: each transform adds an instance of the base object, a transform_end right
+// after it makes that instance move from the first to the second transform during the frame
 void startEl_instance(xmlParser_t &parser, const char *element, const char **attrs)
 {
 	std::string el(element);
-	objID_t boi = *(objID_t *)parser.stateData();
+	instance_dat_t *idat = (instance_dat_t *)parser.stateData();
 	if(el == "transform")
 	{
-		float m[4][4];
-		for(int n=0; attrs[n]; ++n)
+		if(idat->pending) parser.scene->addInstance(idat->baseID, matrix4x4_t(idat->m));
+		parseMatrix(attrs, idat->m);
+		idat->pending = true;
+	}
+	else if(el == "transform_end")
+	{
+		if(!idat->pending)
 		{
-			std::string name(attrs[n]);
-			if(name ==  "m00") m[0][0] = atof(attrs[n+1]); 
-			else if(name ==  "m01") m[0][1] = atof(attrs[n+1]); 
-			else if(name ==  "m02") m[0][2] = atof(attrs[n+1]); 
-			else if(name ==  "m03") m[0][3] = atof(attrs[n+1]); 
-			else if(name ==  "m10") m[1][0] = atof(attrs[n+1]); 
-			else if(name ==  "m11") m[1][1] = atof(attrs[n+1]); 
-			else if(name ==  "m12") m[1][2] = atof(attrs[n+1]); 
-			else if(name ==  "m13") m[1][3] = atof(attrs[n+1]); 
-			else if(name ==  "m20") m[2][0] = atof(attrs[n+1]); 
-			else if(name ==  "m21") m[2][1] = atof(attrs[n+1]); 
-			else if(name ==  "m22") m[2][2] = atof(attrs[n+1]); 
-			else if(name ==  "m23") m[2][3] = atof(attrs[n+1]); 
-			else if(name ==  "m30") m[3][0] = atof(attrs[n+1]); 
-			else if(name ==  "m31") m[3][1] = atof(attrs[n+1]); 
-			else if(name ==  "m32") m[3][2] = atof(attrs[n+1]); 
-			else if(name ==  "m33") m[3][3] = atof(attrs[n+1]); 
+			Y_WARNING << "XMLParser: transform_end without transform, ignored" << yendl;
+			return;
 		}
-		matrix4x4_t *m4 = new matrix4x4_t(m);
-		parser.scene->addInstance(boi,*m4);
+		float m[4][4];
+		// unset elements keep the start transform
+		for(int i=0; i<4; ++i) for(int j=0; j<4; ++j) m[i][j] = idat->m[i][j];
+		parseMatrix(attrs, m);
+		parser.scene->addInstance(idat->baseID, matrix4x4_t(idat->m), matrix4x4_t(m));
+		idat->pending = false;
 	}
 }
 
@@ -502,6 +588,9 @@ void endEl_instance(xmlParser_t &parser, const char *element)
 {
 	if(std::string(element) == "instance" )
 	{
+		instance_dat_t *idat = (instance_dat_t *)parser.stateData();
+		if(idat->pending) parser.scene->addInstance(idat->baseID, matrix4x4_t(idat->m));
+		delete idat;
 		parser.popState();
 	}
 }